@@ -204,6 +204,32 @@ int CompareLineSegmentationResults( const std::vector<vtkPlusLineSegmentationAlg
   return numberOfFailures;
 }
 
+//----------------------------------------------------------------------------
+int CompareLineSegmentationResultsExact( const std::vector<vtkPlusLineSegmentationAlgo::LineParameters>& lineParameters, const std::vector<vtkPlusLineSegmentationAlgo::LineParameters>& referenceLineParameters )
+{
+  if ( lineParameters.size() != referenceLineParameters.size() )
+  {
+    LOG_ERROR( "Number of frames mismatch: current=" << lineParameters.size() << ", reference=" << referenceLineParameters.size() );
+    return 1;
+  }
+  unsigned int numberOfFailures = 0;
+  for ( unsigned int frameIndex = 0; frameIndex < lineParameters.size(); ++frameIndex )
+  {
+    const vtkPlusLineSegmentationAlgo::LineParameters& currentParam = lineParameters[frameIndex];
+    const vtkPlusLineSegmentationAlgo::LineParameters& referenceParam = referenceLineParameters[frameIndex];
+    if ( currentParam.lineDetected != referenceParam.lineDetected
+         || ( currentParam.lineDetected && ( currentParam.lineOriginPoint_Image[0] != referenceParam.lineOriginPoint_Image[0]
+                                             || currentParam.lineOriginPoint_Image[1] != referenceParam.lineOriginPoint_Image[1]
+                                             || currentParam.lineDirectionVector_Image[0] != referenceParam.lineDirectionVector_Image[0]
+                                             || currentParam.lineDirectionVector_Image[1] != referenceParam.lineDirectionVector_Image[1] ) ) )
+    {
+      LOG_ERROR( "Line segmentation result of Frame #" << frameIndex << " differs from the single-threaded result" );
+      numberOfFailures++;
+    }
+  }
+  return numberOfFailures;
+}
+
 //----------------------------------------------------------------------------
 int main( int argc, char** argv )
 {
@@ -217,6 +243,8 @@ int main( int argc, char** argv )
   std::vector<int> clipRectSize;
   std::string inputBaselineFileName;
   bool saveImages = false;
+  int numberOfThreads = 0;
+  bool compareToSingleThread = false;
 
   args.AddArgument( "--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help." );
   args.AddArgument( "--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)" );
@@ -225,6 +253,8 @@ int main( int argc, char** argv )
   args.AddArgument( "--clip-rect-size", vtksys::CommandLineArguments::MULTI_ARGUMENT, &clipRectSize, "Size of the clipping rectangle" );
   args.AddArgument( "--save-images", vtksys::CommandLineArguments::NO_ARGUMENT, &saveImages, "Save images with detected lines overlaid" );
   args.AddArgument( "--baseline-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputBaselineFileName, "Input xml baseline file name with path" );
+  args.AddArgument( "--number-of-threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfThreads, "Number of threads used for line segmentation (default: 0, the number of processors)" );
+  args.AddArgument( "--compare-to-single-thread", vtksys::CommandLineArguments::NO_ARGUMENT, &compareToSingleThread, "Check that the result is identical to the result computed using a single thread" );
 
   if ( !args.Parse() )
   {
@@ -274,6 +304,7 @@ int main( int argc, char** argv )
   lineSegmenter->SetTrackedFrameList( *trackedFrameList );
   lineSegmenter->SetSaveIntermediateImages( saveImages );
   lineSegmenter->SetIntermediateFilesOutputDirectory( vtkPlusConfig::GetInstance()->GetOutputDirectory() );
+  lineSegmenter->SetNumberOfThreads( numberOfThreads );
 
   LOG_DEBUG( "Segment lines" );
   if ( lineSegmenter->Update() != PLUS_SUCCESS )
@@ -284,6 +315,25 @@ int main( int argc, char** argv )
   std::vector<vtkPlusLineSegmentationAlgo::LineParameters> lineParameters;
   lineSegmenter->GetDetectedLineParameters( lineParameters );
 
+  if ( compareToSingleThread )
+  {
+    LOG_INFO( "Comparing result with single-threaded result..." );
+    lineSegmenter->SetNumberOfThreads( 1 );
+    if ( lineSegmenter->Update() != PLUS_SUCCESS )
+    {
+      LOG_ERROR( "Failed to get line positions from video frames using a single thread" );
+      return PLUS_FAIL;
+    }
+    std::vector<vtkPlusLineSegmentationAlgo::LineParameters> singleThreadLineParameters;
+    lineSegmenter->GetDetectedLineParameters( singleThreadLineParameters );
+    int numberOfFailures = CompareLineSegmentationResultsExact( lineParameters, singleThreadLineParameters );
+    if ( numberOfFailures > 0 )
+    {
+      LOG_ERROR( "Number of differences compared to single-threaded result: " << numberOfFailures << ". Test failed!" );
+      exit( EXIT_FAILURE );
+    }
+  }
+
   // Save results to file
   std::string resultSaveFilename = vtkPlusConfig::GetInstance()->GetOutputPath( "LineSegmentationResults.xml" );
   LOG_INFO( "Save calibration results to XML file: " << resultSaveFilename );
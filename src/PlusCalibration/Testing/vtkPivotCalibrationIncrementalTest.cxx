@@ -0,0 +1,221 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPivotCalibrationIncrementalTest.cxx
+  \brief Test incremental pivot calibration, sliding window, and RANSAC outlier rejection on simulated data
+
+  Marker poses are generated by rotating a stylus around a known pivot point, with some tracking noise.
+  The test checks that the incremental result is available after each inserted point and it matches the
+  known pivot point, that only the most recent points are used when the sliding window is enabled, and that
+  samples acquired while the stylus tip slipped are rejected by RANSAC.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkMath.h"
+#include "vtkMatrix4x4.h"
+#include "vtkMinimalStandardRandomSequence.h"
+#include "vtkPlusPivotCalibrationAlgo.h"
+#include "vtkSmartPointer.h"
+#include "vtkTransform.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+namespace
+{
+  const double POSITION_NOISE_MM = 0.1;
+  const double PIVOT_POINT_ERROR_THRESHOLD_MM = 0.5;
+  const double SLIDING_WINDOW_MATCH_THRESHOLD_MM = 1e-6;
+
+  //----------------------------------------------------------------------------
+  /*! Generate a marker to reference transform of a stylus rotated around the pivot point */
+  void GenerateMarkerToReferenceMatrix(vtkMinimalStandardRandomSequence* random, const double pivotPoint_Marker[3], const double pivotPoint_Reference[3], vtkMatrix4x4* markerToReferenceMatrix)
+  {
+    vtkSmartPointer<vtkTransform> markerToReferenceTransform = vtkSmartPointer<vtkTransform>::New();
+    random->Next();
+    markerToReferenceTransform->RotateX(random->GetRangeValue(-40, 40));
+    random->Next();
+    markerToReferenceTransform->RotateY(random->GetRangeValue(-40, 40));
+    random->Next();
+    markerToReferenceTransform->RotateZ(random->GetRangeValue(-180, 180));
+    markerToReferenceMatrix->DeepCopy(markerToReferenceTransform->GetMatrix());
+
+    // Set the translation so that the pivot point is at the same position in the reference coordinate system
+    double rotatedPivotPoint[4] = { pivotPoint_Marker[0], pivotPoint_Marker[1], pivotPoint_Marker[2], 0.0 };
+    markerToReferenceMatrix->MultiplyPoint(rotatedPivotPoint, rotatedPivotPoint);
+    for (int i = 0; i < 3; i++)
+    {
+      random->Next();
+      markerToReferenceMatrix->SetElement(i, 3, pivotPoint_Reference[i] - rotatedPivotPoint[i] + random->GetRangeValue(-POSITION_NOISE_MM, POSITION_NOISE_MM));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  int CheckPivotPoint(const char* description, const double computedPivotPoint[3], const double expectedPivotPoint[3], double threshold)
+  {
+    double distance = sqrt(vtkMath::Distance2BetweenPoints(computedPivotPoint, expectedPivotPoint));
+    if (distance > threshold)
+    {
+      LOG_ERROR(description << " is incorrect: (" << computedPivotPoint[0] << ", " << computedPivotPoint[1] << ", " << computedPivotPoint[2] << "), expected: ("
+                << expectedPivotPoint[0] << ", " << expectedPivotPoint[1] << ", " << expectedPivotPoint[2] << "), distance: " << distance << " mm");
+      return 1;
+    }
+    return 0;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+  int numberOfPoints = 200;
+  int slidingWindowSize = 50;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--number-of-points", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfPoints, "Number of simulated calibration points (default: 200)");
+  args.AddArgument("--sliding-window-size", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &slidingWindowSize, "Number of points in the sliding window (default: 50)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (slidingWindowSize < 10 || numberOfPoints < 2 * slidingWindowSize)
+  {
+    LOG_ERROR("The sliding window must contain at least 10 points and the number of points must be at least twice the sliding window size");
+    return EXIT_FAILURE;
+  }
+
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random = vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(183495439);
+
+  const double pivotPoint_Marker[3] = { 12.0, -5.0, 160.0 };
+  const double pivotPoint_Reference[3] = { 100.0, 200.0, -50.0 };
+
+  int numberOfErrors = 0;
+  double computedPivotPoint_Marker[3] = { 0, 0, 0 };
+  double computedPivotPoint_Reference[3] = { 0, 0, 0 };
+  double rmsError = 0.0;
+
+  // Incremental result is available after each point
+  vtkSmartPointer<vtkPlusPivotCalibrationAlgo> pivotCalibration = vtkSmartPointer<vtkPlusPivotCalibrationAlgo>::New();
+  vtkSmartPointer<vtkMatrix4x4> markerToReferenceMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (int i = 0; i < numberOfPoints; i++)
+  {
+    GenerateMarkerToReferenceMatrix(random, pivotPoint_Marker, pivotPoint_Reference, markerToReferenceMatrix);
+    pivotCalibration->InsertNextCalibrationPoint(markerToReferenceMatrix);
+    if (i == 0 && pivotCalibration->GetIncrementalPivotPointPosition(computedPivotPoint_Marker, computedPivotPoint_Reference) == PLUS_SUCCESS)
+    {
+      LOG_ERROR("Incremental pivot point is computed from a single point");
+      numberOfErrors++;
+    }
+  }
+  if (pivotCalibration->GetIncrementalPivotPointPosition(computedPivotPoint_Marker, computedPivotPoint_Reference, &rmsError) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Incremental pivot point is not available");
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Incremental pivot calibration RMS error: " << rmsError << " mm");
+  numberOfErrors += CheckPivotPoint("Incremental pivot point in marker coordinate system", computedPivotPoint_Marker, pivotPoint_Marker, PIVOT_POINT_ERROR_THRESHOLD_MM);
+  numberOfErrors += CheckPivotPoint("Incremental pivot point in reference coordinate system", computedPivotPoint_Reference, pivotPoint_Reference, PIVOT_POINT_ERROR_THRESHOLD_MM);
+  if (rmsError < 0 || rmsError > 2 * POSITION_NOISE_MM)
+  {
+    LOG_ERROR("Incremental RMS error is incorrect: " << rmsError << " mm");
+    numberOfErrors++;
+  }
+  if (pivotCalibration->DoPivotCalibration() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Pivot calibration failed");
+    return EXIT_FAILURE;
+  }
+  double batchPivotPoint_Marker[3] = { 0, 0, 0 };
+  for (int i = 0; i < 3; i++)
+  {
+    batchPivotPoint_Marker[i] = pivotCalibration->GetPivotPointToMarkerTransformMatrix()->GetElement(i, 3);
+  }
+  numberOfErrors += CheckPivotPoint("Pivot point in marker coordinate system", batchPivotPoint_Marker, pivotPoint_Marker, PIVOT_POINT_ERROR_THRESHOLD_MM);
+
+  // Sliding window: only the most recent points are used, after the stylus is changed the result follows the new stylus
+  const double otherPivotPoint_Marker[3] = { -8.0, 3.0, 120.0 };
+  vtkSmartPointer<vtkPlusPivotCalibrationAlgo> slidingPivotCalibration = vtkSmartPointer<vtkPlusPivotCalibrationAlgo>::New();
+  slidingPivotCalibration->SetSlidingWindowSize(slidingWindowSize);
+  vtkSmartPointer<vtkPlusPivotCalibrationAlgo> windowPivotCalibration = vtkSmartPointer<vtkPlusPivotCalibrationAlgo>::New();
+  for (int i = 0; i < numberOfPoints; i++)
+  {
+    GenerateMarkerToReferenceMatrix(random, (i < numberOfPoints - slidingWindowSize) ? pivotPoint_Marker : otherPivotPoint_Marker, pivotPoint_Reference, markerToReferenceMatrix);
+    slidingPivotCalibration->InsertNextCalibrationPoint(markerToReferenceMatrix);
+    if (i >= numberOfPoints - slidingWindowSize)
+    {
+      windowPivotCalibration->InsertNextCalibrationPoint(markerToReferenceMatrix);
+    }
+  }
+  if (slidingPivotCalibration->GetNumberOfCalibrationPoints() != slidingWindowSize)
+  {
+    LOG_ERROR("Number of calibration points in the sliding window is incorrect: " << slidingPivotCalibration->GetNumberOfCalibrationPoints() << ", expected: " << slidingWindowSize);
+    numberOfErrors++;
+  }
+  double windowPivotPoint_Marker[3] = { 0, 0, 0 };
+  double windowPivotPoint_Reference[3] = { 0, 0, 0 };
+  if (slidingPivotCalibration->GetIncrementalPivotPointPosition(computedPivotPoint_Marker, computedPivotPoint_Reference) != PLUS_SUCCESS
+      || windowPivotCalibration->GetIncrementalPivotPointPosition(windowPivotPoint_Marker, windowPivotPoint_Reference) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Incremental pivot point is not available with sliding window");
+    return EXIT_FAILURE;
+  }
+  numberOfErrors += CheckPivotPoint("Sliding window pivot point", computedPivotPoint_Marker, otherPivotPoint_Marker, PIVOT_POINT_ERROR_THRESHOLD_MM);
+  numberOfErrors += CheckPivotPoint("Sliding window pivot point (compared to calibration using only the points in the window)", computedPivotPoint_Marker, windowPivotPoint_Marker, SLIDING_WINDOW_MATCH_THRESHOLD_MM);
+
+  // RANSAC: samples acquired while the stylus tip slipped to a different position are rejected
+  const double slippedPivotPoint_Reference[3] = { pivotPoint_Reference[0] + 15.0, pivotPoint_Reference[1] - 10.0, pivotPoint_Reference[2] };
+  const int numberOfSlippedPoints = numberOfPoints / 5;
+  vtkSmartPointer<vtkPlusPivotCalibrationAlgo> ransacPivotCalibration = vtkSmartPointer<vtkPlusPivotCalibrationAlgo>::New();
+  ransacPivotCalibration->RansacEnabledOn();
+  for (int i = 0; i < numberOfPoints; i++)
+  {
+    bool slipped = (i >= numberOfPoints / 2 && i < numberOfPoints / 2 + numberOfSlippedPoints);
+    GenerateMarkerToReferenceMatrix(random, pivotPoint_Marker, slipped ? slippedPivotPoint_Reference : pivotPoint_Reference, markerToReferenceMatrix);
+    ransacPivotCalibration->InsertNextCalibrationPoint(markerToReferenceMatrix);
+  }
+  if (ransacPivotCalibration->DoPivotCalibration() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Pivot calibration with RANSAC failed");
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    batchPivotPoint_Marker[i] = ransacPivotCalibration->GetPivotPointToMarkerTransformMatrix()->GetElement(i, 3);
+  }
+  numberOfErrors += CheckPivotPoint("Pivot point with RANSAC", batchPivotPoint_Marker, pivotPoint_Marker, PIVOT_POINT_ERROR_THRESHOLD_MM);
+  numberOfErrors += CheckPivotPoint("Pivot point in reference coordinate system with RANSAC", ransacPivotCalibration->GetPivotPointPosition_Reference(), pivotPoint_Reference, PIVOT_POINT_ERROR_THRESHOLD_MM);
+  if (ransacPivotCalibration->GetNumberOfDetectedOutliers() < numberOfSlippedPoints)
+  {
+    LOG_ERROR("Number of detected outliers is " << ransacPivotCalibration->GetNumberOfDetectedOutliers() << ", expected at least " << numberOfSlippedPoints);
+    numberOfErrors++;
+  }
+  LOG_INFO("Number of detected outliers with RANSAC: " << ransacPivotCalibration->GetNumberOfDetectedOutliers() << " (slipped points: " << numberOfSlippedPoints << ")");
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed with " << numberOfErrors << " errors");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,279 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkProbeCalibrationOptimizerTest.cxx
+  \brief Test for the minimizers of the probe calibration optimizer
+
+  The calibration is computed with the Powell minimizer, then the analytic derivative of the cost function
+  is compared to central finite differences (both with isotropic and anisotropic pixel spacing parameterization),
+  and finally the calibration is computed with the LBFGS minimizer and compared to the Powell result.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusFidPatternRecognition.h"
+#include "PlusMath.h"
+#include "vtkMatrix4x4.h"
+#include "vtkPlusProbeCalibrationAlgo.h"
+#include "vtkPlusProbeCalibrationOptimizerAlgo.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtkPlusTransformRepository.h"
+#include "vtkSmartPointer.h"
+#include "vtkXMLDataElement.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+#include <algorithm>
+#include <vector>
+
+//-------------------------------------------------------
+int CompareGradientWithFiniteDifferences(vtkPlusProbeCalibrationOptimizerAlgo* optimizer, const vnl_matrix_fixed<double,4,4>& imageToProbeMatrix, bool isotropicPixelSpacing, double gradientErrorThreshold)
+{
+  bool originalIsotropicPixelSpacing = optimizer->GetIsotropicPixelSpacing();
+  optimizer->SetIsotropicPixelSpacing(isotropicPixelSpacing);
+
+  std::vector<double> parameters;
+  if (optimizer->GetTransformParameters(imageToProbeMatrix, parameters) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to get transform parameters");
+    optimizer->SetIsotropicPixelSpacing(originalIsotropicPixelSpacing);
+    return 1;
+  }
+
+  // Move away from the minimum, where the gradient is nearly zero
+  const double rotationOffset = 0.01;
+  const double translationOffset = 0.5; // mm
+  const double scalingOffset = 1.01;
+  for (unsigned int i = 0; i < parameters.size(); i++)
+  {
+    if (i < 3)
+    {
+      parameters[i] += rotationOffset;
+    }
+    else if (i < 6)
+    {
+      parameters[i] += translationOffset;
+    }
+    else
+    {
+      parameters[i] *= scalingOffset;
+    }
+  }
+
+  double cost = 0.0;
+  std::vector<double> analyticDerivative;
+  if (optimizer->ComputeCostFromTransformParameters(parameters, cost, &analyticDerivative) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to compute the analytic derivative");
+    optimizer->SetIsotropicPixelSpacing(originalIsotropicPixelSpacing);
+    return 1;
+  }
+
+  std::vector<double> numericDerivative(parameters.size(), 0.0);
+  double numericDerivativeNorm = 0.0;
+  for (unsigned int i = 0; i < parameters.size(); i++)
+  {
+    // Parameters have different units (versor component, mm, mm/pixel), so the step is relative to the parameter
+    const double step = 1e-6 * std::max(1.0, fabs(parameters[i]));
+    std::vector<double> shiftedParameters = parameters;
+    double costPlus = 0.0;
+    double costMinus = 0.0;
+    shiftedParameters[i] = parameters[i] + step;
+    optimizer->ComputeCostFromTransformParameters(shiftedParameters, costPlus);
+    shiftedParameters[i] = parameters[i] - step;
+    optimizer->ComputeCostFromTransformParameters(shiftedParameters, costMinus);
+    numericDerivative[i] = (costPlus - costMinus) / (2 * step);
+    numericDerivativeNorm += numericDerivative[i] * numericDerivative[i];
+  }
+  numericDerivativeNorm = sqrt(numericDerivativeNorm);
+  optimizer->SetIsotropicPixelSpacing(originalIsotropicPixelSpacing);
+
+  int numberOfFailures = 0;
+  for (unsigned int i = 0; i < parameters.size(); i++)
+  {
+    double difference = fabs(analyticDerivative[i] - numericDerivative[i]);
+    LOG_DEBUG("Parameter " << i << " derivative: analytic=" << analyticDerivative[i] << ", numeric=" << numericDerivative[i]);
+    if (difference > gradientErrorThreshold * std::max(1.0, numericDerivativeNorm))
+    {
+      LOG_ERROR("Analytic derivative of the cost with respect to parameter " << i << " of " << parameters.size() << " is " << analyticDerivative[i]
+                << ", finite difference derivative is " << numericDerivative[i]);
+      numberOfFailures++;
+    }
+  }
+  return numberOfFailures;
+}
+
+//-------------------------------------------------------
+PlusStatus CalibrateWithMinimizer(vtkPlusProbeCalibrationAlgo* probeCalibration, vtkPlusProbeCalibrationOptimizerAlgo::MinimizerType minimizer,
+                                  vtkPlusTrackedFrameList* validationTrackedFrameList, vtkPlusTrackedFrameList* calibrationTrackedFrameList,
+                                  vtkPlusTransformRepository* transformRepository, const std::vector<PlusNWire>& nWires, vnl_matrix_fixed<double,4,4>& imageToProbeMatrix)
+{
+  LOG_INFO("Calibrate with " << vtkPlusProbeCalibrationOptimizerAlgo::GetMinimizerAsString(minimizer) << " minimizer...");
+  probeCalibration->GetOptimizer()->SetMinimizer(minimizer);
+  if (probeCalibration->Calibrate(validationTrackedFrameList, calibrationTrackedFrameList, transformRepository, nWires) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Calibration with " << vtkPlusProbeCalibrationOptimizerAlgo::GetMinimizerAsString(minimizer) << " minimizer failed!");
+    return PLUS_FAIL;
+  }
+  vtkSmartPointer<vtkMatrix4x4> imageToProbeMatrixVtk = vtkSmartPointer<vtkMatrix4x4>::New();
+  probeCalibration->GetImageToProbeTransformMatrix(imageToProbeMatrixVtk);
+  PlusMath::ConvertVtkMatrixToVnlMatrix(imageToProbeMatrixVtk, imageToProbeMatrix);
+  return PLUS_SUCCESS;
+}
+
+//-------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp = false;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+  std::string inputConfigFileName;
+  std::string inputCalibrationSeqMetafile;
+  std::string inputValidationSeqMetafile;
+  double gradientErrorThreshold = 1e-3;
+  double translationErrorThreshold = 0.5; // mm
+  double rotationErrorThreshold = 0.5; // deg
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputConfigFileName, "Configuration file name");
+  args.AddArgument("--calibration-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputCalibrationSeqMetafile, "Sequence metafile name of input calibration dataset.");
+  args.AddArgument("--validation-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputValidationSeqMetafile, "Sequence metafile name of input validation dataset. Optional, if not specified then the calibration dataset is used for validation.");
+  args.AddArgument("--gradient-error-threshold", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &gradientErrorThreshold, "Maximum difference between the analytic and finite difference derivatives, relative to the norm of the gradient.");
+  args.AddArgument("--translation-error-threshold", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &translationErrorThreshold, "Maximum translation difference between the LBFGS and Powell results in mm.");
+  args.AddArgument("--rotation-error-threshold", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &rotationErrorThreshold, "Maximum rotation difference between the LBFGS and Powell results in degrees.");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (inputConfigFileName.empty() || inputCalibrationSeqMetafile.empty())
+  {
+    LOG_ERROR("--config-file and --calibration-seq-file must be specified");
+    return EXIT_FAILURE;
+  }
+
+  // Read configuration
+  vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::New();
+  if (PlusXmlUtils::ReadDeviceSetConfigurationFromFile(configRootElement, inputConfigFileName.c_str()) == PLUS_FAIL)
+  {
+    LOG_ERROR("Unable to read configuration from file " << inputConfigFileName.c_str());
+    return EXIT_FAILURE;
+  }
+  vtkPlusConfig::GetInstance()->SetDeviceSetConfigurationData(configRootElement);
+
+  vtkSmartPointer<vtkPlusTransformRepository> transformRepository = vtkSmartPointer<vtkPlusTransformRepository>::New();
+  if (transformRepository->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read CoordinateDefinitions!");
+    return EXIT_FAILURE;
+  }
+
+  vtkSmartPointer<vtkPlusProbeCalibrationAlgo> probeCalibration = vtkSmartPointer<vtkPlusProbeCalibrationAlgo>::New();
+  probeCalibration->ReadConfiguration(configRootElement);
+  vtkPlusProbeCalibrationOptimizerAlgo* optimizer = probeCalibration->GetOptimizer();
+  if (!optimizer->Enabled())
+  {
+    LOG_INFO("Optimization is not enabled in the configuration, use the 2D cost function");
+    optimizer->SetOptimizationMethod(vtkPlusProbeCalibrationOptimizerAlgo::MINIMIZE_DISTANCE_OF_ALL_WIRES_IN_2D);
+  }
+
+  PlusFidPatternRecognition patternRecognition;
+  PlusFidPatternRecognition::PatternRecognitionError error;
+  patternRecognition.ReadConfiguration(configRootElement);
+
+  // Load and segment the images
+  vtkSmartPointer<vtkPlusTrackedFrameList> calibrationTrackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (vtkPlusSequenceIO::Read(inputCalibrationSeqMetafile, calibrationTrackedFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Reading calibration images from '" << inputCalibrationSeqMetafile << "' failed!");
+    return EXIT_FAILURE;
+  }
+  if (patternRecognition.RecognizePattern(calibrationTrackedFrameList, error) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Error occured during segmentation of calibration images!");
+    return EXIT_FAILURE;
+  }
+
+  vtkSmartPointer<vtkPlusTrackedFrameList> validationTrackedFrameList = calibrationTrackedFrameList;
+  if (!inputValidationSeqMetafile.empty())
+  {
+    validationTrackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    if (vtkPlusSequenceIO::Read(inputValidationSeqMetafile, validationTrackedFrameList) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Reading validation images from '" << inputValidationSeqMetafile << "' failed!");
+      return EXIT_FAILURE;
+    }
+    if (patternRecognition.RecognizePattern(validationTrackedFrameList, error) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Error occured during segmentation of validation images!");
+      return EXIT_FAILURE;
+    }
+  }
+
+  const std::vector<PlusNWire>& nWires = patternRecognition.GetFidLineFinder()->GetNWires();
+
+  // Baseline: Powell minimizer
+  vnl_matrix_fixed<double,4,4> powellImageToProbeMatrix;
+  if (CalibrateWithMinimizer(probeCalibration, vtkPlusProbeCalibrationOptimizerAlgo::MINIMIZER_POWELL, validationTrackedFrameList, calibrationTrackedFrameList,
+                             transformRepository, nWires, powellImageToProbeMatrix) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  int numberOfFailures = 0;
+
+  // Analytic derivative of the cost function (uses the calibration data of the last calibration)
+  LOG_INFO("Compare analytic derivative with finite differences...");
+  numberOfFailures += CompareGradientWithFiniteDifferences(optimizer, powellImageToProbeMatrix, true, gradientErrorThreshold);
+  numberOfFailures += CompareGradientWithFiniteDifferences(optimizer, powellImageToProbeMatrix, false, gradientErrorThreshold);
+
+  // LBFGS minimizer must converge to the same result
+  vnl_matrix_fixed<double,4,4> lbfgsImageToProbeMatrix;
+  if (CalibrateWithMinimizer(probeCalibration, vtkPlusProbeCalibrationOptimizerAlgo::MINIMIZER_LBFGS, validationTrackedFrameList, calibrationTrackedFrameList,
+                             transformRepository, nWires, lbfgsImageToProbeMatrix) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  vtkSmartPointer<vtkMatrix4x4> powellImageToProbeMatrixVtk = vtkSmartPointer<vtkMatrix4x4>::New();
+  vtkSmartPointer<vtkMatrix4x4> lbfgsImageToProbeMatrixVtk = vtkSmartPointer<vtkMatrix4x4>::New();
+  PlusMath::ConvertVnlMatrixToVtkMatrix(powellImageToProbeMatrix, powellImageToProbeMatrixVtk);
+  PlusMath::ConvertVnlMatrixToVtkMatrix(lbfgsImageToProbeMatrix, lbfgsImageToProbeMatrixVtk);
+  double translationDifference = PlusMath::GetPositionDifference(powellImageToProbeMatrixVtk, lbfgsImageToProbeMatrixVtk);
+  double rotationDifference = PlusMath::GetOrientationDifference(powellImageToProbeMatrixVtk, lbfgsImageToProbeMatrixVtk);
+  LOG_INFO("Difference between LBFGS and Powell results: translation=" << translationDifference << " mm, rotation=" << rotationDifference << " deg");
+  if (translationDifference > translationErrorThreshold)
+  {
+    LOG_ERROR("Translation difference between LBFGS and Powell results is " << translationDifference << " mm (threshold: " << translationErrorThreshold << " mm)");
+    numberOfFailures++;
+  }
+  if (rotationDifference > rotationErrorThreshold)
+  {
+    LOG_ERROR("Rotation difference between LBFGS and Powell results is " << rotationDifference << " deg (threshold: " << rotationErrorThreshold << " deg)");
+    numberOfFailures++;
+  }
+
+  if (numberOfFailures > 0)
+  {
+    LOG_ERROR("Test failed with " << numberOfFailures << " failures");
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -18,6 +18,7 @@ compares the results to a baseline
 #include "vtkCommand.h"
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
+#include "vtkPlusAccurateTimer.h"
 #include "vtkPlusProbeCalibrationAlgo.h"
 #include "vtkPlusSequenceIO.h"
 #include "vtkSmartPointer.h"
@@ -29,6 +30,7 @@ compares the results to a baseline
 #include "vtkXMLUtilities.h"
 #include "vtksys/CommandLineArguments.hxx" 
 #include "vtksys/SystemTools.hxx"
+#include <algorithm>
 #include <iostream>
 #include <stdlib.h>
 
@@ -39,6 +41,7 @@ const double ERROR_THRESHOLD = 0.05;
 #endif
 
 int CompareCalibrationResultsWithBaseline(const char* baselineFileName, const char* currentResultFileName, double translationErrorThreshold, double rotationErrorThreshold); 
+PlusStatus RunIncrementalCalibration(vtkPlusProbeCalibrationAlgo* freehandCalibration, vtkPlusTrackedFrameList* calibrationTrackedFrameList, vtkPlusTransformRepository* transformRepository, const std::vector<PlusNWire>& nWires, vtkMatrix4x4* imageToProbeMatrix);
 
 int main (int argc, char* argv[])
 {
@@ -50,6 +53,7 @@ int main (int argc, char* argv[])
   std::string inputConfigFileName;
   std::string inputBaselineFileName;
   std::string resultConfigFileName;
+  bool incremental(false);
 
 #ifndef _WIN32
   double inputTranslationErrorThreshold(LINUXTOLERANCE*2); // *PE* methods on linux can have up to about 0.7mm translation error
@@ -76,6 +80,7 @@ int main (int argc, char* argv[])
   args.AddArgument("--rotation-error-threshold", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputRotationErrorThreshold, "Rotation error threshold in degrees. Used for baseline comparison.");  
 
   args.AddArgument("--output-config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &resultConfigFileName, "Result configuration file name. Optional.");
+  args.AddArgument("--incremental", vtksys::CommandLineArguments::NO_ARGUMENT, &incremental, "Add the calibration frames one by one to the incremental calibration before the calibration and check that the calibration computed from the added frames is the same as the calibration result.");
 
   args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");  
 
@@ -139,6 +144,16 @@ int main (int argc, char* argv[])
 
   LOG_INFO("Segmentation success rate of calibration images: " << numberOfSuccessfullySegmentedCalibrationImages << " out of " << calibrationTrackedFrameList->GetNumberOfTrackedFrames());
 
+  vtkSmartPointer<vtkMatrix4x4> incrementalImageToProbeMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  if (incremental)
+  {
+    if (RunIncrementalCalibration(freehandCalibration, calibrationTrackedFrameList, transformRepository, patternRecognition.GetFidLineFinder()->GetNWires(), incrementalImageToProbeMatrix) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Incremental calibration failed!");
+      return EXIT_FAILURE;
+    }
+  }
+
   if (!inputValidationSeqMetafile.empty())
   {
     // Load and segment validation image
@@ -180,6 +195,25 @@ int main (int argc, char* argv[])
     }
   }
 
+  if (incremental)
+  {
+    // The calibration computed from the incrementally added frames must be the same as the calibration from the frame list
+    vtkSmartPointer<vtkMatrix4x4> imageToProbeMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    freehandCalibration->GetImageToProbeTransformMatrix(imageToProbeMatrix);
+    for (int row = 0; row < 4; ++row)
+    {
+      for (int column = 0; column < 4; ++column)
+      {
+        if (fabs(imageToProbeMatrix->GetElement(row, column) - incrementalImageToProbeMatrix->GetElement(row, column)) > 1e-6)
+        {
+          LOG_ERROR("Calibration from incrementally added frames differs from the calibration result at element (" << row << ", " << column << "): "
+            << incrementalImageToProbeMatrix->GetElement(row, column) << " instead of " << imageToProbeMatrix->GetElement(row, column));
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+
   // Save result to configuration file
   if (!resultConfigFileName.empty())
   {
@@ -995,3 +1029,47 @@ int CompareCalibrationResultsWithBaseline(const char* baselineFileName, const ch
 
   return numberOfFailures;
 }
+
+//-------------------------------------------------------------------------------------------------
+PlusStatus RunIncrementalCalibration(vtkPlusProbeCalibrationAlgo* freehandCalibration, vtkPlusTrackedFrameList* calibrationTrackedFrameList, vtkPlusTransformRepository* transformRepository, const std::vector<PlusNWire>& nWires, vtkMatrix4x4* imageToProbeMatrix)
+{
+  LOG_INFO("Incremental calibration...");
+  freehandCalibration->StartIncrementalCalibration(nWires);
+  const int progressReportFrameInterval = 20;
+  double maxFrameProcessingTimeSec = 0;
+  for (unsigned int frameIndex = 0; frameIndex < calibrationTrackedFrameList->GetNumberOfTrackedFrames(); ++frameIndex)
+  {
+    double startTimeSec = vtkPlusAccurateTimer::GetSystemTime();
+    if (freehandCalibration->AddIncrementalCalibrationFrame(calibrationTrackedFrameList->GetTrackedFrame(frameIndex), transformRepository) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frame #" << frameIndex << " to the incremental calibration");
+      return PLUS_FAIL;
+    }
+    maxFrameProcessingTimeSec = std::max(maxFrameProcessingTimeSec, vtkPlusAccurateTimer::GetSystemTime() - startTimeSec);
+    if ((frameIndex + 1) % progressReportFrameInterval == 0 && freehandCalibration->GetIncrementalReprojectionError3DRms() >= 0)
+    {
+      LOG_INFO("Incremental calibration estimate after " << freehandCalibration->GetNumberOfIncrementalCalibrationFrames() << " frames: 3D reprojection error RMS = "
+        << freehandCalibration->GetIncrementalReprojectionError3DRms() << "mm");
+    }
+  }
+  LOG_INFO("Maximum incremental calibration frame processing time: " << maxFrameProcessingTimeSec * 1000.0 << "ms");
+
+  vtkSmartPointer<vtkMatrix4x4> incrementalEstimateMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  if (freehandCalibration->GetIncrementalImageToProbeTransformMatrix(incrementalEstimateMatrix) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Incremental calibration estimate is not available after " << freehandCalibration->GetNumberOfIncrementalCalibrationFrames() << " frames");
+    return PLUS_FAIL;
+  }
+  LOG_INFO("Incremental image to probe transform estimate (3D reprojection error RMS = " << freehandCalibration->GetIncrementalReprojectionError3DRms() << "mm):");
+  PlusMath::LogVtkMatrix(incrementalEstimateMatrix, 6);
+
+  // Full calibration from the added frames
+  if (freehandCalibration->CalibrateFromIncrementalFrames(transformRepository) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Calibration from the incrementally added frames failed");
+    return PLUS_FAIL;
+  }
+  freehandCalibration->GetImageToProbeTransformMatrix(imageToProbeMatrix);
+
+  return PLUS_SUCCESS;
+}
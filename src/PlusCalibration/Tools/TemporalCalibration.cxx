@@ -20,6 +20,7 @@ See License.txt for details.
 // Local includes
 #include "PlusConfigure.h"
 #include "PlusTrackedFrame.h"
+#include "vtkPlusAccurateTimer.h"
 #include "vtkPlusSequenceIO.h"
 #include "vtkPlusTemporalCalibrationAlgo.h"
 #include "vtkPlusTrackedFrameList.h"
@@ -176,6 +177,74 @@ int CompareCalibrationResults(const TemporalCalibrationResult& calibResult, cons
   return numberOfFailures;
 }
 
+//----------------------------------------------------------------------------
+/*! Add the frames of the list that have a timestamp in the (startTime, stopTime] range to the output list */
+void GetFramesInTimeRange(vtkPlusTrackedFrameList* frameList, double startTime, double stopTime, vtkPlusTrackedFrameList* outputFrameList)
+{
+  outputFrameList->Clear();
+  for (unsigned int i = 0; i < frameList->GetNumberOfTrackedFrames(); ++i)
+  {
+    PlusTrackedFrame* trackedFrame = frameList->GetTrackedFrame(i);
+    if (trackedFrame->GetTimestamp() > startTime && trackedFrame->GetTimestamp() <= stopTime)
+    {
+      outputFrameList->AddTrackedFrame(trackedFrame, vtkPlusTrackedFrameList::ADD_INVALID_FRAME);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+/*! Compute the lag by adding the frames in small batches, the same way as they would be added during acquisition */
+PlusStatus RunStreamingCalibration(vtkPlusTemporalCalibrationAlgo* temporalCalibration, vtkPlusTrackedFrameList* fixedFrames, vtkPlusTemporalCalibrationAlgo::FRAME_TYPE fixedType,
+                                   vtkPlusTrackedFrameList* movingFrames, vtkPlusTemporalCalibrationAlgo::FRAME_TYPE movingType, double acquisitionPeriodSec,
+                                   vtkPlusTemporalCalibrationAlgo::TEMPORAL_CALIBRATION_ERROR& error)
+{
+  if (fixedFrames->GetNumberOfTrackedFrames() == 0 || movingFrames->GetNumberOfTrackedFrames() == 0)
+  {
+    LOG_ERROR("Fixed and moving frames are required for streaming temporal calibration");
+    return PLUS_FAIL;
+  }
+  if (temporalCalibration->StartStreaming(fixedType, movingType) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  double startTime = std::min(fixedFrames->GetTrackedFrame(0)->GetTimestamp(), movingFrames->GetTrackedFrame(0)->GetTimestamp()) - acquisitionPeriodSec;
+  double stopTime = std::max(fixedFrames->GetMostRecentTimestamp(), movingFrames->GetMostRecentTimestamp());
+  vtkSmartPointer<vtkPlusTrackedFrameList> newFrames = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  double previousLagSec = 0;
+  bool previousLagValid = false;
+  for (double acquisitionTime = startTime; acquisitionTime < stopTime; acquisitionTime += acquisitionPeriodSec)
+  {
+    GetFramesInTimeRange(fixedFrames, acquisitionTime, acquisitionTime + acquisitionPeriodSec, newFrames);
+    if (temporalCalibration->AddFixedFrames(newFrames) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    GetFramesInTimeRange(movingFrames, acquisitionTime, acquisitionTime + acquisitionPeriodSec, newFrames);
+    if (temporalCalibration->AddMovingFrames(newFrames) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    double lagSec = 0;
+    double confidence = 0;
+    if (temporalCalibration->GetRunningMovingLagSec(lagSec, confidence) == PLUS_SUCCESS && (!previousLagValid || lagSec != previousLagSec))
+    {
+      LOG_INFO("Running lag estimate at " << acquisitionTime + acquisitionPeriodSec - startTime << " sec: " << lagSec << " sec (confidence: " << confidence << ")");
+      previousLagSec = lagSec;
+      previousLagValid = true;
+    }
+  }
+
+  double stopStreamingStartTime = vtkPlusAccurateTimer::GetSystemTime();
+  if (temporalCalibration->StopStreaming(error) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  LOG_INFO("Lag computed in " << (vtkPlusAccurateTimer::GetSystemTime() - stopStreamingStartTime) * 1000.0 << " ms after the acquisition was stopped");
+  return PLUS_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 int main(int argc, char** argv)
 {
@@ -193,6 +262,8 @@ int main(int argc, char** argv)
   std::vector<int> clipRectOrigin;
   std::vector<int> clipRectSize;
   std::string inputBaselineFileName;
+  bool streaming(false);
+  double streamingAcquisitionPeriodSec = 0.1;
 
   vtksys::CommandLineArguments args;
   args.Initialize(argc, argv);
@@ -211,6 +282,8 @@ int main(int argc, char** argv)
   args.AddArgument("--clip-rect-origin", vtksys::CommandLineArguments::MULTI_ARGUMENT, &clipRectOrigin, "Origin of the clipping rectangle");
   args.AddArgument("--clip-rect-size", vtksys::CommandLineArguments::MULTI_ARGUMENT, &clipRectSize, "Size of the clipping rectangle");
   args.AddArgument("--baseline-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputBaselineFileName, "Input xml baseline file name with path");
+  args.AddArgument("--streaming", vtksys::CommandLineArguments::NO_ARGUMENT, &streaming, "Add the frames in small batches, as during acquisition, and compute the lag incrementally");
+  args.AddArgument("--streaming-acquisition-period-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &streamingAcquisitionPeriodSec, "Time range of the frames that are added in one batch in streaming mode (default: 0.1 seconds)");
 
   if (!args.Parse())
   {
@@ -322,7 +395,20 @@ int main(int argc, char** argv)
   vtkPlusTemporalCalibrationAlgo::TEMPORAL_CALIBRATION_ERROR error(vtkPlusTemporalCalibrationAlgo::TEMPORAL_CALIBRATION_ERROR_NONE);
 
   //  Calculate the time-offset
-  if (testTemporalCalibrationObject->Update(error) != PLUS_SUCCESS)
+  if (streaming)
+  {
+    if (streamingAcquisitionPeriodSec <= 0)
+    {
+      LOG_ERROR("Invalid streaming acquisition period: " << streamingAcquisitionPeriodSec);
+      exit(EXIT_FAILURE);
+    }
+    if (RunStreamingCalibration(testTemporalCalibrationObject, fixedFrames, fixedType, movingFrames, movingType, streamingAcquisitionPeriodSec, error) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Cannot determine tracker lag, streaming temporal calibration failed");
+      exit(EXIT_FAILURE);
+    }
+  }
+  else if (testTemporalCalibrationObject->Update(error) != PLUS_SUCCESS)
   {
     LOG_ERROR("Cannot determine tracker lag, temporal calibration failed");
     exit(EXIT_FAILURE);
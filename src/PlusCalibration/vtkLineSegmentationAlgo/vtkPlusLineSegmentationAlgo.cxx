@@ -15,10 +15,8 @@ See License.txt for details.
 
 // ITK includes
 #include <itkBinaryThresholdImageFilter.h>
-#include <itkImageDuplicator.h>
 #include <itkImageFileWriter.h>
 #include <itkImageRegionIterator.h>
-#include <itkLineIterator.h>
 #include <itkOtsuThresholdImageFilter.h>
 #include <itkRGBPixel.h>
 #include <itkResampleImageFilter.h>
@@ -29,6 +27,7 @@ See License.txt for details.
 #include <vtkContextScene.h>
 #include <vtkContextView.h>
 #include <vtkDoubleArray.h>
+#include <vtkImageData.h>
 #include <vtkIntArray.h>
 #include <vtkObjectFactory.h>
 #include <vtkPen.h>
@@ -39,6 +38,9 @@ See License.txt for details.
 #include <vtkRenderer.h>
 #include <vtkTable.h>
 
+// STL includes
+#include <algorithm>
+
 static const double INTESNITY_THRESHOLD_PERCENTAGE_OF_PEAK = 0.5; // threshold (as the percentage of the peak intensity along a scanline) for COG
 static const double MAX_CONSECUTIVE_INVALID_VIDEO_FRAMES = 10; // the maximum number of consecutive invalid frames before warning message issued
 static const double MAX_PERCENTAGE_OF_INVALID_VIDEO_FRAMES = 0.1; // the maximum percentage of the invalid frames before warning message issued
@@ -47,6 +49,8 @@ static const int MINIMUM_NUMBER_OF_VALID_SCANLINES = 5; // minimum number of val
 static const int NUMBER_OF_SCANLINES = 40; // number of scan-lines for line detection
 static const unsigned int DIMENSION = 2; // dimension of video frames (used for Ransac plane)
 static const double EXPECTED_LINE_SEGMENTATION_SUCCESS_RATE = 0.5; // log a warning if the actual line segmentation success rate (fraction of frames where the line segmentation was successful) is below this threshold
+static const double MAXIMAL_DISTANCE_FROM_LINE_PIX = 0.5; // maximum distance of a point from the line to agree with the line in RANSAC
+static const double RANSAC_DESIRED_PROBABILITY_FOR_NO_OUTLIERS = 0.999; // probability that at least one of the subsets selected by RANSAC doesn't contain an outlier
 
 enum PEAK_POS_METRIC_TYPE
 {
@@ -55,6 +59,37 @@ enum PEAK_POS_METRIC_TYPE
 };
 const PEAK_POS_METRIC_TYPE PEAK_POS_METRIC = PEAK_POS_COG;
 
+typedef itk::PlaneParametersEstimator<DIMENSION> PlaneEstimatorType;
+typedef itk::RANSAC<itk::Point<double, DIMENSION>, double> RANSACType;
+
+//----------------------------------------------------------------------------
+struct vtkPlusLineSegmentationAlgo::FrameSegmentationWorkspace
+{
+  FrameSegmentationWorkspace()
+    : PlaneEstimator(PlaneEstimatorType::New())
+    , RansacEstimator(RANSACType::New())
+  {
+    this->PlaneEstimator->SetDelta(MAXIMAL_DISTANCE_FROM_LINE_PIX);
+    this->RansacEstimator->SetParametersEstimator(this->PlaneEstimator.GetPointer());
+  }
+
+  std::vector<int> IntensityProfile;
+  std::vector<itk::Point<double, DIMENSION> > IntensityPeakPositions;
+  std::vector<double> LineModelParameters;
+  PlaneEstimatorType::Pointer PlaneEstimator;
+  RANSACType::Pointer RansacEstimator;
+};
+
+//----------------------------------------------------------------------------
+struct vtkPlusLineSegmentationAlgo::VideoPositionMetricThreadInfo
+{
+  vtkPlusLineSegmentationAlgo* Self;
+  /*! Frames that are in the signal time range */
+  std::vector<unsigned int> FrameNumbers;
+  /*! Signal value for each frame (only valid if the line was detected on the frame) */
+  std::vector<double> SignalValues;
+};
+
 vtkStandardNewMacro(vtkPlusLineSegmentationAlgo);
 
 //----------------------------------------------------------------------------
@@ -71,16 +106,26 @@ vtkPlusLineSegmentationAlgo::vtkPlusLineSegmentationAlgo()
   , PlotIntensityProfile(false)
   , m_SignalTimeRangeMin(0.0)
   , m_SignalTimeRangeMax(-1.0)
+  , NumberOfThreads(0)
+  , SingleFrameWorkspace(NULL)
 {
   m_ClipRectangleOrigin[0] = 0;
   m_ClipRectangleOrigin[1] = 0;
   m_ClipRectangleSize[0] = 0;
   m_ClipRectangleSize[1] = 0;
+  this->Threader = vtkMultiThreader::New();
 }
 
 //----------------------------------------------------------------------------
 vtkPlusLineSegmentationAlgo::~vtkPlusLineSegmentationAlgo()
 {
+  if (this->Threader)
+  {
+    this->Threader->Delete();
+    this->Threader = NULL;
+  }
+  delete this->SingleFrameWorkspace;
+  this->SingleFrameWorkspace = NULL;
 }
 
 //-----------------------------------------------------------------------------
@@ -193,204 +238,260 @@ PlusStatus vtkPlusLineSegmentationAlgo::ComputeVideoPositionMetric()
   nonDetectedLineParams.lineDirectionVector_Image[1] = 1;
   m_LineParameters.assign(m_TrackedFrameList->GetNumberOfTrackedFrames(), nonDetectedLineParams);
 
-  //  For each video frame, detect line and extract mindpoint and slope parameters
-  int numberOfSuccessfulLineSegmentations = 0;
+  VideoPositionMetricThreadInfo info;
+  info.Self = this;
+  info.SignalValues.assign(m_TrackedFrameList->GetNumberOfTrackedFrames(), 0.0);
+
+  // Collect the frames that are in the signal range
   bool signalTimeRangeDefined = (m_SignalTimeRangeMin <= m_SignalTimeRangeMax);
   for (unsigned int frameNumber = 0; frameNumber < m_TrackedFrameList->GetNumberOfTrackedFrames(); ++frameNumber)
   {
-    LOG_TRACE("Calculating video position metric for frame " << frameNumber);
     PlusTrackedFrame* trackedFrame = m_TrackedFrameList->GetTrackedFrame(frameNumber);
     if (signalTimeRangeDefined && (trackedFrame->GetTimestamp() < m_SignalTimeRangeMin || trackedFrame->GetTimestamp() > m_SignalTimeRangeMax))
     {
       // frame is out of the specified signal range
-      LOG_TRACE("Skip frame, it is out of the valid signal range");
+      LOG_TRACE("Skip frame " << frameNumber << ", it is out of the valid signal range");
       continue;
     }
+    info.FrameNumbers.push_back(frameNumber);
+  }
 
-    // Get current image
-    if (trackedFrame->GetImageData()->GetVTKScalarPixelType() != VTK_UNSIGNED_CHAR)
+  //  For each video frame, detect line and extract mindpoint and slope parameters
+  int numberOfThreads = (this->NumberOfThreads > 0 ? this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+  numberOfThreads = std::min(numberOfThreads, static_cast<int>(info.FrameNumbers.size()));
+  if (m_SaveIntermediateImages || this->PlotIntensityProfile)
+  {
+    // Intermediate image saving and intensity profile plotting are only used for debugging, process the frames in this thread
+    numberOfThreads = 1;
+  }
+  if (numberOfThreads > 1)
+  {
+    this->Threader->SetNumberOfThreads(numberOfThreads);
+    this->Threader->SetSingleMethod(VideoPositionMetricThreadFunction, &info);
+    this->Threader->SingleMethodExecute();
+  }
+  else
+  {
+    FrameSegmentationWorkspace workspace;
+    for (std::vector<unsigned int>::iterator frameNumberIt = info.FrameNumbers.begin(); frameNumberIt != info.FrameNumbers.end(); ++frameNumberIt)
     {
-      LOG_ERROR("vtkPlusLineSegmentationAlgo::ComputeVideoPositionMetric only supports 8-bit images");
-      continue;
+      ComputeFramePositionMetric(m_TrackedFrameList->GetTrackedFrame(*frameNumberIt), *frameNumberIt, workspace, m_LineParameters[*frameNumberIt], info.SignalValues[*frameNumberIt]);
     }
-    CharImageType::Pointer localImage = CharImageType::New();
-    PlusVideoFrame::DeepCopyVtkVolumeToItkImage<CharPixelType>(trackedFrame->GetImageData()->GetImage(), localImage);
-    if (localImage.IsNull())
+  }
+
+  // Store the results in frame order
+  int numberOfSuccessfulLineSegmentations = 0;
+  for (unsigned int frameNumber = 0; frameNumber < m_TrackedFrameList->GetNumberOfTrackedFrames(); ++frameNumber)
+  {
+    if (!m_LineParameters[frameNumber].lineDetected)
     {
-      // Dropped frame
-      LOG_ERROR("vtkPlusLineSegmentationAlgo::ComputeVideoPositionMetric failed to retrieve image data from frame");
       continue;
     }
+    ++numberOfSuccessfulLineSegmentations;
+    m_SignalValues.push_back(info.SignalValues[frameNumber]);
+    m_SignalTimestamps.push_back(m_TrackedFrameList->GetTrackedFrame(frameNumber)->GetTimestamp());
+  }
 
-    // Create an image duplicator to copy the original image
-    typedef itk::ImageDuplicator<CharImageType> DuplicatorType;
-    DuplicatorType::Pointer duplicator = DuplicatorType::New();
-    CharImageType::Pointer scanlineImage;
-    if (m_SaveIntermediateImages == true)
-    {
-      duplicator->SetInputImage(localImage);
-      duplicator->Update();
-
-      // Create an image copy to draw the scanlines on
-      scanlineImage = duplicator->GetOutput();
-    }
+  double segmentationSuccessRate = double(numberOfSuccessfulLineSegmentations) / m_TrackedFrameList->GetNumberOfTrackedFrames();
+  if (segmentationSuccessRate < EXPECTED_LINE_SEGMENTATION_SUCCESS_RATE)
+  {
+    LOG_WARNING("Line segmentation success rate is very low (" << segmentationSuccessRate * 100 << "%): a line could only be detected on " << numberOfSuccessfulLineSegmentations << " frames out of " << m_TrackedFrameList->GetNumberOfTrackedFrames());
+  }
 
-    std::vector<itk::Point<double, 2> > intensityPeakPositions;
-    CharImageType::RegionType region = localImage->GetLargestPossibleRegion();
-    LimitToClipRegion(region);
+  bool plotVideoMetric = vtkPlusLogger::Instance()->GetLogLevel() >= vtkPlusLogger::LOG_LEVEL_TRACE;
+  if (plotVideoMetric)
+  {
+    PlotDoubleArray(m_SignalValues);
+  }
 
-    int numOfValidScanlines = 0;
+  return PLUS_SUCCESS;
 
-    for (int currScanlineNum = 0; currScanlineNum < NUMBER_OF_SCANLINES; ++currScanlineNum)
-    {
-      // Set the scanline start pixel
-      CharImageType::IndexType startPixel;
-      double scanlineSpacingPix = static_cast<double>(region.GetSize()[0] - 1) / (NUMBER_OF_SCANLINES - 1);
-      startPixel[0] = region.GetIndex()[0] + scanlineSpacingPix * (currScanlineNum);
-      startPixel[1] = region.GetIndex()[1];
-
-      // Set the scanline end pixel
-      CharImageType::IndexType endPixel;
-      endPixel[0] = startPixel[0];
-      endPixel[1] = startPixel[1] + region.GetSize()[1] - 1;
-
-      std::deque<int> intensityProfile; // Holds intensity profile of the line
-      itk::LineIterator<CharImageType> it(localImage, startPixel, endPixel);
-      it.GoToBegin();
-
-      itk::LineIterator<CharImageType>* itScanlineImage = NULL;
-      if (m_SaveIntermediateImages == true)
-      {
-        // Iterator for the scanline image copy
-        // it's time-consuming to instantiate this iterator, so only do it if intermediate image saving is requested
-        itScanlineImage = new itk::LineIterator<CharImageType>(scanlineImage, startPixel, endPixel);
-        itScanlineImage->GoToBegin();
-      }
+} //  End LineDetection
 
-      while (!it.IsAtEnd())
-      {
-        intensityProfile.push_back((int)it.Get());
-        if (m_SaveIntermediateImages == true)
-        {
-          // Set the pixels on the scanline image copy to white
-          itScanlineImage->Set(255);
-          ++(*itScanlineImage);
-        }
-        ++it;
-      }
+//-----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPlusLineSegmentationAlgo::VideoPositionMetricThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  VideoPositionMetricThreadInfo* info = static_cast<VideoPositionMetricThreadInfo*>(threadInfo->UserData);
 
-      // Delete the iterator declared with new()
-      if (itScanlineImage != NULL)
-      {
-        delete itScanlineImage;
-        itScanlineImage = NULL;
-      }
+  // Frames are assigned to threads in a round-robin fashion, each thread writes the results of its own frames only
+  FrameSegmentationWorkspace workspace;
+  int numberOfFrames = info->FrameNumbers.size();
+  for (int i = threadInfo->ThreadID; i < numberOfFrames; i += threadInfo->NumberOfThreads)
+  {
+    unsigned int frameNumber = info->FrameNumbers[i];
+    info->Self->ComputeFramePositionMetric(info->Self->m_TrackedFrameList->GetTrackedFrame(frameNumber), frameNumber, workspace, info->Self->m_LineParameters[frameNumber], info->SignalValues[frameNumber]);
+  }
 
-      if (this->PlotIntensityProfile)
-      {
-        // Plot the intensity profile
-        PlotIntArray(intensityProfile);
-      }
+  return VTK_THREAD_RETURN_VALUE;
+}
 
-      // Find the max intensity value from the peak with the largest area
-      int maxFromLargestArea = -1;
-      int maxFromLargestAreaIndex = -1;
-      int startOfMaxArea = -1;
-      if (FindLargestPeak(intensityProfile, maxFromLargestArea, maxFromLargestAreaIndex, startOfMaxArea) == PLUS_SUCCESS)
-      {
-        double currPeakPos_y = -1;
-        switch (PEAK_POS_METRIC)
-        {
-        case PEAK_POS_COG:
-        {
-          /* Use center-of-gravity (COG) as peak-position metric*/
-          if (ComputeCenterOfGravity(intensityProfile, startOfMaxArea, currPeakPos_y) != PLUS_SUCCESS)
-          {
-            // unable to compute center-of-gravity; this scanline is invalid
-            continue;
-          }
-          break;
-        }
-        case PEAK_POS_START:
-        {
-          /* Use peak start as peak-position metric*/
-          if (FindPeakStart(intensityProfile, maxFromLargestArea, startOfMaxArea, currPeakPos_y) != PLUS_SUCCESS)
-          {
-            // unable to compute peak start; this scanline is invalid
-            continue;
-          }
-          break;
-        }
-        }
+//-----------------------------------------------------------------------------
+void vtkPlusLineSegmentationAlgo::ComputeFramePositionMetric(PlusTrackedFrame* trackedFrame, unsigned int frameNumber, FrameSegmentationWorkspace& workspace, LineParameters& lineParameters, double& signalValue)
+{
+  LOG_TRACE("Calculating video position metric for frame " << frameNumber);
 
-        itk::Point<double, 2> currPeakPos;
-        currPeakPos[0] = static_cast<double>(startPixel[0]);
-        currPeakPos[1] = startPixel[1] + currPeakPos_y;
-        intensityPeakPositions.push_back(currPeakPos);
-        ++numOfValidScanlines;
+  // Get current image
+  if (trackedFrame->GetImageData()->GetVTKScalarPixelType() != VTK_UNSIGNED_CHAR)
+  {
+    LOG_ERROR("vtkPlusLineSegmentationAlgo::ComputeVideoPositionMetric only supports 8-bit images");
+    return;
+  }
+  vtkImageData* image = trackedFrame->GetImageData()->GetImage();
+  if (image == NULL)
+  {
+    // Dropped frame
+    LOG_ERROR("vtkPlusLineSegmentationAlgo::ComputeVideoPositionMetric failed to retrieve image data from frame");
+    return;
+  }
 
-      } // end if() found intensity peak
+  // The scanlines are read directly from the frame buffer
+  int extent[6] = {0, 0, 0, 0, 0, 0};
+  image->GetExtent(extent);
+  vtkIdType increments[3] = {0, 0, 0};
+  image->GetIncrements(increments);
+  const CharPixelType* pixels = static_cast<const CharPixelType*>(image->GetScalarPointer(extent[0], extent[2], extent[4]));
+
+  CharImageType::RegionType region;
+  CharImageType::IndexType regionIndex;
+  regionIndex[0] = 0;
+  regionIndex[1] = 0;
+  CharImageType::SizeType regionSize;
+  regionSize[0] = extent[1] - extent[0] + 1;
+  regionSize[1] = extent[3] - extent[2] + 1;
+  region.SetIndex(regionIndex);
+  region.SetSize(regionSize);
+  LimitToClipRegion(region);
+
+  CharImageType::Pointer scanlineImage;
+  if (m_SaveIntermediateImages == true)
+  {
+    // Create an image copy to draw the scanlines on
+    scanlineImage = CharImageType::New();
+    PlusVideoFrame::DeepCopyVtkVolumeToItkImage<CharPixelType>(image, scanlineImage);
+  }
 
-    } // end currScanlineNum loop
+  workspace.IntensityPeakPositions.clear();
+  int numOfValidScanlines = 0;
 
-    if (numOfValidScanlines < MINIMUM_NUMBER_OF_VALID_SCANLINES)
+  double scanlineSpacingPix = static_cast<double>(region.GetSize()[0] - 1) / (NUMBER_OF_SCANLINES - 1);
+  for (int currScanlineNum = 0; currScanlineNum < NUMBER_OF_SCANLINES; ++currScanlineNum)
+  {
+    // Set the scanline start pixel
+    CharImageType::IndexType startPixel;
+    startPixel[0] = region.GetIndex()[0] + scanlineSpacingPix * (currScanlineNum);
+    startPixel[1] = region.GetIndex()[1];
+
+    // Set the scanline end pixel
+    CharImageType::IndexType endPixel;
+    endPixel[0] = startPixel[0];
+    endPixel[1] = startPixel[1] + region.GetSize()[1] - 1;
+
+    // Holds intensity profile of the line
+    std::vector<int>& intensityProfile = workspace.IntensityProfile;
+    intensityProfile.clear();
+    const CharPixelType* scanlinePixel = pixels + startPixel[0] * increments[0] + startPixel[1] * increments[1];
+    for (CharImageType::IndexValueType y = startPixel[1]; y <= endPixel[1]; ++y, scanlinePixel += increments[1])
     {
-      //TODO: drop the frame from the analysis
-      LOG_DEBUG("Only " << numOfValidScanlines << " valid scanlines; this is less than the required " << MINIMUM_NUMBER_OF_VALID_SCANLINES << ". Skipping frame" << frameNumber);
+      intensityProfile.push_back(static_cast<int>(*scanlinePixel));
     }
 
-    LineParameters params;
-    ComputeLineParameters(intensityPeakPositions, params);
-    if (!params.lineDetected)
+    if (m_SaveIntermediateImages == true)
     {
-      LOG_DEBUG("Unable to compute line parameters for frame " << frameNumber);
-      continue;
+      // Set the pixels on the scanline image copy to white
+      CharImageType::IndexType scanlineImagePixel = startPixel;
+      for (; scanlineImagePixel[1] <= endPixel[1]; ++scanlineImagePixel[1])
+      {
+        scanlineImage->SetPixel(scanlineImagePixel, 255);
+      }
     }
-    if (params.lineDirectionVector_Image[0] < MIN_X_SLOPE_COMPONENT_FOR_DETECTED_LINE)
+
+    if (this->PlotIntensityProfile)
     {
-      // Line is close to vertical, skip frame because intersection of
-      // line with image's horizontal half point is unstable
-      LOG_TRACE("Line on frame " << frameNumber << " is too close to vertical, skip the frame");
-      continue;
+      // Plot the intensity profile
+      PlotIntArray(intensityProfile);
     }
 
-    ++numberOfSuccessfulLineSegmentations;
-    m_LineParameters[frameNumber] = params;
-
-    // Store the y-value of the line, when the line's x-value is half of the image's width
-    double t = (region.GetIndex()[0] + 0.5 * region.GetSize()[0] - params.lineOriginPoint_Image[0]) / params.lineDirectionVector_Image[0];
-    m_SignalValues.push_back(std::abs(params.lineOriginPoint_Image[1] + t * params.lineDirectionVector_Image[1]));
+    // Find the max intensity value from the peak with the largest area
+    int maxFromLargestArea = -1;
+    int maxFromLargestAreaIndex = -1;
+    int startOfMaxArea = -1;
+    if (FindLargestPeak(intensityProfile, maxFromLargestArea, maxFromLargestAreaIndex, startOfMaxArea) == PLUS_SUCCESS)
+    {
+      double currPeakPos_y = -1;
+      switch (PEAK_POS_METRIC)
+      {
+      case PEAK_POS_COG:
+      {
+        /* Use center-of-gravity (COG) as peak-position metric*/
+        if (ComputeCenterOfGravity(intensityProfile, startOfMaxArea, currPeakPos_y) != PLUS_SUCCESS)
+        {
+          // unable to compute center-of-gravity; this scanline is invalid
+          continue;
+        }
+        break;
+      }
+      case PEAK_POS_START:
+      {
+        /* Use peak start as peak-position metric*/
+        if (FindPeakStart(intensityProfile, maxFromLargestArea, startOfMaxArea, currPeakPos_y) != PLUS_SUCCESS)
+        {
+          // unable to compute peak start; this scanline is invalid
+          continue;
+        }
+        break;
+      }
+      }
 
-    //  Store timestamp for image frame
-    m_SignalTimestamps.push_back(m_TrackedFrameList->GetTrackedFrame(frameNumber)->GetTimestamp());
+      itk::Point<double, 2> currPeakPos;
+      currPeakPos[0] = static_cast<double>(startPixel[0]);
+      currPeakPos[1] = startPixel[1] + currPeakPos_y;
+      workspace.IntensityPeakPositions.push_back(currPeakPos);
+      ++numOfValidScanlines;
 
-    if (m_SaveIntermediateImages == true)
-    {
-      SaveIntermediateImage(frameNumber, scanlineImage,
-                            params.lineOriginPoint_Image[0], params.lineOriginPoint_Image[1], params.lineDirectionVector_Image[0], params.lineDirectionVector_Image[1],
-                            numOfValidScanlines, intensityPeakPositions);
-    }
+    } // end if() found intensity peak
 
-  } // end frameNum loop
+  } // end currScanlineNum loop
 
-  double segmentationSuccessRate = double(numberOfSuccessfulLineSegmentations) / m_TrackedFrameList->GetNumberOfTrackedFrames();
-  if (segmentationSuccessRate < EXPECTED_LINE_SEGMENTATION_SUCCESS_RATE)
+  if (numOfValidScanlines < MINIMUM_NUMBER_OF_VALID_SCANLINES)
   {
-    LOG_WARNING("Line segmentation success rate is very low (" << segmentationSuccessRate * 100 << "%): a line could only be detected on " << numberOfSuccessfulLineSegmentations << " frames out of " << m_TrackedFrameList->GetNumberOfTrackedFrames());
+    //TODO: drop the frame from the analysis
+    LOG_DEBUG("Only " << numOfValidScanlines << " valid scanlines; this is less than the required " << MINIMUM_NUMBER_OF_VALID_SCANLINES << ". Skipping frame" << frameNumber);
   }
 
-  bool plotVideoMetric = vtkPlusLogger::Instance()->GetLogLevel() >= vtkPlusLogger::LOG_LEVEL_TRACE;
-  if (plotVideoMetric)
+  // The random number generator of RANSAC is seeded by the frame number, so that the result
+  // does not depend on which thread processes the frame
+  LineParameters params;
+  ComputeLineParameters(workspace, frameNumber, params);
+  if (!params.lineDetected)
   {
-    PlotDoubleArray(m_SignalValues);
+    LOG_DEBUG("Unable to compute line parameters for frame " << frameNumber);
+    return;
+  }
+  if (params.lineDirectionVector_Image[0] < MIN_X_SLOPE_COMPONENT_FOR_DETECTED_LINE)
+  {
+    // Line is close to vertical, skip frame because intersection of
+    // line with image's horizontal half point is unstable
+    LOG_TRACE("Line on frame " << frameNumber << " is too close to vertical, skip the frame");
+    return;
   }
 
-  return PLUS_SUCCESS;
+  lineParameters = params;
 
-} //  End LineDetection
+  // Store the y-value of the line, when the line's x-value is half of the image's width
+  double t = (region.GetIndex()[0] + 0.5 * region.GetSize()[0] - params.lineOriginPoint_Image[0]) / params.lineDirectionVector_Image[0];
+  signalValue = std::abs(params.lineOriginPoint_Image[1] + t * params.lineDirectionVector_Image[1]);
+
+  if (m_SaveIntermediateImages == true)
+  {
+    SaveIntermediateImage(frameNumber, scanlineImage,
+                          params.lineOriginPoint_Image[0], params.lineOriginPoint_Image[1], params.lineDirectionVector_Image[0], params.lineDirectionVector_Image[1],
+                          numOfValidScanlines, workspace.IntensityPeakPositions);
+  }
+}
 
 //-----------------------------------------------------------------------------
-PlusStatus vtkPlusLineSegmentationAlgo::FindPeakStart(std::deque<int>& intensityProfile, int maxFromLargestArea, int startOfMaxArea, double& startOfPeak)
+PlusStatus vtkPlusLineSegmentationAlgo::FindPeakStart(const std::vector<int>& intensityProfile, int maxFromLargestArea, int startOfMaxArea, double& startOfPeak)
 {
   // Start of peak is defined as the location at which it reaches 50% of its maximum value.
   double startPeakValue = maxFromLargestArea * 0.5;
@@ -408,7 +509,7 @@ PlusStatus vtkPlusLineSegmentationAlgo::FindPeakStart(std::deque<int>& intensity
 }
 
 //-----------------------------------------------------------------------------
-PlusStatus vtkPlusLineSegmentationAlgo::FindLargestPeak(std::deque<int>& intensityProfile, int& maxFromLargestArea, int& maxFromLargestAreaIndex, int& startOfMaxArea)
+PlusStatus vtkPlusLineSegmentationAlgo::FindLargestPeak(const std::vector<int>& intensityProfile, int& maxFromLargestArea, int& maxFromLargestAreaIndex, int& startOfMaxArea)
 {
   int currentLargestArea = 0;
   int currentArea = 0;
@@ -487,7 +588,7 @@ PlusStatus vtkPlusLineSegmentationAlgo::FindLargestPeak(std::deque<int>& intensi
 }
 //-----------------------------------------------------------------------------
 
-PlusStatus vtkPlusLineSegmentationAlgo::ComputeCenterOfGravity(std::deque<int>& intensityProfile, int startOfMaxArea, double& centerOfGravity)
+PlusStatus vtkPlusLineSegmentationAlgo::ComputeCenterOfGravity(const std::vector<int>& intensityProfile, int startOfMaxArea, double& centerOfGravity)
 {
   if (intensityProfile.size() == 0)
   {
@@ -526,49 +627,34 @@ PlusStatus vtkPlusLineSegmentationAlgo::ComputeCenterOfGravity(std::deque<int>&
 }
 
 //-----------------------------------------------------------------------------
-void vtkPlusLineSegmentationAlgo::ComputeLineParameters(std::vector<itk::Point<double, 2> >& data, LineParameters& outputParameters)
+void vtkPlusLineSegmentationAlgo::ComputeLineParameters(FrameSegmentationWorkspace& workspace, unsigned int randomSeed, LineParameters& outputParameters)
 {
   outputParameters.lineDetected = false;
 
-  std::vector<double> ransacParameterResult;
-  typedef itk::PlaneParametersEstimator<DIMENSION> PlaneEstimatorType;
-  typedef itk::RANSAC<itk::Point<double, DIMENSION>, double> RANSACType;
+  std::vector<itk::Point<double, DIMENSION> >& data = workspace.IntensityPeakPositions;
+  std::vector<double>& ransacParameterResult = workspace.LineModelParameters;
 
-  //create and initialize the parameter estimator
-  double maximalDistanceFromPlane = 0.5;
-  PlaneEstimatorType::Pointer planeEstimator = PlaneEstimatorType::New();
-  planeEstimator->SetDelta(maximalDistanceFromPlane);
-  planeEstimator->LeastSquaresEstimate(data, ransacParameterResult);
-  if (ransacParameterResult.empty())
+  if (vtkPlusLogger::Instance()->GetLogLevel() >= vtkPlusLogger::LOG_LEVEL_TRACE)
   {
-    LOG_DEBUG("Unable to fit line through points with least squares estimation");
-  }
-  else
-  {
-    LOG_TRACE("Least squares line parameters (n, a):");
-    for (unsigned int i = 0; i < (2 * DIMENSION - 1); i++)
+    // The least squares estimate is only computed for logging, RANSAC computes its own estimate
+    workspace.PlaneEstimator->LeastSquaresEstimate(data, ransacParameterResult);
+    if (ransacParameterResult.empty())
     {
-      LOG_TRACE(" LS parameter: " << ransacParameterResult[i]);
+      LOG_DEBUG("Unable to fit line through points with least squares estimation");
+    }
+    else
+    {
+      LOG_TRACE("Least squares line parameters (n, a):");
+      for (unsigned int i = 0; i < (2 * DIMENSION - 1); i++)
+      {
+        LOG_TRACE(" LS parameter: " << ransacParameterResult[i]);
+      }
     }
-  }
-
-  //create and initialize the RANSAC algorithm
-  double desiredProbabilityForNoOutliers = 0.999;
-  RANSACType::Pointer ransacEstimator = RANSACType::New();
-
-  try
-  {
-    ransacEstimator->SetData(data);
-  }
-  catch (std::exception& e)
-  {
-    LOG_DEBUG(e.what());
-    return;
   }
 
   try
   {
-    ransacEstimator->SetParametersEstimator(planeEstimator.GetPointer());
+    workspace.RansacEstimator->SetData(data);
   }
   catch (std::exception& e)
   {
@@ -576,10 +662,10 @@ void vtkPlusLineSegmentationAlgo::ComputeLineParameters(std::vector<itk::Point<d
     return;
   }
 
-
+  workspace.RansacEstimator->SetRandomSeed(randomSeed);
   try
   {
-    ransacEstimator->Compute(ransacParameterResult, desiredProbabilityForNoOutliers);
+    workspace.RansacEstimator->Compute(ransacParameterResult, RANSAC_DESIRED_PROBABILITY_FOR_NO_OUTLIERS);
   }
   catch (std::exception& e)
   {
@@ -729,7 +815,7 @@ PlusStatus vtkPlusLineSegmentationAlgo::Update()
 }
 
 //-----------------------------------------------------------------------------
-void vtkPlusLineSegmentationAlgo::PlotIntArray(const std::deque<int>& intensityValues)
+void vtkPlusLineSegmentationAlgo::PlotIntArray(const std::vector<int>& intensityValues)
 {
   //  Create table
   vtkSmartPointer<vtkTable> table = vtkSmartPointer<vtkTable>::New();
@@ -828,6 +914,35 @@ void vtkPlusLineSegmentationAlgo::GetDetectedPositions(std::deque<double>& posit
   positions = m_SignalValues;
 }
 
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusLineSegmentationAlgo::DetectLine(PlusTrackedFrame& trackedFrame, unsigned int frameNumber, LineParameters& lineParameters, double& position)
+{
+  lineParameters.lineDetected = false;
+  lineParameters.lineOriginPoint_Image[0] = 0;
+  lineParameters.lineOriginPoint_Image[1] = 0;
+  lineParameters.lineDirectionVector_Image[0] = 0;
+  lineParameters.lineDirectionVector_Image[1] = 1;
+  position = 0.0;
+
+  if (!trackedFrame.GetImageData()->IsImageValid())
+  {
+    LOG_DEBUG("Skip frame " << frameNumber << ", it does not contain valid image data");
+    return PLUS_FAIL;
+  }
+  if (trackedFrame.GetImageData()->GetImageOrientation() != US_IMG_ORIENT_MF || trackedFrame.GetImageData()->GetImageType() != US_IMG_BRIGHTNESS)
+  {
+    LOG_ERROR("vtkPlusLineSegmentationAlgo video input data verification failed: video data orientation or type is not supported (MF orientation, BRIGHTNESS type is expected)");
+    return PLUS_FAIL;
+  }
+
+  if (this->SingleFrameWorkspace == NULL)
+  {
+    this->SingleFrameWorkspace = new FrameSegmentationWorkspace;
+  }
+  ComputeFramePositionMetric(&trackedFrame, frameNumber, *this->SingleFrameWorkspace, lineParameters, position);
+  return lineParameters.lineDetected ? PLUS_SUCCESS : PLUS_FAIL;
+}
+
 //-----------------------------------------------------------------------------
 void vtkPlusLineSegmentationAlgo::GetDetectedLineParameters(std::vector<LineParameters>& parameters)
 {
@@ -916,6 +1031,7 @@ PlusStatus vtkPlusLineSegmentationAlgo::ReadConfiguration(vtkXMLDataElement* aCo
 
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(SaveIntermediateImages, lineSegmentationElement);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(PlotIntensityProfile, lineSegmentationElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, NumberOfThreads, lineSegmentationElement);
 
   this->IntermediateFilesOutputDirectory = vtkPlusConfig::GetInstance()->GetOutputDirectory();
   XML_READ_CSTRING_ATTRIBUTE_OPTIONAL(IntermediateFilesOutputDirectory, lineSegmentationElement);
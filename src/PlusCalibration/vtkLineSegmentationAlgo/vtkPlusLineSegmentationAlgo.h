@@ -9,8 +9,10 @@
 
 #include "itkImage.h"
 #include "vtkPlusCalibrationExport.h"
+#include "vtkMultiThreader.h"
 #include "vtkObject.h"
 #include <deque>
+#include <vector>
 
 class PlusTrackedFrame;
 class vtkPlusTrackedFrameList;
@@ -18,6 +20,10 @@ class vtkPlusTrackedFrameList;
 /*!
   \class vtkPlusLineSegmentationAlgo
   \brief Detect the position of a line (image of a plane) in an US image sequence.
+
+  Frames are processed in parallel. The line fitting on each frame uses a random number generator
+  that is seeded by the frame index, therefore the result does not depend on the number of threads.
+
   \ingroup PlusLibCalibrationAlgorithm
 */
 class vtkPlusCalibrationExport vtkPlusLineSegmentationAlgo : public vtkObject
@@ -70,6 +76,17 @@ public:
   /*! Get the parameters of the plane where a line was successfully detected. No frames are skipped, the size of the vector matches the number of input tracked frames. If line detection failed on an image then the lineDetected parameter of the item is set to false. */
   void GetDetectedLineParameters(std::vector<LineParameters>& parameters);
 
+  /*!
+    Detect the line on a single frame, for processing frames one by one as they are acquired.
+    The input frame list and the detected signal of Update() are not used or modified.
+    \param trackedFrame Frame to process (MF orientation, BRIGHTNESS type, 8-bit image)
+    \param frameNumber Index of the frame in the acquired sequence, used for seeding the line fitting
+    \param lineParameters Detected line parameters
+    \param position Line position in the middle of the clip region
+    \return PLUS_FAIL if the line cannot be detected on the frame
+  */
+  PlusStatus DetectLine(PlusTrackedFrame& trackedFrame, unsigned int frameNumber, LineParameters& lineParameters, double& position);
+
   /*! Enable/disable saving of intermediate images for debugging */
   void SetSaveIntermediateImages(bool saveIntermediateImages);
 
@@ -81,6 +98,11 @@ public:
   vtkGetMacro(PlotIntensityProfile, bool);
   vtkSetMacro(PlotIntensityProfile, bool);
 
+  /*! Set the number of threads used for processing the frames (0 means the default number of threads is used) */
+  vtkSetMacro(NumberOfThreads, int);
+  /*! Get the number of threads used for processing the frames */
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkPlusLineSegmentationAlgo();
   virtual ~vtkPlusLineSegmentationAlgo();
@@ -89,15 +111,35 @@ protected:
 
   PlusStatus ComputeVideoPositionMetric();
 
-  PlusStatus FindPeakStart(std::deque<int>& intensityProfile, int maxFromLargestArea, int startOfMaxArea, double& startOfPeak);
+  /*! Buffers and line fitting objects that are reused between frames (each thread has its own) */
+  struct FrameSegmentationWorkspace;
 
-  PlusStatus FindLargestPeak(std::deque<int>& intensityProfile, int& maxFromLargestArea, int& maxFromLargestAreaIndex, int& startOfMaxArea);
+  /*! Input and output of VideoPositionMetricThreadFunction */
+  struct VideoPositionMetricThreadInfo;
 
-  PlusStatus ComputeCenterOfGravity(std::deque<int>& intensityProfile, int startOfMaxArea, double& centerOfGravity);
+  /*! Thread function that computes the line parameters for a subset of the frames */
+  static VTK_THREAD_RETURN_TYPE VideoPositionMetricThreadFunction(void* arg);
 
-  void ComputeLineParameters(std::vector<itk::Point<double, 2> >& data, LineParameters& outputParameters);
+  /*!
+    Detect the line on a single frame
+    \param trackedFrame Frame to process
+    \param frameNumber Index of the frame, used for seeding the line fitting and naming intermediate images
+    \param workspace Buffers and line fitting objects, only used by one thread at a time
+    \param lineParameters Detected line parameters (lineDetected is false if the line cannot be detected)
+    \param signalValue Line position in the middle of the clip region
+  */
+  void ComputeFramePositionMetric(PlusTrackedFrame* trackedFrame, unsigned int frameNumber, FrameSegmentationWorkspace& workspace, LineParameters& lineParameters, double& signalValue);
 
-  void PlotIntArray(const std::deque<int>& intensityValues);
+  PlusStatus FindPeakStart(const std::vector<int>& intensityProfile, int maxFromLargestArea, int startOfMaxArea, double& startOfPeak);
+
+  PlusStatus FindLargestPeak(const std::vector<int>& intensityProfile, int& maxFromLargestArea, int& maxFromLargestAreaIndex, int& startOfMaxArea);
+
+  PlusStatus ComputeCenterOfGravity(const std::vector<int>& intensityProfile, int startOfMaxArea, double& centerOfGravity);
+
+  /*! Fit a line to the data points with RANSAC. The random number generator is seeded by randomSeed so that the result is reproducible. */
+  void ComputeLineParameters(FrameSegmentationWorkspace& workspace, unsigned int randomSeed, LineParameters& outputParameters);
+
+  void PlotIntArray(const std::vector<int>& intensityValues);
 
   void PlotDoubleArray(const std::deque<double>& intensityValues);
 
@@ -131,6 +173,15 @@ protected:
   /*! Clip rectangle origin for the processing (in pixels). Everything outside the rectangle is ignored. */
   CharImageType::SizeValueType m_ClipRectangleSize[2];
 
+  /*! Threader for processing the frames in parallel */
+  vtkMultiThreader* Threader;
+
+  /*! Number of threads used for processing the frames (0 means the default number of threads is used) */
+  int NumberOfThreads;
+
+  /*! Workspace used by DetectLine, created at the first call */
+  FrameSegmentationWorkspace* SingleFrameWorkspace;
+
 private:
   vtkPlusLineSegmentationAlgo(const vtkPlusLineSegmentationAlgo&);
   void operator=(const vtkPlusLineSegmentationAlgo&);
@@ -16,6 +16,159 @@
 #include "vtkMath.h"
 #include "vtksys/SystemTools.hxx"
 
+#include <vnl/algo/vnl_svd.h>
+
+#include <algorithm>
+
+#include "ParametersEstimator.h"
+#include "RANSAC.h"
+
+static const double DEFAULT_RANSAC_THRESHOLD_MM = 2.0;
+static const double RANSAC_DESIRED_PROBABILITY_FOR_NO_OUTLIERS = 0.999;
+// The pivot point cannot be computed if the smallest singular value of the normal matrix is smaller than this fraction of the largest singular value
+// (e.g., if the stylus was not rotated around two different axes)
+static const double MINIMUM_RELATIVE_SINGULAR_VALUE = 1e-6;
+
+//-----------------------------------------------------------------------------
+/*!
+  Add (or remove, if weight is -1) a sample to the normal equations of the pivot calibration problem
+  (see vtkPlusPivotCalibrationAlgo::GetPivotPointPosition for the definition of Ai and bi)
+*/
+static void AddToNormalEquations(vtkMatrix4x4* markerToReferenceTransformMatrix, double weight,
+                                 vnl_matrix_fixed<double, 6, 6>& normalMatrix, vnl_vector_fixed<double, 6>& normalVector, double& squaredTranslationSum)
+{
+  double aMatrixRow[6] = {0};
+  for (int i = 0; i < 3; i++)
+  {
+    aMatrixRow[0] = markerToReferenceTransformMatrix->Element[i][0];
+    aMatrixRow[1] = markerToReferenceTransformMatrix->Element[i][1];
+    aMatrixRow[2] = markerToReferenceTransformMatrix->Element[i][2];
+    aMatrixRow[3] = (i == 0 ? -1 : 0);
+    aMatrixRow[4] = (i == 1 ? -1 : 0);
+    aMatrixRow[5] = (i == 2 ? -1 : 0);
+    double b = -markerToReferenceTransformMatrix->Element[i][3];
+    for (int row = 0; row < 6; row++)
+    {
+      for (int column = 0; column < 6; column++)
+      {
+        normalMatrix(row, column) += weight * aMatrixRow[row] * aMatrixRow[column];
+      }
+      normalVector(row) += weight * aMatrixRow[row] * b;
+    }
+    squaredTranslationSum += weight * b * b;
+  }
+}
+
+//-----------------------------------------------------------------------------
+/*!
+  Solve the normal equations of the pivot calibration problem
+  \param x Solution: pivot point in the marker coordinate system (x[0..2]) and in the reference coordinate system (x[3..5])
+  \param rmsError If not NULL then the RMS of the pivot point position errors is returned here
+  \return false if the normal matrix is singular
+*/
+static bool SolveNormalEquations(const vnl_matrix_fixed<double, 6, 6>& normalMatrix, const vnl_vector_fixed<double, 6>& normalVector, double squaredTranslationSum,
+                                 unsigned int numberOfSamples, vnl_vector<double>& x, double* rmsError)
+{
+  if (numberOfSamples == 0)
+  {
+    return false;
+  }
+  vnl_svd<double> svd(vnl_matrix<double>(normalMatrix.data_block(), 6, 6));
+  if (svd.W(5) <= MINIMUM_RELATIVE_SINGULAR_VALUE * svd.W(0))
+  {
+    return false;
+  }
+  x = svd.solve(vnl_vector<double>(normalVector.data_block(), 6));
+  if (rmsError != NULL)
+  {
+    // Sum of squared residuals: |A*x-b|^2 = x^T*(A^T*A)*x - 2*x^T*(A^T*b) + b^T*b
+    vnl_vector<double> normalMatrixTimesX = vnl_matrix<double>(normalMatrix.data_block(), 6, 6) * x;
+    double squaredResidualSum = dot_product(x, normalMatrixTimesX) - 2.0 * dot_product(x, vnl_vector<double>(normalVector.data_block(), 6)) + squaredTranslationSum;
+    *rmsError = sqrt(std::max(squaredResidualSum, 0.0) / numberOfSamples);
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+  Pivot point estimator for RANSAC. Parameters: pivot point in the marker coordinate system (3 values)
+  and in the reference coordinate system (3 values).
+*/
+class PivotPointParametersEstimator : public itk::ParametersEstimator<vtkMatrix4x4*, double>
+{
+public:
+  typedef PivotPointParametersEstimator                     Self;
+  typedef itk::ParametersEstimator<vtkMatrix4x4*, double>   Superclass;
+  typedef itk::SmartPointer<Self>                           Pointer;
+  typedef itk::SmartPointer<const Self>                     ConstPointer;
+  itkNewMacro(Self);
+  itkTypeMacro(PivotPointParametersEstimator, ParametersEstimator);
+
+  void SetDelta(double delta)
+  {
+    this->Delta = delta;
+  }
+
+  /*! Three samples are needed, as the pivot point cannot be determined from the rotation between two samples along the rotation axis */
+  virtual void Estimate(std::vector<vtkMatrix4x4**>& data, std::vector<double>& parameters)
+  {
+    LeastSquaresEstimate(data, parameters);
+  }
+
+  virtual void Estimate(std::vector<vtkMatrix4x4*>& data, std::vector<double>& parameters)
+  {
+    LeastSquaresEstimate(data, parameters);
+  }
+
+  virtual void LeastSquaresEstimate(std::vector<vtkMatrix4x4**>& data, std::vector<double>& parameters)
+  {
+    std::vector<vtkMatrix4x4*> samples;
+    for (std::vector<vtkMatrix4x4**>::iterator it = data.begin(); it != data.end(); ++it)
+    {
+      samples.push_back(**it);
+    }
+    LeastSquaresEstimate(samples, parameters);
+  }
+
+  virtual void LeastSquaresEstimate(std::vector<vtkMatrix4x4*>& data, std::vector<double>& parameters)
+  {
+    parameters.clear();
+    vnl_matrix_fixed<double, 6, 6> normalMatrix(0.0);
+    vnl_vector_fixed<double, 6> normalVector(0.0);
+    double squaredTranslationSum = 0.0;
+    for (std::vector<vtkMatrix4x4*>::iterator it = data.begin(); it != data.end(); ++it)
+    {
+      AddToNormalEquations(*it, 1.0, normalMatrix, normalVector, squaredTranslationSum);
+    }
+    vnl_vector<double> x;
+    if (!SolveNormalEquations(normalMatrix, normalVector, squaredTranslationSum, data.size(), x, NULL))
+    {
+      // singular configuration
+      return;
+    }
+    parameters.assign(x.begin(), x.end());
+  }
+
+  /*! The sample agrees with the model if its pivot point is closer to the model pivot point than Delta */
+  virtual bool Agree(std::vector<double>& parameters, vtkMatrix4x4*& data)
+  {
+    double pivotPoint_Marker[4] = { parameters[0], parameters[1], parameters[2], 1.0 };
+    double pivotPoint_Reference[4] = { 0, 0, 0, 1 };
+    data->MultiplyPoint(pivotPoint_Marker, pivotPoint_Reference);
+    double modelPivotPoint_Reference[3] = { parameters[3], parameters[4], parameters[5] };
+    return vtkMath::Distance2BetweenPoints(pivotPoint_Reference, modelPivotPoint_Reference) < this->Delta * this->Delta;
+  }
+
+protected:
+  PivotPointParametersEstimator()
+    : Delta(DEFAULT_RANSAC_THRESHOLD_MM)
+  {
+    this->SetMinimalForEstimate(3);
+  }
+
+  double Delta;
+};
+
 vtkStandardNewMacro(vtkPlusPivotCalibrationAlgo);
 
 //-----------------------------------------------------------------------------
@@ -31,6 +184,23 @@ vtkPlusPivotCalibrationAlgo::vtkPlusPivotCalibrationAlgo()
   this->PivotPointPosition_Reference[1] = 0.0;
   this->PivotPointPosition_Reference[2] = 0.0;
   this->PivotPointPosition_Reference[3] = 1.0;
+
+  this->SlidingWindowSize = 0;
+  this->RansacEnabled = false;
+  this->RansacThresholdMm = DEFAULT_RANSAC_THRESHOLD_MM;
+
+  this->NormalMatrix.fill(0.0);
+  this->NormalVector.fill(0.0);
+  this->SquaredTranslationSum = 0.0;
+  this->NumberOfRemovedPointsSinceRecompute = 0;
+
+  this->IncrementalResultValid = false;
+  for (int i = 0; i < 3; i++)
+  {
+    this->IncrementalPivotPoint_Marker[i] = 0.0;
+    this->IncrementalPivotPoint_Reference[i] = 0.0;
+  }
+  this->IncrementalRmsError = -1.0;
 }
 
 //-----------------------------------------------------------------------------
@@ -49,6 +219,8 @@ void vtkPlusPivotCalibrationAlgo::RemoveAllCalibrationPoints()
   }
   this->MarkerToReferenceTransformMatrixArray.clear();
   this->OutlierIndices.clear();
+  RecomputeNormalEquations();
+  UpdateIncrementalResult();
 }
 
 //----------------------------------------------------------------------------
@@ -57,6 +229,122 @@ PlusStatus vtkPlusPivotCalibrationAlgo::InsertNextCalibrationPoint(vtkMatrix4x4*
   vtkMatrix4x4* markerToReferenceTransformMatrixCopy = vtkMatrix4x4::New();
   markerToReferenceTransformMatrixCopy->DeepCopy(aMarkerToReferenceTransformMatrix);
   this->MarkerToReferenceTransformMatrixArray.push_back(markerToReferenceTransformMatrixCopy);
+  AddToNormalEquations(markerToReferenceTransformMatrixCopy, 1.0, this->NormalMatrix, this->NormalVector, this->SquaredTranslationSum);
+
+  // Remove the oldest points that are out of the sliding window
+  while (this->SlidingWindowSize > 0 && this->MarkerToReferenceTransformMatrixArray.size() > static_cast<unsigned int>(this->SlidingWindowSize))
+  {
+    vtkMatrix4x4* oldestMarkerToReferenceTransformMatrix = this->MarkerToReferenceTransformMatrixArray.front();
+    AddToNormalEquations(oldestMarkerToReferenceTransformMatrix, -1.0, this->NormalMatrix, this->NormalVector, this->SquaredTranslationSum);
+    oldestMarkerToReferenceTransformMatrix->Delete();
+    this->MarkerToReferenceTransformMatrixArray.pop_front();
+    this->NumberOfRemovedPointsSinceRecompute++;
+  }
+  if (this->SlidingWindowSize > 0 && this->NumberOfRemovedPointsSinceRecompute >= this->SlidingWindowSize)
+  {
+    // Subtracting removed points from the sums accumulates numerical errors, therefore recompute the sums from time to time
+    // (the cost of the recomputation is amortized over the removed points)
+    RecomputeNormalEquations();
+  }
+
+  UpdateIncrementalResult();
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusPivotCalibrationAlgo::RecomputeNormalEquations()
+{
+  this->NormalMatrix.fill(0.0);
+  this->NormalVector.fill(0.0);
+  this->SquaredTranslationSum = 0.0;
+  for (std::list<vtkMatrix4x4*>::iterator it = this->MarkerToReferenceTransformMatrixArray.begin(); it != this->MarkerToReferenceTransformMatrixArray.end(); ++it)
+  {
+    AddToNormalEquations(*it, 1.0, this->NormalMatrix, this->NormalVector, this->SquaredTranslationSum);
+  }
+  this->NumberOfRemovedPointsSinceRecompute = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusPivotCalibrationAlgo::UpdateIncrementalResult()
+{
+  vnl_vector<double> x;
+  this->IncrementalResultValid = SolveNormalEquations(this->NormalMatrix, this->NormalVector, this->SquaredTranslationSum,
+                                 this->MarkerToReferenceTransformMatrixArray.size(), x, &this->IncrementalRmsError);
+  if (!this->IncrementalResultValid)
+  {
+    this->IncrementalRmsError = -1.0;
+    return;
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    this->IncrementalPivotPoint_Marker[i] = x[i];
+    this->IncrementalPivotPoint_Reference[i] = x[3 + i];
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusPivotCalibrationAlgo::GetIncrementalPivotPointPosition(double pivotPoint_Marker[3], double pivotPoint_Reference[3], double* rmsError /*=NULL*/)
+{
+  if (!this->IncrementalResultValid)
+  {
+    return PLUS_FAIL;
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    pivotPoint_Marker[i] = this->IncrementalPivotPoint_Marker[i];
+    pivotPoint_Reference[i] = this->IncrementalPivotPoint_Reference[i];
+  }
+  if (rmsError != NULL)
+  {
+    *rmsError = this->IncrementalRmsError;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusPivotCalibrationAlgo::GetNumberOfCalibrationPoints()
+{
+  return this->MarkerToReferenceTransformMatrixArray.size();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusPivotCalibrationAlgo::GetRansacOutliers(std::set<unsigned int>& outlierSampleIndices)
+{
+  outlierSampleIndices.clear();
+
+  typedef itk::RANSAC<vtkMatrix4x4*, double> RANSACType;
+  std::vector<vtkMatrix4x4*> data(this->MarkerToReferenceTransformMatrixArray.begin(), this->MarkerToReferenceTransformMatrixArray.end());
+
+  PivotPointParametersEstimator::Pointer pivotPointEstimator = PivotPointParametersEstimator::New();
+  pivotPointEstimator->SetDelta(this->RansacThresholdMm);
+
+  std::vector<double> ransacParameterResult;
+  RANSACType::Pointer ransacEstimator = RANSACType::New();
+  try
+  {
+    ransacEstimator->SetData(data);
+    ransacEstimator->SetParametersEstimator(pivotPointEstimator.GetPointer());
+    ransacEstimator->Compute(ransacParameterResult, RANSAC_DESIRED_PROBABILITY_FOR_NO_OUTLIERS);
+  }
+  catch (std::exception& e)
+  {
+    LOG_ERROR("vtkPlusPivotCalibrationAlgo failed: RANSAC error: " << e.what());
+    return PLUS_FAIL;
+  }
+  if (ransacParameterResult.empty())
+  {
+    LOG_ERROR("vtkPlusPivotCalibrationAlgo failed: RANSAC could not compute the pivot point. Make sure the stylus is rotated around at least two different axes.");
+    return PLUS_FAIL;
+  }
+
+  for (unsigned int sampleIndex = 0; sampleIndex < data.size(); sampleIndex++)
+  {
+    if (!pivotPointEstimator->Agree(ransacParameterResult, data[sampleIndex]))
+    {
+      outlierSampleIndices.insert(sampleIndex);
+    }
+  }
+  LOG_DEBUG("RANSAC rejected " << outlierSampleIndices.size() << " of " << data.size() << " samples");
   return PLUS_SUCCESS;
 }
 
@@ -79,16 +367,23 @@ It's an Ax=b linear problem that can be solved with robust LSQR:
       [ PivotPoint_Reference ]
  bi = [ -MarkerToReferenceTransformTranslationVector ]
 */
-PlusStatus vtkPlusPivotCalibrationAlgo::GetPivotPointPosition(double* pivotPoint_Marker, double* pivotPoint_Reference)
+PlusStatus vtkPlusPivotCalibrationAlgo::GetPivotPointPosition(double* pivotPoint_Marker, double* pivotPoint_Reference, const std::set<unsigned int>& excludedSampleIndices)
 {
   std::vector<vnl_vector<double> > aMatrix;
   std::vector<double> bVector;
   vnl_vector<double> xVector(6, 0);   // result vector
+  std::vector<unsigned int> usedSampleIndices; // sample index for each 3 rows of the matrix
 
   vnl_vector<double> aMatrixRow(6);
+  unsigned int sampleIndex = 0;
   for (std::list< vtkMatrix4x4* >::iterator markerToReferenceTransformIt = this->MarkerToReferenceTransformMatrixArray.begin();
-       markerToReferenceTransformIt != this->MarkerToReferenceTransformMatrixArray.end(); ++markerToReferenceTransformIt)
+       markerToReferenceTransformIt != this->MarkerToReferenceTransformMatrixArray.end(); ++markerToReferenceTransformIt, ++sampleIndex)
   {
+    if (excludedSampleIndices.find(sampleIndex) != excludedSampleIndices.end())
+    {
+      continue;
+    }
+    usedSampleIndices.push_back(sampleIndex);
     for (int i = 0; i < 3; i++)
     {
       aMatrixRow(0) = (*markerToReferenceTransformIt)->Element[i][0];
@@ -126,7 +421,7 @@ PlusStatus vtkPlusPivotCalibrationAlgo::GetPivotPointPosition(double* pivotPoint
   // corrupted), but there would be no measurable difference anyway if the only a few percent of the points are
   // outliers.
 
-  this->OutlierIndices.clear();
+  this->OutlierIndices = excludedSampleIndices;
   unsigned int processFromRowIndex = 0;
   for (unsigned int i = 0; i < notOutliersIndices.size(); i++)
   {
@@ -136,8 +431,8 @@ PlusStatus vtkPlusPivotCalibrationAlgo::GetPivotPointPosition(double* pivotPoint
       // samples were missed, so they are outliers
       for (unsigned int outlierRowIndex = processFromRowIndex; outlierRowIndex < nextNotOutlierRowIndex; outlierRowIndex++)
       {
-        int sampleIndex = outlierRowIndex / 3; // 3 rows are generated per sample
-        this->OutlierIndices.insert(sampleIndex);
+        unsigned int outlierSampleIndex = usedSampleIndices[outlierRowIndex / 3]; // 3 rows are generated per sample
+        this->OutlierIndices.insert(outlierSampleIndex);
       }
     }
     processFromRowIndex = nextNotOutlierRowIndex + 1;
@@ -163,9 +458,19 @@ PlusStatus vtkPlusPivotCalibrationAlgo::DoPivotCalibration(vtkPlusTransformRepos
     return PLUS_FAIL;
   }
 
+  // Reject samples that are not consistent with the majority of the samples (e.g., the stylus tip slipped)
+  std::set<unsigned int> ransacOutlierIndices;
+  if (this->RansacEnabled)
+  {
+    if (GetRansacOutliers(ransacOutlierIndices) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+  }
+
   double pivotPoint_Marker[4] = {0, 0, 0, 1};
   double pivotPoint_Reference[4] = {0, 0, 0, 1};
-  if (GetPivotPointPosition(pivotPoint_Marker, pivotPoint_Reference) != PLUS_SUCCESS)
+  if (GetPivotPointPosition(pivotPoint_Marker, pivotPoint_Reference, ransacOutlierIndices) != PLUS_SUCCESS)
   {
     return PLUS_FAIL;
   }
@@ -282,6 +587,9 @@ PlusStatus vtkPlusPivotCalibrationAlgo::ReadConfiguration(vtkXMLDataElement* aCo
   XML_READ_CSTRING_ATTRIBUTE_REQUIRED(ObjectMarkerCoordinateFrame, pivotCalibrationElement);
   XML_READ_CSTRING_ATTRIBUTE_REQUIRED(ReferenceCoordinateFrame, pivotCalibrationElement);
   XML_READ_CSTRING_ATTRIBUTE_REQUIRED(ObjectPivotPointCoordinateFrame, pivotCalibrationElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, SlidingWindowSize, pivotCalibrationElement);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(RansacEnabled, pivotCalibrationElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, RansacThresholdMm, pivotCalibrationElement);
   return PLUS_SUCCESS;
 }
 
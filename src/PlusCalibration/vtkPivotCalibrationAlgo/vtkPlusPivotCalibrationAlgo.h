@@ -15,6 +15,10 @@ See License.txt for details.
 #include <vtkObject.h>
 #include <vtkMatrix4x4.h>
 
+// ITK includes
+#include <vnl/vnl_matrix_fixed.h>
+#include <vnl/vnl_vector_fixed.h>
+
 // STL includes
 #include <list>
 #include <set>
@@ -38,7 +42,12 @@ class vtkXMLDataElement;
   of the PivotPoint coordinate system is chosen to be the cross product of the Z and X axes.
 
   The method detects outlier points (points that have larger than 3x error than the standard deviation) and ignores them when computing the pivot point
-  coordinates and the calibration error.
+  coordinates and the calibration error. Optionally, samples that are not consistent with the majority of the samples (e.g., because the stylus tip
+  slipped during the acquisition) are rejected by RANSAC before the robust LSQR computation.
+
+  The normal equations of the least squares problem are accumulated as the calibration points are inserted, therefore an approximate
+  pivot point position and RMS error (without outlier rejection) is available after each inserted point in constant time, which allows
+  displaying a live result during the acquisition. Optionally, only the most recent points are used (sliding window).
 
   \ingroup PlusLibCalibrationAlgorithm
 */
@@ -62,11 +71,25 @@ public:
   void RemoveAllCalibrationPoints();
 
   /*!
-    Insert acquired point to calibration point list
+    Insert acquired point to calibration point list and update the incremental result.
+    If the sliding window is enabled then the oldest point is removed when the window is full.
     \param aMarkerToReferenceTransformMatrix New calibration point (tool to reference transform)
   */
   PlusStatus InsertNextCalibrationPoint(vtkMatrix4x4* aMarkerToReferenceTransformMatrix);
 
+  /*!
+    Get the pivot point position computed from the calibration points that are inserted so far.
+    The result is updated in each InsertNextCalibrationPoint call in constant time. Outliers are not rejected.
+    \param pivotPoint_Marker Pivot point position in the marker coordinate system
+    \param pivotPoint_Reference Pivot point position in the reference coordinate system
+    \param rmsError If not NULL then the RMS distance (in mm) between the pivot point positions computed from each sample and the pivot point position in the reference coordinate system is returned here
+    \return PLUS_FAIL if there are not enough calibration points or the orientations of the points are too similar for computing the pivot point
+  */
+  PlusStatus GetIncrementalPivotPointPosition(double pivotPoint_Marker[3], double pivotPoint_Reference[3], double* rmsError = NULL);
+
+  /*! Get the number of calibration points that are currently used for the calibration */
+  int GetNumberOfCalibrationPoints();
+
   /*!
     Calibrate (call the minimizer and set the result)
     \param aTransformRepository Transform repository to save the results into
@@ -87,6 +110,22 @@ public:
   int GetNumberOfDetectedOutliers();
 
 public:
+  /*!
+    Maximum number of calibration points used for the calibration. If the number of inserted points exceeds this value
+    then the oldest points are removed. 0 means all the points are used.
+  */
+  vtkSetMacro(SlidingWindowSize, int);
+  vtkGetMacro(SlidingWindowSize, int);
+
+  /*! If enabled then outliers are rejected by RANSAC before computing the calibration result */
+  vtkSetMacro(RansacEnabled, bool);
+  vtkGetMacro(RansacEnabled, bool);
+  vtkBooleanMacro(RansacEnabled, bool);
+
+  /*! Maximum distance (in mm) of the pivot point computed from a sample from the pivot point of the RANSAC model for the sample to be considered as inlier */
+  vtkSetMacro(RansacThresholdMm, double);
+  vtkGetMacro(RansacThresholdMm, double);
+
   vtkGetMacro(CalibrationError, double);
   vtkGetObjectMacro(PivotPointToMarkerTransformMatrix, vtkMatrix4x4);
   vtkGetVector3Macro(PivotPointPosition_Reference, double);
@@ -108,7 +147,20 @@ protected:
   /*! Compute the mean position error of the pivot point (in mm) */
   void ComputeCalibrationError();
 
-  PlusStatus GetPivotPointPosition(double* pivotPoint_Marker, double* pivotPoint_Reference);
+  /*!
+    Compute the pivot point position using robust LSQR
+    \param excludedSampleIndices Indices of samples that are not used in the computation (they are considered as outliers)
+  */
+  PlusStatus GetPivotPointPosition(double* pivotPoint_Marker, double* pivotPoint_Reference, const std::set<unsigned int>& excludedSampleIndices);
+
+  /*! Find outlier samples using RANSAC */
+  PlusStatus GetRansacOutliers(std::set<unsigned int>& outlierSampleIndices);
+
+  /*! Reset the accumulated normal equations and add all the current calibration points */
+  void RecomputeNormalEquations();
+
+  /*! Compute the incremental result from the accumulated normal equations */
+  void UpdateIncrementalResult();
 
 protected:
   /*! Pivot point to marker transform (eg. stylus tip to stylus) - the result of the calibration */
@@ -134,6 +186,32 @@ protected:
 
   /*! List of outlier sample indices */
   std::set<unsigned int>    OutlierIndices;
+
+  /*! Maximum number of calibration points used for the calibration, 0 if all points are used */
+  int                       SlidingWindowSize;
+
+  /*! Reject outliers by RANSAC before computing the calibration result */
+  bool                      RansacEnabled;
+
+  /*! Inlier threshold for RANSAC (in mm) */
+  double                    RansacThresholdMm;
+
+  /*!
+    Normal equations of the least squares problem (see GetPivotPointPosition) accumulated for the current calibration points:
+    NormalMatrix = sum(Ai^T * Ai), NormalVector = sum(Ai^T * bi), SquaredTranslationSum = sum(bi^T * bi)
+  */
+  vnl_matrix_fixed<double, 6, 6> NormalMatrix;
+  vnl_vector_fixed<double, 6> NormalVector;
+  double                    SquaredTranslationSum;
+
+  /*! Number of points removed from the normal equations since they were recomputed (removal accumulates numerical errors) */
+  int                       NumberOfRemovedPointsSinceRecompute;
+
+  /*! Incremental result, computed from the normal equations */
+  bool                      IncrementalResultValid;
+  double                    IncrementalPivotPoint_Marker[3];
+  double                    IncrementalPivotPoint_Reference[3];
+  double                    IncrementalRmsError;
 };
 
 #endif
@@ -8,6 +8,8 @@ See License.txt for details.
 #include "vtkPlusProbeCalibrationAlgo.h"
 
 #include "float.h"
+#include <algorithm>
+#include <vnl/vnl_det.h>
 #include <vnl/vnl_inverse.h>
 
 #include "vtkPlusTrackedFrameList.h"
@@ -32,6 +34,19 @@ See License.txt for details.
 
 static const int MIN_NUMBER_OF_VALID_CALIBRATION_FRAMES = 10; // minimum number of successfully calibrated frames required for calibration
 static const double DEFAULT_ERROR_CONFIDENCE_INTERVAL = 0.95; // this fraction of the data is taken into account when computing mean and standard deviation in the final calibration error report
+static const int SQUARED_ERROR_SUM_FRAMES_PER_BLOCK = 16; // number of frames in a block of the parallel error computation, the block sums are added in a fixed order so that the result does not depend on the number of threads
+
+//----------------------------------------------------------------------------
+struct vtkPlusProbeCalibrationAlgo::SquaredErrorSumThreadInfo
+{
+  vtkPlusProbeCalibrationAlgo* Self;
+  bool Error2d;
+  bool ComputeGradient;
+  vnl_matrix_fixed<double, 4, 4> ImageToProbeMatrix;
+  vnl_matrix_fixed<double, 4, 4> ProbeToImageMatrix;
+  int NumberOfFrames;
+  std::vector<SquaredErrorSumType> BlockSums;
+};
 
 vtkStandardNewMacro(vtkPlusProbeCalibrationAlgo);
 
@@ -49,9 +64,11 @@ vtkPlusProbeCalibrationAlgo::vtkPlusProbeCalibrationAlgo()
   , PhantomCoordinateFrame(NULL)
   , ReferenceCoordinateFrame(NULL)
   , ErrorConfidenceLevel(DEFAULT_ERROR_CONFIDENCE_INTERVAL)
+  , NumberOfThreads(0)
 {
   this->Optimizer = vtkPlusProbeCalibrationOptimizerAlgo::New();
   this->Optimizer->SetProbeCalibrationAlgo(this);
+  this->Threader = vtkMultiThreader::New();
 }
 
 //----------------------------------------------------------------------------
@@ -62,6 +79,11 @@ vtkPlusProbeCalibrationAlgo::~vtkPlusProbeCalibrationAlgo()
     this->Optimizer->Delete();
     this->Optimizer = NULL;
   }
+  if (this->Threader)
+  {
+    this->Threader->Delete();
+    this->Threader = NULL;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -76,6 +98,7 @@ PlusStatus vtkPlusProbeCalibrationAlgo::ReadConfiguration(vtkXMLDataElement* aCo
   XML_READ_CSTRING_ATTRIBUTE_REQUIRED(ReferenceCoordinateFrame, probeCalibrationElement);
 
   // Optimization options
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, NumberOfThreads, probeCalibrationElement);
   if (this->Optimizer->ReadConfiguration(probeCalibrationElement) != PLUS_SUCCESS)
   {
     LOG_ERROR("vtkPlusProbeCalibrationOptimizerAlgo is not well specified in vtkPlusProbeCalibrationOptimizerAlgo element of the configuration!");
@@ -179,6 +202,16 @@ PlusStatus vtkPlusProbeCalibrationAlgo::ComputeImageToProbeTransformByLinearLeas
     imageToProbeTransformMatrix.set_row(row, resultVector);
   }
 
+  CompleteImageToProbeTransformMatrix(imageToProbeTransformMatrix);
+
+  LOG_DEBUG(outliers.size() << " outliers points were found");
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::CompleteImageToProbeTransformMatrix(vnl_matrix_fixed<double, 4, 4>& imageToProbeTransformMatrix)
+{
   // Force the last row to be exactly (0,0,0,1) - sometimes it contains numbers of 1e-18 magnitude
   imageToProbeTransformMatrix(3, 0) = 0;
   imageToProbeTransformMatrix(3, 1) = 0;
@@ -198,10 +231,6 @@ PlusStatus vtkPlusProbeCalibrationAlgo::ComputeImageToProbeTransformByLinearLeas
   imageToProbeTransformMatrix(0, 2) = zVector[0];
   imageToProbeTransformMatrix(1, 2) = zVector[1];
   imageToProbeTransformMatrix(2, 2) = zVector[2];
-
-  LOG_DEBUG(outliers.size() << " outliers points were found");
-
-  return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
@@ -249,6 +278,8 @@ PlusStatus vtkPlusProbeCalibrationAlgo::Calibrate(vtkPlusTrackedFrameList* valid
   this->PreProcessedWirePositions[CALIBRATION_ALL].Clear();
   this->PreProcessedWirePositions[VALIDATION_ALL].Clear();
   this->PreProcessedWirePositions[CALIBRATION_NOT_OUTLIER].Clear();
+  // The cached calibration positions are replaced, so the incremental estimate is not valid anymore
+  this->IncrementalCalibration.Clear();
 
   // Add tracked frames for calibration and validation
   for (int frameNumber = validationStartFrame; frameNumber < validationEndFrame; ++frameNumber)
@@ -277,6 +308,26 @@ PlusStatus vtkPlusProbeCalibrationAlgo::Calibrate(vtkPlusTrackedFrameList* valid
     }
   }
 
+  if (CalibrateFromPreProcessedWirePositions(transformRepository) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  // Save the calibration results and error reports into a file
+  if (SaveCalibrationResultAndErrorReportToXML(validationTrackedFrameList, validationStartFrame, validationEndFrame, calibrationTrackedFrameList, calibrationStartFrame, calibrationEndFrame) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to save report!");
+    return PLUS_FAIL;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationAlgo::CalibrateFromPreProcessedWirePositions(vtkPlusTransformRepository* transformRepository)
+{
+  this->PreProcessedWirePositions[CALIBRATION_NOT_OUTLIER].Clear();
+
   if (PreProcessedWirePositions[CALIBRATION_ALL].FramePositions.empty())
   {
     LOG_ERROR("Unable to perform calibration - calibration data is empty!");
@@ -355,16 +406,158 @@ PlusStatus vtkPlusProbeCalibrationAlgo::Calibrate(vtkPlusTrackedFrameList* valid
              << this->PreProcessedWirePositions[CALIBRATION_ALL].NWireErrors.ReprojectionError2DStdDevs[wire][1] << "px)");
   }
 
-  // Save the calibration results and error reports into a file
-  if (SaveCalibrationResultAndErrorReportToXML(validationTrackedFrameList, validationStartFrame, validationEndFrame, calibrationTrackedFrameList, calibrationStartFrame, calibrationEndFrame) != PLUS_SUCCESS)
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::StartIncrementalCalibration(const std::vector<PlusNWire>& nWires)
+{
+  LOG_TRACE("vtkPlusProbeCalibrationAlgo::StartIncrementalCalibration");
+
+  this->NWires = nWires;
+
+  this->PreProcessedWirePositions[CALIBRATION_ALL].Clear();
+  this->PreProcessedWirePositions[VALIDATION_ALL].Clear();
+  this->PreProcessedWirePositions[CALIBRATION_NOT_OUTLIER].Clear();
+  this->IncrementalCalibration.Clear();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationAlgo::AddIncrementalCalibrationFrame(PlusTrackedFrame* trackedFrame, vtkPlusTransformRepository* transformRepository)
+{
+  LOG_TRACE("vtkPlusProbeCalibrationAlgo::AddIncrementalCalibrationFrame");
+
+  if (trackedFrame == NULL || transformRepository == NULL)
   {
-    LOG_ERROR("Failed to save report!");
+    LOG_ERROR("Failed to add incremental calibration frame - invalid input");
     return PLUS_FAIL;
   }
+  if (trackedFrame->GetImageData()->GetImageOrientation() != US_IMG_ORIENT_MF || trackedFrame->GetImageData()->GetImageType() != US_IMG_BRIGHTNESS)
+  {
+    LOG_ERROR("Failed to add incremental calibration frame - MF oriented BRIGHTNESS image is expected");
+    return PLUS_FAIL;
+  }
+
+  std::vector<NWirePositionType>& framePositions = this->PreProcessedWirePositions[CALIBRATION_ALL].FramePositions;
+  const size_t numberOfFramesBefore = framePositions.size();
+  if (AddPositionsPerImage(trackedFrame, transformRepository, CALIBRATION_ALL) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to add incremental calibration frame");
+    return PLUS_FAIL;
+  }
+  if (framePositions.size() == numberOfFramesBefore)
+  {
+    // segmentation failed on the frame, nothing to add
+    return PLUS_SUCCESS;
+  }
+
+  // Add the middle wire positions of the new frame to the normal equations
+  const NWirePositionType& framePosition = framePositions.back();
+  for (unsigned int nWireIndex = 0; nWireIndex < this->NWires.size(); ++nWireIndex)
+  {
+    const vnl_vector_fixed<double, 4>& middleWirePos_Image = framePosition.AllWiresIntersectionPointsPos_Image[nWireIndex * 3 + 1];
+    const vnl_vector_fixed<double, 4>& middleWirePos_Probe = framePosition.MiddleWireIntersectionPointsPos_Probe[nWireIndex];
+    const double a[3] = { middleWirePos_Image[0], middleWirePos_Image[1], 1.0 };
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        this->IncrementalCalibration.ImageMoments(i, j) += a[i] * a[j];
+        this->IncrementalCalibration.ImageProbeMoments(i, j) += a[i] * middleWirePos_Probe[j];
+      }
+      this->IncrementalCalibration.ProbeSquaredNormSum += middleWirePos_Probe[i] * middleWirePos_Probe[i];
+    }
+    this->IncrementalCalibration.NumberOfPoints++;
+  }
 
+  UpdateIncrementalEstimate();
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::UpdateIncrementalEstimate()
+{
+  IncrementalCalibrationType& incremental = this->IncrementalCalibration;
+  incremental.EstimateValid = false;
+  incremental.ReprojectionError3DRms = -1.0;
+
+  if (GetNumberOfIncrementalCalibrationFrames() < MIN_NUMBER_OF_VALID_CALIBRATION_FRAMES)
+  {
+    return;
+  }
+
+  // The image positions must not be collinear, otherwise the normal equations are singular.
+  // The determinant is compared to the product of the diagonal elements to make the check independent of the image size.
+  const vnl_matrix_fixed<double, 3, 3>& m = incremental.ImageMoments;
+  double diagonalProduct = m(0, 0) * m(1, 1) * m(2, 2);
+  if (diagonalProduct <= 0 || vnl_det(m) < 1e-12 * diagonalProduct)
+  {
+    LOG_DEBUG("Incremental calibration estimate is not available - image positions of the wires are degenerate");
+    return;
+  }
+
+  // Solve the normal equations: row r of ImageToProbe (x, y, translation elements) is the r-th column of M^-1 * C
+  vnl_matrix_fixed<double, 3, 3> solution = vnl_inverse(m) * incremental.ImageProbeMoments;
+  incremental.ImageToProbeTransformMatrix.fill(0);
+  for (int row = 0; row < 3; ++row)
+  {
+    incremental.ImageToProbeTransformMatrix(row, 0) = solution(0, row);
+    incremental.ImageToProbeTransformMatrix(row, 1) = solution(1, row);
+    incremental.ImageToProbeTransformMatrix(row, 3) = solution(2, row);
+  }
+  CompleteImageToProbeTransformMatrix(incremental.ImageToProbeTransformMatrix);
+
+  // Sum of squared errors from the sums: sum(|X^T*a - b|^2) = sum(b^T*b) - 2*trace(X^T*C) + trace(X^T*M*X)
+  double squaredErrorSum = incremental.ProbeSquaredNormSum;
+  vnl_matrix_fixed<double, 3, 3> momentsTimesSolution = m * solution;
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      squaredErrorSum += solution(i, j) * (momentsTimesSolution(i, j) - 2.0 * incremental.ImageProbeMoments(i, j));
+    }
+  }
+  // The result may be slightly negative due to rounding errors if the fit is perfect
+  incremental.ReprojectionError3DRms = sqrt(std::max(0.0, squaredErrorSum) / incremental.NumberOfPoints);
+  incremental.EstimateValid = true;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusProbeCalibrationAlgo::GetNumberOfIncrementalCalibrationFrames()
+{
+  return this->PreProcessedWirePositions[CALIBRATION_ALL].FramePositions.size();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationAlgo::GetIncrementalImageToProbeTransformMatrix(vtkMatrix4x4* imageToProbeMatrix)
+{
+  if (!this->IncrementalCalibration.EstimateValid)
+  {
+    return PLUS_FAIL;
+  }
+  PlusMath::ConvertVnlMatrixToVtkMatrix(this->IncrementalCalibration.ImageToProbeTransformMatrix, imageToProbeMatrix);
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+double vtkPlusProbeCalibrationAlgo::GetIncrementalReprojectionError3DRms()
+{
+  return this->IncrementalCalibration.ReprojectionError3DRms;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationAlgo::CalibrateFromIncrementalFrames(vtkPlusTransformRepository* transformRepository)
+{
+  LOG_TRACE("vtkPlusProbeCalibrationAlgo::CalibrateFromIncrementalFrames");
+
+  // The added frames are used for validation as well
+  this->PreProcessedWirePositions[VALIDATION_ALL].Clear();
+  this->PreProcessedWirePositions[VALIDATION_ALL].FramePositions = this->PreProcessedWirePositions[CALIBRATION_ALL].FramePositions;
+
+  return CalibrateFromPreProcessedWirePositions(transformRepository);
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusProbeCalibrationAlgo::AddPositionsPerImage(PlusTrackedFrame* trackedFrame, vtkPlusTransformRepository* transformRepository, PreProcessedWirePositionIdType datasetType)
 {
@@ -1145,6 +1338,199 @@ void vtkPlusProbeCalibrationAlgo::ComputeError3d(const vnl_matrix_fixed<double,
   PlusMath::ComputeRms(reprojectionErrors, errorRms);
 }
 
+//--------------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::ComputeSquaredErrorSum2d(const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, double& squaredErrorSum, int& numberOfErrors, vnl_matrix_fixed<double, 3, 4>* squaredErrorSumGradient /*=NULL*/)
+{
+  ComputeSquaredErrorSum(true, imageToProbeMatrix, squaredErrorSum, numberOfErrors, squaredErrorSumGradient);
+}
+
+//--------------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::ComputeSquaredErrorSum3d(const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, double& squaredErrorSum, int& numberOfErrors, vnl_matrix_fixed<double, 3, 4>* squaredErrorSumGradient /*=NULL*/)
+{
+  ComputeSquaredErrorSum(false, imageToProbeMatrix, squaredErrorSum, numberOfErrors, squaredErrorSumGradient);
+}
+
+//--------------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::ComputeSquaredErrorSum(bool error2d, const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, double& squaredErrorSum, int& numberOfErrors, vnl_matrix_fixed<double, 3, 4>* squaredErrorSumGradient)
+{
+  SquaredErrorSumThreadInfo info;
+  info.Self = this;
+  info.Error2d = error2d;
+  info.ComputeGradient = (squaredErrorSumGradient != NULL);
+  info.ImageToProbeMatrix = imageToProbeMatrix;
+  if (error2d)
+  {
+    info.ProbeToImageMatrix = vnl_inverse(imageToProbeMatrix);
+  }
+  info.NumberOfFrames = this->PreProcessedWirePositions[CALIBRATION_NOT_OUTLIER].FramePositions.size();
+  int numberOfBlocks = (info.NumberOfFrames + SQUARED_ERROR_SUM_FRAMES_PER_BLOCK - 1) / SQUARED_ERROR_SUM_FRAMES_PER_BLOCK;
+  info.BlockSums.resize(numberOfBlocks);
+
+  int numberOfThreads = (this->NumberOfThreads > 0 ? this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+  numberOfThreads = std::min(numberOfThreads, numberOfBlocks);
+  if (numberOfThreads > 1)
+  {
+    this->Threader->SetNumberOfThreads(numberOfThreads);
+    this->Threader->SetSingleMethod(SquaredErrorSumThreadFunction, &info);
+    this->Threader->SingleMethodExecute();
+  }
+  else
+  {
+    for (int blockIndex = 0; blockIndex < numberOfBlocks; blockIndex++)
+    {
+      int firstFrameIndex = blockIndex * SQUARED_ERROR_SUM_FRAMES_PER_BLOCK;
+      int lastFrameIndex = std::min(firstFrameIndex + SQUARED_ERROR_SUM_FRAMES_PER_BLOCK, info.NumberOfFrames);
+      if (error2d)
+      {
+        ComputeSquaredErrorSum2d(firstFrameIndex, lastFrameIndex, info.ProbeToImageMatrix, info.ComputeGradient, info.BlockSums[blockIndex]);
+      }
+      else
+      {
+        ComputeSquaredErrorSum3d(firstFrameIndex, lastFrameIndex, info.ImageToProbeMatrix, info.ComputeGradient, info.BlockSums[blockIndex]);
+      }
+    }
+  }
+
+  // Add the block sums in block order, so that the result is the same for any number of threads
+  squaredErrorSum = 0.0;
+  numberOfErrors = 0;
+  if (squaredErrorSumGradient != NULL)
+  {
+    squaredErrorSumGradient->fill(0.0);
+  }
+  for (int blockIndex = 0; blockIndex < numberOfBlocks; blockIndex++)
+  {
+    squaredErrorSum += info.BlockSums[blockIndex].SquaredErrorSum;
+    numberOfErrors += info.BlockSums[blockIndex].NumberOfErrors;
+    if (squaredErrorSumGradient != NULL)
+    {
+      (*squaredErrorSumGradient) += info.BlockSums[blockIndex].Gradient;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPlusProbeCalibrationAlgo::SquaredErrorSumThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  SquaredErrorSumThreadInfo* info = static_cast<SquaredErrorSumThreadInfo*>(threadInfo->UserData);
+
+  // Blocks are assigned to threads in a round-robin fashion
+  int numberOfBlocks = info->BlockSums.size();
+  for (int blockIndex = threadInfo->ThreadID; blockIndex < numberOfBlocks; blockIndex += threadInfo->NumberOfThreads)
+  {
+    int firstFrameIndex = blockIndex * SQUARED_ERROR_SUM_FRAMES_PER_BLOCK;
+    int lastFrameIndex = std::min(firstFrameIndex + SQUARED_ERROR_SUM_FRAMES_PER_BLOCK, info->NumberOfFrames);
+    if (info->Error2d)
+    {
+      info->Self->ComputeSquaredErrorSum2d(firstFrameIndex, lastFrameIndex, info->ProbeToImageMatrix, info->ComputeGradient, info->BlockSums[blockIndex]);
+    }
+    else
+    {
+      info->Self->ComputeSquaredErrorSum3d(firstFrameIndex, lastFrameIndex, info->ImageToProbeMatrix, info->ComputeGradient, info->BlockSums[blockIndex]);
+    }
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//--------------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::ComputeSquaredErrorSum2d(int firstFrameIndex, int lastFrameIndex, const vnl_matrix_fixed<double, 4, 4>& probeToImageMatrix, bool computeGradient, SquaredErrorSumType& result)
+{
+  result.SquaredErrorSum = 0.0;
+  result.NumberOfErrors = 0;
+  result.Gradient.fill(0.0);
+
+  const std::vector<NWirePositionType>& framePositions = this->PreProcessedWirePositions[CALIBRATION_NOT_OUTLIER].FramePositions;
+  for (int frameIndex = firstFrameIndex; frameIndex < lastFrameIndex; frameIndex++)
+  {
+    vnl_matrix_fixed<double, 4, 4> phantomToImageMatrix = probeToImageMatrix * vnl_inverse(framePositions[frameIndex].ProbeToPhantomTransform);
+    for (unsigned int nWireIndex = 0; nWireIndex < this->NWires.size(); nWireIndex++)
+    {
+      for (int wireIndex = 0; wireIndex < 3; wireIndex++)
+      {
+        const PlusFidWire& wire = this->NWires[nWireIndex].GetWires()[wireIndex];
+        vnl_vector_fixed<double, 4> wireFrontPoint_Image = phantomToImageMatrix * vnl_vector_fixed<double, 4>(wire.EndPointFront[0], wire.EndPointFront[1], wire.EndPointFront[2], 1.0);
+        vnl_vector_fixed<double, 4> wireBackPoint_Image = phantomToImageMatrix * vnl_vector_fixed<double, 4>(wire.EndPointBack[0], wire.EndPointBack[1], wire.EndPointBack[2], 1.0);
+
+        // Intersection of the wire and the image plane (z=0) is at wireFrontPoint_Image + t * wireDirection_Image
+        double zDifference = wireFrontPoint_Image[2] - wireBackPoint_Image[2];
+        if (zDifference == 0.0)
+        {
+          // Image plane and wire are parallel
+          continue;
+        }
+        double t = wireFrontPoint_Image[2] / zDifference;
+        vnl_vector_fixed<double, 4> wireDirection_Image = wireBackPoint_Image - wireFrontPoint_Image;
+
+        const vnl_vector_fixed<double, 4>& segmentedPoint_Image = framePositions[frameIndex].AllWiresIntersectionPointsPos_Image[3 * nWireIndex + wireIndex];
+        double errorX = segmentedPoint_Image[0] - (wireFrontPoint_Image[0] + t * wireDirection_Image[0]);
+        double errorY = segmentedPoint_Image[1] - (wireFrontPoint_Image[1] + t * wireDirection_Image[1]);
+        result.SquaredErrorSum += errorX * errorX + errorY * errorY;
+        result.NumberOfErrors++;
+
+        if (!computeGradient)
+        {
+          continue;
+        }
+
+        // Derivative of the squared error with respect to the wire end point positions (divided by 2)
+        double errorAlongWire = wireDirection_Image[0] * errorX + wireDirection_Image[1] * errorY;
+        double zDifferenceSquared = zDifference * zDifference;
+        double frontPointGradient[3] = { (1.0 - t) * errorX, (1.0 - t) * errorY, -wireBackPoint_Image[2] * errorAlongWire / zDifferenceSquared };
+        double backPointGradient[3] = { t * errorX, t * errorY, wireFrontPoint_Image[2] * errorAlongWire / zDifferenceSquared };
+
+        // The end points depend on the image to probe matrix (M) as: d(endPoint_Image) = -inverse(M) * dM * endPoint_Image
+        for (int row = 0; row < 3; row++)
+        {
+          double frontPointWeight = 0.0;
+          double backPointWeight = 0.0;
+          for (int i = 0; i < 3; i++)
+          {
+            frontPointWeight += probeToImageMatrix(i, row) * frontPointGradient[i];
+            backPointWeight += probeToImageMatrix(i, row) * backPointGradient[i];
+          }
+          for (int column = 0; column < 4; column++)
+          {
+            result.Gradient(row, column) += 2.0 * (frontPointWeight * wireFrontPoint_Image[column] + backPointWeight * wireBackPoint_Image[column]);
+          }
+        }
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::ComputeSquaredErrorSum3d(int firstFrameIndex, int lastFrameIndex, const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, bool computeGradient, SquaredErrorSumType& result)
+{
+  result.SquaredErrorSum = 0.0;
+  result.NumberOfErrors = 0;
+  result.Gradient.fill(0.0);
+
+  const std::vector<NWirePositionType>& framePositions = this->PreProcessedWirePositions[CALIBRATION_NOT_OUTLIER].FramePositions;
+  for (int frameIndex = firstFrameIndex; frameIndex < lastFrameIndex; frameIndex++)
+  {
+    for (unsigned int nWireIndex = 0; nWireIndex < this->NWires.size(); nWireIndex++)
+    {
+      const vnl_vector_fixed<double, 4>& segmentedPoint_Image = framePositions[frameIndex].AllWiresIntersectionPointsPos_Image[nWireIndex * 3 + 1];
+      vnl_vector_fixed<double, 4> pointErrorVector = imageToProbeMatrix * segmentedPoint_Image - framePositions[frameIndex].MiddleWireIntersectionPointsPos_Probe[nWireIndex];
+      result.SquaredErrorSum += pointErrorVector.squared_magnitude();
+      result.NumberOfErrors++;
+
+      if (computeGradient)
+      {
+        for (int row = 0; row < 3; row++)
+        {
+          for (int column = 0; column < 4; column++)
+          {
+            result.Gradient(row, column) += 2.0 * pointErrorVector[row] * segmentedPoint_Image[column];
+          }
+        }
+      }
+    }
+  }
+}
+
 //--------------------------------------------------------------------------------
 double vtkPlusProbeCalibrationAlgo::GetCalibrationReprojectionError3DMean()
 {
@@ -15,6 +15,7 @@
 
 #include <vnl/vnl_double_3.h>
 
+#include "vtkMultiThreader.h"
 #include "vtkObject.h"
 #include "vtkPlusProbeCalibrationOptimizerAlgo.h"
 
@@ -122,6 +123,64 @@ public:
   void ComputeError2d( const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, double& errorMean, double& errorStDev, double& errorRms );
   void ComputeError3d( const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, double& errorMean, double& errorStDev, double& errorRms );
 
+  /*!
+    Compute the sum of squared 2D reprojection errors of the non-outlier calibration frames (same errors as in ComputeError2d).
+    Frames are processed in parallel. The result does not depend on the number of threads.
+    \param squaredErrorSum Sum of the squared errors
+    \param numberOfErrors Number of errors in the sum
+    \param squaredErrorSumGradient If not NULL then the derivative of the sum with respect to the elements of the first three rows of the matrix is returned here
+  */
+  void ComputeSquaredErrorSum2d( const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, double& squaredErrorSum, int& numberOfErrors, vnl_matrix_fixed<double, 3, 4>* squaredErrorSumGradient = NULL );
+  /*!
+    Compute the sum of squared 3D reprojection errors of the non-outlier calibration frames (same errors as in ComputeError3d).
+    Frames are processed in parallel. The result does not depend on the number of threads.
+    \param squaredErrorSum Sum of the squared errors
+    \param numberOfErrors Number of errors in the sum
+    \param squaredErrorSumGradient If not NULL then the derivative of the sum with respect to the elements of the first three rows of the matrix is returned here
+  */
+  void ComputeSquaredErrorSum3d( const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, double& squaredErrorSum, int& numberOfErrors, vnl_matrix_fixed<double, 3, 4>* squaredErrorSumGradient = NULL );
+
+  /*! Set the number of threads used for computing the errors during the optimization (0 means the default number of threads is used) */
+  vtkSetMacro( NumberOfThreads, int );
+  /*! Get the number of threads used for computing the errors during the optimization */
+  vtkGetMacro( NumberOfThreads, int );
+
+  /*!
+    Start collecting frames for incremental calibration. Previously added frames and the incremental estimate are discarded.
+    \param nWires NWire structure that contains the computed imaginary intersections. It used to determine the computed position
+  */
+  void StartIncrementalCalibration( const std::vector<PlusNWire>& nWires );
+
+  /*!
+    Add a segmented frame to the incremental calibration. The wire positions of the frame are cached and added to the
+    normal equations of the linear least squares problem, then the ImageToProbe estimate and its 3D reprojection error are updated.
+    The processing time of a frame does not depend on the number of frames that are already added.
+    Frames without segmented points are ignored.
+    \param trackedFrame The tracked frame (already segmented) to add
+    \param transformRepository Transform repository object to be able to get the default transform
+  */
+  PlusStatus AddIncrementalCalibrationFrame( PlusTrackedFrame* trackedFrame, vtkPlusTransformRepository* transformRepository );
+
+  /*! Get the number of frames that are added to the incremental calibration (frames without segmented points are not counted) */
+  int GetNumberOfIncrementalCalibrationFrames();
+
+  /*!
+    Get the current incremental ImageToProbe estimate (linear least squares solution without outlier removal)
+    \return PLUS_FAIL if not enough frames are added yet or the added positions do not determine the transform
+  */
+  PlusStatus GetIncrementalImageToProbeTransformMatrix( vtkMatrix4x4* imageToProbeMatrix );
+
+  /*! Get the RMS 3D reprojection error of all the added frames, computed with the incremental estimate. Negative if no estimate is available. */
+  double GetIncrementalReprojectionError3DRms();
+
+  /*!
+    Run the full calibration (linear least squares with outlier removal and optimization if enabled) on the frames added by
+    AddIncrementalCalibrationFrame. The added frames are used for validation as well. The result is set in the transform repository
+    and the reprojection errors are computed, but no calibration report file is saved.
+    \param transformRepository Transform repository object to store the result in
+  */
+  PlusStatus CalibrateFromIncrementalFrames( vtkPlusTransformRepository* transformRepository );
+
 protected:
 
   enum PreProcessedWirePositionIdType
@@ -183,12 +242,49 @@ protected:
   */
   PlusStatus ComputeImageToProbeTransformByLinearLeastSquaresMethod( vnl_matrix_fixed<double, 4, 4>& imageToProbeTransformMatrix, std::set<int>& outliers );
 
+  /*!
+    Complete a transformation matrix computed from in-plane points to a 3D-3D transformation matrix: the z axis is set perpendicular to the x and y axes,
+    with the average length of the x and y axes, and the last row is set to (0,0,0,1)
+  */
+  static void CompleteImageToProbeTransformMatrix( vnl_matrix_fixed<double, 4, 4>& imageToProbeTransformMatrix );
+
+  /*!
+    Compute the calibration from the calibration and validation wire positions (linear least squares, optimization if enabled)
+    and compute the reprojection errors
+  */
+  PlusStatus CalibrateFromPreProcessedWirePositions( vtkPlusTransformRepository* transformRepository );
+
+  /*! Solve the normal equations of the incremental calibration and update the incremental estimate and its error */
+  void UpdateIncrementalEstimate();
+
   /*! Remove outliers from calibration data
   */
   void UpdateNonOutlierData( const std::set<int>& outliers );
 
   static double PointToWireDistance( const vnl_double_3& aPoint, const vnl_double_3& aLineEndPoint1, const vnl_double_3& aLineEndPoint2 );
 
+  /*! Sum of squared errors and its gradient, computed for a block of frames */
+  struct SquaredErrorSumType
+  {
+    double SquaredErrorSum;
+    int NumberOfErrors;
+    vnl_matrix_fixed<double, 3, 4> Gradient;
+  };
+
+  /*! Compute the sum of squared 2D or 3D errors in parallel, see ComputeSquaredErrorSum2d and ComputeSquaredErrorSum3d */
+  void ComputeSquaredErrorSum( bool error2d, const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, double& squaredErrorSum, int& numberOfErrors, vnl_matrix_fixed<double, 3, 4>* squaredErrorSumGradient );
+
+  /*! Compute the sum of squared 2D errors of the non-outlier calibration frames in the [firstFrameIndex, lastFrameIndex) range */
+  void ComputeSquaredErrorSum2d( int firstFrameIndex, int lastFrameIndex, const vnl_matrix_fixed<double, 4, 4>& probeToImageMatrix, bool computeGradient, SquaredErrorSumType& result );
+  /*! Compute the sum of squared 3D errors of the non-outlier calibration frames in the [firstFrameIndex, lastFrameIndex) range */
+  void ComputeSquaredErrorSum3d( int firstFrameIndex, int lastFrameIndex, const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, bool computeGradient, SquaredErrorSumType& result );
+
+  /*! Input and output of SquaredErrorSumThreadFunction */
+  struct SquaredErrorSumThreadInfo;
+
+  /*! Thread function that computes the squared error sums for a subset of the frame blocks */
+  static VTK_THREAD_RETURN_TYPE SquaredErrorSumThreadFunction( void* arg );
+
 protected:
   /*! Set the image coordinate frame name */
   vtkSetStringMacro( ImageCoordinateFrame );
@@ -308,6 +404,45 @@ protected:
 
   PreProcessedWirePositionsType PreProcessedWirePositions[LAST_PREPROCESSED_WIRE_POS_ID];
 
+  /*!
+    Normal equations of the linear least squares calibration, accumulated from the frames added by AddIncrementalCalibrationFrame.
+    For each middle wire intersection a = (x, y, 1) is the position in the image frame and b = (x, y, z) is the position in the probe frame.
+  */
+  struct IncrementalCalibrationType
+  {
+    /*! Sum of a * a^T */
+    vnl_matrix_fixed<double, 3, 3> ImageMoments;
+    /*! Sum of a * b^T */
+    vnl_matrix_fixed<double, 3, 3> ImageProbeMoments;
+    /*! Sum of b^T * b */
+    double ProbeSquaredNormSum;
+    /*! Number of middle wire intersections in the sums */
+    int NumberOfPoints;
+
+    /*! The estimate is available */
+    bool EstimateValid;
+    vnl_matrix_fixed<double, 4, 4> ImageToProbeTransformMatrix;
+    double ReprojectionError3DRms;
+
+    IncrementalCalibrationType()
+    {
+      Clear();
+    }
+
+    void Clear()
+    {
+      ImageMoments.fill(0);
+      ImageProbeMoments.fill(0);
+      ProbeSquaredNormSum = 0;
+      NumberOfPoints = 0;
+      EstimateValid = false;
+      ImageToProbeTransformMatrix.set_identity();
+      ReprojectionError3DRms = -1.0;
+    }
+  };
+
+  IncrementalCalibrationType IncrementalCalibration;
+
   /*!
     Confidence level (trusted zone) as a percentage of the independent validation data used to produce the final error computation results.  It serves as an effective way to get rid of corrupted data
     (or outliers) in the validation dataset. Default value: 0.95 (or 95%), meaning the top ranked 95% of the ascendingly-ordered PRE values from the validation data would be accepted as the valid PRE values.
@@ -316,6 +451,12 @@ protected:
 
   vtkPlusProbeCalibrationOptimizerAlgo* Optimizer;
 
+  /*! Threader for computing the errors during the optimization */
+  vtkMultiThreader* Threader;
+
+  /*! Number of threads used for computing the errors during the optimization (0 means the default number of threads is used) */
+  int NumberOfThreads;
+
 private:
   vtkPlusProbeCalibrationAlgo( const vtkPlusProbeCalibrationAlgo& );
   void operator=( const vtkPlusProbeCalibrationAlgo& );
@@ -18,11 +18,19 @@ See License.txt for details.
 
 #include "vtksys/SystemTools.hxx"
 
+#include <algorithm>
+
+#include "itkLBFGSOptimizer.h"
 #include "itkPowellOptimizer.h"
 #include "itkScaleVersor3DTransform.h"
 #include "itkSimilarity3DTransform.h"
 
-typedef  itk::PowellOptimizer  OptimizerType;
+typedef  itk::SingleValuedNonLinearOptimizer  OptimizerType;
+typedef  itk::PowellOptimizer  PowellOptimizerType;
+typedef  itk::LBFGSOptimizer  LBFGSOptimizerType;
+
+// Lower limit of the scalar part of the rotation versor for computing the derivatives (the versor parameterization is singular at 180 deg rotation)
+static const double MINIMUM_VERSOR_W_FOR_DERIVATIVE = 1e-6;
 
 //-----------------------------------------------------------------------------
 class DistanceToWiresCostFunction : public itk::SingleValuedCostFunction 
@@ -38,14 +46,17 @@ public:
 
   typedef Superclass::ParametersType              ParametersType;
   typedef Superclass::DerivativeType              DerivativeType;
+  typedef Superclass::MeasureType                 MeasureType;
   typedef itk::VersorRigid3DTransform< double > RigidTransformType;
 
   DistanceToWiresCostFunction()
   : m_CalibrationOptimizer(NULL)
+  , m_NumberOfEvaluations(0)
   {
   }
 
   DistanceToWiresCostFunction(vtkPlusProbeCalibrationOptimizerAlgo* calibrationOptimizer) 
+  : m_NumberOfEvaluations(0)
   {
     m_CalibrationOptimizer=calibrationOptimizer;
   }
@@ -127,20 +138,107 @@ public:
     return PLUS_SUCCESS;
   }
 
-  double GetValue( const ParametersType & imageToProbeTransformParameters ) const
+  /*!
+    Compute the derivative of the cost with respect to the transform parameters from the derivative
+    with respect to the elements of the first three rows of the transform matrix (chain rule)
+  */
+  static PlusStatus GetParametersDerivative(DerivativeType& derivative, const ParametersType & imageToProbeTransformParameters, const vnl_matrix_fixed<double,3,4>& matrixDerivative)
+  {
+    if (imageToProbeTransformParameters.GetSize()!=7 && imageToProbeTransformParameters.GetSize()!=8)
+    {
+      LOG_ERROR("GetParametersDerivative expects 7 or 8 parameters");
+      return PLUS_FAIL;
+    }
+    bool isotropicPixelSpacing=(imageToProbeTransformParameters.GetSize()==7);
+
+    RigidTransformType::Pointer rigidTransform=RigidTransformType::New();
+    rigidTransform->SetParameters(imageToProbeTransformParameters);
+    vnl_matrix_fixed<double,3,3> rotation=rigidTransform->GetMatrix().GetVnlMatrix();
+    double x=rigidTransform->GetVersor().GetX();
+    double y=rigidTransform->GetVersor().GetY();
+    double z=rigidTransform->GetVersor().GetZ();
+    double w=std::max(rigidTransform->GetVersor().GetW(), MINIMUM_VERSOR_W_FOR_DERIVATIVE);
+
+    // Partial derivatives of the rotation matrix with respect to the versor components
+    const double dRotationDx[3][3]={ {0, 2*y, 2*z}, {2*y, -4*x, -2*w}, {2*z, 2*w, -4*x} };
+    const double dRotationDy[3][3]={ {-4*y, 2*x, 2*w}, {2*x, 0, 2*z}, {-2*w, 2*z, -4*y} };
+    const double dRotationDz[3][3]={ {-4*z, -2*w, 2*x}, {2*w, -4*z, 2*y}, {2*x, 2*y, 0} };
+    const double dRotationDw[3][3]={ {0, -2*z, 2*y}, {2*z, 0, -2*x}, {-2*y, 2*x, 0} };
+    const double (*dRotationDVersor[3])[3]={ dRotationDx, dRotationDy, dRotationDz };
+    const double versor[3]={ x, y, z };
+
+    // Column scaling factors and their derivatives with respect to the scaling parameters (see GetTransformMatrix)
+    double scale[3]={0};
+    double dScaleDParam6[3]={0};
+    double dScaleDParam7[3]={0};
+    if (isotropicPixelSpacing)
+    {
+      scale[0]=scale[1]=scale[2]=imageToProbeTransformParameters(6);
+      dScaleDParam6[0]=dScaleDParam6[1]=dScaleDParam6[2]=1.0;
+    }
+    else
+    {
+      scale[0]=imageToProbeTransformParameters(6);
+      scale[1]=imageToProbeTransformParameters(7);
+      scale[2]=(imageToProbeTransformParameters(6)+imageToProbeTransformParameters(7))/2;
+      dScaleDParam6[0]=1.0;
+      dScaleDParam6[2]=0.5;
+      dScaleDParam7[1]=1.0;
+      dScaleDParam7[2]=0.5;
+    }
+
+    derivative.SetSize(imageToProbeTransformParameters.GetSize());
+    derivative.Fill(0.0);
+    for (int row=0; row<3; row++)
+    {
+      for (int column=0; column<3; column++)
+      {
+        // Versor (the scalar part depends on the vector part: w=sqrt(1-x^2-y^2-z^2))
+        for (int versorIndex=0; versorIndex<3; versorIndex++)
+        {
+          double dRotation=dRotationDVersor[versorIndex][row][column]-versor[versorIndex]/w*dRotationDw[row][column];
+          derivative[versorIndex]+=matrixDerivative(row,column)*scale[column]*dRotation;
+        }
+        // Scaling
+        derivative[6]+=matrixDerivative(row,column)*rotation(row,column)*dScaleDParam6[column];
+        if (!isotropicPixelSpacing)
+        {
+          derivative[7]+=matrixDerivative(row,column)*rotation(row,column)*dScaleDParam7[column];
+        }
+      }
+      // Translation
+      derivative[3+row]=matrixDerivative(row,3);
+    }
+    return PLUS_SUCCESS;
+  }
+
+  MeasureType GetValue( const ParametersType & imageToProbeTransformParameters ) const
   {
+    m_NumberOfEvaluations++;
     vnl_matrix_fixed<double,4,4> imageToProbeTransform_vnl;
     GetTransformMatrix(imageToProbeTransform_vnl, imageToProbeTransformParameters);    
-    double errorMean=0.0;
-    double errorStDev=0.0;
-    double errorRms=0.0;
-    m_CalibrationOptimizer->ComputeError(imageToProbeTransform_vnl, errorMean, errorStDev, errorRms);
-    return errorRms;
+    return m_CalibrationOptimizer->ComputeCost(imageToProbeTransform_vnl);
   }
 
-  void GetDerivative( const ParametersType & parameters, DerivativeType  & derivative ) const
+  void GetDerivative( const ParametersType & imageToProbeTransformParameters, DerivativeType  & derivative ) const
   {
-    LOG_ERROR("GetDerivative is not implemented");
+    MeasureType value=0.0;
+    GetValueAndDerivative(imageToProbeTransformParameters, value, derivative);
+  }
+
+  void GetValueAndDerivative( const ParametersType & imageToProbeTransformParameters, MeasureType & value, DerivativeType & derivative ) const
+  {
+    m_NumberOfEvaluations++;
+    vnl_matrix_fixed<double,4,4> imageToProbeTransform_vnl;
+    GetTransformMatrix(imageToProbeTransform_vnl, imageToProbeTransformParameters);
+    vnl_matrix_fixed<double,3,4> costGradient;
+    value=m_CalibrationOptimizer->ComputeCost(imageToProbeTransform_vnl, &costGradient);
+    GetParametersDerivative(derivative, imageToProbeTransformParameters, costGradient);
+  }
+
+  unsigned int GetNumberOfEvaluations() const
+  {
+    return m_NumberOfEvaluations;
   }
 
   unsigned int GetNumberOfParameters(void) const
@@ -157,6 +255,7 @@ public:
 
 private:
   vtkPlusProbeCalibrationOptimizerAlgo* m_CalibrationOptimizer;
+  mutable unsigned int m_NumberOfEvaluations;
 }; 
 
 //-----------------------------------------------------------------------------
@@ -165,6 +264,8 @@ vtkStandardNewMacro(vtkPlusProbeCalibrationOptimizerAlgo);
 //-----------------------------------------------------------------------------
 vtkPlusProbeCalibrationOptimizerAlgo::vtkPlusProbeCalibrationOptimizerAlgo()
 : IsotropicPixelSpacing(true)
+, OptimizationMethod(MINIMIZE_NONE)
+, Minimizer(MINIMIZER_POWELL)
 , ProbeCalibrationAlgo(NULL)
 {  
 }
@@ -196,6 +297,97 @@ void vtkPlusProbeCalibrationOptimizerAlgo::ComputeError(const vnl_matrix_fixed<d
   }
 }
 
+//--------------------------------------------------------------------------------
+double vtkPlusProbeCalibrationOptimizerAlgo::ComputeCost(const vnl_matrix_fixed<double,4,4> &imageToProbeTransformationMatrix, vnl_matrix_fixed<double,3,4>* costGradient /*=NULL*/)
+{
+  double squaredErrorSum=0.0;
+  int numberOfErrors=0;
+  switch (this->OptimizationMethod)
+  {
+  case MINIMIZE_DISTANCE_OF_MIDDLE_WIRES_IN_3D:
+    this->ProbeCalibrationAlgo->ComputeSquaredErrorSum3d(imageToProbeTransformationMatrix, squaredErrorSum, numberOfErrors, costGradient);
+    break;
+  case MINIMIZE_DISTANCE_OF_ALL_WIRES_IN_2D:
+    this->ProbeCalibrationAlgo->ComputeSquaredErrorSum2d(imageToProbeTransformationMatrix, squaredErrorSum, numberOfErrors, costGradient);
+    break;
+  default:
+    LOG_ERROR("Invalid cost function");
+  }
+
+  if (numberOfErrors==0)
+  {
+    if (costGradient!=NULL)
+    {
+      costGradient->fill(0.0);
+    }
+    return 0.0;
+  }
+
+  // cost = sqrt(squaredErrorSum/numberOfErrors) => d(cost) = d(squaredErrorSum)/(2*numberOfErrors*cost)
+  double errorRms=sqrt(squaredErrorSum/numberOfErrors);
+  if (costGradient!=NULL)
+  {
+    if (errorRms>0)
+    {
+      (*costGradient)/=(2.0*numberOfErrors*errorRms);
+    }
+    else
+    {
+      costGradient->fill(0.0);
+    }
+  }
+  return errorRms;
+}
+
+//--------------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::ComputeCostFromTransformParameters(const std::vector<double> &transformParameters, double &cost, std::vector<double>* parametersDerivative /*=NULL*/)
+{
+  DistanceToWiresCostFunction::Pointer costFunction = new DistanceToWiresCostFunction(this);
+  if (transformParameters.size()!=costFunction->GetNumberOfParameters())
+  {
+    LOG_ERROR("ComputeCostFromTransformParameters expects "<<costFunction->GetNumberOfParameters()<<" parameters, received "<<transformParameters.size());
+    return PLUS_FAIL;
+  }
+
+  DistanceToWiresCostFunction::ParametersType parameters(costFunction->GetNumberOfParameters());
+  for (unsigned int i=0; i<parameters.GetSize(); i++)
+  {
+    parameters[i]=transformParameters[i];
+  }
+
+  if (parametersDerivative==NULL)
+  {
+    cost=costFunction->GetValue(parameters);
+    return PLUS_SUCCESS;
+  }
+
+  DistanceToWiresCostFunction::DerivativeType derivative;
+  costFunction->GetValueAndDerivative(parameters, cost, derivative);
+  parametersDerivative->resize(derivative.GetSize());
+  for (unsigned int i=0; i<derivative.GetSize(); i++)
+  {
+    (*parametersDerivative)[i]=derivative[i];
+  }
+  return PLUS_SUCCESS;
+}
+
+//--------------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::GetTransformParameters(const vnl_matrix_fixed<double,4,4> &imageToProbeTransformationMatrix, std::vector<double> &transformParameters)
+{
+  DistanceToWiresCostFunction::Pointer costFunction = new DistanceToWiresCostFunction(this);
+  DistanceToWiresCostFunction::ParametersType parameters(costFunction->GetNumberOfParameters());
+  if (DistanceToWiresCostFunction::GetTransformParameters(parameters, imageToProbeTransformationMatrix)!=PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  transformParameters.resize(parameters.GetSize());
+  for (unsigned int i=0; i<parameters.GetSize(); i++)
+  {
+    transformParameters[i]=parameters[i];
+  }
+  return PLUS_SUCCESS;
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::ShowTransformation(const vnl_matrix_fixed<double,4,4> &imageToProbeTransformationMatrix)
 {
@@ -253,7 +445,34 @@ PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::Update()
     PlusMath::LogVtkMatrix(vtkMatrix);
   }
 
-  OptimizerType::Pointer  optimizer = OptimizerType::New();
+  OptimizerType::Pointer optimizer;
+  PowellOptimizerType::Pointer powellOptimizer;
+  switch (this->Minimizer)
+  {
+  case MINIMIZER_POWELL:
+    powellOptimizer = PowellOptimizerType::New();
+    powellOptimizer->SetStepLength( 10 );
+    powellOptimizer->SetStepTolerance( 1e-8 );
+    powellOptimizer->SetValueTolerance( 1e-8 );
+    powellOptimizer->SetMaximumIteration( 300 );
+    optimizer = powellOptimizer.GetPointer();
+    break;
+  case MINIMIZER_LBFGS:
+    {
+      LBFGSOptimizerType::Pointer lbfgsOptimizer = LBFGSOptimizerType::New();
+      lbfgsOptimizer->SetTrace( false );
+      lbfgsOptimizer->SetGradientConvergenceTolerance( 1e-6 );
+      lbfgsOptimizer->SetLineSearchAccuracy( 0.9 );
+      lbfgsOptimizer->SetDefaultStepLength( 1.0 );
+      lbfgsOptimizer->SetMaximumNumberOfFunctionEvaluations( 2000 );
+      optimizer = lbfgsOptimizer.GetPointer();
+    }
+    break;
+  default:
+    LOG_ERROR("Unknown minimizer: "<<this->Minimizer);
+    return PLUS_FAIL;
+  }
+
   try 
   {
     optimizer->SetCostFunction( costFunction.GetPointer() );
@@ -264,11 +483,6 @@ PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::Update()
     return PLUS_FAIL;
   }
 
-  optimizer->SetStepLength( 10 );
-  optimizer->SetStepTolerance( 1e-8 );
-  optimizer->SetValueTolerance( 1e-8 );
-  optimizer->SetMaximumIteration( 300 );
-
 
   const double rotationParametersScale=1.0;
   const double translationParametersScale=0.5;
@@ -316,7 +530,14 @@ PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::Update()
   }
 
   std::string stopCondition=optimizer->GetStopConditionDescription();
-  LOG_INFO("Optimization stopping condition: "<<stopCondition<<". Number of iterations: " << optimizer->GetCurrentIteration());
+  if (powellOptimizer.IsNotNull())
+  {
+    LOG_INFO("Optimization stopping condition: "<<stopCondition<<". Number of iterations: " << powellOptimizer->GetCurrentIteration() << ". Number of cost function evaluations: " << costFunction->GetNumberOfEvaluations());
+  }
+  else
+  {
+    LOG_INFO("Optimization stopping condition: "<<stopCondition<<". Number of cost function evaluations: " << costFunction->GetNumberOfEvaluations());
+  }
 
   // Store the matrix
 
@@ -328,7 +549,7 @@ PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::Update()
   }
 
   // Store the optimized parameters and show the results
-  LOG_INFO("Cost function = " << GetOptimizationMethodAsString(this->OptimizationMethod));
+  LOG_INFO("Cost function = " << GetOptimizationMethodAsString(this->OptimizationMethod) << ", minimizer = " << GetMinimizerAsString(this->Minimizer));
 
   LOG_INFO("Without optimization:");
   ShowTransformation(this->ImageToProbeSeedTransformMatrix);
@@ -383,6 +604,19 @@ const char* vtkPlusProbeCalibrationOptimizerAlgo::GetOptimizationMethodAsString(
   }
 }
 
+//----------------------------------------------------------------------------
+const char* vtkPlusProbeCalibrationOptimizerAlgo::GetMinimizerAsString(MinimizerType type)
+{
+  switch (type)
+  {
+  case MINIMIZER_POWELL: return "POWELL";
+  case MINIMIZER_LBFGS: return "LBFGS";
+  default:
+    LOG_ERROR("Unknown minimizer: "<<type);
+    return "unknown";
+  }
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::ReadConfiguration( vtkXMLDataElement* aConfig )
 {
@@ -414,6 +648,9 @@ PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::ReadConfiguration( vtkXMLDataEl
   }
 
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(IsotropicPixelSpacing, aConfig);
+  XML_READ_ENUM2_ATTRIBUTE_OPTIONAL(Minimizer, aConfig,
+    GetMinimizerAsString(MINIMIZER_POWELL), MINIMIZER_POWELL,
+    GetMinimizerAsString(MINIMIZER_LBFGS), MINIMIZER_LBFGS);
 
   return PLUS_SUCCESS;
 }
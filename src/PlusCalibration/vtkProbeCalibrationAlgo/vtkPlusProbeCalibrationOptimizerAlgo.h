@@ -46,6 +46,13 @@ public:
     MINIMIZE_DISTANCE_OF_ALL_WIRES_IN_2D
   };  
 
+  /* Choose one of the possible minimizers */
+  enum MinimizerType
+  {
+    MINIMIZER_POWELL, // derivative-free, robust but requires many cost function evaluations
+    MINIMIZER_LBFGS // uses the analytic derivative of the cost function, requires much fewer cost function evaluations
+  };
+
   vtkTypeMacro(vtkPlusProbeCalibrationOptimizerAlgo,vtkObject);
   static vtkPlusProbeCalibrationOptimizerAlgo *New();
 
@@ -68,6 +75,22 @@ public:
 
   void ComputeError(const vnl_matrix_fixed<double,4,4> &imageToProbeTransformationMatrix, double &errorMean, double &errorStDev, double &errorRms);
 
+  /*!
+    Compute the value of the cost function (RMS error) without computing the error statistics, for the minimizer
+    \param costGradient If not NULL then the derivative of the cost with respect to the elements of the first three rows of the matrix is returned here
+  */
+  double ComputeCost(const vnl_matrix_fixed<double,4,4> &imageToProbeTransformationMatrix, vnl_matrix_fixed<double,3,4>* costGradient = NULL);
+
+  /*!
+    Compute the value of the cost function from the transform parameters that the minimizer works with
+    (3 rotation versor components, 3 translation components, and 1 or 2 scaling factors depending on IsotropicPixelSpacing)
+    \param parametersDerivative If not NULL then the analytic derivative of the cost with respect to the parameters is returned here
+  */
+  PlusStatus ComputeCostFromTransformParameters(const std::vector<double> &transformParameters, double &cost, std::vector<double>* parametersDerivative = NULL);
+
+  /*! Get the transform parameters that the minimizer works with from an image to probe matrix (see ComputeCostFromTransformParameters) */
+  PlusStatus GetTransformParameters(const vnl_matrix_fixed<double,4,4> &imageToProbeTransformationMatrix, std::vector<double> &transformParameters);
+
   bool GetIsotropicPixelSpacing() { return this->IsotropicPixelSpacing; }
   void SetIsotropicPixelSpacing(bool isotropicPixelSpacing) { this->IsotropicPixelSpacing=isotropicPixelSpacing; }
 
@@ -75,6 +98,10 @@ public:
   void SetOptimizationMethod(OptimizationMethodType optimizationMethod) { this->OptimizationMethod=optimizationMethod; }
   static const char* GetOptimizationMethodAsString(OptimizationMethodType type);
 
+  MinimizerType GetMinimizer() { return this->Minimizer; }
+  void SetMinimizer(MinimizerType minimizer) { this->Minimizer=minimizer; }
+  static const char* GetMinimizerAsString(MinimizerType type);
+
   void SetImageToProbeSeedTransform(const vnl_matrix_fixed<double,4,4> &imageToProbeTransformMatrix);
 
   void SetProbeCalibrationAlgo(vtkPlusProbeCalibrationAlgo* probeCalibrationAlgo);
@@ -93,6 +120,9 @@ protected:
   /*! Cost function to minimize during the optimization */
   OptimizationMethodType OptimizationMethod;
 
+  /*! Algorithm that minimizes the cost function */
+  MinimizerType Minimizer;
+
   /*! Store the seed for the optimization process */
   vnl_matrix_fixed<double,4,4> ImageToProbeSeedTransformMatrix;
 
@@ -10,11 +10,13 @@
 #include "vtkDoubleArray.h"
 #include "vtkPlusLineSegmentationAlgo.h"
 #include "vtkMath.h"
+#include "vtkMatrix4x4.h"
 #include "vtkPiecewiseFunction.h"
 #include "vtkPlusPrincipalMotionDetectionAlgo.h"
 #include "vtkTable.h"
 #include "vtkPlusTemporalCalibrationAlgo.h"
 #include "vtkPlusTrackedFrameList.h"
+#include "vtkPlusTransformRepository.h"
 #include <algorithm>
 #include <fstream>
 #include <iostream>
@@ -23,6 +25,20 @@
 
 vtkStandardNewMacro(vtkPlusTemporalCalibrationAlgo);
 
+//-----------------------------------------------------------------------------
+// Log a problem as an error, or only at debug level when errors are not reported (e.g., running estimates from partial data)
+#define LOG_ERROR_OR_DEBUG(logErrors, msg) \
+  { \
+    if (logErrors) \
+    { \
+      LOG_ERROR(msg); \
+    } \
+    else \
+    { \
+      LOG_DEBUG(msg); \
+    } \
+  }
+
 //-----------------------------------------------------------------------------
 // Default algorithm parameters
 namespace
@@ -37,6 +53,7 @@ namespace
   const double MINIMUM_SAMPLING_RESOLUTION_SEC = 0.00001;
   const double DEFAULT_SAMPLING_RESOLUTION_SEC = 0.001;
   const double DEFAULT_MAX_MOVING_LAG_SEC = 0.5;
+  const double DEFAULT_STREAMING_UPDATE_INTERVAL_SEC = 1.0;
 
   enum SignalAlignmentMetricType
   {
@@ -77,9 +94,22 @@ vtkPlusTemporalCalibrationAlgo::vtkPlusTemporalCalibrationAlgo()
   , MaxMovingLagSec(DEFAULT_MAX_MOVING_LAG_SEC)
   , BestCorrelationNormalizationFactor(0.0)
   , FixedSignalValuesNormalizationFactor(0.0)
+  , AlignedSignalCorrelation(0.0)
+  , Streaming(false)
+  , StreamingLineSegmenter(NULL)
+  , StreamingUpdateIntervalSec(DEFAULT_STREAMING_UPDATE_INTERVAL_SEC)
+  , RunningEstimateTimestamp(0.0)
+  , RunningEstimateAttempted(false)
+  , RunningEstimateValid(false)
+  , RunningMovingLagSec(0.0)
+  , RunningLagConfidence(0.0)
 {
   this->FixedSignal.frameList = NULL;
   this->MovingSignal.frameList = NULL;
+  this->StreamingFixedSignal.frameType = FRAME_TYPE_NONE;
+  this->StreamingFixedSignal.numberOfFrames = 0;
+  this->StreamingMovingSignal.frameType = FRAME_TYPE_NONE;
+  this->StreamingMovingSignal.numberOfFrames = 0;
   this->LineSegmentationClipRectangleOrigin[0] = 0;
   this->LineSegmentationClipRectangleOrigin[1] = 0;
   this->LineSegmentationClipRectangleSize[0] = 0;
@@ -100,6 +130,11 @@ vtkPlusTemporalCalibrationAlgo::~vtkPlusTemporalCalibrationAlgo()
     this->MovingSignal.frameList->UnRegister(NULL);
     this->MovingSignal.frameList = NULL;
   }
+  if (this->StreamingLineSegmenter != NULL)
+  {
+    this->StreamingLineSegmenter->Delete();
+    this->StreamingLineSegmenter = NULL;
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -325,11 +360,11 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::GetSignalRange(const std::deque<doubl
 }
 
 //-----------------------------------------------------------------------------
-PlusStatus vtkPlusTemporalCalibrationAlgo::NormalizeMetricValues(std::deque<double>& signal, double& normalizationFactor, int startIndex/*=0*/, int stopIndex/*=-1*/)
+PlusStatus vtkPlusTemporalCalibrationAlgo::NormalizeMetricValues(std::deque<double>& signal, double& normalizationFactor, int startIndex/*=0*/, int stopIndex/*=-1*/, bool logErrors/*=true*/)
 {
   if (signal.size() == 0)
   {
-    LOG_ERROR("NormalizeMetricValues failed because the metric vector is empty");
+    LOG_ERROR_OR_DEBUG(logErrors, "NormalizeMetricValues failed because the metric vector is empty");
     return PLUS_FAIL;
   }
 
@@ -359,7 +394,7 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::NormalizeMetricValues(std::deque<doub
     double maxPeakToPeak = fabs(maxValue - minValue);
     if (maxPeakToPeak < 1e-10)
     {
-      LOG_ERROR("Cannot normalize data, peak to peak difference is too small");
+      LOG_ERROR_OR_DEBUG(logErrors, "Cannot normalize data, peak to peak difference is too small");
     }
     else
     {
@@ -380,7 +415,7 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::NormalizeMetricValues(std::deque<doub
 
     if (stdev < 1e-10)
     {
-      LOG_ERROR("Cannot normalize data, stdev is too small");
+      LOG_ERROR_OR_DEBUG(logErrors, "Cannot normalize data, stdev is too small");
     }
     else
     {
@@ -400,11 +435,11 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::NormalizeMetricValues(std::deque<doub
 }
 
 //-----------------------------------------------------------------------------
-PlusStatus vtkPlusTemporalCalibrationAlgo::NormalizeMetricValues(std::deque<double>& signal, double& normalizationFactor, double startTime, double stopTime, const std::deque<double>& timestamps)
+PlusStatus vtkPlusTemporalCalibrationAlgo::NormalizeMetricValues(std::deque<double>& signal, double& normalizationFactor, double startTime, double stopTime, const std::deque<double>& timestamps, bool logErrors/*=true*/)
 {
   if (timestamps.size() == 0)
   {
-    LOG_ERROR("NormalizeMetricValues failed because the metric vector is empty");
+    LOG_ERROR_OR_DEBUG(logErrors, "NormalizeMetricValues failed because the metric vector is empty");
     return PLUS_FAIL;
   }
 
@@ -430,7 +465,7 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::NormalizeMetricValues(std::deque<doub
     }
   }
 
-  return NormalizeMetricValues(signal, normalizationFactor, startIndex, stopIndex);
+  return NormalizeMetricValues(signal, normalizationFactor, startIndex, stopIndex, logErrors);
 }
 
 
@@ -447,7 +482,7 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::ResampleSignalLinearly(const std::deq
 }
 
 //-----------------------------------------------------------------------------
-void vtkPlusTemporalCalibrationAlgo::ComputeCorrelationBetweenFixedAndMovingSignal(double minTrackerLagSec, double maxTrackerLagSec, double stepSizeSec, double& bestCorrelationValue, double& bestCorrelationTimeOffset, double& bestCorrelationNormalizationFactor, std::deque<double>& corrTimeOffsets, std::deque<double>& corrValues)
+void vtkPlusTemporalCalibrationAlgo::ComputeCorrelationBetweenFixedAndMovingSignal(double minTrackerLagSec, double maxTrackerLagSec, double stepSizeSec, double& bestCorrelationValue, double& bestCorrelationTimeOffset, double& bestCorrelationNormalizationFactor, std::deque<double>& corrTimeOffsets, std::deque<double>& corrValues, bool logErrors/*=true*/)
 {
   // We will let the tracker metric be the "sliding" metric and let the video metric be the "fixed" metric. Since we are assuming a maximum offset between the two streams.
 
@@ -464,7 +499,7 @@ void vtkPlusTemporalCalibrationAlgo::ComputeCorrelationBetweenFixedAndMovingSign
   std::deque<double> normalizationFactors;
   if (stepSizeSec < TIMESTAMP_EPSILON_SEC)
   {
-    LOG_ERROR("Sampling resolution is too small: " << stepSizeSec << " sec");
+    LOG_ERROR_OR_DEBUG(logErrors, "Sampling resolution is too small: " << stepSizeSec << " sec");
     return;
   }
   std::deque<double> slidingSignalTimestamps(this->FixedSignal.signalTimestamps.size());
@@ -480,11 +515,11 @@ void vtkPlusTemporalCalibrationAlgo::ComputeCorrelationBetweenFixedAndMovingSign
       slidingSignalTimestamps.at(i) =  this->FixedSignal.signalTimestamps.at(i) + offsetValueSec;
     }
 
-    NormalizeMetricValues(this->FixedSignal.signalValues, this->FixedSignalValuesNormalizationFactor, slidingSignalTimestamps.front(), slidingSignalTimestamps.back(), this->FixedSignal.signalTimestamps);
+    NormalizeMetricValues(this->FixedSignal.signalValues, this->FixedSignalValuesNormalizationFactor, slidingSignalTimestamps.front(), slidingSignalTimestamps.back(), this->FixedSignal.signalTimestamps, logErrors);
 
     ResampleSignalLinearly(slidingSignalTimestamps, trackerPositionPiecewiseSignal, resampledTrackerPositionMetric);
     double normalizationFactor = 1.0;
-    NormalizeMetricValues(resampledTrackerPositionMetric, normalizationFactor);
+    NormalizeMetricValues(resampledTrackerPositionMetric, normalizationFactor, 0, -1, logErrors);
     normalizationFactors.push_back(normalizationFactor);
 
     corrValues.push_back(ComputeAlignmentMetric(this->FixedSignal.signalValues, resampledTrackerPositionMetric));
@@ -644,11 +679,17 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeCommonTimeRange()
   double movingTimestampMin = this->MovingSignal.frameList->GetTrackedFrame(0)->GetTimestamp();
   double movingTimestampMax = this->MovingSignal.frameList->GetTrackedFrame(this->MovingSignal.frameList->GetNumberOfTrackedFrames() - 1)->GetTimestamp();;
 
+  return ComputeCommonTimeRange(fixedTimestampMin, fixedTimestampMax, movingTimestampMin, movingTimestampMax);
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeCommonTimeRange(double fixedTimestampMin, double fixedTimestampMax, double movingTimestampMin, double movingTimestampMax, bool logErrors/*=true*/)
+{
   double commonRangeMin = std::max(fixedTimestampMin, movingTimestampMin);
   double commonRangeMax = std::min(fixedTimestampMax, movingTimestampMax);
   if (commonRangeMin + this->MaxMovingLagSec >= commonRangeMax - this->MaxMovingLagSec)
   {
-    LOG_ERROR("Insufficient overlap between fixed and moving frames timestamps to compute time offset (fixed: " << fixedTimestampMin << "-" << fixedTimestampMax << " sec, moving: " << movingTimestampMin << "-" << movingTimestampMax << " sec)");
+    LOG_ERROR_OR_DEBUG(logErrors, "Insufficient overlap between fixed and moving frames timestamps to compute time offset (fixed: " << fixedTimestampMin << "-" << fixedTimestampMax << " sec, moving: " << movingTimestampMin << "-" << movingTimestampMax << " sec)");
     return PLUS_FAIL;
   }
 
@@ -686,15 +727,21 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeMovingSignalLagSec(TEMPORAL_CA
     return PLUS_FAIL;
   }
 
+  return ComputeMovingSignalLagFromPositionSignals(error);
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeMovingSignalLagFromPositionSignals(TEMPORAL_CALIBRATION_ERROR& error, bool logErrors/*=true*/)
+{
   // Compute approx image image frame period. We will use this frame period as a step size in the coarse optimum search phase.
-  double fixedTimestampMin = this->FixedSignal.signalTimestamps.at(0);
-  double fixedTimestampMax = this->FixedSignal.signalTimestamps.at(this->FixedSignal.signalTimestamps.size() - 1);
   if (this->FixedSignal.signalTimestamps.size() < 2)
   {
     error = TEMPORAL_CALIBRATION_ERROR_NOT_ENOUGH_FIXED_FRAMES;
-    LOG_ERROR("Not enough fixed frames are available");
+    LOG_ERROR_OR_DEBUG(logErrors, "Not enough fixed frames are available");
     return PLUS_FAIL;
   }
+  double fixedTimestampMin = this->FixedSignal.signalTimestamps.at(0);
+  double fixedTimestampMax = this->FixedSignal.signalTimestamps.at(this->FixedSignal.signalTimestamps.size() - 1);
   double imageFramePeriodSec = (fixedTimestampMax - fixedTimestampMin) / (this->FixedSignal.signalTimestamps.size() - 1);
 
   double searchRangeFineStep = imageFramePeriodSec * 3;
@@ -706,10 +753,10 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeMovingSignalLagSec(TEMPORAL_CA
   double bestCorrelationNormalizationFactor = 1.0;
   std::deque<double> corrTimeOffsets;
   std::deque<double> corrValues;
-  ComputeCorrelationBetweenFixedAndMovingSignal(-this->MaxMovingLagSec, this->MaxMovingLagSec, imageFramePeriodSec, bestCorrelationValue, bestCorrelationTimeOffset, bestCorrelationNormalizationFactor, corrTimeOffsets, corrValues);
+  ComputeCorrelationBetweenFixedAndMovingSignal(-this->MaxMovingLagSec, this->MaxMovingLagSec, imageFramePeriodSec, bestCorrelationValue, bestCorrelationTimeOffset, bestCorrelationNormalizationFactor, corrTimeOffsets, corrValues, logErrors);
   std::deque<double> corrTimeOffsetsFine;
   std::deque<double> corrValuesFine;
-  ComputeCorrelationBetweenFixedAndMovingSignal(bestCorrelationTimeOffset - searchRangeFineStep, bestCorrelationTimeOffset + searchRangeFineStep, this->SamplingResolutionSec, bestCorrelationValue, bestCorrelationTimeOffset, bestCorrelationNormalizationFactor, corrTimeOffsetsFine, corrValuesFine);
+  ComputeCorrelationBetweenFixedAndMovingSignal(bestCorrelationTimeOffset - searchRangeFineStep, bestCorrelationTimeOffset + searchRangeFineStep, this->SamplingResolutionSec, bestCorrelationValue, bestCorrelationTimeOffset, bestCorrelationNormalizationFactor, corrTimeOffsetsFine, corrValuesFine, logErrors);
   LOG_DEBUG("Time offset with sign convention #1: " << bestCorrelationTimeOffset);
 
   //  Compute cross correlation with sign convention #2
@@ -732,7 +779,8 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeMovingSignalLagSec(TEMPORAL_CA
     bestCorrelationTimeOffsetInvertedTracker,
     bestCorrelationNormalizationFactorInvertedTracker,
     corrTimeOffsetsInvertedTracker,
-    corrValuesInvertedTracker
+    corrValuesInvertedTracker,
+    logErrors
   );
   std::deque<double> corrTimeOffsetsInvertedTrackerFine;
   std::deque<double> corrValuesInvertedTrackerFine;
@@ -743,7 +791,8 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeMovingSignalLagSec(TEMPORAL_CA
     bestCorrelationTimeOffsetInvertedTracker,
     bestCorrelationNormalizationFactorInvertedTracker,
     corrTimeOffsetsInvertedTrackerFine,
-    corrValuesInvertedTrackerFine
+    corrValuesInvertedTrackerFine,
+    logErrors
   );
   LOG_DEBUG("Time offset with sign convention #2: " << bestCorrelationTimeOffsetInvertedTracker);
 
@@ -791,7 +840,7 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeMovingSignalLagSec(TEMPORAL_CA
 
   // Get a normalized tracker position metric that can be displayed
   double unusedNormFactor = 1.0;
-  NormalizeMetricValues(this->MovingSignal.normalizedSignalValues, unusedNormFactor);
+  NormalizeMetricValues(this->MovingSignal.normalizedSignalValues, unusedNormFactor, 0, -1, logErrors);
 
   this->CalibrationError = sqrt(-this->BestCorrelationValue) / this->BestCorrelationNormalizationFactor;   // RMSE in mm
 
@@ -839,18 +888,42 @@ PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeMovingSignalLagSec(TEMPORAL_CA
 
   this->MaxCalibrationError = std::sqrt(this->MaxCalibrationError) / this->BestCorrelationNormalizationFactor;
 
+  // Correlation coefficient of the aligned signals, indicates how reliable the computed lag is
+  double fixedMean = 0;
+  double movingMean = 0;
+  for (unsigned int i = 0; i < resampledNormalizedTrackerPositionMetric.size(); ++i)
+  {
+    fixedMean += this->FixedSignal.signalValues.at(i);
+    movingMean += resampledNormalizedTrackerPositionMetric.at(i);
+  }
+  fixedMean /= resampledNormalizedTrackerPositionMetric.size();
+  movingMean /= resampledNormalizedTrackerPositionMetric.size();
+  double covariance = 0;
+  double fixedVariance = 0;
+  double movingVariance = 0;
+  for (unsigned int i = 0; i < resampledNormalizedTrackerPositionMetric.size(); ++i)
+  {
+    double fixedDiff = this->FixedSignal.signalValues.at(i) - fixedMean;
+    double movingDiff = resampledNormalizedTrackerPositionMetric.at(i) - movingMean;
+    covariance += fixedDiff * movingDiff;
+    fixedVariance += fixedDiff * fixedDiff;
+    movingVariance += movingDiff * movingDiff;
+  }
+  this->AlignedSignalCorrelation = (fixedVariance > 0 && movingVariance > 0) ? covariance / std::sqrt(fixedVariance * movingVariance) : 0.0;
+
   this->NeverUpdated = false;
 
   if (this->BestCorrelationValue <= SIGNAL_ALIGNMENT_METRIC_THRESHOLD[SIGNAL_ALIGNMENT_METRIC])
   {
     error = TEMPORAL_CALIBRATION_ERROR_RESULT_ABOVE_THRESHOLD;
-    LOG_ERROR("Calculated correlation exceeds threshold value. This may be an indicator of a poor calibration.");
+    LOG_ERROR_OR_DEBUG(logErrors, "Calculated correlation exceeds threshold value. This may be an indicator of a poor calibration.");
     return PLUS_FAIL;
   }
 
   LOG_DEBUG("Temporal calibration BestCorrelationValue = " << this->BestCorrelationValue << " (threshold=" << SIGNAL_ALIGNMENT_METRIC_THRESHOLD[SIGNAL_ALIGNMENT_METRIC] << ")");
   LOG_DEBUG("MaxCalibrationError=" << this->MaxCalibrationError);
   LOG_DEBUG("CalibrationError=" << this->CalibrationError);
+  LOG_DEBUG("AlignedSignalCorrelation=" << this->AlignedSignalCorrelation);
   return PLUS_SUCCESS;
 }
 
@@ -924,3 +997,340 @@ void vtkPlusTemporalCalibrationAlgo::SetVideoClipRectangle(int* clipRectOriginIn
   this->LineSegmentationClipRectangleSize[0] = clipRectSizeIntVec[0];
   this->LineSegmentationClipRectangleSize[1] = clipRectSizeIntVec[1];
 }
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::StartStreaming(FRAME_TYPE fixedFrameType, FRAME_TYPE movingFrameType)
+{
+  const FRAME_TYPE frameTypes[2] = { fixedFrameType, movingFrameType };
+  const std::string* transformNames[2] = { &this->FixedSignal.probeToReferenceTransformName, &this->MovingSignal.probeToReferenceTransformName };
+  bool videoSignal = false;
+  for (int i = 0; i < 2; ++i)
+  {
+    switch (frameTypes[i])
+    {
+    case FRAME_TYPE_TRACKER:
+    {
+      PlusTransformName transformName;
+      if (transformName.SetTransformName(transformNames[i]->c_str()) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Cannot start streaming temporal calibration, transform name is invalid (" << *transformNames[i] << ")");
+        return PLUS_FAIL;
+      }
+      break;
+    }
+    case FRAME_TYPE_VIDEO:
+      videoSignal = true;
+      break;
+    default:
+      LOG_ERROR("Cannot start streaming temporal calibration. Unknown frame type: " << frameTypes[i]);
+      return PLUS_FAIL;
+    }
+  }
+
+  if (videoSignal)
+  {
+    if (this->StreamingLineSegmenter == NULL)
+    {
+      this->StreamingLineSegmenter = vtkPlusLineSegmentationAlgo::New();
+    }
+    this->StreamingLineSegmenter->SetClipRectangle(this->LineSegmentationClipRectangleOrigin, this->LineSegmentationClipRectangleSize);
+    this->StreamingLineSegmenter->SetSaveIntermediateImages(this->SaveIntermediateImages);
+    this->StreamingLineSegmenter->SetIntermediateFilesOutputDirectory(this->IntermediateFilesOutputDirectory);
+  }
+
+  this->FixedSignal.frameType = fixedFrameType;
+  this->MovingSignal.frameType = movingFrameType;
+  StreamingSignalType* streamingSignals[2] = { &this->StreamingFixedSignal, &this->StreamingMovingSignal };
+  for (int i = 0; i < 2; ++i)
+  {
+    streamingSignals[i]->frameType = frameTypes[i];
+    streamingSignals[i]->numberOfFrames = 0;
+    streamingSignals[i]->timestamps.clear();
+    streamingSignals[i]->values.clear();
+  }
+
+  this->RunningEstimateAttempted = false;
+  this->RunningEstimateValid = false;
+  this->Streaming = true;
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::AddFixedFrames(vtkPlusTrackedFrameList* frameList)
+{
+  if (!this->Streaming)
+  {
+    LOG_ERROR("Cannot add fixed frames, streaming temporal calibration is not started");
+    return PLUS_FAIL;
+  }
+  if (AddStreamingFrames(frameList, this->FixedSignal.probeToReferenceTransformName, this->StreamingFixedSignal) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to compute position signal from fixed frames");
+    return PLUS_FAIL;
+  }
+  UpdateRunningEstimate();
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::AddMovingFrames(vtkPlusTrackedFrameList* frameList)
+{
+  if (!this->Streaming)
+  {
+    LOG_ERROR("Cannot add moving frames, streaming temporal calibration is not started");
+    return PLUS_FAIL;
+  }
+  if (AddStreamingFrames(frameList, this->MovingSignal.probeToReferenceTransformName, this->StreamingMovingSignal) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to compute position signal from moving frames");
+    return PLUS_FAIL;
+  }
+  UpdateRunningEstimate();
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::AddStreamingFrames(vtkPlusTrackedFrameList* frameList, const std::string& probeToReferenceTransformName, StreamingSignalType& streamingSignal)
+{
+  if (frameList == NULL)
+  {
+    LOG_ERROR("Cannot add frames, the frame list is NULL");
+    return PLUS_FAIL;
+  }
+  if (frameList->GetNumberOfTrackedFrames() == 0)
+  {
+    return PLUS_SUCCESS;
+  }
+
+  vtkSmartPointer<vtkPlusTransformRepository> transformRepository;
+  vtkSmartPointer<vtkMatrix4x4> probeToReferenceTransform;
+  PlusTransformName transformName;
+  if (streamingSignal.frameType == FRAME_TYPE_TRACKER)
+  {
+    transformRepository = vtkSmartPointer<vtkPlusTransformRepository>::New();
+    probeToReferenceTransform = vtkSmartPointer<vtkMatrix4x4>::New();
+    transformName.SetTransformName(probeToReferenceTransformName.c_str());
+  }
+
+  for (unsigned int frameIndex = 0; frameIndex < frameList->GetNumberOfTrackedFrames(); ++frameIndex)
+  {
+    PlusTrackedFrame* trackedFrame = frameList->GetTrackedFrame(frameIndex);
+    unsigned int frameNumber = streamingSignal.numberOfFrames++;
+    double timestamp = trackedFrame->GetTimestamp();
+    if (!streamingSignal.timestamps.empty() && timestamp <= streamingSignal.timestamps.back())
+    {
+      LOG_DEBUG("Skip frame " << frameNumber << ", its timestamp (" << timestamp << ") is not newer than the previous frame's");
+      continue;
+    }
+
+    if (streamingSignal.frameType == FRAME_TYPE_TRACKER)
+    {
+      transformRepository->SetTransforms(*trackedFrame);
+      bool valid = false;
+      transformRepository->GetTransform(transformName, probeToReferenceTransform, &valid);
+      if (!valid)
+      {
+        // There is no available transform for this frame; skip that frame
+        continue;
+      }
+      streamingSignal.timestamps.push_back(timestamp);
+      streamingSignal.values.push_back(probeToReferenceTransform->GetElement(0, 3));
+      streamingSignal.values.push_back(probeToReferenceTransform->GetElement(1, 3));
+      streamingSignal.values.push_back(probeToReferenceTransform->GetElement(2, 3));
+    }
+    else
+    {
+      PlusVideoFrame* videoFrame = trackedFrame->GetImageData();
+      if (videoFrame->IsImageValid() && (videoFrame->GetImageOrientation() != US_IMG_ORIENT_MF || videoFrame->GetImageType() != US_IMG_BRIGHTNESS))
+      {
+        LOG_ERROR("Video data orientation or type is not supported (MF orientation, BRIGHTNESS type is expected)");
+        return PLUS_FAIL;
+      }
+      vtkPlusLineSegmentationAlgo::LineParameters lineParameters;
+      double linePosition = 0;
+      if (this->StreamingLineSegmenter->DetectLine(*trackedFrame, frameNumber, lineParameters, linePosition) != PLUS_SUCCESS)
+      {
+        // Line detection failed; skip that frame
+        continue;
+      }
+      streamingSignal.timestamps.push_back(timestamp);
+      streamingSignal.values.push_back(linePosition);
+    }
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::ComputePositionSignalValuesFromStreaming(const StreamingSignalType& streamingSignal, SignalType& signal, bool logErrors)
+{
+  signal.signalTimestamps.clear();
+  signal.signalValues.clear();
+
+  // Frames in the signal time range
+  std::vector<unsigned int> frameIndices;
+  for (unsigned int i = 0; i < streamingSignal.timestamps.size(); ++i)
+  {
+    if (streamingSignal.timestamps[i] >= signal.signalTimeRangeMin && streamingSignal.timestamps[i] <= signal.signalTimeRangeMax)
+    {
+      frameIndices.push_back(i);
+    }
+  }
+  if (frameIndices.size() < 2)
+  {
+    LOG_ERROR_OR_DEBUG(logErrors, "Not enough frames are available in the signal time range");
+    return PLUS_FAIL;
+  }
+
+  double minimumPeakToPeak = 0;
+  switch (streamingSignal.frameType)
+  {
+  case FRAME_TYPE_TRACKER:
+  {
+    // Calculate the principal axis of motion the same way as for tracked frame lists
+    std::deque<itk::Point<double, 3> > trackerPositions;
+    for (std::vector<unsigned int>::iterator it = frameIndices.begin(); it != frameIndices.end(); ++it)
+    {
+      itk::Point<double, 3> trackerPosition;
+      trackerPosition[0] = streamingSignal.values[3 * (*it)];
+      trackerPosition[1] = streamingSignal.values[3 * (*it) + 1];
+      trackerPosition[2] = streamingSignal.values[3 * (*it) + 2];
+      trackerPositions.push_back(trackerPosition);
+    }
+    vtkSmartPointer<vtkPlusPrincipalMotionDetectionAlgo> trackerDataMetricExtractor = vtkSmartPointer<vtkPlusPrincipalMotionDetectionAlgo>::New();
+    itk::Point<double, 3> principalAxisOfMotion;
+    trackerDataMetricExtractor->ComputePrincipalAxis(trackerPositions, principalAxisOfMotion, static_cast<int>(trackerPositions.size()));
+
+    // Project the tool positions onto the principal axis of motion
+    for (unsigned int i = 0; i < frameIndices.size(); ++i)
+    {
+      signal.signalTimestamps.push_back(streamingSignal.timestamps[frameIndices[i]]);
+      signal.signalValues.push_back(trackerPositions[i][0] * principalAxisOfMotion[0]
+                                    + trackerPositions[i][1] * principalAxisOfMotion[1]
+                                    + trackerPositions[i][2] * principalAxisOfMotion[2]);
+    }
+    minimumPeakToPeak = MINIMUM_TRACKER_SIGNAL_PEAK_TO_PEAK_MM;
+    break;
+  }
+  case FRAME_TYPE_VIDEO:
+    for (std::vector<unsigned int>::iterator it = frameIndices.begin(); it != frameIndices.end(); ++it)
+    {
+      signal.signalTimestamps.push_back(streamingSignal.timestamps[*it]);
+      signal.signalValues.push_back(streamingSignal.values[*it]);
+    }
+    minimumPeakToPeak = MINIMUM_VIDEO_SIGNAL_PEAK_TO_PEAK_PIXEL;
+    break;
+  default:
+    LOG_ERROR("Compute position signal value failed. Unknown frame type: " << streamingSignal.frameType);
+    return PLUS_FAIL;
+  }
+
+  // If the metric values do not "swing" sufficiently, the signal is considered constant--i.e. infinite period--and will
+  // not work for our purposes
+  double minValue = 0;
+  double maxValue = 0;
+  GetSignalRange(signal.signalValues, 0, signal.signalValues.size() - 1, minValue, maxValue);
+  double maxPeakToPeak = std::abs(maxValue - minValue);
+  if (maxPeakToPeak < minimumPeakToPeak)
+  {
+    LOG_ERROR_OR_DEBUG(logErrors, "Detected metric values do not vary sufficiently. Actual peak-to-peak variation: " << maxPeakToPeak << ", expected minimum: " << minimumPeakToPeak);
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::ComputeMovingSignalLagFromStreaming(TEMPORAL_CALIBRATION_ERROR& error, bool logErrors)
+{
+  if (this->StreamingFixedSignal.timestamps.empty() || this->StreamingMovingSignal.timestamps.empty())
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_NO_TIMESTAMPS;
+    LOG_ERROR_OR_DEBUG(logErrors, "No position signal could be computed from the " << (this->StreamingFixedSignal.timestamps.empty() ? "fixed" : "moving") << " frames");
+    return PLUS_FAIL;
+  }
+
+  double fixedTimestampMin = this->StreamingFixedSignal.timestamps.front();
+  double fixedTimestampMax = this->StreamingFixedSignal.timestamps.back();
+  double movingTimestampMin = this->StreamingMovingSignal.timestamps.front();
+  double movingTimestampMax = this->StreamingMovingSignal.timestamps.back();
+  if (ComputeCommonTimeRange(fixedTimestampMin, fixedTimestampMax, movingTimestampMin, movingTimestampMax, logErrors) != PLUS_SUCCESS)
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_NO_COMMON_TIME_RANGE;
+    return PLUS_FAIL;
+  }
+
+  if (ComputePositionSignalValuesFromStreaming(this->StreamingFixedSignal, this->FixedSignal, logErrors) != PLUS_SUCCESS)
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_FAILED_COMPUTE_FIXED;
+    LOG_ERROR_OR_DEBUG(logErrors, "Failed to compute position signal from fixed frames");
+    return PLUS_FAIL;
+  }
+  if (ComputePositionSignalValuesFromStreaming(this->StreamingMovingSignal, this->MovingSignal, logErrors) != PLUS_SUCCESS)
+  {
+    error = TEMPORAL_CALIBRATION_ERROR_FAILED_COMPUTE_MOVING;
+    LOG_ERROR_OR_DEBUG(logErrors, "Failed to compute position signal from moving frames");
+    return PLUS_FAIL;
+  }
+
+  return ComputeMovingSignalLagFromPositionSignals(error, logErrors);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusTemporalCalibrationAlgo::UpdateRunningEstimate()
+{
+  if (this->StreamingFixedSignal.timestamps.empty() || this->StreamingMovingSignal.timestamps.empty())
+  {
+    return;
+  }
+  double latestTimestamp = std::min(this->StreamingFixedSignal.timestamps.back(), this->StreamingMovingSignal.timestamps.back());
+  if (this->RunningEstimateAttempted && latestTimestamp - this->RunningEstimateTimestamp < this->StreamingUpdateIntervalSec)
+  {
+    return;
+  }
+  this->RunningEstimateAttempted = true;
+  this->RunningEstimateTimestamp = latestTimestamp;
+
+  TEMPORAL_CALIBRATION_ERROR error = TEMPORAL_CALIBRATION_ERROR_NONE;
+  if (ComputeMovingSignalLagFromStreaming(error, false) != PLUS_SUCCESS)
+  {
+    LOG_DEBUG("Running lag estimate is not available yet (error code: " << error << ")");
+    return;
+  }
+  this->RunningEstimateValid = true;
+  this->RunningMovingLagSec = this->MovingLagSec;
+  this->RunningLagConfidence = this->AlignedSignalCorrelation;
+  LOG_DEBUG("Running lag estimate: " << this->RunningMovingLagSec << " sec (confidence: " << this->RunningLagConfidence << ")");
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::GetRunningMovingLagSec(double& lagSec, double& confidence)
+{
+  if (!this->RunningEstimateValid)
+  {
+    return PLUS_FAIL;
+  }
+  lagSec = this->RunningMovingLagSec;
+  confidence = this->RunningLagConfidence;
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusTemporalCalibrationAlgo::StopStreaming(TEMPORAL_CALIBRATION_ERROR& error)
+{
+  if (!this->Streaming)
+  {
+    LOG_ERROR("Cannot stop streaming temporal calibration, it is not started");
+    return PLUS_FAIL;
+  }
+  this->Streaming = false;
+
+  if (ComputeMovingSignalLagFromStreaming(error, true) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  this->RunningEstimateValid = true;
+  this->RunningMovingLagSec = this->MovingLagSec;
+  this->RunningLagConfidence = this->AlignedSignalCorrelation;
+  error = TEMPORAL_CALIBRATION_ERROR_NONE;
+  return PLUS_SUCCESS;
+}
@@ -16,6 +16,7 @@
 
 class PlusTrackedFrame;
 class vtkPiecewiseFunction;
+class vtkPlusLineSegmentationAlgo;
 class vtkTable;
 class vtkPlusTrackedFrameList;
 
@@ -25,6 +26,11 @@ class vtkPlusTrackedFrameList;
 
   See more infomation in the \ref AlgorithmTemporalCalibration "user documentation".
 
+  The lag can be computed from recorded frame lists (SetFixedFrames, SetMovingFrames, Update) or
+  during the acquisition (StartStreaming, AddFixedFrames, AddMovingFrames, StopStreaming).
+  In streaming mode the position metric is extracted from each frame when it is added and only
+  the metric values are kept, so the result is available shortly after the acquisition is stopped.
+
   \ingroup PlusLibCalibrationAlgorithm
 */
 
@@ -138,17 +144,85 @@ public:
   PlusStatus GetBestCorrelation(double& videoCorrelation);
   PlusStatus GetMaxCalibrationError(double& maxCalibrationError);
 
+  /*!
+    Start computing the lag from frames that are added while they are acquired.
+    Previously added frames are discarded. Probe to reference transform names and the video clip rectangle must be set before calling this method.
+  */
+  PlusStatus StartStreaming(FRAME_TYPE fixedFrameType, FRAME_TYPE movingFrameType);
+
+  /*!
+    Add fixed frames that were acquired since the previous call (e.g., the frames that vtkPlusChannel::GetTrackedFrameList returned since the last timestamp).
+    The position metric is computed from the frames immediately and the running lag estimate is updated if StreamingUpdateIntervalSec has elapsed.
+  */
+  PlusStatus AddFixedFrames(vtkPlusTrackedFrameList* frameList);
+
+  /*! Add moving frames that were acquired since the previous call. See AddFixedFrames. */
+  PlusStatus AddMovingFrames(vtkPlusTrackedFrameList* frameList);
+
+  /*!
+    Get the latest lag estimate that was computed during streaming.
+    \param lagSec Time [s] by which the moving signal lags the fixed signal
+    \param confidence Correlation coefficient of the aligned fixed and moving signals (1.0 if the signals match perfectly)
+    \return PLUS_FAIL if not enough motion has been acquired yet to estimate the lag
+  */
+  PlusStatus GetRunningMovingLagSec(double& lagSec, double& confidence);
+
+  /*! Compute the lag from all the frames that were added since StartStreaming. The results are available the same way as after Update(). */
+  PlusStatus StopStreaming(TEMPORAL_CALIBRATION_ERROR& error);
+
+  /*! Returns true between StartStreaming and StopStreaming */
+  vtkGetMacro(Streaming, bool);
+
+  /*! Minimum amount of new data [s] between running lag estimates in streaming mode. Default is 1 second. */
+  vtkSetMacro(StreamingUpdateIntervalSec, double);
+  vtkGetMacro(StreamingUpdateIntervalSec, double);
+
 protected:
+  /*! Position metric that is computed from the frames as they are added in streaming mode */
+  struct StreamingSignalType
+  {
+    FRAME_TYPE frameType;
+    /*! Number of frames that have been added, used as frame index for seeding the line detection */
+    unsigned int numberOfFrames;
+    /*! Timestamps of the frames where the position metric could be computed */
+    std::deque<double> timestamps;
+    /*! Detected line positions (one value per timestamp) for video, tool positions (three values per timestamp) for tracker frames */
+    std::deque<double> values;
+  };
+
   PlusStatus ComputeMovingSignalLagSec(TEMPORAL_CALIBRATION_ERROR& error);
   PlusStatus ComputePositionSignalValues(SignalType& signal);
   PlusStatus GetSignalRange(const std::deque<double>& signal, int startIndex, int stopIndex, double& minValue, double& maxValue);
 
   /*! Determine common signal time range between the fixed and moving signals  */
   PlusStatus ComputeCommonTimeRange();
+  PlusStatus ComputeCommonTimeRange(double fixedTimestampMin, double fixedTimestampMax, double movingTimestampMin, double movingTimestampMax, bool logErrors = true);
+
+  /*!
+    Find the lag that best aligns the position signals. The signal values and timestamps must be computed already.
+    \param logErrors If false then problems are only logged at debug level
+  */
+  PlusStatus ComputeMovingSignalLagFromPositionSignals(TEMPORAL_CALIBRATION_ERROR& error, bool logErrors = true);
 
-  PlusStatus NormalizeMetricValues(std::deque<double>& signal, double& normalizationFactor, int startIndex = 0, int stopIndex = -1);
-  PlusStatus NormalizeMetricValues(std::deque<double>& signal, double& normalizationFactor, double startTime, double stopTime, const std::deque<double>& timestamps);
-  void ComputeCorrelationBetweenFixedAndMovingSignal(double minTrackerLagSec, double maxTrackerLagSec, double stepSizeSec, double& bestCorrelationValue, double& bestCorrelationTimeOffset, double& bestCorrelationNormalizationFactor, std::deque<double>& corrTimeOffsets, std::deque<double>& corrValues);
+  /*! Compute the position metric from the frames and append it to the streaming signal */
+  PlusStatus AddStreamingFrames(vtkPlusTrackedFrameList* frameList, const std::string& probeToReferenceTransformName, StreamingSignalType& streamingSignal);
+
+  /*!
+    Copy the part of the streaming signal that is in the signal time range to the position signal.
+    Tool positions are projected to their principal axis of motion.
+    \param logErrors If false then problems are only logged at debug level (used for running estimates, when it is expected that there is not enough data yet)
+  */
+  PlusStatus ComputePositionSignalValuesFromStreaming(const StreamingSignalType& streamingSignal, SignalType& signal, bool logErrors);
+
+  /*! Compute the lag from the streaming signals */
+  PlusStatus ComputeMovingSignalLagFromStreaming(TEMPORAL_CALIBRATION_ERROR& error, bool logErrors);
+
+  /*! Update the running lag estimate if enough new data has been added since the previous estimate */
+  void UpdateRunningEstimate();
+
+  PlusStatus NormalizeMetricValues(std::deque<double>& signal, double& normalizationFactor, int startIndex = 0, int stopIndex = -1, bool logErrors = true);
+  PlusStatus NormalizeMetricValues(std::deque<double>& signal, double& normalizationFactor, double startTime, double stopTime, const std::deque<double>& timestamps, bool logErrors = true);
+  void ComputeCorrelationBetweenFixedAndMovingSignal(double minTrackerLagSec, double maxTrackerLagSec, double stepSizeSec, double& bestCorrelationValue, double& bestCorrelationTimeOffset, double& bestCorrelationNormalizationFactor, std::deque<double>& corrTimeOffsets, std::deque<double>& corrValues, bool logErrors = true);
 
   double ComputeAlignmentMetric(const std::deque<double>& signalA, const std::deque<double>& signalB);
 
@@ -213,6 +287,26 @@ protected:
   /*! Clip rectangle origin for the line segmentation (in pixels). Everything outside the rectangle is ignored. */
   int LineSegmentationClipRectangleSize[2];
 
+  /*! Correlation coefficient of the fixed and moving signals, aligned with the computed lag */
+  double AlignedSignalCorrelation;
+
+  /*! True between StartStreaming and StopStreaming */
+  bool Streaming;
+  StreamingSignalType StreamingFixedSignal;
+  StreamingSignalType StreamingMovingSignal;
+
+  /*! Line segmenter that processes the video frames in streaming mode */
+  vtkPlusLineSegmentationAlgo* StreamingLineSegmenter;
+
+  /*! Minimum amount of new data [s] between running lag estimates in streaming mode */
+  double StreamingUpdateIntervalSec;
+  /*! Latest timestamp of the data that was available at the previous running estimate attempt */
+  double RunningEstimateTimestamp;
+  bool RunningEstimateAttempted;
+  bool RunningEstimateValid;
+  double RunningMovingLagSec;
+  double RunningLagConfidence;
+
 private:
   vtkPlusTemporalCalibrationAlgo();
   ~vtkPlusTemporalCalibrationAlgo();
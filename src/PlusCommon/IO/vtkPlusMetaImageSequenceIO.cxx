@@ -7,6 +7,8 @@ See License.txt for details.
 #include "PlusConfigure.h"
 #include "itksys/SystemTools.hxx"
 #include "vtkPlusMetaImageSequenceIO.h"
+#include <algorithm>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <vector>
@@ -50,6 +52,9 @@ namespace
 
   static const int MAX_LINE_LENGTH = 1000;
 
+  // Size of the blocks that the header is read in, in bytes
+  static const size_t HEADER_READ_BLOCK_SIZE = 1024 * 1024;
+
   static const int SEQMETA_FIELD_PADDED_LINE_LENGTH = 40;
   static const char* SEQMETA_FIELD_US_IMG_ORIENT = "UltrasoundImageOrientation";
   static const char* SEQMETA_FIELD_US_IMG_TYPE = "UltrasoundImageType";
@@ -61,23 +66,66 @@ namespace
 
   static std::string SEQMETA_FIELD_FRAME_FIELD_PREFIX = "Seq_Frame";
   static std::string SEQMETA_FIELD_IMG_STATUS = "ImageStatus";
+
+  //----------------------------------------------------------------------------
+  // Remove white-space characters from the beginning and end of a text, the same way as PlusCommon::Trim
+  void TrimHeaderText(const char*& begin, const char*& end)
+  {
+    while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r' || *begin == '\n'))
+    {
+      ++begin;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n'))
+    {
+      --end;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Parse the frame number of a frame field name (e.g., 0012 in Seq_Frame0012_Timestamp)
+  PlusStatus ParseHeaderFrameNumber(const char* begin, const char* end, int& frameNumber)
+  {
+    // More than 9 digits could overflow
+    if (begin == end || end - begin > 9)
+    {
+      return PLUS_FAIL;
+    }
+    frameNumber = 0;
+    for (const char* digit = begin; digit < end; ++digit)
+    {
+      if (*digit < '0' || *digit > '9')
+      {
+        return PLUS_FAIL;
+      }
+      frameNumber = frameNumber * 10 + (*digit - '0');
+    }
+    return PLUS_SUCCESS;
+  }
 }
 
 //----------------------------------------------------------------------------
 
 vtkStandardNewMacro(vtkPlusMetaImageSequenceIO);
+vtkCxxSetObjectMacro(vtkPlusMetaImageSequenceIO, PixelDataSource, vtkPlusMetaImageSequenceIO);
 
 //----------------------------------------------------------------------------
 vtkPlusMetaImageSequenceIO::vtkPlusMetaImageSequenceIO()
   : vtkPlusSequenceIOBase()
   , IsPixelDataBinary(true)
   , Output2DDataWithZDimensionIncluded(false)
+  , PixelDataSource(NULL)
+  , FramePixelsInputStream(NULL)
+  , DecompressionStreamActive(false)
+  , NextDecompressedFrameNumber(0)
+  , CompressedBytesRemaining(0)
 {
 }
 
 //----------------------------------------------------------------------------
 vtkPlusMetaImageSequenceIO::~vtkPlusMetaImageSequenceIO()
 {
+  this->CloseFramePixelsInputStream();
+  this->SetPixelDataSource(NULL);
 }
 
 //----------------------------------------------------------------------------
@@ -88,6 +136,13 @@ void vtkPlusMetaImageSequenceIO::PrintSelf(ostream& os, vtkIndent indent)
   // TODO : anything specific to print
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusMetaImageSequenceIO::SetFrameFieldNamesToRead(const std::vector<std::string>& fieldNames)
+{
+  this->FrameFieldNamesToRead.clear();
+  this->FrameFieldNamesToRead.insert(fieldNames.begin(), fieldNames.end());
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusMetaImageSequenceIO::ReadImageHeader()
 {
@@ -99,30 +154,92 @@ PlusStatus vtkPlusMetaImageSequenceIO::ReadImageHeader()
     return PLUS_FAIL;
   }
 
-  char line[MAX_LINE_LENGTH + 1] = {0};
-  while (fgets(line, MAX_LINE_LENGTH, stream))
-  {
+  // The header is read in large blocks and split into lines in memory, which is much faster
+  // than reading it line by line when there are hundreds of thousands of frame fields
+  std::vector<char> buffer(HEADER_READ_BLOCK_SIZE);
+  FilePositionOffsetType bufferFileOffset = 0; // position of the first byte of the buffer in the file
+  size_t bufferDataSize = 0; // number of bytes in the buffer that are read from the file
+  size_t lineStart = 0; // position of the next line in the buffer
+  bool endOfFile = false;
 
-    std::string lineStr = line;
+  // Consecutive frame fields usually belong to the same frame, so the frame is only looked up when the frame number changes
+  int currentFrameNumber = -1;
+  PlusTrackedFrame* currentFrame = NULL;
+
+  // Reused for each line to avoid memory allocations
+  std::string name;
+  std::string value;
+
+  while (true)
+  {
+    const char* lineBegin = &buffer[0] + lineStart;
+    const char* lineEnd = static_cast<const char*>(memchr(lineBegin, '\n', bufferDataSize - lineStart));
+    size_t nextLineStart = 0;
+    if (lineEnd != NULL)
+    {
+      nextLineStart = lineEnd - &buffer[0] + 1;
+    }
+    else if (!endOfFile)
+    {
+      // Line is incomplete, move it to the beginning of the buffer and read the next block
+      size_t incompleteLineSize = bufferDataSize - lineStart;
+      memmove(&buffer[0], &buffer[0] + lineStart, incompleteLineSize);
+      bufferFileOffset += lineStart;
+      bufferDataSize = incompleteLineSize;
+      lineStart = 0;
+      if (bufferDataSize == buffer.size())
+      {
+        // Line is longer than the buffer
+        buffer.resize(buffer.size() * 2);
+      }
+      size_t readSize = fread(&buffer[0] + bufferDataSize, 1, buffer.size() - bufferDataSize, stream);
+      if (readSize == 0)
+      {
+        if (ferror(stream))
+        {
+          LOG_ERROR("Error reading the file " << this->FileName);
+          break;
+        }
+        endOfFile = true;
+      }
+      bufferDataSize += readSize;
+      continue;
+    }
+    else if (lineStart < bufferDataSize)
+    {
+      // Last line of the file, without line ending
+      lineEnd = &buffer[0] + bufferDataSize;
+      nextLineStart = bufferDataSize;
+    }
+    else
+    {
+      // End of file
+      break;
+    }
+    lineStart = nextLineStart;
 
     // Split line into name and value
-    size_t equalSignFound;
-    equalSignFound = lineStr.find_first_of("=");
-    if (equalSignFound == std::string::npos)
+    const char* equalSign = static_cast<const char*>(memchr(lineBegin, '=', lineEnd - lineBegin));
+    if (equalSign == NULL)
     {
-      LOG_WARNING("Parsing line failed, equal sign is missing (" << lineStr << ")");
+      LOG_WARNING("Parsing line failed, equal sign is missing (" << std::string(lineBegin, lineEnd) << ")");
       continue;
     }
-    std::string name = lineStr.substr(0, equalSignFound);
-    std::string value = lineStr.substr(equalSignFound + 1);
+    const char* nameBegin = lineBegin;
+    const char* nameEnd = equalSign;
+    const char* valueBegin = equalSign + 1;
+    const char* valueEnd = lineEnd;
 
     // trim spaces from the left and right
-    PlusCommon::Trim(name);
-    PlusCommon::Trim(value);
+    TrimHeaderText(nameBegin, nameEnd);
+    TrimHeaderText(valueBegin, valueEnd);
 
-    if (name.compare(0, SEQMETA_FIELD_FRAME_FIELD_PREFIX.size(), SEQMETA_FIELD_FRAME_FIELD_PREFIX) != 0)
+    if (static_cast<size_t>(nameEnd - nameBegin) < SEQMETA_FIELD_FRAME_FIELD_PREFIX.size()
+        || memcmp(nameBegin, SEQMETA_FIELD_FRAME_FIELD_PREFIX.c_str(), SEQMETA_FIELD_FRAME_FIELD_PREFIX.size()) != 0)
     {
       // field
+      name.assign(nameBegin, nameEnd);
+      value.assign(valueBegin, valueEnd);
       SetCustomString(name.c_str(), value.c_str());
 
       // Arrived to ElementDataFile, this is the last element
@@ -130,8 +247,8 @@ PlusStatus vtkPlusMetaImageSequenceIO::ReadImageHeader()
       {
         if (value.compare(SEQMETA_FIELD_VALUE_ELEMENT_DATA_FILE_LOCAL) == 0)
         {
-          // pixel data stored locally
-          this->PixelDataFileOffset = FTELL(stream);
+          // pixel data stored locally, right after this line
+          this->PixelDataFileOffset = bufferFileOffset + nextLineStart;
         }
         else
         {
@@ -147,36 +264,38 @@ PlusStatus vtkPlusMetaImageSequenceIO::ReadImageHeader()
     {
       // frame field
       // name: Seq_Frame0000_CustomTransform
-      name.erase(0, SEQMETA_FIELD_FRAME_FIELD_PREFIX.size());   // 0000_CustomTransform
-
-      // Split line into name and value
-      size_t underscoreFound;
-      underscoreFound = name.find_first_of("_");
-      if (underscoreFound == std::string::npos)
+      const char* frameNumberBegin = nameBegin + SEQMETA_FIELD_FRAME_FIELD_PREFIX.size();   // 0000_CustomTransform
+      const char* underscore = static_cast<const char*>(memchr(frameNumberBegin, '_', nameEnd - frameNumberBegin));
+      if (underscore == NULL)
       {
-        LOG_WARNING("Parsing line failed, underscore is missing from frame field name (" << lineStr << ")");
+        LOG_WARNING("Parsing line failed, underscore is missing from frame field name (" << std::string(lineBegin, lineEnd) << ")");
         continue;
       }
-      std::string frameNumberStr = name.substr(0, underscoreFound);   // 0000
-      std::string frameFieldName = name.substr(underscoreFound + 1);   // CustomTransform
 
       int frameNumber = 0;
-      if (PlusCommon::StringToInt(frameNumberStr.c_str(), frameNumber) != PLUS_SUCCESS)
+      if (ParseHeaderFrameNumber(frameNumberBegin, underscore, frameNumber) != PLUS_SUCCESS)
       {
-        LOG_WARNING("Parsing line failed, cannot get frame number from frame field (" << lineStr << ")");
+        LOG_WARNING("Parsing line failed, cannot get frame number from frame field (" << std::string(lineBegin, lineEnd) << ")");
         continue;
       }
-      SetCustomFrameString(frameNumber, frameFieldName.c_str(), value.c_str());
 
-      if (ferror(stream))
+      // The frame is created even if none of its fields are requested, so that the number of frames is the same as when all fields are read
+      if (frameNumber != currentFrameNumber)
       {
-        LOG_ERROR("Error reading the file " << this->FileName);
-        break;
+        this->CreateTrackedFrameIfNonExisting(frameNumber);
+        currentFrame = this->TrackedFrameList->GetTrackedFrame(frameNumber);
+        currentFrameNumber = frameNumber;
       }
-      if (feof(stream))
+
+      name.assign(underscore + 1, nameEnd);   // CustomTransform
+      if (!this->FrameFieldNamesToRead.empty() && name.compare(SEQMETA_FIELD_IMG_STATUS) != 0
+          && this->FrameFieldNamesToRead.find(name) == this->FrameFieldNamesToRead.end())
       {
-        break;
+        // this field is not requested
+        continue;
       }
+      value.assign(valueBegin, valueEnd);
+      currentFrame->SetCustomFrameField(name, value);
     }
   }
 
@@ -488,6 +607,191 @@ PlusStatus vtkPlusMetaImageSequenceIO::ReadImagePixels()
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::ReadHeader()
+{
+  // The pixel data may be in a different file or at a different offset, so start reading frames from scratch
+  this->CloseFramePixelsInputStream();
+  return Superclass::ReadHeader();
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusMetaImageSequenceIO::CanReadFramePixels() const
+{
+  return true;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::ReadFramePixels(unsigned int frameNumber, PlusVideoFrame& videoFrame)
+{
+  if (frameNumber >= this->Dimensions[3])
+  {
+    LOG_ERROR("Cannot read frame " << frameNumber << " from " << this->FileName << ", the sequence contains " << this->Dimensions[3] << " frames");
+    return PLUS_FAIL;
+  }
+
+  unsigned int frameSizeInBytes = 0;
+  if (this->Dimensions[0] > 0 && this->Dimensions[1] > 0 && this->Dimensions[2] > 0)
+  {
+    frameSizeInBytes = this->Dimensions[0] * this->Dimensions[1] * this->Dimensions[2] * PlusVideoFrame::GetNumberOfBytesPerScalar(this->PixelType) * this->NumberOfScalarComponents;
+  }
+  if (frameSizeInBytes == 0)
+  {
+    LOG_ERROR("No image data in the metafile: " << this->FileName);
+    return PLUS_FAIL;
+  }
+
+  if (this->FramePixelsInputStream == NULL)
+  {
+    if (FileOpen(&this->FramePixelsInputStream, GetPixelDataFilePath().c_str(), "rb") != PLUS_SUCCESS)
+    {
+      LOG_ERROR("The file " << GetPixelDataFilePath() << " could not be opened for reading");
+      this->FramePixelsInputStream = NULL;
+      return PLUS_FAIL;
+    }
+  }
+  this->FramePixelsBuffer.resize(frameSizeInBytes);
+
+  if (!this->UseCompression)
+  {
+    FilePositionOffsetType offset = this->PixelDataFileOffset + static_cast<FilePositionOffsetType>(frameNumber) * frameSizeInBytes;
+    FSEEK(this->FramePixelsInputStream, offset, SEEK_SET);
+    if (fread(&(this->FramePixelsBuffer[0]), 1, frameSizeInBytes, this->FramePixelsInputStream) != frameSizeInBytes)
+    {
+      LOG_ERROR("Could not read " << frameSizeInBytes << " bytes of frame " << frameNumber << " from " << GetPixelDataFilePath());
+      return PLUS_FAIL;
+    }
+  }
+  else
+  {
+    if (!this->DecompressionStreamActive || frameNumber < this->NextDecompressedFrameNumber)
+    {
+      // Restart decompression from the beginning of the pixel data
+      if (this->DecompressionStreamActive)
+      {
+        inflateEnd(&this->DecompressionStream);
+        this->DecompressionStreamActive = false;
+      }
+      this->DecompressionStream.zalloc = Z_NULL;
+      this->DecompressionStream.zfree = Z_NULL;
+      this->DecompressionStream.opaque = Z_NULL;
+      this->DecompressionStream.next_in = Z_NULL;
+      this->DecompressionStream.avail_in = 0;
+      int ret = inflateInit(&this->DecompressionStream);
+      if (ret != Z_OK)
+      {
+        LOG_ERROR("Image decompression initialization failed (errorCode=" << ret << ")");
+        return PLUS_FAIL;
+      }
+      this->DecompressionStreamActive = true;
+      this->NextDecompressedFrameNumber = 0;
+      PlusCommon::StringToInt(this->TrackedFrameList->GetCustomString(SEQMETA_FIELD_COMPRESSED_DATA_SIZE), this->CompressedBytesRemaining);
+      FSEEK(this->FramePixelsInputStream, this->PixelDataFileOffset, SEEK_SET);
+    }
+
+    // Skip frames until we reach the requested one
+    while (this->NextDecompressedFrameNumber <= frameNumber)
+    {
+      if (this->DecompressNextFrame(frameSizeInBytes) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to decompress frame " << this->NextDecompressedFrameNumber << " from " << GetPixelDataFilePath());
+        inflateEnd(&this->DecompressionStream);
+        this->DecompressionStreamActive = false;
+        return PLUS_FAIL;
+      }
+      this->NextDecompressedFrameNumber++;
+    }
+  }
+
+  PlusVideoFrame::FlipInfoType flipInfo;
+  if (PlusVideoFrame::GetFlipAxes(this->ImageOrientationInFile, this->ImageType, this->ImageOrientationInMemory, flipInfo) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to convert image data to the requested orientation, from " << PlusVideoFrame::GetStringFromUsImageOrientation(this->ImageOrientationInFile) <<
+              " to " << PlusVideoFrame::GetStringFromUsImageOrientation(this->ImageOrientationInMemory));
+    return PLUS_FAIL;
+  }
+
+  videoFrame.SetImageOrientation(this->ImageOrientationInMemory);
+  videoFrame.SetImageType(this->ImageType);
+  if (videoFrame.AllocateFrame(this->Dimensions, this->PixelType, this->NumberOfScalarComponents) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Cannot allocate memory for frame " << frameNumber);
+    return PLUS_FAIL;
+  }
+
+  int clipRectOrigin[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+  int clipRectSize[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+  if (PlusVideoFrame::GetOrientedClippedImage(&(this->FramePixelsBuffer[0]), flipInfo, this->ImageType, this->PixelType, this->NumberOfScalarComponents, this->Dimensions, videoFrame, clipRectOrigin, clipRectSize) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to get oriented image from sequence metafile (frame number: " << frameNumber << ")!");
+    return PLUS_FAIL;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::DecompressNextFrame(unsigned int frameSizeInBytes)
+{
+  const unsigned int compressedChunkSize = 65536;
+  this->CompressedChunkBuffer.resize(compressedChunkSize);
+
+  this->DecompressionStream.next_out = (Bytef*) & (this->FramePixelsBuffer[0]);
+  this->DecompressionStream.avail_out = frameSizeInBytes;
+  while (this->DecompressionStream.avail_out > 0)
+  {
+    if (this->DecompressionStream.avail_in == 0)
+    {
+      if (this->CompressedBytesRemaining == 0)
+      {
+        LOG_ERROR("Compressed pixel data is shorter than expected");
+        return PLUS_FAIL;
+      }
+      size_t bytesToRead = static_cast<size_t>(std::min<unsigned long long>(compressedChunkSize, this->CompressedBytesRemaining));
+      size_t bytesRead = fread(&(this->CompressedChunkBuffer[0]), 1, bytesToRead, this->FramePixelsInputStream);
+      if (bytesRead == 0)
+      {
+        LOG_ERROR("Could not read compressed pixel data");
+        return PLUS_FAIL;
+      }
+      this->CompressedBytesRemaining -= bytesRead;
+      this->DecompressionStream.next_in = (Bytef*) & (this->CompressedChunkBuffer[0]);
+      this->DecompressionStream.avail_in = static_cast<uInt>(bytesRead);
+    }
+
+    int ret = inflate(&this->DecompressionStream, Z_NO_FLUSH);
+    if (ret == Z_STREAM_END && this->DecompressionStream.avail_out > 0)
+    {
+      LOG_ERROR("Cannot uncompress the pixel data: uncompressed data is less than expected");
+      return PLUS_FAIL;
+    }
+    if (ret != Z_OK && ret != Z_STREAM_END)
+    {
+      LOG_ERROR("Cannot uncompress the pixel data (errorCode=" << ret << ")");
+      return PLUS_FAIL;
+    }
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusMetaImageSequenceIO::CloseFramePixelsInputStream()
+{
+  if (this->DecompressionStreamActive)
+  {
+    inflateEnd(&this->DecompressionStream);
+    this->DecompressionStreamActive = false;
+  }
+  this->NextDecompressedFrameNumber = 0;
+  this->CompressedBytesRemaining = 0;
+  if (this->FramePixelsInputStream != NULL)
+  {
+    fclose(this->FramePixelsInputStream);
+    this->FramePixelsInputStream = NULL;
+  }
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusMetaImageSequenceIO::PrepareImageFile()
 {
@@ -588,8 +892,25 @@ PlusStatus vtkPlusMetaImageSequenceIO::WriteInitialImageHeader()
     return PLUS_FAIL;
   }
 
+  if (this->PixelDataSource != NULL)
+  {
+    if (this->PixelDataSource->GetUseCompression() != this->GetUseCompression() || !this->EnableImageDataWrite)
+    {
+      LOG_ERROR("Pixel data of " << this->PixelDataSource->FileName << " can only be copied with image data writing enabled and with the same compression setting");
+      return PLUS_FAIL;
+    }
+    this->PixelType = this->PixelDataSource->PixelType;
+    this->NumberOfScalarComponents = this->PixelDataSource->NumberOfScalarComponents;
+    this->ImageType = this->PixelDataSource->ImageType;
+    this->ImageOrientationInFile = this->PixelDataSource->ImageOrientationInFile;
+  }
+
   // First, is this 2D or 3D?
   bool isData3D = (this->TrackedFrameList->GetTrackedFrame(0)->GetFrameSize()[2] > 1);
+  if (this->PixelDataSource != NULL)
+  {
+    isData3D = (this->PixelDataSource->Dimensions[2] > 1);
+  }
   bool isDataTimeSeries = this->IsDataTimeSeries; // don't compute it from the number of frames because we may still have only one frame but acquire more frames later
 
   // Override fields
@@ -626,7 +947,13 @@ PlusStatus vtkPlusMetaImageSequenceIO::WriteInitialImageHeader()
   }
 
   unsigned int frameSize[3] = {0, 0, 0};
-  if (this->EnableImageDataWrite)
+  if (this->PixelDataSource != NULL)
+  {
+    frameSize[0] = this->PixelDataSource->Dimensions[0];
+    frameSize[1] = this->PixelDataSource->Dimensions[1];
+    frameSize[2] = this->PixelDataSource->Dimensions[2];
+  }
+  else if (this->EnableImageDataWrite)
   {
     this->GetMaximumImageDimensions(frameSize);
   }
@@ -643,7 +970,7 @@ PlusStatus vtkPlusMetaImageSequenceIO::WriteInitialImageHeader()
   this->Dimensions[2] = frameSize[2];
   this->Dimensions[3] = this->TrackedFrameList->GetNumberOfTrackedFrames();
 
-  if (this->EnableImageDataWrite)
+  if (this->EnableImageDataWrite && this->PixelDataSource == NULL)
   {
     // Make sure the frame size is the same for each valid image
     // If it's needed, we can use the largest frame size for each frame and copy the image data row by row
@@ -665,7 +992,7 @@ PlusStatus vtkPlusMetaImageSequenceIO::WriteInitialImageHeader()
   this->UpdateDimensionsCustomStrings(this->TrackedFrameList->GetNumberOfTrackedFrames(), isData3D);
 
   // PixelType
-  if (this->TrackedFrameList->IsContainingValidImageData())
+  if (this->PixelDataSource == NULL && this->TrackedFrameList->IsContainingValidImageData())
   {
     this->PixelType = this->TrackedFrameList->GetPixelType();
     if (this->PixelType == VTK_VOID)
@@ -681,7 +1008,7 @@ PlusStatus vtkPlusMetaImageSequenceIO::WriteInitialImageHeader()
   // ElementNumberOfChannels
   if (this->EnableImageDataWrite)
   {
-    if (this->TrackedFrameList->IsContainingValidImageData())
+    if (this->PixelDataSource == NULL && this->TrackedFrameList->IsContainingValidImageData())
     {
       this->NumberOfScalarComponents = this->TrackedFrameList->GetNumberOfScalarComponents();
     }
@@ -852,42 +1179,53 @@ PlusStatus vtkPlusMetaImageSequenceIO::AppendImagesToHeader()
   }
 
   // Write frame fields (Seq_Frame0000_... = ...)
-  for (unsigned int frameNumber = this->CurrentFrameOffset; frameNumber < this->TrackedFrameList->GetNumberOfTrackedFrames() + this->CurrentFrameOffset; frameNumber++)
-  {
-    LOG_DEBUG("Writing frame " << frameNumber);
-    unsigned int adjustedFrameNumber = frameNumber - this->CurrentFrameOffset;
-    PlusTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame(adjustedFrameNumber);
+  PlusStatus status = this->WriteFrameFieldsToHeader(stream);
+
+  fclose(stream);
+
+  return status;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusMetaImageSequenceIO::FormatFrameFieldsHeaderText(unsigned int frameNumber, std::string& headerText)
+{
+  PlusTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame(frameNumber);
 
-    std::ostringstream frameIndexStr;
-    frameIndexStr << std::setfill('0') << std::setw(4) << frameNumber;
+  std::ostringstream frameIndexStr;
+  frameIndexStr << std::setfill('0') << std::setw(4) << frameNumber + this->CurrentFrameOffset;
+  const std::string fieldPrefix = SEQMETA_FIELD_FRAME_FIELD_PREFIX + frameIndexStr.str() + "_";
 
-    std::vector<std::string> fieldNames;
-    trackedFrame->GetCustomFrameFieldNameList(fieldNames);
+  std::vector<std::string> fieldNames;
+  trackedFrame->GetCustomFrameFieldNameList(fieldNames);
 
-    for (std::vector<std::string>::iterator it = fieldNames.begin(); it != fieldNames.end(); it++)
+  for (std::vector<std::string>::iterator it = fieldNames.begin(); it != fieldNames.end(); it++)
+  {
+    if (this->PixelDataSource != NULL && it->compare(SEQMETA_FIELD_IMG_STATUS) == 0)
     {
-      std::string field = SEQMETA_FIELD_FRAME_FIELD_PREFIX + frameIndexStr.str() + "_" + (*it) + " = " + trackedFrame->GetCustomFrameField(it->c_str()) + "\n";
-      fputs(field.c_str(), stream);
-      TotalBytesWritten += field.length();
+      continue;  // written after the other fields, the same way as the computed image status
     }
-    //Only write this field if the image is saved. If only the tracking pose is kept do not save this field to the header
-    if (this->EnableImageDataWrite)
+    headerText += fieldPrefix + (*it) + " = " + trackedFrame->GetCustomFrameField(it->c_str()) + "\n";
+  }
+  //Only write this field if the image is saved. If only the tracking pose is kept do not save this field to the header
+  if (this->EnableImageDataWrite)
+  {
+    // Add image status field
+    std::string imageStatus("OK");
+    if (this->PixelDataSource != NULL)
     {
-      // Add image status field
-      std::string imageStatus("OK");
-      if (!trackedFrame->GetImageData()->IsImageValid())
+      // The frame contains no pixel data, the status is the one that is stored in the source
+      const char* sourceImageStatus = trackedFrame->GetCustomFrameField(SEQMETA_FIELD_IMG_STATUS);
+      if (sourceImageStatus != NULL)
       {
-        imageStatus = "INVALID";
+        imageStatus = sourceImageStatus;
       }
-      std::string imgStatusField = SEQMETA_FIELD_FRAME_FIELD_PREFIX + frameIndexStr.str() + "_" + SEQMETA_FIELD_IMG_STATUS + " = " + imageStatus + "\n";
-      fputs(imgStatusField.c_str(), stream);
-      TotalBytesWritten += imgStatusField.length();
     }
+    else if (!trackedFrame->GetImageData()->IsImageValid())
+    {
+      imageStatus = "INVALID";
+    }
+    headerText += fieldPrefix + SEQMETA_FIELD_IMG_STATUS + " = " + imageStatus + "\n";
   }
-
-  fclose(stream);
-
-  return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
@@ -925,24 +1263,14 @@ PlusStatus vtkPlusMetaImageSequenceIO::WriteCompressedImagePixelsToFile(int& com
 {
   LOG_DEBUG("Writing compressed pixel data into file started");
 
-  compressedDataSize = 0;
-
-  const int outputBufferSize = 16384; // can be any number, just picked a value from a zlib example
-  unsigned char outputBuffer[outputBufferSize];
-
-  z_stream strm; // stream describing the compression state
-
-  // use the default memory allocation routines
-  strm.zalloc = Z_NULL;
-  strm.zfree = Z_NULL;
-  strm.opaque = Z_NULL;
-  int ret = deflateInit(&strm, Z_DEFAULT_COMPRESSION);
-  if (ret != Z_OK)
+  if (this->ParallelCompression)
   {
-    LOG_ERROR("Image compression initialization failed (errorCode=" << ret << ")");
-    return PLUS_FAIL;
+    // Pixel data is still a single zlib stream (finished in Close), but blocks of frames are compressed in parallel
+    return this->WriteCompressedFramesToFile(COMPRESSED_DATA_ZLIB, compressedDataSize);
   }
 
+  compressedDataSize = 0;
+
   // Create a blank frame if we have to write an invalid frame to metafile
   PlusVideoFrame blankFrame;
   if (blankFrame.AllocateFrame(this->Dimensions, this->PixelType, this->NumberOfScalarComponents) != PLUS_SUCCESS)
@@ -962,7 +1290,6 @@ PlusStatus vtkPlusMetaImageSequenceIO::WriteCompressedImagePixelsToFile(int& com
       if (trackedFrame == NULL)
       {
         LOG_ERROR("Cannot access frame " << frameNumber << " while trying to writing compress data into file");
-        deflateEnd(&strm);
         return PLUS_FAIL;
       }
     }
@@ -976,59 +1303,158 @@ PlusStatus vtkPlusMetaImageSequenceIO::WriteCompressedImagePixelsToFile(int& com
       }
     }
 
-    strm.next_in = (Bytef*)videoFrame->GetScalarPointer();
-    strm.avail_in = videoFrame->GetFrameSizeInBytes();
-
+    // All frames of the file are compressed into a single stream, which is finished in Close(),
+    // so frames may be written by multiple WriteImages calls.
     // Note: it's possible to request to consume all inputs and delete all history after each frame writing to allow random access
-    int flush = (frameNumber < this->TrackedFrameList->GetNumberOfTrackedFrames() - 1) ? Z_NO_FLUSH : Z_FINISH;
-
-    // run deflate() on input until output buffer not full, finish
-    // compression if all of source has been read in
-    do
+    this->CompressionStream.next_in = (Bytef*)videoFrame->GetScalarPointer();
+    this->CompressionStream.avail_in = videoFrame->GetFrameSizeInBytes();
+    if (this->DeflateToFile(Z_NO_FLUSH, compressedDataSize) != PLUS_SUCCESS)
     {
-      strm.avail_out = outputBufferSize;
-      strm.next_out = outputBuffer;
+      LOG_ERROR("Error occurred during compressing image data into file");
+      return PLUS_FAIL;
+    }
+  }
 
-      ret = deflate(&strm, flush);    /* no bad return value */
-      if (ret == Z_STREAM_ERROR)
-      {
-        // state clobbered
-        LOG_ERROR("Zlib state became invalid during the compression process (errorCode=" << ret << ")");
-        deflateEnd(&strm);   // clean up
-        return PLUS_FAIL;
-      }
+  LOG_DEBUG("Writing compressed pixel data into file completed");
+  return PLUS_SUCCESS;
+}
 
-      size_t numberOfBytesReadyForWriting = outputBufferSize - strm.avail_out;
-      size_t numberOfBytesWritten = 0;
-      if (PlusCommon::RobustFwrite(this->OutputImageFileHandle, outputBuffer, numberOfBytesReadyForWriting, numberOfBytesWritten) != PLUS_SUCCESS)
-      {
-        LOG_ERROR("Error writing compressed data into file");
-        deflateEnd(&strm);   // clean up
-        return PLUS_FAIL;
-      }
-      compressedDataSize += numberOfBytesWritten;
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::DeflateToFile(int flush, int& compressedDataSize)
+{
+  const int outputBufferSize = 16384; // can be any number, just picked a value from a zlib example
+  unsigned char outputBuffer[outputBufferSize];
+
+  // run deflate() on input until output buffer not full, finish
+  // compression if all of source has been read in
+  int ret = Z_OK;
+  do
+  {
+    this->CompressionStream.avail_out = outputBufferSize;
+    this->CompressionStream.next_out = outputBuffer;
 
+    ret = deflate(&this->CompressionStream, flush);    /* no bad return value */
+    if (ret == Z_STREAM_ERROR)
+    {
+      // state clobbered
+      LOG_ERROR("Zlib state became invalid during the compression process (errorCode=" << ret << ")");
+      return PLUS_FAIL;
     }
-    while (strm.avail_out == 0);
 
-    if (strm.avail_in != 0)
+    size_t numberOfBytesReadyForWriting = outputBufferSize - this->CompressionStream.avail_out;
+    size_t numberOfBytesWritten = 0;
+    if (PlusCommon::RobustFwrite(this->OutputImageFileHandle, outputBuffer, numberOfBytesReadyForWriting, numberOfBytesWritten) != PLUS_SUCCESS)
     {
-      // state clobbered (by now all input should have been consumed)
-      LOG_ERROR("Zlib state became invalid during the compression process");
-      deflateEnd(&strm);   // clean up
+      LOG_ERROR("Error writing compressed data into file");
       return PLUS_FAIL;
     }
+    compressedDataSize += numberOfBytesWritten;
   }
+  while (this->CompressionStream.avail_out == 0);
 
-  deflateEnd(&strm);   // clean up
+  if (this->CompressionStream.avail_in != 0)
+  {
+    // state clobbered (by now all input should have been consumed)
+    LOG_ERROR("Zlib state became invalid during the compression process");
+    return PLUS_FAIL;
+  }
 
-  LOG_DEBUG("Writing compressed pixel data into file completed");
+  if (flush == Z_FINISH && ret != Z_STREAM_END)
+  {
+    LOG_ERROR("Zlib compression stream could not be finished (errorCode=" << ret << ")");
+    return PLUS_FAIL;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::WriteImages()
+{
+  if (this->PixelDataSource == NULL)
+  {
+    return Superclass::WriteImages();
+  }
+
+  // Only the frame fields are in the tracked frame list, the pixel data is copied when all the frames are written
+  unsigned int numberOfSourceFrames = this->PixelDataSource->Dimensions[3];
+  unsigned int numberOfWrittenFrames = this->CurrentFrameOffset + this->TrackedFrameList->GetNumberOfTrackedFrames();
+  if (numberOfWrittenFrames > numberOfSourceFrames)
+  {
+    LOG_ERROR("Cannot write " << numberOfWrittenFrames << " frames, pixel data is available for " << numberOfSourceFrames << " frames in " << this->PixelDataSource->FileName);
+    return PLUS_FAIL;
+  }
+  if (numberOfWrittenFrames == numberOfSourceFrames)
+  {
+    if (this->CopyPixelDataFromSource() != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+  }
+
+  this->CurrentFrameOffset = numberOfWrittenFrames;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::CopyPixelDataFromSource()
+{
+  vtkPlusMetaImageSequenceIO* source = this->PixelDataSource;
+
+  unsigned long long pixelDataSize = 0;
+  if (source->GetUseCompression())
+  {
+    if (PlusCommon::StringToInt(source->TrackedFrameList->GetCustomString(SEQMETA_FIELD_COMPRESSED_DATA_SIZE), pixelDataSize) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Size of the compressed pixel data is not available in " << source->FileName);
+      return PLUS_FAIL;
+    }
+  }
+  else
+  {
+    pixelDataSize = static_cast<unsigned long long>(source->Dimensions[0]) * source->Dimensions[1] * source->Dimensions[2] * source->Dimensions[3]
+                    * PlusVideoFrame::GetNumberOfBytesPerScalar(source->PixelType) * source->NumberOfScalarComponents;
+  }
 
-  if (ret != Z_STREAM_END)
+  FILE* stream = NULL;
+  if (FileOpen(&stream, source->GetPixelDataFilePath().c_str(), "rb") != PLUS_SUCCESS)
   {
-    LOG_ERROR("Error occurred during compressing image data into file");
+    LOG_ERROR("The file " << source->GetPixelDataFilePath() << " could not be opened for reading");
     return PLUS_FAIL;
   }
+  FSEEK(stream, source->PixelDataFileOffset, SEEK_SET);
+
+  LOG_DEBUG("Copying " << pixelDataSize << " bytes of pixel data from " << source->GetPixelDataFilePath());
+
+  const size_t copyBufferSize = 1024 * 1024;
+  std::vector<unsigned char> copyBuffer(copyBufferSize);
+  unsigned long long bytesRemaining = pixelDataSize;
+  while (bytesRemaining > 0)
+  {
+    size_t bytesToRead = static_cast<size_t>(std::min<unsigned long long>(copyBufferSize, bytesRemaining));
+    size_t bytesRead = fread(&copyBuffer[0], 1, bytesToRead, stream);
+    if (bytesRead != bytesToRead)
+    {
+      LOG_ERROR("Could not read pixel data from " << source->GetPixelDataFilePath() << ", " << bytesRemaining << " bytes are missing");
+      fclose(stream);
+      return PLUS_FAIL;
+    }
+    size_t bytesWritten = 0;
+    if (PlusCommon::RobustFwrite(this->OutputImageFileHandle, &copyBuffer[0], bytesRead, bytesWritten) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Error writing pixel data into file");
+      fclose(stream);
+      return PLUS_FAIL;
+    }
+    bytesRemaining -= bytesRead;
+  }
+  fclose(stream);
+
+  this->TotalBytesWritten += pixelDataSize;
+  if (this->GetUseCompression())
+  {
+    this->CompressedBytesWritten += pixelDataSize;
+  }
   return PLUS_SUCCESS;
 }
 
@@ -1302,9 +1728,43 @@ const char* vtkPlusMetaImageSequenceIO::GetDimensionKindsString()
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusMetaImageSequenceIO::Close()
 {
+  if (this->PixelDataSource != NULL && this->CurrentFrameOffset != this->PixelDataSource->Dimensions[3])
+  {
+    LOG_ERROR("Only " << this->CurrentFrameOffset << " frames are written, pixel data of all the " << this->PixelDataSource->Dimensions[3]
+              << " frames of " << this->PixelDataSource->FileName << " have to be written");
+    return PLUS_FAIL;
+  }
+
   // Update fields that are known only at the end of the processing
   if (this->GetUseCompression())
   {
+    if (this->PixelDataSource == NULL && this->ParallelCompression)
+    {
+      int compressedDataSize = 0;
+      PlusStatus status = this->FinishCompressedFramesStream(COMPRESSED_DATA_ZLIB, compressedDataSize);
+      this->TotalBytesWritten += compressedDataSize;
+      this->CompressedBytesWritten += compressedDataSize;
+      if (status != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Error occurred during compressing image data into file");
+        deflateEnd(&this->CompressionStream);
+        return PLUS_FAIL;
+      }
+    }
+    else if (this->PixelDataSource == NULL && this->CompressionStream.total_in > 0)
+    {
+      // Frames are compressed into a single stream, finish it after the last frame
+      int compressedDataSize = 0;
+      PlusStatus status = this->DeflateToFile(Z_FINISH, compressedDataSize);
+      this->TotalBytesWritten += compressedDataSize;
+      this->CompressedBytesWritten += compressedDataSize;
+      if (status != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Error occurred during compressing image data into file");
+        deflateEnd(&this->CompressionStream);
+        return PLUS_FAIL;
+      }
+    }
     std::stringstream ss;
     ss << this->CompressedBytesWritten;
     this->SetCustomString(SEQMETA_FIELD_COMPRESSED_DATA_SIZE, ss.str().c_str());
@@ -16,6 +16,8 @@
 #include "vtkPlusSequenceIOBase.h"
 #include "itk_zlib.h"
 
+#include <set>
+
 class vtkPlusTrackedFrameList;
 
 /*!
@@ -74,6 +76,44 @@ public:
   */
   virtual PlusStatus SetFileName(const std::string& aFilename);
 
+  /*! Read only the header of the file, pixel data of individual frames can be read by ReadFramePixels */
+  virtual PlusStatus ReadHeader();
+
+  /*! Pixel data of individual frames can be read from both uncompressed and compressed files */
+  virtual bool CanReadFramePixels() const;
+
+  /*!
+    Read pixel data of a single frame. Uncompressed frames are read directly from their position in the file.
+    Compressed pixel data is a single zlib stream, therefore it is decompressed sequentially:
+    reading the next frame is fast, but reading an earlier frame restarts the decompression from the first frame.
+  */
+  virtual PlusStatus ReadFramePixels(unsigned int frameNumber, PlusVideoFrame& videoFrame);
+
+  /*!
+    Set the names of the frame fields that are read from the header (e.g., Timestamp and ProbeToTrackerTransform).
+    Other frame fields are skipped, which makes reading the header of long sequences faster and uses less memory.
+    The image status field is always read, as it is needed for reading the pixel data.
+    If the list is empty (default) then all the frame fields are read.
+  */
+  void SetFrameFieldNamesToRead(const std::vector<std::string>& fieldNames);
+
+  /*!
+    Set a sequence file that the pixel data is copied from as is, without decompressing and recompressing it.
+    It allows fast saving of a sequence when only the frame fields are changed: the frames in the tracked frame list
+    contain only the frame fields (including the image status) as they are read by ReadHeader() of the source.
+    The frame size, pixel type, image type, and image orientation are taken from the source, compression must be the same as in the source.
+    The pixel data is copied when the last frame of the source is written, therefore all the frames of the source must be written.
+    If NULL (default) then the pixel data of the frames in the tracked frame list is written.
+  */
+  virtual void SetPixelDataSource(vtkPlusMetaImageSequenceIO* source);
+  vtkGetObjectMacro(PixelDataSource, vtkPlusMetaImageSequenceIO);
+
+  /*!
+    Write images to disc, compression allowed. The compressed pixel data of subsequent calls is appended to the same zlib stream,
+    which is finished when the file is closed. If a pixel data source is set then its pixel data is copied instead.
+  */
+  virtual PlusStatus WriteImages();
+
 protected:
   vtkPlusMetaImageSequenceIO();
   virtual ~vtkPlusMetaImageSequenceIO();
@@ -98,6 +138,21 @@ protected:
   */
   virtual PlusStatus WriteCompressedImagePixelsToFile(int& compressedDataSize);
 
+  /*! Compress the pending input of CompressionStream and write the compressed data into the pixel data file */
+  PlusStatus DeflateToFile(int flush, int& compressedDataSize);
+
+  /*! Copy the pixel data of PixelDataSource into the pixel data file */
+  PlusStatus CopyPixelDataFromSource();
+
+  /*! Format the fields of a frame as Seq_FrameNNNN_FieldName = value lines */
+  virtual void FormatFrameFieldsHeaderText(unsigned int frameNumber, std::string& headerText);
+
+  /*! Close the file and decompression stream that are used for reading individual frames */
+  void CloseFramePixelsInputStream();
+
+  /*! Decompress the next frame of the compressed pixel data into FramePixelsBuffer */
+  PlusStatus DecompressNextFrame(unsigned int frameSizeInBytes);
+
   /*! Conversion between ITK and METAIO pixel types */
   PlusStatus ConvertMetaElementTypeToVtkPixelType(const std::string& elementTypeStr, PlusCommon::VTKScalarPixelType& vtkPixelType);
   /*! Conversion between ITK and METAIO pixel types */
@@ -111,6 +166,27 @@ private:
   /*! compression stream handle for compression streaming */
   z_stream CompressionStream;
 
+  /*! Names of the frame fields that are read from the header, all fields are read if empty */
+  std::set<std::string> FrameFieldNamesToRead;
+
+  /*! Sequence file that the pixel data is copied from, NULL if the pixel data of the frames is written */
+  vtkPlusMetaImageSequenceIO* PixelDataSource;
+
+  /*! File handle for reading the pixel data of individual frames */
+  FILE* FramePixelsInputStream;
+  /*! Decompression stream handle for reading individual frames from compressed pixel data */
+  z_stream DecompressionStream;
+  /*! True if DecompressionStream is initialized */
+  bool DecompressionStreamActive;
+  /*! Number of the frame that the decompression stream provides next */
+  unsigned int NextDecompressedFrameNumber;
+  /*! Number of compressed bytes that have not been read from the file yet */
+  unsigned long long CompressedBytesRemaining;
+  /*! Pixel data of the most recently read frame, as stored in the file */
+  std::vector<unsigned char> FramePixelsBuffer;
+  /*! Compressed data that has been read from the file but not decompressed yet */
+  std::vector<unsigned char> CompressedChunkBuffer;
+
 protected:
   vtkPlusMetaImageSequenceIO(const vtkPlusMetaImageSequenceIO&); //purposely not implemented
   void operator=(const vtkPlusMetaImageSequenceIO&); //purposely not implemented
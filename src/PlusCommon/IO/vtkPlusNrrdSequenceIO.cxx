@@ -520,7 +520,8 @@ PlusStatus vtkPlusNrrdSequenceIO::ReadImagePixels()
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusNrrdSequenceIO::PrepareImageFile()
 {
-  if( this->GetUseCompression() )
+  // With parallel compression the gzip members are written into the file by WriteCompressedImagePixelsToFile
+  if( this->GetUseCompression() && !this->ParallelCompression )
   {
     this->CompressionStream = gzopen( this->TempImageFileName.c_str(), "ab" );
 
@@ -782,43 +783,41 @@ PlusStatus vtkPlusNrrdSequenceIO::AppendImagesToHeader()
     return PLUS_FAIL;
   }
 
-  // Write frame fields (Seq_Frame0000_... = ...)
-  for ( unsigned int frameNumber = CurrentFrameOffset; frameNumber < this->TrackedFrameList->GetNumberOfTrackedFrames() + CurrentFrameOffset; frameNumber++ )
-  {
-    LOG_DEBUG( "Writing frame " << frameNumber );
-    unsigned int adjustedFrameNumber = frameNumber - CurrentFrameOffset;
-    PlusTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame( adjustedFrameNumber );
+  // Write frame fields (Seq_Frame0000_...:=...)
+  PlusStatus status = this->WriteFrameFieldsToHeader( stream );
 
-    std::ostringstream frameIndexStr;
-    frameIndexStr << std::setfill( '0' ) << std::setw( 4 ) << frameNumber;
+  fclose( stream );
 
-    std::vector<std::string> fieldNames;
-    trackedFrame->GetCustomFrameFieldNameList( fieldNames );
+  return status;
+}
 
-    for ( std::vector<std::string>::iterator it = fieldNames.begin(); it != fieldNames.end(); it++ )
-    {
-      std::string field = SEQUENCE_FIELD_FRAME_FIELD_PREFIX + frameIndexStr.str() + "_" + ( *it ) + ":=" + trackedFrame->GetCustomFrameField( it->c_str() ) + "\n";
-      fputs( field.c_str(), stream );
-      TotalBytesWritten += field.length();
-    }
-    //Only write this field if the image is saved. If only the tracking pose is kept do not save this field to the header
-    if( this->EnableImageDataWrite )
+//----------------------------------------------------------------------------
+void vtkPlusNrrdSequenceIO::FormatFrameFieldsHeaderText( unsigned int frameNumber, std::string& headerText )
+{
+  PlusTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame( frameNumber );
+
+  std::ostringstream frameIndexStr;
+  frameIndexStr << std::setfill( '0' ) << std::setw( 4 ) << frameNumber + this->CurrentFrameOffset;
+  const std::string fieldPrefix = SEQUENCE_FIELD_FRAME_FIELD_PREFIX + frameIndexStr.str() + "_";
+
+  std::vector<std::string> fieldNames;
+  trackedFrame->GetCustomFrameFieldNameList( fieldNames );
+
+  for ( std::vector<std::string>::iterator it = fieldNames.begin(); it != fieldNames.end(); it++ )
+  {
+    headerText += fieldPrefix + ( *it ) + ":=" + trackedFrame->GetCustomFrameField( it->c_str() ) + "\n";
+  }
+  //Only write this field if the image is saved. If only the tracking pose is kept do not save this field to the header
+  if( this->EnableImageDataWrite )
+  {
+    // Add image status field
+    std::string imageStatus( "OK" );
+    if ( !trackedFrame->GetImageData()->IsImageValid() )
     {
-      // Add image status field
-      std::string imageStatus( "OK" );
-      if ( !trackedFrame->GetImageData()->IsImageValid() )
-      {
-        imageStatus = "INVALID";
-      }
-      std::string imgStatusField = SEQUENCE_FIELD_FRAME_FIELD_PREFIX + frameIndexStr.str() + "_" + SEQUENCE_FIELD_IMG_STATUS + ":=" + imageStatus + "\n";
-      fputs( imgStatusField.c_str(), stream );
-      TotalBytesWritten += imgStatusField.length();
+      imageStatus = "INVALID";
     }
+    headerText += fieldPrefix + SEQUENCE_FIELD_IMG_STATUS + ":=" + imageStatus + "\n";
   }
-
-  fclose( stream );
-
-  return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
@@ -847,16 +846,32 @@ PlusStatus vtkPlusNrrdSequenceIO::FinalizeHeader()
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusNrrdSequenceIO::Close()
 {
-  if( this->GetUseCompression() )
+  PlusStatus status = PLUS_SUCCESS;
+  if( this->GetUseCompression() && !this->ParallelCompression )
   {
     gzclose( this->CompressionStream );
   }
   else
   {
+    if ( this->GetUseCompression() )
+    {
+      // Finish the gzip stream that is continued by each WriteImages call
+      int compressedDataSize = 0;
+      status = this->FinishCompressedFramesStream( COMPRESSED_DATA_GZIP, compressedDataSize );
+      this->TotalBytesWritten += compressedDataSize;
+      if ( status != PLUS_SUCCESS )
+      {
+        LOG_ERROR( "Error occurred during compressing image data into file" );
+      }
+    }
     fclose( this->OutputImageFileHandle );
   }
 
-  return Superclass::Close();
+  if ( Superclass::Close() != PLUS_SUCCESS )
+  {
+    return PLUS_FAIL;
+  }
+  return status;
 }
 
 //----------------------------------------------------------------------------
@@ -864,6 +879,12 @@ PlusStatus vtkPlusNrrdSequenceIO::WriteCompressedImagePixelsToFile( int& compres
 {
   LOG_DEBUG( "Writing compressed pixel data into file started" );
 
+  if ( this->ParallelCompression )
+  {
+    // Each call continues the same gzip stream (finished in Close), blocks of frames are compressed in parallel
+    return this->WriteCompressedFramesToFile( COMPRESSED_DATA_GZIP, compressedDataSize );
+  }
+
   compressedDataSize = 0;
 
   // Create a blank frame if we have to write an invalid frame to file
@@ -1174,10 +1195,16 @@ PlusStatus vtkPlusNrrdSequenceIO::UpdateFieldInImageHeader( const char* fieldNam
       break;
     }
 
+    if ( line[0] == '#' || line.compare( 0, 4, "NRRD" ) == 0 )
+    {
+      // comment or magic line, these are always present in the header
+      continue;
+    }
+
     // Split line into name and value
     size_t colonFound;
     colonFound = line.find_first_of( ":" );
-    if ( colonFound == std::string::npos || line[0] == '#' )
+    if ( colonFound == std::string::npos )
     {
       LOG_WARNING( "Not a field line. Skipping... (" << line << ")" );
       continue;
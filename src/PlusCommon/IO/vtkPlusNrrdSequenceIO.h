@@ -109,6 +109,9 @@ protected:
   */
   virtual PlusStatus WriteCompressedImagePixelsToFile( int& compressedDataSize );
 
+  /*! Format the fields of a frame as Seq_FrameNNNN_FieldName:=value lines */
+  virtual void FormatFrameFieldsHeaderText( unsigned int frameNumber, std::string& headerText );
+
   /*! Conversion between ITK and METAIO pixel types */
   PlusStatus ConvertNrrdTypeToVtkPixelType( const std::string& elementTypeStr, PlusCommon::VTKScalarPixelType& vtkPixelType );
   /*! Conversion between ITK and METAIO pixel types */
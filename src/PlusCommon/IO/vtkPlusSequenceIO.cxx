@@ -12,7 +12,7 @@
 #include "vtkPlusTrackedFrameList.h"
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusSequenceIO::Write(const std::string& filename, vtkPlusTrackedFrameList* frameList, US_IMAGE_ORIENTATION orientationInFile/*=US_IMG_ORIENT_MF*/, bool useCompression/*=true*/, bool enableImageDataWrite/*=true*/)
+PlusStatus vtkPlusSequenceIO::Write(const std::string& filename, vtkPlusTrackedFrameList* frameList, US_IMAGE_ORIENTATION orientationInFile/*=US_IMG_ORIENT_MF*/, bool useCompression/*=true*/, bool enableImageDataWrite/*=true*/, bool parallelCompression/*=false*/)
 {
   // Convert local filename to plus output filename
   if( vtksys::SystemTools::FileExists(filename.c_str()) )
@@ -24,7 +24,7 @@ PlusStatus vtkPlusSequenceIO::Write(const std::string& filename, vtkPlusTrackedF
   // Parse sequence filename to determine if it's metafile or NRRD
   if( vtkPlusMetaImageSequenceIO::CanWriteFile(filename) )
   {
-    if( frameList->SaveToSequenceMetafile(filename, orientationInFile, useCompression, enableImageDataWrite) != PLUS_SUCCESS )
+    if( frameList->SaveToSequenceMetafile(filename, orientationInFile, useCompression, enableImageDataWrite, parallelCompression) != PLUS_SUCCESS )
     {
       LOG_ERROR("Unable to save file: " << filename << " as sequence metafile.");
       return PLUS_FAIL;
@@ -34,7 +34,7 @@ PlusStatus vtkPlusSequenceIO::Write(const std::string& filename, vtkPlusTrackedF
   }
   else if( vtkPlusNrrdSequenceIO::CanWriteFile(filename) )
   {
-    if( frameList->SaveToNrrdFile(filename, orientationInFile, useCompression, enableImageDataWrite) != PLUS_SUCCESS )
+    if( frameList->SaveToNrrdFile(filename, orientationInFile, useCompression, enableImageDataWrite, parallelCompression) != PLUS_SUCCESS )
     {
       LOG_ERROR("Unable to save file: " << filename << " as Nrrd file.");
       return PLUS_FAIL;
@@ -22,8 +22,8 @@ class vtkPlusTrackedFrameList;
 class vtkPlusCommonExport vtkPlusSequenceIO : public vtkObject
 {
 public:
-  /*! Write object contents into file */
-  static PlusStatus Write(const std::string& filename, vtkPlusTrackedFrameList* frameList, US_IMAGE_ORIENTATION orientationInFile=US_IMG_ORIENT_MF, bool useCompression=true, bool EnableImageDataWrite=true);
+  /*! Write object contents into file. If parallelCompression is enabled then blocks of frames are compressed in parallel. */
+  static PlusStatus Write(const std::string& filename, vtkPlusTrackedFrameList* frameList, US_IMAGE_ORIENTATION orientationInFile=US_IMG_ORIENT_MF, bool useCompression=true, bool EnableImageDataWrite=true, bool parallelCompression=false);
 
   /*! Read file contents into the object */
   static PlusStatus Read(const std::string& filename, vtkPlusTrackedFrameList* frameList);
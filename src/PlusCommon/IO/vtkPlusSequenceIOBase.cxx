@@ -9,8 +9,13 @@ See License.txt for details.
 #include "vtkPlusSequenceIOBase.h"
 #include "vtkPlusTrackedFrameList.h"
 #include "vtksys/SystemTools.hxx"
+#include "vtk_zlib.h"
 #include "PlusTrackedFrame.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
 #if _WIN32
 #include <errno.h>
 
@@ -21,6 +26,70 @@ See License.txt for details.
 
 #endif
 
+namespace
+{
+  // Number of frames whose fields are formatted together in a block of the header
+  const unsigned int HEADER_TEXT_FRAMES_PER_BLOCK = 256;
+  // Minimum uncompressed size of a block of frames that is compressed by one thread
+  const unsigned long COMPRESSION_BLOCK_SIZE_BYTES = 1024 * 1024;
+  // Size of the deflate window, this much data preceding a block is used as preset dictionary
+  const size_t COMPRESSION_DICTIONARY_SIZE_BYTES = 32768;
+  // Number of blocks that may be produced by each thread ahead of the writer
+  const unsigned int MAX_PENDING_BLOCKS_PER_THREAD = 2;
+}
+
+//----------------------------------------------------------------------------
+struct vtkPlusSequenceIOBase::OrderedWriteInfo
+{
+  enum BlockType
+  {
+    FRAME_FIELDS_HEADER_TEXT,
+    COMPRESSED_PIXELS
+  };
+
+  struct Block
+  {
+    Block() : Checksum( 0 ), UncompressedSize( 0 ), Ready( false ) {}
+    /*! Formatted header text or raw deflate data of the frames of the block */
+    std::string Data;
+    /*! Adler-32 or CRC-32 of the uncompressed pixel data of the block */
+    unsigned long Checksum;
+    unsigned long long UncompressedSize;
+    /*! The block is produced and waiting to be written */
+    bool Ready;
+  };
+
+  OrderedWriteInfo()
+    : Self( NULL ), Type( FRAME_FIELDS_HEADER_TEXT ), Format( COMPRESSED_DATA_ZLIB ), Stream( NULL ), BlankFrame( NULL ), PrecedingData( NULL )
+    , NumberOfFrames( 0 ), FramesPerBlock( 1 ), NumberOfBlocks( 0 ), NextBlockToProduce( 0 ), NextBlockToWrite( 0 ), Failed( false )
+    , BytesWritten( 0 ), Checksum( 0 ), UncompressedSize( 0 ) {}
+
+  vtkPlusSequenceIOBase* Self;
+  BlockType Type;
+  CompressedDataFormat Format;
+  FILE* Stream;
+  const PlusVideoFrame* BlankFrame;
+  /*! End of the uncompressed data that is written before the frames of this write */
+  const std::vector<unsigned char>* PrecedingData;
+  unsigned int NumberOfFrames;
+  unsigned int FramesPerBlock;
+  unsigned int NumberOfBlocks;
+
+  /*! Slots for the blocks that are being produced or waiting to be written, block i is stored in slot i modulo the number of slots */
+  std::vector<Block> Blocks;
+  unsigned int NextBlockToProduce;
+  unsigned int NextBlockToWrite;
+  bool Failed;
+  std::mutex Mutex;
+  std::condition_variable BlockProduced;
+  std::condition_variable BlockWritten;
+
+  /*! Results, updated by the writer */
+  unsigned long long BytesWritten;
+  unsigned long Checksum;
+  unsigned long long UncompressedSize;
+};
+
 //----------------------------------------------------------------------------
 
 vtkCxxSetObjectMacro( vtkPlusSequenceIOBase, TrackedFrameList, vtkPlusTrackedFrameList );
@@ -29,6 +98,10 @@ vtkCxxSetObjectMacro( vtkPlusSequenceIOBase, TrackedFrameList, vtkPlusTrackedFra
 vtkPlusSequenceIOBase::vtkPlusSequenceIOBase()
   : TrackedFrameList( vtkPlusTrackedFrameList::New() )
   , UseCompression( false )
+  , ParallelCompression( false )
+  , CompressedFramesStreamStarted( false )
+  , CompressedFramesChecksum( 0 )
+  , CompressedFramesUncompressedSize( 0 )
   , CompressedBytesWritten( 0 )
   , EnableImageDataWrite( true )
   , PixelType( VTK_VOID )
@@ -43,6 +116,8 @@ vtkPlusSequenceIOBase::vtkPlusSequenceIOBase()
   , PixelDataFileOffset( 0 )
   , PixelDataFileName( "" )
   , OutputImageFileHandle( NULL )
+  , Threader( vtkMultiThreader::New() )
+  , NumberOfThreads( 0 )
 {
   this->Dimensions[0] = 1;
   this->Dimensions[1] = 1;
@@ -57,6 +132,11 @@ vtkPlusSequenceIOBase::~vtkPlusSequenceIOBase()
   {
     this->SetTrackedFrameList( NULL );
   }
+  if ( this->Threader != NULL )
+  {
+    this->Threader->Delete();
+    this->Threader = NULL;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -84,6 +164,32 @@ PlusStatus vtkPlusSequenceIOBase::Read()
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::ReadHeader()
+{
+  this->TrackedFrameList->Clear();
+
+  if ( this->ReadImageHeader() != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Could not load header from file: " << this->FileName );
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusSequenceIOBase::CanReadFramePixels() const
+{
+  return false;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::ReadFramePixels( unsigned int frameNumber, PlusVideoFrame& videoFrame )
+{
+  LOG_ERROR( "Reading pixel data of individual frames is not supported for file: " << this->FileName );
+  return PLUS_FAIL;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusSequenceIOBase::DeleteCustomFrameString( int frameNumber, const char* fieldName )
 {
@@ -311,6 +417,8 @@ PlusStatus vtkPlusSequenceIOBase::Close()
   this->CurrentFrameOffset = 0;
   this->TotalBytesWritten = 0;
   this->CompressedBytesWritten = 0;
+  this->CompressedFramesStreamStarted = false;
+  this->CompressedFramesDictionary.clear();
 
   return PLUS_SUCCESS;
 }
@@ -587,3 +695,424 @@ PlusStatus vtkPlusSequenceIOBase::AppendFile( const std::string& sourceFilename,
   }
   return PLUS_SUCCESS;
 }
+
+//----------------------------------------------------------------------------
+const PlusVideoFrame* vtkPlusSequenceIOBase::GetFrameToWrite( unsigned int frameNumber, const PlusVideoFrame& blankFrame )
+{
+  if ( !this->EnableImageDataWrite )
+  {
+    return &blankFrame;
+  }
+  PlusTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame( frameNumber );
+  if ( trackedFrame == NULL || !trackedFrame->GetImageData()->IsImageValid() )
+  {
+    return &blankFrame;
+  }
+  return trackedFrame->GetImageData();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::WriteFrameFieldsToHeader( FILE* stream )
+{
+  OrderedWriteInfo info;
+  info.Self = this;
+  info.Type = OrderedWriteInfo::FRAME_FIELDS_HEADER_TEXT;
+  info.Stream = stream;
+  info.NumberOfFrames = this->TrackedFrameList->GetNumberOfTrackedFrames();
+  info.FramesPerBlock = HEADER_TEXT_FRAMES_PER_BLOCK;
+  info.NumberOfBlocks = ( info.NumberOfFrames + info.FramesPerBlock - 1 ) / info.FramesPerBlock;
+
+  PlusStatus status = this->WriteBlocksInOrder( info );
+  this->TotalBytesWritten += info.BytesWritten;
+  if ( status != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Failed to write frame fields to the header" );
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::WriteCompressedFramesToFile( CompressedDataFormat format, int& compressedDataSize )
+{
+  compressedDataSize = 0;
+
+  // Create a blank frame if we have to write an invalid frame to file
+  PlusVideoFrame blankFrame;
+  if ( blankFrame.AllocateFrame( this->Dimensions, this->PixelType, this->NumberOfScalarComponents ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Failed to allocate space for blank image." );
+    return PLUS_FAIL;
+  }
+  blankFrame.FillBlank();
+
+  OrderedWriteInfo info;
+  info.Self = this;
+  info.Type = OrderedWriteInfo::COMPRESSED_PIXELS;
+  info.Format = format;
+  info.Stream = this->OutputImageFileHandle;
+  info.BlankFrame = &blankFrame;
+  info.PrecedingData = &this->CompressedFramesDictionary;
+  info.NumberOfFrames = this->TrackedFrameList->GetNumberOfTrackedFrames();
+  unsigned long frameSizeInBytes = std::max( blankFrame.GetFrameSizeInBytes(), 1ul );
+  info.FramesPerBlock = std::max( static_cast<unsigned int>( COMPRESSION_BLOCK_SIZE_BYTES / frameSizeInBytes ), 1u );
+  info.NumberOfBlocks = ( info.NumberOfFrames + info.FramesPerBlock - 1 ) / info.FramesPerBlock;
+
+  if ( !this->CompressedFramesStreamStarted )
+  {
+    // The blocks are raw deflate data, the stream header is written before the first block
+    std::vector<unsigned char> streamHeader;
+    if ( format == COMPRESSED_DATA_GZIP )
+    {
+      // magic, deflate method, no flags, no modification time, no extra flags, unknown OS
+      const unsigned char gzipHeader[10] = { 0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff };
+      streamHeader.assign( gzipHeader, gzipHeader + sizeof( gzipHeader ) );
+    }
+    else
+    {
+      // deflate with 32K window, default compression level, no preset dictionary
+      const unsigned char zlibHeader[2] = { 0x78, 0x9c };
+      streamHeader.assign( zlibHeader, zlibHeader + sizeof( zlibHeader ) );
+    }
+    size_t writtenSize = 0;
+    if ( PlusCommon::RobustFwrite( this->OutputImageFileHandle, &streamHeader[0], streamHeader.size(), writtenSize ) != PLUS_SUCCESS )
+    {
+      LOG_ERROR( "Error writing compressed data into file" );
+      return PLUS_FAIL;
+    }
+    compressedDataSize += writtenSize;
+    this->CompressedFramesStreamStarted = true;
+    this->CompressedFramesChecksum = ( format == COMPRESSED_DATA_GZIP ) ? crc32( 0L, Z_NULL, 0 ) : adler32( 0L, Z_NULL, 0 );
+    this->CompressedFramesUncompressedSize = 0;
+    this->CompressedFramesDictionary.clear();
+  }
+  info.Checksum = this->CompressedFramesChecksum;
+  info.UncompressedSize = this->CompressedFramesUncompressedSize;
+
+  if ( this->WriteBlocksInOrder( info ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Error occurred during compressing image data into file" );
+    return PLUS_FAIL;
+  }
+  compressedDataSize += info.BytesWritten;
+  this->CompressedFramesChecksum = info.Checksum;
+  this->CompressedFramesUncompressedSize = info.UncompressedSize;
+
+  // The end of the frames is the dictionary of the first block of the next call
+  std::vector<unsigned char> dictionary( COMPRESSION_DICTIONARY_SIZE_BYTES );
+  size_t dictionaryStart = this->GetPrecedingUncompressedData( info, info.NumberOfFrames, dictionary );
+  this->CompressedFramesDictionary.assign( dictionary.begin() + dictionaryStart, dictionary.end() );
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::FinishCompressedFramesStream( CompressedDataFormat format, int& compressedDataSize )
+{
+  compressedDataSize = 0;
+  if ( !this->CompressedFramesStreamStarted )
+  {
+    return PLUS_SUCCESS;
+  }
+  this->CompressedFramesStreamStarted = false;
+  this->CompressedFramesDictionary.clear();
+
+  // Final (empty) deflate block
+  z_stream strm;
+  strm.zalloc = Z_NULL;
+  strm.zfree = Z_NULL;
+  strm.opaque = Z_NULL;
+  int ret = deflateInit2( &strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY );
+  if ( ret != Z_OK )
+  {
+    LOG_ERROR( "Image compression initialization failed (errorCode=" << ret << ")" );
+    return PLUS_FAIL;
+  }
+  unsigned char outputBuffer[Z_BUFSIZE];
+  strm.next_in = Z_NULL;
+  strm.avail_in = 0;
+  strm.avail_out = Z_BUFSIZE;
+  strm.next_out = outputBuffer;
+  ret = deflate( &strm, Z_FINISH );
+  deflateEnd( &strm );
+  if ( ret != Z_STREAM_END )
+  {
+    LOG_ERROR( "Error occurred during compressing image data" );
+    return PLUS_FAIL;
+  }
+  std::vector<unsigned char> streamEnd( outputBuffer, outputBuffer + ( Z_BUFSIZE - strm.avail_out ) );
+
+  if ( format == COMPRESSED_DATA_GZIP )
+  {
+    // CRC-32 and uncompressed size modulo 2^32, little endian
+    for ( int i = 0; i < 4; i++ )
+    {
+      streamEnd.push_back( static_cast<unsigned char>( ( this->CompressedFramesChecksum >> ( 8 * i ) ) & 0xff ) );
+    }
+    for ( int i = 0; i < 4; i++ )
+    {
+      streamEnd.push_back( static_cast<unsigned char>( ( this->CompressedFramesUncompressedSize >> ( 8 * i ) ) & 0xff ) );
+    }
+  }
+  else
+  {
+    // Adler-32, big endian
+    for ( int i = 3; i >= 0; i-- )
+    {
+      streamEnd.push_back( static_cast<unsigned char>( ( this->CompressedFramesChecksum >> ( 8 * i ) ) & 0xff ) );
+    }
+  }
+  size_t writtenSize = 0;
+  if ( PlusCommon::RobustFwrite( this->OutputImageFileHandle, &streamEnd[0], streamEnd.size(), writtenSize ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Error writing compressed data into file" );
+    return PLUS_FAIL;
+  }
+  compressedDataSize = static_cast<int>( writtenSize );
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::WriteBlocksInOrder( OrderedWriteInfo& info )
+{
+  int numberOfThreads = ( this->NumberOfThreads > 0 ? this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads() );
+  // One thread writes, the others produce the blocks
+  numberOfThreads = std::min<int>( numberOfThreads, info.NumberOfBlocks + 1 );
+
+  if ( numberOfThreads < 2 )
+  {
+    info.Blocks.resize( 1 );
+    for ( unsigned int blockIndex = 0; blockIndex < info.NumberOfBlocks; blockIndex++ )
+    {
+      if ( this->ProduceBlock( info, blockIndex ) != PLUS_SUCCESS || this->WriteBlock( info, blockIndex ) != PLUS_SUCCESS )
+      {
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  info.Blocks.resize( ( numberOfThreads - 1 ) * MAX_PENDING_BLOCKS_PER_THREAD );
+  this->Threader->SetNumberOfThreads( numberOfThreads );
+  this->Threader->SetSingleMethod( OrderedWriteThreadFunction, &info );
+  this->Threader->SingleMethodExecute();
+
+  return info.Failed ? PLUS_FAIL : PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPlusSequenceIOBase::OrderedWriteThreadFunction( void* arg )
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>( arg );
+  OrderedWriteInfo* info = static_cast<OrderedWriteInfo*>( threadInfo->UserData );
+  const unsigned int numberOfSlots = static_cast<unsigned int>( info->Blocks.size() );
+
+  std::unique_lock<std::mutex> lock( info->Mutex );
+  if ( threadInfo->ThreadID == 0 )
+  {
+    // Writer: wait for the next block in order, write it, and release its slot
+    while ( !info->Failed && info->NextBlockToWrite < info->NumberOfBlocks )
+    {
+      OrderedWriteInfo::Block& block = info->Blocks[info->NextBlockToWrite % numberOfSlots];
+      info->BlockProduced.wait( lock, [info, &block] { return info->Failed || block.Ready; } );
+      if ( info->Failed )
+      {
+        break;
+      }
+      lock.unlock();
+      PlusStatus status = info->Self->WriteBlock( *info, info->NextBlockToWrite );
+      lock.lock();
+      if ( status != PLUS_SUCCESS )
+      {
+        info->Failed = true;
+      }
+      block.Ready = false;
+      info->NextBlockToWrite++;
+      info->BlockWritten.notify_all();
+    }
+  }
+  else
+  {
+    // Producer: take the next block if there is a free slot for it
+    while ( true )
+    {
+      info->BlockWritten.wait( lock, [info, numberOfSlots]
+      {
+        return info->Failed || info->NextBlockToProduce >= info->NumberOfBlocks || info->NextBlockToProduce < info->NextBlockToWrite + numberOfSlots;
+      } );
+      if ( info->Failed || info->NextBlockToProduce >= info->NumberOfBlocks )
+      {
+        break;
+      }
+      unsigned int blockIndex = info->NextBlockToProduce++;
+      lock.unlock();
+      PlusStatus status = info->Self->ProduceBlock( *info, blockIndex );
+      lock.lock();
+      if ( status != PLUS_SUCCESS )
+      {
+        info->Failed = true;
+      }
+      else
+      {
+        info->Blocks[blockIndex % numberOfSlots].Ready = true;
+      }
+      info->BlockProduced.notify_all();
+    }
+  }
+  // Wake up the threads that wait for this thread
+  info->BlockWritten.notify_all();
+  info->BlockProduced.notify_all();
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::ProduceBlock( OrderedWriteInfo& info, unsigned int blockIndex )
+{
+  OrderedWriteInfo::Block& block = info.Blocks[blockIndex % info.Blocks.size()];
+  block.Data.clear();
+  unsigned int firstFrameNumber = blockIndex * info.FramesPerBlock;
+  unsigned int endFrameNumber = std::min( firstFrameNumber + info.FramesPerBlock, info.NumberOfFrames );
+
+  if ( info.Type == OrderedWriteInfo::FRAME_FIELDS_HEADER_TEXT )
+  {
+    for ( unsigned int frameNumber = firstFrameNumber; frameNumber < endFrameNumber; frameNumber++ )
+    {
+      this->FormatFrameFieldsHeaderText( frameNumber, block.Data );
+    }
+    return PLUS_SUCCESS;
+  }
+
+  // Raw deflate data: the zlib or gzip header and trailer are written separately
+  z_stream strm;
+  strm.zalloc = Z_NULL;
+  strm.zfree = Z_NULL;
+  strm.opaque = Z_NULL;
+  int ret = deflateInit2( &strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY );
+  if ( ret != Z_OK )
+  {
+    LOG_ERROR( "Image compression initialization failed (errorCode=" << ret << ")" );
+    return PLUS_FAIL;
+  }
+
+  // The end of the preceding frames is in the decompression window when this block is decompressed,
+  // so it can be used as dictionary for compressing this block as well as a single stream would
+  std::vector<unsigned char> dictionary( COMPRESSION_DICTIONARY_SIZE_BYTES );
+  size_t dictionaryStart = this->GetPrecedingUncompressedData( info, firstFrameNumber, dictionary );
+  if ( dictionaryStart < dictionary.size() )
+  {
+    deflateSetDictionary( &strm, &dictionary[dictionaryStart], static_cast<uInt>( dictionary.size() - dictionaryStart ) );
+  }
+
+  // Blocks end on a byte boundary without closing the stream, the stream is closed by FinishCompressedFramesStream
+  const int blockEndFlush = Z_SYNC_FLUSH;
+  const bool gzip = ( info.Format == COMPRESSED_DATA_GZIP );
+  block.Checksum = gzip ? crc32( 0L, Z_NULL, 0 ) : adler32( 0L, Z_NULL, 0 );
+  block.UncompressedSize = 0;
+
+  unsigned char outputBuffer[Z_BUFSIZE];
+  unsigned int frameNumber = firstFrameNumber;
+  do
+  {
+    int flush = blockEndFlush;
+    strm.next_in = Z_NULL;
+    strm.avail_in = 0;
+    if ( frameNumber < endFrameNumber )
+    {
+      const PlusVideoFrame* videoFrame = this->GetFrameToWrite( frameNumber, *info.BlankFrame );
+      strm.next_in = static_cast<Bytef*>( videoFrame->GetScalarPointer() );
+      strm.avail_in = videoFrame->GetFrameSizeInBytes();
+      block.Checksum = gzip ? crc32( block.Checksum, strm.next_in, strm.avail_in ) : adler32( block.Checksum, strm.next_in, strm.avail_in );
+      block.UncompressedSize += strm.avail_in;
+      if ( frameNumber + 1 < endFrameNumber )
+      {
+        flush = Z_NO_FLUSH;
+      }
+    }
+
+    // run deflate() on input until output buffer not full
+    do
+    {
+      strm.avail_out = Z_BUFSIZE;
+      strm.next_out = outputBuffer;
+      ret = deflate( &strm, flush );
+      if ( ret == Z_STREAM_ERROR )
+      {
+        LOG_ERROR( "Zlib state became invalid during the compression process (errorCode=" << ret << ")" );
+        deflateEnd( &strm );
+        return PLUS_FAIL;
+      }
+      block.Data.append( reinterpret_cast<char*>( outputBuffer ), Z_BUFSIZE - strm.avail_out );
+    }
+    while ( strm.avail_out == 0 );
+
+    if ( strm.avail_in != 0 )
+    {
+      // by now all input should have been consumed
+      LOG_ERROR( "Zlib state became invalid during the compression process" );
+      deflateEnd( &strm );
+      return PLUS_FAIL;
+    }
+    frameNumber++;
+  }
+  while ( frameNumber < endFrameNumber );
+
+  deflateEnd( &strm );
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+size_t vtkPlusSequenceIOBase::GetPrecedingUncompressedData( OrderedWriteInfo& info, unsigned int frameNumber, std::vector<unsigned char>& data )
+{
+  size_t dataStart = data.size();
+  for ( ; frameNumber > 0 && dataStart > 0; frameNumber-- )
+  {
+    const PlusVideoFrame* videoFrame = this->GetFrameToWrite( frameNumber - 1, *info.BlankFrame );
+    size_t frameSize = videoFrame->GetFrameSizeInBytes();
+    size_t copySize = std::min( frameSize, dataStart );
+    memcpy( &data[dataStart - copySize], static_cast<unsigned char*>( videoFrame->GetScalarPointer() ) + frameSize - copySize, copySize );
+    dataStart -= copySize;
+  }
+  if ( info.PrecedingData != NULL && dataStart > 0 && !info.PrecedingData->empty() )
+  {
+    // Data written by previous calls
+    size_t copySize = std::min( info.PrecedingData->size(), dataStart );
+    memcpy( &data[dataStart - copySize], &( *info.PrecedingData )[info.PrecedingData->size() - copySize], copySize );
+    dataStart -= copySize;
+  }
+  return dataStart;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::WriteBlock( OrderedWriteInfo& info, unsigned int blockIndex )
+{
+  OrderedWriteInfo::Block& block = info.Blocks[blockIndex % info.Blocks.size()];
+  size_t writtenSize = 0;
+  PlusStatus status = PLUS_SUCCESS;
+  if ( !block.Data.empty() )
+  {
+    status = PlusCommon::RobustFwrite( info.Stream, &block.Data[0], block.Data.size(), writtenSize );
+  }
+  info.BytesWritten += writtenSize;
+  if ( status != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Unable to write block " << blockIndex << " to file. Block size: " << block.Data.size() << ", successfully written: " << writtenSize << " bytes" );
+    return PLUS_FAIL;
+  }
+
+  if ( info.Type == OrderedWriteInfo::COMPRESSED_PIXELS )
+  {
+    if ( info.Format == COMPRESSED_DATA_GZIP )
+    {
+      info.Checksum = crc32_combine( info.Checksum, block.Checksum, static_cast<z_off_t>( block.UncompressedSize ) );
+    }
+    else
+    {
+      info.Checksum = adler32_combine( info.Checksum, block.Checksum, static_cast<z_off_t>( block.UncompressedSize ) );
+    }
+    info.UncompressedSize += block.UncompressedSize;
+  }
+
+  block.Data.clear();
+  return PLUS_SUCCESS;
+}
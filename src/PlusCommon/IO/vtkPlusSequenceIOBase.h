@@ -10,6 +10,7 @@
 #include "PlusCommon.h"
 #include "vtkPlusCommonExport.h"
 #include "PlusVideoFrame.h"
+#include "vtkMultiThreader.h"
 #include "vtkObject.h"
 
 class vtkPlusTrackedFrameList;
@@ -39,6 +40,22 @@ public:
   /*! Read file contents into the object */
   virtual PlusStatus Read();
 
+  /*!
+    Read only the header of the file: custom strings and frame fields, without pixel data.
+    Pixel data of individual frames can be read afterwards by ReadFramePixels.
+  */
+  virtual PlusStatus ReadHeader();
+
+  /*! Returns true if the reader can read the pixel data of individual frames (see ReadFramePixels) */
+  virtual bool CanReadFramePixels() const;
+
+  /*!
+    Read pixel data of a single frame into the provided video frame. ReadHeader must be called before.
+    Frames can be read in any order, but reading them in increasing frame number order is the fastest.
+    The image status field of the frame is not checked.
+  */
+  virtual PlusStatus ReadFramePixels(unsigned int frameNumber, PlusVideoFrame& videoFrame);
+
   /*! Write images to disc, compression allowed */
   virtual PlusStatus WriteImages();
 
@@ -70,6 +87,7 @@ public:
     * y axis: points towards the y coordinate increase direction
   */
   vtkSetMacro( ImageOrientationInMemory, US_IMAGE_ORIENTATION );
+  vtkGetMacro( ImageOrientationInMemory, US_IMAGE_ORIENTATION );
 
   /*!
     Set input/output file name. The file contains only the image header in case of
@@ -129,6 +147,15 @@ public:
   /*! Return the dimensions of the sequence */
   vtkGetVector4Macro( Dimensions, unsigned int );
 
+  /*! Return the pixel type of the images in the sequence */
+  vtkGetMacro( PixelType, PlusCommon::VTKScalarPixelType );
+
+  /*! Return the number of scalar components of the images in the sequence */
+  vtkGetMacro( NumberOfScalarComponents, int );
+
+  /*! Return the image type (B-mode, RF, ...) of the images in the sequence */
+  vtkGetMacro( ImageType, US_IMAGE_TYPE );
+
   /*! Flag to enable/disable writing of image data */
   vtkGetMacro( EnableImageDataWrite, bool );
   /*! Flag to enable/disable writing of image data */
@@ -136,7 +163,31 @@ public:
   /*! Flag to enable/disable writing of image data */
   vtkBooleanMacro( EnableImageDataWrite, bool );
 
+  /*! Set the number of threads used for formatting the header and compressing the pixel data (0 means the default number of threads is used) */
+  vtkSetMacro( NumberOfThreads, int );
+  /*! Get the number of threads used for formatting the header and compressing the pixel data */
+  vtkGetMacro( NumberOfThreads, int );
+
+  /*!
+    Flag to enable/disable parallel compression of image data. Must be set before writing.
+    The compressed data is still a standard zlib (or gzip) stream, but it is compressed in blocks of frames,
+    so the file is slightly larger and not byte-identical to the file written with sequential compression.
+    The stream is continued by each WriteImages call and it is finished when the file is closed.
+  */
+  vtkGetMacro( ParallelCompression, bool );
+  /*! Flag to enable/disable parallel compression of image data */
+  vtkSetMacro( ParallelCompression, bool );
+  /*! Flag to enable/disable parallel compression of image data */
+  vtkBooleanMacro( ParallelCompression, bool );
+
 protected:
+  /*! Container format of the compressed pixel data */
+  enum CompressedDataFormat
+  {
+    COMPRESSED_DATA_ZLIB,
+    COMPRESSED_DATA_GZIP
+  };
+
   /*! Read all the fields in the image file header */
   virtual PlusStatus ReadImageHeader() = 0;
 
@@ -162,6 +213,64 @@ protected:
   */
   virtual PlusStatus WriteCompressedImagePixelsToFile( int& compressedDataSize ) = 0;
 
+  /*!
+    Format the custom fields (and the image status) of a frame as header text.
+    It is called from multiple threads at the same time, therefore it must not modify the object.
+    \param frameNumber index of the frame in the tracked frame list (the frame number in the file is offset by CurrentFrameOffset)
+    \param headerText the formatted fields are appended to this string
+  */
+  virtual void FormatFrameFieldsHeaderText( unsigned int frameNumber, std::string& headerText ) = 0;
+
+  /*!
+    Write the custom fields of all the frames in the tracked frame list to the header.
+    Blocks of frames are formatted in parallel (see FormatFrameFieldsHeaderText) and written to the stream in frame order.
+  */
+  PlusStatus WriteFrameFieldsToHeader( FILE* stream );
+
+  /*!
+    Compress the pixel data of all the frames in the tracked frame list and write it into OutputImageFileHandle.
+    Blocks of consecutive frames are compressed in parallel, each block using the end of the preceding block as preset dictionary,
+    and the blocks are written in order, so that the result is a single standard zlib or gzip stream.
+    The stream header is written by the first call, the following calls continue the same stream,
+    and the stream has to be finished by FinishCompressedFramesStream after the last frame.
+    \param compressedDataSize returns the size of the total compressed data that is written to the file.
+  */
+  PlusStatus WriteCompressedFramesToFile( CompressedDataFormat format, int& compressedDataSize );
+
+  /*!
+    Write the end of the stream that is written by WriteCompressedFramesToFile (final deflate block and zlib or gzip trailer).
+    Does nothing if no compressed frames have been written.
+    \param compressedDataSize returns the size of the compressed data that is written to the file.
+  */
+  PlusStatus FinishCompressedFramesStream( CompressedDataFormat format, int& compressedDataSize );
+
+  /*! Blocks of frames that are produced in parallel and written in order, shared by the threads of WriteBlocksInOrder */
+  struct OrderedWriteInfo;
+
+  /*!
+    Produce all the blocks of the write in worker threads while writing the completed blocks in order in the calling thread.
+    The number of blocks that are produced but not written yet is limited, so the memory usage does not depend on the number of frames.
+  */
+  PlusStatus WriteBlocksInOrder( OrderedWriteInfo& info );
+
+  /*! Thread function of WriteBlocksInOrder: thread 0 writes the blocks, the other threads produce them */
+  static VTK_THREAD_RETURN_TYPE OrderedWriteThreadFunction( void* arg );
+
+  /*! Format or compress the frames of a block, called from multiple threads at the same time */
+  PlusStatus ProduceBlock( OrderedWriteInfo& info, unsigned int blockIndex );
+
+  /*! Write a produced block to the stream, called in block order */
+  PlusStatus WriteBlock( OrderedWriteInfo& info, unsigned int blockIndex );
+
+  /*! Returns the frame that is written into the file for the specified frame, the blank frame if the image is not available */
+  const PlusVideoFrame* GetFrameToWrite( unsigned int frameNumber, const PlusVideoFrame& blankFrame );
+
+  /*!
+    Copy the end of the uncompressed pixel data that precedes a frame (including the data written by previous WriteCompressedFramesToFile calls)
+    to the end of the data vector. Returns the position of the first copied byte, which is the size of the data vector if nothing is available.
+  */
+  size_t GetPrecedingUncompressedData( OrderedWriteInfo& info, unsigned int frameNumber, std::vector<unsigned char>& data );
+
   /*! Opens a file. Doesn't log error if it fails because it may be expected. */
   static PlusStatus FileOpen( FILE** stream, const char* filename, const char* flags );
 
@@ -212,6 +321,16 @@ protected:
   std::string TempImageFileName;
   /*! Enable/disable zlib compression of pixel data */
   bool UseCompression;
+  /*! Compress blocks of frames in parallel instead of compressing all the frames sequentially */
+  bool ParallelCompression;
+  /*! The header of the stream that is written by WriteCompressedFramesToFile is already written */
+  bool CompressedFramesStreamStarted;
+  /*! Adler-32 or CRC-32 of the uncompressed pixel data written by WriteCompressedFramesToFile so far */
+  unsigned long CompressedFramesChecksum;
+  /*! Size of the uncompressed pixel data written by WriteCompressedFramesToFile so far */
+  unsigned long long CompressedFramesUncompressedSize;
+  /*! End of the uncompressed pixel data written by WriteCompressedFramesToFile so far, used as dictionary for the next frames */
+  std::vector<unsigned char> CompressedFramesDictionary;
   /*! Buffered compressed data size */
   unsigned long long CompressedBytesWritten;
   /*! Whether to enable pixel writing */
@@ -254,6 +373,11 @@ protected:
   /*! file handle for image output */
   FILE* OutputImageFileHandle;
 
+  /*! Threader for formatting the header and compressing the pixel data */
+  vtkMultiThreader* Threader;
+  /*! Number of threads used for formatting the header and compressing the pixel data (0 means the default number of threads) */
+  int NumberOfThreads;
+
 protected:
   vtkPlusSequenceIOBase();
   virtual ~vtkPlusSequenceIOBase();
@@ -0,0 +1,178 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusFieldMap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <set>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Orders entries by field name, the same way as std::map<std::string, std::string> does
+  struct EntryNameLess
+  {
+    template<typename EntryType>
+    bool operator()(const EntryType& entry, const std::string& name) const { return entry.Name->compare(name) < 0; }
+    template<typename EntryType>
+    bool operator()(const EntryType& entry, const char* name) const { return entry.Name->compare(name) < 0; }
+  };
+
+  //----------------------------------------------------------------------------
+  template<typename EntryContainerType, typename NameType>
+  typename EntryContainerType::const_iterator FindEntry(const EntryContainerType& entries, const NameType& name)
+  {
+    typename EntryContainerType::const_iterator entryIt = std::lower_bound(entries.begin(), entries.end(), name, EntryNameLess());
+    if (entryIt != entries.end() && entryIt->Name->compare(name) == 0)
+    {
+      return entryIt;
+    }
+    return entries.end();
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusFieldMap::PlusFieldMap()
+{
+}
+
+//----------------------------------------------------------------------------
+PlusFieldMap::PlusFieldMap(const PlusFieldMap& other)
+  : Entries(other.Entries)
+{
+}
+
+//----------------------------------------------------------------------------
+PlusFieldMap& PlusFieldMap::operator=(const PlusFieldMap& other)
+{
+  this->Entries = other.Entries;
+  return *this;
+}
+
+//----------------------------------------------------------------------------
+PlusFieldMap::~PlusFieldMap()
+{
+}
+
+//----------------------------------------------------------------------------
+const PlusFieldMap::EntryContainerType& PlusFieldMap::GetEntries() const
+{
+  static const EntryContainerType emptyEntries;
+  return this->Entries ? *this->Entries : emptyEntries;
+}
+
+//----------------------------------------------------------------------------
+void PlusFieldMap::Detach()
+{
+  if (!this->Entries)
+  {
+    this->Entries = std::make_shared<EntryContainerType>();
+  }
+  else if (this->Entries.use_count() > 1)
+  {
+    this->Entries = std::make_shared<EntryContainerType>(*this->Entries);
+  }
+  else
+  {
+    // We are the only owner, but another thread may have just released its copy:
+    // make sure its reads of the entries happen before our modifications.
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+}
+
+//----------------------------------------------------------------------------
+const std::string* PlusFieldMap::InternName(const std::string& name)
+{
+  // The name table is never deleted, so that interned names remain valid
+  // even for maps that are destroyed during static deinitialization.
+  static std::set<std::string>* internedNames = new std::set<std::string>;
+  static vtkPlusSimpleRecursiveCriticalSection* internedNamesMutex = new vtkPlusSimpleRecursiveCriticalSection;
+
+  PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> internedNamesGuardedLock(internedNamesMutex);
+  return &(*internedNames->insert(name).first);
+}
+
+//----------------------------------------------------------------------------
+void PlusFieldMap::clear()
+{
+  this->Entries.reset();
+}
+
+//----------------------------------------------------------------------------
+PlusFieldMap::const_iterator PlusFieldMap::find(const std::string& name) const
+{
+  return const_iterator(FindEntry(this->GetEntries(), name));
+}
+
+//----------------------------------------------------------------------------
+PlusFieldMap::const_iterator PlusFieldMap::find(const char* name) const
+{
+  return const_iterator(FindEntry(this->GetEntries(), name));
+}
+
+//----------------------------------------------------------------------------
+const std::string* PlusFieldMap::GetValue(const std::string& name) const
+{
+  EntryContainerType::const_iterator entryIt = FindEntry(this->GetEntries(), name);
+  return (entryIt != this->GetEntries().end()) ? &entryIt->Value : NULL;
+}
+
+//----------------------------------------------------------------------------
+const std::string* PlusFieldMap::GetValue(const char* name) const
+{
+  EntryContainerType::const_iterator entryIt = FindEntry(this->GetEntries(), name);
+  return (entryIt != this->GetEntries().end()) ? &entryIt->Value : NULL;
+}
+
+//----------------------------------------------------------------------------
+std::string& PlusFieldMap::operator[](const std::string& name)
+{
+  this->Detach();
+  EntryContainerType::iterator entryIt = std::lower_bound(this->Entries->begin(), this->Entries->end(), name, EntryNameLess());
+  if (entryIt == this->Entries->end() || entryIt->Name->compare(name) != 0)
+  {
+    Entry newEntry;
+    newEntry.Name = InternName(name);
+    entryIt = this->Entries->insert(entryIt, newEntry);
+  }
+  return entryIt->Value;
+}
+
+//----------------------------------------------------------------------------
+void PlusFieldMap::SetValue(const std::string& name, const std::string& value)
+{
+  // Skip the copy if the value is unchanged, this keeps the entries shared with other maps
+  const std::string* currentValue = this->GetValue(name);
+  if (currentValue != NULL && *currentValue == value)
+  {
+    return;
+  }
+  (*this)[name] = value;
+}
+
+//----------------------------------------------------------------------------
+PlusFieldMap::const_iterator PlusFieldMap::erase(const_iterator position)
+{
+  // Position may refer to entries that are shared with other maps, so locate it by index
+  EntryContainerType::difference_type index = position.Position - this->GetEntries().begin();
+  this->Detach();
+  EntryContainerType::iterator nextEntryIt = this->Entries->erase(this->Entries->begin() + index);
+  return const_iterator(nextEntryIt);
+}
+
+//----------------------------------------------------------------------------
+PlusFieldMap::size_type PlusFieldMap::erase(const std::string& name)
+{
+  const_iterator fieldIt = this->find(name);
+  if (fieldIt == this->end())
+  {
+    return 0;
+  }
+  this->erase(fieldIt);
+  return 1;
+}
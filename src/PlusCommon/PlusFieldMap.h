@@ -0,0 +1,143 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusFieldMap_h
+#define __PlusFieldMap_h
+
+#include "vtkPlusCommonExport.h"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+  \class PlusFieldMap
+  \brief Compact name/value store for the custom fields of tracked frames and buffer items
+
+  Field names are interned once per process, so each entry only holds a pointer to the
+  shared name string and the value. Entries are kept in a flat vector sorted by name, so
+  iteration order is the same as it was with std::map<std::string, std::string>.
+
+  The entry vector is shared between copies (copy-on-write): copying a field map is a
+  reference count increment and the entries are only duplicated when a shared map is
+  modified. Similarly to standard containers, a single map object must not be accessed
+  from multiple threads at the same time, but copies of a map can be used from different threads.
+
+  The map can only be read through iterators, values can be changed by operator[] or erase.
+  References and pointers returned by the map are valid until the map is next modified or copied.
+
+  \ingroup PlusLibCommon
+*/
+class vtkPlusCommonExport PlusFieldMap
+{
+protected:
+  struct Entry
+  {
+    /*! Interned field name, owned by the process-wide name table */
+    const std::string* Name;
+    std::string Value;
+  };
+  typedef std::vector<Entry> EntryContainerType;
+
+public:
+  typedef std::string key_type;
+  typedef std::string mapped_type;
+  typedef std::size_t size_type;
+
+  /*! Name/value pair returned by the map iterators, accessible through first/second like a std::map element */
+  struct value_type
+  {
+    value_type(const std::string& name, const std::string& value) : first(name), second(value) {}
+    const std::string& first;
+    const std::string& second;
+  };
+
+  /*! Read-only iterator, it can be used the same way as a std::map<std::string, std::string>::const_iterator */
+  class const_iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef PlusFieldMap::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef PlusFieldMap::value_type reference;
+
+    /*! Helper for returning a pointer-like object from operator-> */
+    class pointer
+    {
+    public:
+      pointer(const value_type& element) : Element(element) {}
+      const value_type* operator->() const { return &this->Element; }
+    private:
+      value_type Element;
+    };
+
+    const_iterator() {}
+    reference operator*() const { return value_type(*this->Position->Name, this->Position->Value); }
+    pointer operator->() const { return pointer(**this); }
+    const_iterator& operator++() { ++this->Position; return *this; }
+    const_iterator operator++(int) { const_iterator previous(*this); ++this->Position; return previous; }
+    bool operator==(const const_iterator& other) const { return this->Position == other.Position; }
+    bool operator!=(const const_iterator& other) const { return this->Position != other.Position; }
+
+  protected:
+    friend class PlusFieldMap;
+    explicit const_iterator(EntryContainerType::const_iterator position) : Position(position) {}
+    EntryContainerType::const_iterator Position;
+  };
+  typedef const_iterator iterator;
+
+public:
+  PlusFieldMap();
+  PlusFieldMap(const PlusFieldMap& other);
+  PlusFieldMap& operator=(const PlusFieldMap& other);
+  ~PlusFieldMap();
+
+  const_iterator begin() const { return const_iterator(this->GetEntries().begin()); }
+  const_iterator end() const { return const_iterator(this->GetEntries().end()); }
+
+  size_type size() const { return this->Entries ? this->Entries->size() : 0; }
+  bool empty() const { return this->size() == 0; }
+
+  /*! Remove all fields */
+  void clear();
+
+  /*! Find a field by name. Returns end() if the field is not defined. */
+  const_iterator find(const std::string& name) const;
+  const_iterator find(const char* name) const;
+
+  /*! Returns 1 if the field is defined, 0 otherwise */
+  size_type count(const std::string& name) const { return this->find(name) != this->end() ? 1 : 0; }
+
+  /*! Get a reference to the value of a field. The field is added with empty value if it is not defined yet. */
+  std::string& operator[](const std::string& name);
+
+  /*! Remove a field. Returns iterator to the following field. */
+  const_iterator erase(const_iterator position);
+  /*! Remove a field by name. Returns the number of removed fields (0 or 1). */
+  size_type erase(const std::string& name);
+
+  /*! Get the value of a field. Returns NULL if the field is not defined. */
+  const std::string* GetValue(const std::string& name) const;
+  const std::string* GetValue(const char* name) const;
+
+  /*! Set the value of a field, adds the field if it is not defined yet */
+  void SetValue(const std::string& name, const std::string& value);
+
+protected:
+  const EntryContainerType& GetEntries() const;
+
+  /*! Make sure the entries are allocated and not shared with any other map, so that they can be modified */
+  void Detach();
+
+  /*! Returns the unique copy of a field name that is shared by all maps */
+  static const std::string* InternName(const std::string& name);
+
+  std::shared_ptr<EntryContainerType> Entries;
+};
+
+#endif
@@ -133,7 +133,8 @@ PlusStatus PlusTrackedFrame::PrintToXML(vtkXMLDataElement* trackedFrame, const s
       vtkSmartPointer<vtkXMLDataElement> customField = vtkSmartPointer<vtkXMLDataElement>::New();
       customField->SetName("CustomFrameField");
       customField->SetAttribute("Name", statusName.c_str());
-      customField->SetAttribute("Value", CustomFrameFields[statusName].c_str());
+      const std::string* statusValue = CustomFrameFields.GetValue(statusName);
+      customField->SetAttribute("Value", statusValue != NULL ? statusValue->c_str() : "");
       trackedFrame->AddNestedElement(customField);
     }
     vtkSmartPointer<vtkXMLDataElement> customField = vtkSmartPointer<vtkXMLDataElement>::New();
@@ -292,7 +293,7 @@ void PlusTrackedFrame::SetTimestamp(double value)
   this->Timestamp = value;
   std::ostringstream strTimestamp;
   strTimestamp << std::setprecision(FLOATING_POINT_PRECISION) << this->Timestamp;
-  this->CustomFrameFields["Timestamp"] = strTimestamp.str();
+  this->CustomFrameFields.SetValue("Timestamp", strTimestamp.str());
 }
 
 //----------------------------------------------------------------------------
@@ -353,7 +354,7 @@ void PlusTrackedFrame::SetCustomFrameField(std::string name, std::string value)
     }
   }
 
-  this->CustomFrameFields[name] = value;
+  this->CustomFrameFields.SetValue(name, value);
 }
 
 //----------------------------------------------------------------------------
@@ -365,11 +366,10 @@ const char* PlusTrackedFrame::GetCustomFrameField(const char* fieldName)
     return NULL;
   }
 
-  FieldMapType::iterator fieldIterator;
-  fieldIterator = this->CustomFrameFields.find(fieldName);
-  if (fieldIterator != this->CustomFrameFields.end())
+  const std::string* fieldValue = this->CustomFrameFields.GetValue(fieldName);
+  if (fieldValue != NULL)
   {
-    return fieldIterator->second.c_str();
+    return fieldValue->c_str();
   }
   return NULL;
 }
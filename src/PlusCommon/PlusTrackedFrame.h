@@ -9,6 +9,7 @@
 
 #include "vtkPlusCommonExport.h"
 
+#include "PlusFieldMap.h"
 #include "PlusVideoFrame.h"
 
 class vtkMatrix4x4;
@@ -40,7 +41,7 @@ public:
 public:
   static const std::string TransformPostfix;
   static const std::string TransformStatusPostfix;
-  typedef std::map<std::string, std::string> FieldMapType;
+  typedef PlusFieldMap FieldMapType;
 
 public:
   PlusTrackedFrame();
@@ -64,7 +65,7 @@ public:
   /*! Set custom frame field */
   void SetCustomFrameField(std::string name, std::string value);
 
-  /*! Get custom frame field value */
+  /*! Get custom frame field value. The returned pointer is valid until the custom fields of the frame are modified. */
   const char* GetCustomFrameField(const char* fieldName);
   const char* GetCustomFrameField(const std::string& fieldName);
 
@@ -148,7 +149,7 @@ public:
   /*! Convert from field status enum to field status string */
   static std::string ConvertFieldStatusToString(TrackedFrameFieldStatus status);
 
-  /*! Return all custom fields in a map */
+  /*! Return all custom fields in a map (copying the map is cheap, the fields are shared until modified) */
   const FieldMapType& GetCustomFields() { return this->CustomFrameFields; }
 
   /*! Returns true if the input string ends with "Transform", else false */
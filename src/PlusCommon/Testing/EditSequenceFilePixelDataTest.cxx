@@ -0,0 +1,192 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file EditSequenceFilePixelDataTest.cxx
+  \brief Test for the pixel data of sequence files that are edited by EditSequenceFile
+
+  With --generate a test sequence is written that contains a frame with invalid image.
+  With --compare the frames of an edited sequence are compared to the frames of the original sequence:
+  the number of frames, the image status, and the pixel data must be the same.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusTrackedFrame.h"
+#include "vtkPlusMetaImageSequenceIO.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+
+#include "vtkMatrix4x4.h"
+#include "vtkSmartPointer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+namespace
+{
+  const int NUMBER_OF_FRAMES = 7;
+  const int INVALID_FRAME_NUMBER = 3;
+}
+
+//-------------------------------------------------------
+PlusStatus GenerateSequenceFile(const std::string& fileName, bool useCompression)
+{
+  const int frameSize[3] = {64, 48, 1};
+  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  for (int frameNumber = 0; frameNumber < NUMBER_OF_FRAMES; frameNumber++)
+  {
+    PlusTrackedFrame frame;
+    if (frameNumber != INVALID_FRAME_NUMBER)
+    {
+      frame.GetImageData()->AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1);
+      unsigned char* pixels = static_cast<unsigned char*>(frame.GetImageData()->GetScalarPointer());
+      for (int y = 0; y < frameSize[1]; y++)
+      {
+        for (int x = 0; x < frameSize[0]; x++)
+        {
+          pixels[y * frameSize[0] + x] = static_cast<unsigned char>(x * 3 + y + frameNumber * 11);
+        }
+      }
+    }
+    std::ostringstream frameNumberStr;
+    frameNumberStr << frameNumber;
+    frame.SetCustomFrameField("FrameNumber", frameNumberStr.str());
+    vtkSmartPointer<vtkMatrix4x4> probeToTrackerMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    probeToTrackerMatrix->SetElement(0, 3, frameNumber);
+    frame.SetCustomFrameTransform(PlusTransformName("Probe", "Tracker"), probeToTrackerMatrix);
+    frame.SetCustomFrameTransformStatus(PlusTransformName("Probe", "Tracker"), FIELD_OK);
+    frame.SetTimestamp(1.0 + frameNumber * 0.1);
+    trackedFrameList->AddTrackedFrame(&frame, vtkPlusTrackedFrameList::ADD_INVALID_FRAME);
+  }
+
+  vtkSmartPointer<vtkPlusMetaImageSequenceIO> writer = vtkSmartPointer<vtkPlusMetaImageSequenceIO>::New();
+  writer->SetUseCompression(useCompression);
+  writer->SetFileName(fileName);
+  writer->SetTrackedFrameList(trackedFrameList);
+  if (writer->Write() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't write sequence file: " << fileName);
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//-------------------------------------------------------
+int CompareSequenceFiles(const std::string& fileName, const std::string& originalFileName)
+{
+  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (vtkPlusSequenceIO::Read(fileName, trackedFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't read sequence file: " << fileName);
+    return 1;
+  }
+  vtkSmartPointer<vtkPlusTrackedFrameList> originalTrackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (vtkPlusSequenceIO::Read(originalFileName, originalTrackedFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't read sequence file: " << originalFileName);
+    return 1;
+  }
+
+  if (trackedFrameList->GetNumberOfTrackedFrames() != originalTrackedFrameList->GetNumberOfTrackedFrames())
+  {
+    LOG_ERROR("Number of frames in " << fileName << " is " << trackedFrameList->GetNumberOfTrackedFrames()
+              << ", expected " << originalTrackedFrameList->GetNumberOfTrackedFrames());
+    return 1;
+  }
+
+  int numberOfFailures = 0;
+  int numberOfInvalidFrames = 0;
+  for (unsigned int frameNumber = 0; frameNumber < originalTrackedFrameList->GetNumberOfTrackedFrames(); frameNumber++)
+  {
+    PlusVideoFrame* frame = trackedFrameList->GetTrackedFrame(frameNumber)->GetImageData();
+    PlusVideoFrame* originalFrame = originalTrackedFrameList->GetTrackedFrame(frameNumber)->GetImageData();
+    if (frame->IsImageValid() != originalFrame->IsImageValid())
+    {
+      LOG_ERROR("Image status of frame " << frameNumber << " in " << fileName << " is different from the original");
+      numberOfFailures++;
+      continue;
+    }
+    if (!originalFrame->IsImageValid())
+    {
+      numberOfInvalidFrames++;
+      continue;
+    }
+    if (frame->GetFrameSizeInBytes() != originalFrame->GetFrameSizeInBytes()
+        || memcmp(frame->GetScalarPointer(), originalFrame->GetScalarPointer(), frame->GetFrameSizeInBytes()) != 0)
+    {
+      LOG_ERROR("Pixel data of frame " << frameNumber << " in " << fileName << " is different from the original");
+      numberOfFailures++;
+    }
+  }
+
+  if (numberOfInvalidFrames == 0)
+  {
+    LOG_ERROR("The original sequence " << originalFileName << " is expected to contain a frame with invalid image");
+    numberOfFailures++;
+  }
+
+  return numberOfFailures;
+}
+
+//-------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp = false;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+  bool generate = false;
+  bool compare = false;
+  bool useCompression = false;
+  std::string seqFileName;
+  std::string originalSeqFileName;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--generate", vtksys::CommandLineArguments::NO_ARGUMENT, &generate, "Write a test sequence file, which contains a frame with invalid image, to --seq-file.");
+  args.AddArgument("--use-compression", vtksys::CommandLineArguments::NO_ARGUMENT, &useCompression, "Compress the generated sequence file.");
+  args.AddArgument("--compare", vtksys::CommandLineArguments::NO_ARGUMENT, &compare, "Compare the frames of --seq-file to the frames of --original-seq-file.");
+  args.AddArgument("--seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &seqFileName, "Sequence file that is generated or compared.");
+  args.AddArgument("--original-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &originalSeqFileName, "Sequence file that --seq-file is compared to.");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (seqFileName.empty() || generate == compare)
+  {
+    LOG_ERROR("--seq-file and exactly one of --generate and --compare must be specified");
+    return EXIT_FAILURE;
+  }
+
+  if (generate)
+  {
+    return (GenerateSequenceFile(vtkPlusConfig::GetInstance()->GetOutputPath(seqFileName), useCompression) == PLUS_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  if (originalSeqFileName.empty())
+  {
+    LOG_ERROR("--original-seq-file must be specified for comparison");
+    return EXIT_FAILURE;
+  }
+  int numberOfFailures = CompareSequenceFiles(seqFileName, originalSeqFileName);
+  if (numberOfFailures > 0)
+  {
+    LOG_ERROR("Test failed with " << numberOfFailures << " failures");
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
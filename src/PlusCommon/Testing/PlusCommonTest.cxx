@@ -9,7 +9,9 @@ See License.txt for details.
 #include "vtksys/CommandLineArguments.hxx"
 #include "vtkSmartPointer.h"
 
+#include "PlusTrackedFrame.h"
 #include "vtkPlusRecursiveCriticalSection.h"
+#include "vtkPlusTrackedFrameList.h"
 
 static double DOUBLE_THRESHOLD=0.0001; 
 
@@ -164,6 +166,98 @@ int main(int argc, char **argv)
   if ( TestInvalidTransformName("TolTo","ToTol") != PLUS_SUCCESS ) { exit(EXIT_FAILURE); }
   if ( TestInvalidTransformName("to","to") != PLUS_SUCCESS ) { exit(EXIT_FAILURE); }
 
+  // ***********************************************
+  // Test PlusTrackedFrame custom fields
+  // ***********************************************
+
+  PlusTrackedFrame originalFrame;
+  originalFrame.SetCustomFrameField("ProbeToTrackerTransform", "1 0 0 0 0 1 0 0 0 0 1 0 0 0 0 1");
+  originalFrame.SetCustomFrameField("FrameNumber", "12");
+  originalFrame.SetCustomFrameField("ProbeToTrackerTransformStatus", "OK");
+  PlusTrackedFrame copiedFrame(originalFrame);
+  copiedFrame.SetCustomFrameField("FrameNumber", "13");
+  copiedFrame.SetCustomFrameField("AnotherField", "value");
+  if (STRCASECMP(originalFrame.GetCustomFrameField("FrameNumber"), "12") != 0 || originalFrame.IsCustomFrameFieldDefined("AnotherField"))
+  {
+    LOG_ERROR("Modifying a copied tracked frame changed the custom fields of the original frame");
+    exit(EXIT_FAILURE);
+  }
+  if (STRCASECMP(copiedFrame.GetCustomFrameField("FrameNumber"), "13") != 0 || STRCASECMP(copiedFrame.GetCustomFrameField("ProbeToTrackerTransformStatus"), "OK") != 0)
+  {
+    LOG_ERROR("Custom fields of the copied tracked frame are incorrect");
+    exit(EXIT_FAILURE);
+  }
+  if (copiedFrame.DeleteCustomFrameField("AnotherField") != PLUS_SUCCESS || copiedFrame.IsCustomFrameFieldDefined("AnotherField"))
+  {
+    LOG_ERROR("Failed to delete custom field from the copied tracked frame");
+    exit(EXIT_FAILURE);
+  }
+  std::vector<std::string> fieldNames;
+  copiedFrame.GetCustomFrameFieldNameList(fieldNames);
+  if (fieldNames.size() != 3 || fieldNames[0] != "FrameNumber" || fieldNames[1] != "ProbeToTrackerTransform" || fieldNames[2] != "ProbeToTrackerTransformStatus")
+  {
+    LOG_ERROR("Custom field names are not listed in alphabetical order");
+    exit(EXIT_FAILURE);
+  }
+
+  // ***********************************************
+  // Test vtkPlusTrackedFrameList validation
+  // ***********************************************
+
+  vtkSmartPointer<vtkPlusTrackedFrameList> frameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  frameList->SetValidationRequirements(REQUIRE_UNIQUE_TIMESTAMP | REQUIRE_TRACKING_OK);
+  // ProbeToReference is computed from the ProbeToTracker and ReferenceToTracker transforms of the frames
+  frameList->SetFrameTransformNameForValidation(PlusTransformName("Probe", "Reference"));
+  PlusTrackedFrame validatedFrame;
+  double identityMatrix[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+  validatedFrame.SetCustomFrameTransform(PlusTransformName("Probe", "Tracker"), identityMatrix);
+  validatedFrame.SetCustomFrameTransformStatus(PlusTransformName("Probe", "Tracker"), FIELD_OK);
+  validatedFrame.SetCustomFrameTransform(PlusTransformName("Reference", "Tracker"), identityMatrix);
+  validatedFrame.SetCustomFrameTransformStatus(PlusTransformName("Reference", "Tracker"), FIELD_OK);
+  for (int i = 0; i < 100; ++i)
+  {
+    validatedFrame.SetTimestamp(i);
+    frameList->AddTrackedFrame(&validatedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME);
+  }
+  for (int i = 0; i < 100; i += 10)
+  {
+    // duplicate timestamps
+    validatedFrame.SetTimestamp(i);
+    frameList->AddTrackedFrame(&validatedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME);
+  }
+  if (frameList->GetNumberOfTrackedFrames() != 100)
+  {
+    LOG_ERROR("Frames with duplicate timestamps were added to the tracked frame list (number of frames: " << frameList->GetNumberOfTrackedFrames() << ", expected: 100)");
+    exit(EXIT_FAILURE);
+  }
+  validatedFrame.SetTimestamp(200);
+  validatedFrame.SetCustomFrameTransformStatus(PlusTransformName("Reference", "Tracker"), FIELD_INVALID);
+  frameList->AddTrackedFrame(&validatedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME);
+  if (frameList->GetNumberOfTrackedFrames() != 100)
+  {
+    LOG_ERROR("Frame with invalid computed validation transform was added to the tracked frame list");
+    exit(EXIT_FAILURE);
+  }
+  validatedFrame.SetCustomFrameTransformStatus(PlusTransformName("Reference", "Tracker"), FIELD_OK);
+  frameList->RemoveTrackedFrame(50);
+  validatedFrame.SetTimestamp(50);
+  frameList->AddTrackedFrame(&validatedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME);
+  if (frameList->GetNumberOfTrackedFrames() != 100)
+  {
+    LOG_ERROR("Frame with the timestamp of a removed frame was not added to the tracked frame list");
+    exit(EXIT_FAILURE);
+  }
+  // ProbeToTracker status is read directly from the frames
+  frameList->SetFrameTransformNameForValidation(PlusTransformName("Probe", "Tracker"));
+  validatedFrame.SetTimestamp(300);
+  validatedFrame.SetCustomFrameTransformStatus(PlusTransformName("Probe", "Tracker"), FIELD_INVALID);
+  frameList->AddTrackedFrame(&validatedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME);
+  if (frameList->GetNumberOfTrackedFrames() != 100)
+  {
+    LOG_ERROR("Frame with invalid validation transform was added to the tracked frame list");
+    exit(EXIT_FAILURE);
+  }
+
   LOG_INFO("Test recursive critical section");
   vtkPlusRecursiveCriticalSection* critSec = vtkPlusRecursiveCriticalSection::New();
   LOG_INFO(" Lock");
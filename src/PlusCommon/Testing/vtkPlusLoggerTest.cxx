@@ -8,6 +8,8 @@
 
 #include "vtksys/CommandLineArguments.hxx"
 #include "vtkSmartPointer.h"
+#include <fstream>
+#include <vector>
 
 class vtkLogTestObject : public vtkObject
 {
@@ -74,5 +76,58 @@ int main(int argc, char **argv)
   logTester->DebugOn();
   logTester->LogMessages();
 
+  // Test asynchronous logging
+  vtkPlusLogger::Instance()->SetAsynchronousLogging(true);
+  if (!vtkPlusLogger::Instance()->GetAsynchronousLogging())
+  {
+    std::cerr << "Failed to enable asynchronous logging" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const int numberOfAsynchronousMessages = 1000;
+  for (int i = 0; i < numberOfAsynchronousMessages; i++)
+  {
+    LOG_INFO("This is asynchronous test message #" << i << "#");
+  }
+  vtkPlusLogger::Instance()->SetAsynchronousLogging(false);
+
+  unsigned long numberOfDroppedMessages = vtkPlusLogger::Instance()->GetNumberOfDroppedMessages();
+  if (numberOfDroppedMessages != 0)
+  {
+    std::cerr << "Number of dropped asynchronous log messages: " << numberOfDroppedMessages << " (expected 0)" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // All the asynchronous messages must have been written to the log file when asynchronous logging is disabled
+  std::vector<int> messageCount(numberOfAsynchronousMessages, 0);
+  std::ifstream logFile(vtkPlusLogger::Instance()->GetLogFileName().c_str());
+  if (!logFile.is_open())
+  {
+    std::cerr << "Failed to open log file: " << vtkPlusLogger::Instance()->GetLogFileName() << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string messagePrefix = "This is asynchronous test message #";
+  std::string line;
+  while (std::getline(logFile, line))
+  {
+    size_t prefixPos = line.find(messagePrefix);
+    if (prefixPos == std::string::npos)
+    {
+      continue;
+    }
+    int messageIndex = atoi(line.c_str() + prefixPos + messagePrefix.size());
+    if (messageIndex >= 0 && messageIndex < numberOfAsynchronousMessages)
+    {
+      messageCount[messageIndex]++;
+    }
+  }
+  for (int i = 0; i < numberOfAsynchronousMessages; i++)
+  {
+    if (messageCount[i] != 1)
+    {
+      std::cerr << "Asynchronous test message #" << i << "# is found " << messageCount[i] << " times in the log file (expected 1)" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
   return EXIT_SUCCESS; 
  }
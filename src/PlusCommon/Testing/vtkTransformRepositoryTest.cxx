@@ -365,6 +365,14 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  /////////////////////////////////////////////////////////////////////////////
+  // Check that compiled transform paths are not reused after delete
+  if (transformRepository->GetTransformValid(PlusTransformName("Probe", "Stylus"), isValid)==PLUS_SUCCESS)
+  {
+    LOG_ERROR("ProbeToStylus should not be available after deleting ProbeToTracker");
+    return EXIT_FAILURE;
+  }
+
   /////////////////////////////////////////////////////////////////////////////
   // Check circle detection - after delete
   if (transformRepository->SetTransform(PlusTransformName("Probe", "Phantom"), mxProbeToPhantom)!=PLUS_SUCCESS)
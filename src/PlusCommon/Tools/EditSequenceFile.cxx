@@ -8,6 +8,8 @@ See License.txt for details.
 #include "PlusConfigure.h"
 #include "PlusMath.h"
 #include "PlusTrackedFrame.h"
+#include "vtkPlusMetaImageSequenceIO.h"
+#include "vtkPlusNrrdSequenceIO.h"
 #include "vtkPlusSequenceIO.h"
 #include "vtkPlusTrackedFrameList.h"
 #include "vtkPlusTransformRepository.h"
@@ -21,6 +23,7 @@ See License.txt for details.
 #include <vtkXMLUtilities.h>
 #include <vtksys/CommandLineArguments.hxx>
 #include <vtksys/RegularExpression.hxx>
+#include <vtksys/SystemTools.hxx>
 
 enum OperationType
 {
@@ -51,6 +54,7 @@ public:
     FrameScalarDecimalDigits = 5;
     FrameTransformStart = NULL;
     FrameTransformIncrement = NULL;
+    NextFrameScalar = 0;
   }
 
   std::string               FieldName;
@@ -63,21 +67,94 @@ public:
   vtkMatrix4x4*             FrameTransformStart;
   vtkMatrix4x4*             FrameTransformIncrement;
   std::string               FrameTransformIndexFieldName;
+
+  // Values of the next frame, kept between chunks of frames
+  double                          NextFrameScalar;
+  vtkSmartPointer<vtkTransform>   NextFrameTransform;
 };
 
-PlusStatus TrimSequenceFile(vtkPlusTrackedFrameList* trackedFrameList, unsigned int firstFrameIndex, unsigned int lastFrameIndex);
-PlusStatus DecimateSequenceFile(vtkPlusTrackedFrameList* trackedFrameList, unsigned int decimationFactor);
+/*! Editing operation that is applied on each chunk of frames */
+class FrameEdit
+{
+public:
+  FrameEdit()
+  {
+    Operation = NO_OPERATION;
+    FillGrayLevel = 0;
+    UpdateReferenceTransform = false;
+  }
+
+  OperationType                       Operation;
+  FrameFieldUpdate                    FieldUpdate;
+  std::string                         FieldName;
+  std::vector<std::string>            TransformNamesToAdd;
+  vtkSmartPointer<vtkXMLDataElement>  DeviceSetConfiguration;
+  std::vector<unsigned int>           FillRectOrigin;
+  std::vector<unsigned int>           FillRectSize;
+  int                                 FillGrayLevel;
+  PlusVideoFrame::FlipInfoType        FlipInfo;
+  std::vector<int>                    CropRectOrigin;
+  std::vector<int>                    CropRectSize;
+  bool                                UpdateReferenceTransform;
+  PlusTransformName                   ReferenceTransformName;
+};
+
+/*! Input sequence file. Frames are read one by one if the file format allows it, otherwise the whole file is read at once. */
+class InputSequence
+{
+public:
+  InputSequence()
+  {
+    FrameByFrame = false;
+    ContainsImageData = false;
+    NumberOfFrames = 0;
+  }
+
+  std::string                             FileName;
+  vtkSmartPointer<vtkPlusSequenceIOBase>  Reader;
+  bool                                    FrameByFrame;
+  bool                                    ContainsImageData;
+  unsigned int                            NumberOfFrames;
+};
+
+/*! Output sequence file, written in chunks of frames */
+class OutputSequence
+{
+public:
+  OutputSequence()
+  {
+    NumberOfFramesWritten = 0;
+    HeaderPrepared = false;
+    IsData3D = false;
+    PixelDataPassThrough = false;
+  }
+
+  vtkSmartPointer<vtkPlusSequenceIOBase>    Writer;
+  vtkSmartPointer<vtkPlusTrackedFrameList>  Frames; // frames that have not been written yet
+  unsigned int                              NumberOfFramesWritten;
+  bool                                      HeaderPrepared;
+  bool                                      IsData3D;
+  bool                                      PixelDataPassThrough; // pixel data is copied from the input file, frames contain only the frame fields
+};
+
+PlusStatus OpenInputSequence(const std::string& fileName, InputSequence& input);
+PlusStatus ReadInputFrame(InputSequence& input, unsigned int frameIndex, bool readPixelData, vtkPlusTrackedFrameList* outputFrameList);
+PlusStatus EditFrames(vtkPlusTrackedFrameList* trackedFrameList, FrameEdit& frameEdit);
+PlusStatus WriteFrames(OutputSequence& output);
+PlusStatus CloseOutputSequence(OutputSequence& output);
 PlusStatus UpdateFrameFieldValue(FrameFieldUpdate& fieldUpdate);
 PlusStatus DeleteFrameField(vtkPlusTrackedFrameList* trackedFrameList, std::string fieldName);
 PlusStatus ConvertStringToMatrix(std::string& strMatrix, vtkMatrix4x4* matrix);
-PlusStatus AddTransform(vtkPlusTrackedFrameList* trackedFrameList, std::vector<std::string> transformNamesToAdd, std::string deviceSetConfigurationFileName);
+PlusStatus AddTransform(vtkPlusTrackedFrameList* trackedFrameList, std::vector<std::string> transformNamesToAdd, vtkXMLDataElement* deviceSetConfiguration);
 PlusStatus FillRectangle(vtkPlusTrackedFrameList* trackedFrameList, const std::vector<unsigned int>& fillRectOrigin, const std::vector<unsigned int>& fillRectSize, int fillGrayLevel);
 PlusStatus CropRectangle(vtkPlusTrackedFrameList* trackedFrameList, PlusVideoFrame::FlipInfoType& flipInfo, const std::vector<int>& cropRectOrigin, const std::vector<int>& cropRectSize);
+PlusStatus UpdateReferenceTransform(vtkPlusTrackedFrameList* trackedFrameList, const PlusTransformName& referenceTransformName);
 
 namespace
 {
   const std::string FIELD_VALUE_FRAME_SCALAR = "{frame-scalar}";
   const std::string FIELD_VALUE_FRAME_TRANSFORM = "{frame-transform}";
+  const char* FIELD_NAME_IMAGE_STATUS = "ImageStatus";
 }
 
 int main(int argc, char** argv)
@@ -93,7 +170,9 @@ int main(int argc, char** argv)
   std::string                     strOperation;
   OperationType                   operation;
   bool                            useCompression = false;
+  bool                            parallelCompression = false;
   bool                            incrementTimestamps = false;
+  int                             chunkSize = 100; // Number of frames that are read, edited, and written at once
 
   int                             firstFrameIndex = -1; // First frame index used for trimming the sequence file.
   int                             lastFrameIndex = -1; // Last frame index used for trimming the sequence file.
@@ -162,7 +241,9 @@ int main(int argc, char** argv)
   args.AddArgument("--update-reference-transform", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &strUpdatedReferenceTransformName, "Set the reference transform name to update old files by changing all ToolToReference transforms to ToolToTracker transform.");
 
   args.AddArgument("--use-compression", vtksys::CommandLineArguments::NO_ARGUMENT, &useCompression, "Compress sequence file images.");
+  args.AddArgument("--parallel-compression", vtksys::CommandLineArguments::NO_ARGUMENT, &parallelCompression, "Compress blocks of frames in parallel (only used if --use-compression is specified). The output is a valid compressed stream but differs byte-wise from the sequentially compressed output.");
   args.AddArgument("--increment-timestamps", vtksys::CommandLineArguments::NO_ARGUMENT, &incrementTimestamps, "Increment timestamps in the order of the input-file-names");
+  args.AddArgument("--chunk-size", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &chunkSize, "Number of frames that are read, edited, and written at once. 0 means all frames are processed at once. (Default: 100)");
 
   args.AddArgument("--add-transform", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &transformNamesToAdd, "Name of the transform to add to each frame (e.g., StylusTipToTracker); multiple transforms can be added separated by a comma (e.g., StylusTipToReference,ProbeToReference)");
   args.AddArgument("--config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &deviceSetConfigurationFileName, "Used device set configuration file path and name");
@@ -218,6 +299,9 @@ int main(int argc, char** argv)
 
     std::cout << "- REMOVE_IMAGE_DATA: Remove image data from a meta file that has both image and tracker data, and keep only the tracker data." << std::endl;
 
+    std::cout << std::endl << "Frames are read, edited, and written in chunks (see --chunk-size), so sequences larger than the available memory can be edited." << std::endl;
+    std::cout << "If only the fields of a MetaImage sequence are changed and the compression is not changed then the pixel data is copied without decoding." << std::endl;
+
     return EXIT_SUCCESS;
   }
 
@@ -236,6 +320,12 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
+  if (chunkSize < 0)
+  {
+    LOG_ERROR("Invalid chunk size: " << chunkSize << ". It must be a positive integer, or 0 for processing all frames at once.");
+    return EXIT_FAILURE;
+  }
+
   // Set operation
   if (strOperation.empty())
   {
@@ -320,10 +410,7 @@ int main(int argc, char** argv)
   }
 
   ///////////////////////////////////////////////////////////////////
-  // Read input files
-
-  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
-  vtkSmartPointer<vtkPlusTrackedFrameList> timestampFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  // Open input files, only the headers are read here
 
   if (!inputFileName.empty())
   {
@@ -331,48 +418,32 @@ int main(int argc, char** argv)
     inputFileNames.insert(inputFileNames.begin(), inputFileName);
   }
 
-  double lastTimestamp = 0;
+  std::vector<InputSequence> inputs(inputFileNames.size());
+  unsigned int totalNumberOfFrames = 0;
   for (unsigned int i = 0; i < inputFileNames.size(); i++)
   {
     LOG_INFO("Read input sequence file: " << inputFileNames[i]);
-
-    if (vtkPlusSequenceIO::Read(inputFileNames[i], timestampFrameList) != PLUS_SUCCESS)
+    if (OpenInputSequence(inputFileNames[i], inputs[i]) != PLUS_SUCCESS)
     {
-      LOG_ERROR("Couldn't read sequence file: " <<  inputFileName);
+      LOG_ERROR("Couldn't read sequence file: " << inputFileNames[i]);
       return EXIT_FAILURE;
     }
-
-    if (incrementTimestamps)
-    {
-      vtkPlusTrackedFrameList* tfList = timestampFrameList;
-      for (unsigned int f = 0; f < tfList->GetNumberOfTrackedFrames(); ++f)
-      {
-        PlusTrackedFrame* tf = tfList->GetTrackedFrame(f);
-        tf->SetTimestamp(lastTimestamp + tf->GetTimestamp());
-      }
-
-      lastTimestamp = tfList->GetTrackedFrame(tfList->GetNumberOfTrackedFrames() - 1)->GetTimestamp();
-    }
-
-    if (trackedFrameList->AddTrackedFrameList(timestampFrameList) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Failed to append tracked frame list!");
-      return EXIT_SUCCESS;
-    }
+    totalNumberOfFrames += inputs[i].NumberOfFrames;
   }
 
-
   ///////////////////////////////////////////////////////////////////
-  // Make the operation
+  // Set up the operation
+
+  // Frames of the merged input sequences that are kept: every frameIndexStep-th frame between the first and last index
+  unsigned int firstSelectedFrameIndex = 0;
+  unsigned int lastSelectedFrameIndex = (totalNumberOfFrames > 0 ? totalNumberOfFrames - 1 : 0);
+  unsigned int frameIndexStep = 1;
+
+  FrameEdit frameEdit;
+  frameEdit.Operation = operation;
 
   switch (operation)
   {
-  case NO_OPERATION:
-  case MERGE:
-  {
-    // No need to do anything just save into output file
-  }
-  break;
   case TRIM:
   {
     if (firstFrameIndex < 0)
@@ -383,10 +454,12 @@ int main(int argc, char** argv)
     {
       lastFrameIndex = 0;
     }
-    unsigned int firstFrameIndexUint = static_cast<unsigned int>(firstFrameIndex);
-    unsigned int lastFrameIndexUint = static_cast<unsigned int>(lastFrameIndex);
-    if (TrimSequenceFile(trackedFrameList, firstFrameIndexUint, lastFrameIndexUint) != PLUS_SUCCESS)
+    firstSelectedFrameIndex = static_cast<unsigned int>(firstFrameIndex);
+    lastSelectedFrameIndex = static_cast<unsigned int>(lastFrameIndex);
+    LOG_INFO("Trim sequence file from frame #: " << firstSelectedFrameIndex << " to frame #" << lastSelectedFrameIndex);
+    if (lastSelectedFrameIndex >= totalNumberOfFrames || firstSelectedFrameIndex > lastSelectedFrameIndex)
     {
+      LOG_ERROR("Invalid input range: (" << firstSelectedFrameIndex << ", " << lastSelectedFrameIndex << ")" << " Permitted range within (0, " << totalNumberOfFrames - 1 << ")");
       LOG_ERROR("Failed to trim sequence file");
       return EXIT_FAILURE;
     }
@@ -394,62 +467,186 @@ int main(int argc, char** argv)
   break;
   case DECIMATE:
   {
-    if (DecimateSequenceFile(trackedFrameList, decimationFactor) != PLUS_SUCCESS)
+    LOG_INFO("Decimate sequence file: keep 1 frame out of every " << decimationFactor << " frames");
+    if (decimationFactor < 2)
     {
+      LOG_ERROR("Invalid decimation factor: " << decimationFactor << ". It must be an integer larger or equal than 2.");
       LOG_ERROR("Failed to decimate sequence file");
       return EXIT_FAILURE;
     }
+    frameIndexStep = static_cast<unsigned int>(decimationFactor);
   }
   break;
   case UPDATE_FRAME_FIELD_NAME:
+  case UPDATE_FRAME_FIELD_VALUE:
   {
-    FrameFieldUpdate fieldUpdate;
-    fieldUpdate.TrackedFrameList = trackedFrameList;
+    LOG_INFO("Update frame field");
+    FrameFieldUpdate& fieldUpdate = frameEdit.FieldUpdate;
     fieldUpdate.FieldName = fieldName;
     fieldUpdate.UpdatedFieldName = updatedFieldName;
+    if (operation == UPDATE_FRAME_FIELD_VALUE)
+    {
+      fieldUpdate.UpdatedFieldValue = updatedFieldValue;
+      fieldUpdate.FrameScalarDecimalDigits = frameScalarDecimalDigits;
+      fieldUpdate.FrameScalarIncrement = frameScalarIncrement;
+      fieldUpdate.FrameScalarStart = frameScalarStart;
+      fieldUpdate.FrameTransformStart = frameTransformStart;
+      fieldUpdate.FrameTransformIncrement = frameTransformIncrement;
+      fieldUpdate.FrameTransformIndexFieldName = strFrameTransformIndexFieldName;
+    }
 
-    if (UpdateFrameFieldValue(fieldUpdate) != PLUS_SUCCESS)
+    // Set the start scalar value and transform matrix
+    fieldUpdate.NextFrameScalar = fieldUpdate.FrameScalarStart;
+    fieldUpdate.NextFrameTransform = vtkSmartPointer<vtkTransform>::New();
+    if (fieldUpdate.FrameTransformStart != NULL)
     {
-      LOG_ERROR("Failed to update frame field name '" << fieldName << "' to '" << updatedFieldName << "'");
+      fieldUpdate.NextFrameTransform->SetMatrix(fieldUpdate.FrameTransformStart);
+    }
+  }
+  break;
+  case DELETE_FRAME_FIELD:
+  {
+    if (fieldName.empty())
+    {
+      LOG_ERROR("Field name is empty!");
+      LOG_ERROR("Failed to delete frame field");
       return EXIT_FAILURE;
     }
+    LOG_INFO("Delete frame field: " << fieldName);
+    frameEdit.FieldName = fieldName;
   }
   break;
-  case UPDATE_FRAME_FIELD_VALUE:
+  case ADD_TRANSFORM:
   {
-    FrameFieldUpdate fieldUpdate;
-    fieldUpdate.TrackedFrameList = trackedFrameList;
-    fieldUpdate.FieldName = fieldName;
-    fieldUpdate.UpdatedFieldName = updatedFieldName;
-    fieldUpdate.UpdatedFieldValue = updatedFieldValue;
-    fieldUpdate.FrameScalarDecimalDigits = frameScalarDecimalDigits;
-    fieldUpdate.FrameScalarIncrement = frameScalarIncrement;
-    fieldUpdate.FrameScalarStart = frameScalarStart;
-    fieldUpdate.FrameTransformStart = frameTransformStart;
-    fieldUpdate.FrameTransformIncrement = frameTransformIncrement;
-    fieldUpdate.FrameTransformIndexFieldName = strFrameTransformIndexFieldName;
-
-    if (UpdateFrameFieldValue(fieldUpdate) != PLUS_SUCCESS)
+    LOG_INFO("Add transform '" << transformNamesToAdd << "' using device set configuration file '" << deviceSetConfigurationFileName << "'");
+    PlusCommon::SplitStringIntoTokens(transformNamesToAdd, ',', frameEdit.TransformNamesToAdd);
+    if (frameEdit.TransformNamesToAdd.empty())
+    {
+      LOG_ERROR("No transform names are specified to be added");
+      return EXIT_FAILURE;
+    }
+    if (deviceSetConfigurationFileName.empty())
+    {
+      LOG_ERROR("Used device set configuration file name is empty");
+      return EXIT_FAILURE;
+    }
+    frameEdit.DeviceSetConfiguration = vtkSmartPointer<vtkXMLDataElement>::New();
+    if (PlusXmlUtils::ReadDeviceSetConfigurationFromFile(frameEdit.DeviceSetConfiguration, deviceSetConfigurationFileName.c_str()) == PLUS_FAIL)
     {
-      LOG_ERROR("Failed to update frame field value");
+      LOG_ERROR("Unable to read configuration from file " << deviceSetConfigurationFileName.c_str());
       return EXIT_FAILURE;
     }
   }
   break;
-  case DELETE_FRAME_FIELD:
+  case FILL_IMAGE_RECTANGLE:
   {
-    if (DeleteFrameField(trackedFrameList, fieldName) != PLUS_SUCCESS)
+    if (rectOriginPix.size() != 2 || rectSizePix.size() != 2)
     {
-      LOG_ERROR("Failed to delete frame field");
+      LOG_ERROR("Incorrect size of vector for rectangle origin or size. Aborting.");
+      return EXIT_FAILURE;
+    }
+    if (rectOriginPix[0] < 0 || rectOriginPix[1] < 0 || rectSizePix[0] < 0 || rectSizePix[1] < 0)
+    {
+      LOG_ERROR("Negative value for rectangle origin or size entered. Aborting.");
       return EXIT_FAILURE;
     }
+    frameEdit.FillRectOrigin.assign(rectOriginPix.begin(), rectOriginPix.end());
+    frameEdit.FillRectSize.assign(rectSizePix.begin(), rectSizePix.end());
+    frameEdit.FillGrayLevel = fillGrayLevel;
+  }
+  break;
+  case CROP:
+  {
+    frameEdit.FlipInfo.hFlip = flipX;
+    frameEdit.FlipInfo.vFlip = flipY;
+    frameEdit.FlipInfo.eFlip = flipZ;
+    frameEdit.CropRectOrigin = rectOriginPix;
+    frameEdit.CropRectSize = rectSizePix;
   }
   break;
+  default:
+    // Other operations are applied on the whole sequence or when writing the output
+    break;
+  }
+
+  if (!strUpdatedReferenceTransformName.empty())
+  {
+    if (frameEdit.ReferenceTransformName.SetTransformName(strUpdatedReferenceTransformName.c_str()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Reference transform name is invalid: " << strUpdatedReferenceTransformName);
+      return EXIT_FAILURE;
+    }
+    frameEdit.UpdateReferenceTransform = true;
+  }
+
+  unsigned int numberOfSelectedFrames = 0;
+  if (totalNumberOfFrames > 0)
+  {
+    numberOfSelectedFrames = (lastSelectedFrameIndex - firstSelectedFrameIndex) / frameIndexStep + 1;
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Set up the output file
+
+  OutputSequence output;
+  output.Writer.TakeReference(vtkPlusSequenceIO::CreateSequenceHandlerForFile(outputFileName));
+  if (output.Writer == NULL)
+  {
+    LOG_ERROR("Couldn't write sequence file: " << outputFileName);
+    return EXIT_FAILURE;
+  }
+
+  // If only the fields are changed then the pixel data does not have to be decoded and encoded again
+  vtkPlusMetaImageSequenceIO* pixelDataSource = NULL;
+  if (inputs.size() == 1 && inputs[0].FrameByFrame && inputs[0].ContainsImageData
+      && inputs[0].NumberOfFrames == inputs[0].Reader->GetDimensions()[3]
+      && inputs[0].Reader->GetUseCompression() == useCompression
+      && vtkPlusMetaImageSequenceIO::SafeDownCast(output.Writer) != NULL)
+  {
+    switch (operation)
+    {
+    case NO_OPERATION:
+    case MERGE:
+    case UPDATE_FRAME_FIELD_NAME:
+    case UPDATE_FRAME_FIELD_VALUE:
+    case DELETE_FRAME_FIELD:
+    case UPDATE_FIELD_NAME:
+    case UPDATE_FIELD_VALUE:
+    case DELETE_FIELD:
+    case ADD_TRANSFORM:
+      pixelDataSource = vtkPlusMetaImageSequenceIO::SafeDownCast(inputs[0].Reader);
+      break;
+    default:
+      break;
+    }
+  }
+
+  output.Frames = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  output.Writer->SetUseCompression(useCompression);
+  output.Writer->SetParallelCompression(parallelCompression);
+  output.Writer->SetFileName(outputFileName);
+  output.Writer->SetTrackedFrameList(output.Frames);
+  output.Writer->SetEnableImageDataWrite(operation != REMOVE_IMAGE_DATA);
+  if (numberOfSelectedFrames == 1)
+  {
+    output.Writer->IsDataTimeSeriesOff();
+  }
+  if (pixelDataSource != NULL)
+  {
+    LOG_INFO("Pixel data is copied from " << inputs[0].FileName << " without decoding");
+    vtkPlusMetaImageSequenceIO::SafeDownCast(output.Writer)->SetPixelDataSource(pixelDataSource);
+    output.PixelDataPassThrough = true;
+  }
+
+  // Operations on the fields of the whole sequence
+  vtkPlusTrackedFrameList* outputFrameList = output.Frames;
+  switch (operation)
+  {
   case DELETE_FIELD:
   {
     // Delete field
     LOG_INFO("Delete field: " << fieldName);
-    if (trackedFrameList->SetCustomString(fieldName.c_str(), NULL) != PLUS_SUCCESS)
+    if (outputFrameList->SetCustomString(fieldName.c_str(), NULL) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to delete field: " << fieldName);
       return EXIT_FAILURE;
@@ -460,20 +657,21 @@ int main(int argc, char** argv)
   {
     // Update field name
     LOG_INFO("Update field name '" << fieldName << "' to  '" << updatedFieldName << "'");
-    const char* fieldValue = trackedFrameList->GetCustomString(fieldName.c_str());
+    const char* fieldValue = outputFrameList->GetCustomString(fieldName.c_str());
     if (fieldValue != NULL)
     {
+      std::string copyOfFieldValue(fieldValue);
       // Delete field
-      if (trackedFrameList->SetCustomString(fieldName.c_str(), NULL) != PLUS_SUCCESS)
+      if (outputFrameList->SetCustomString(fieldName.c_str(), NULL) != PLUS_SUCCESS)
       {
         LOG_ERROR("Failed to delete field: " << fieldName);
         return EXIT_FAILURE;
       }
 
       // Add new field
-      if (trackedFrameList->SetCustomString(updatedFieldName.c_str(), fieldValue) != PLUS_SUCCESS)
+      if (outputFrameList->SetCustomString(updatedFieldName.c_str(), copyOfFieldValue.c_str()) != PLUS_SUCCESS)
       {
-        LOG_ERROR("Failed to update field '" << updatedFieldName << "' with value '" << fieldValue << "'");
+        LOG_ERROR("Failed to update field '" << updatedFieldName << "' with value '" << copyOfFieldValue << "'");
         return EXIT_FAILURE;
       }
     }
@@ -483,230 +681,381 @@ int main(int argc, char** argv)
   {
     // Update field value
     LOG_INFO("Update field '" << fieldName << "' with value '" << updatedFieldValue << "'");
-    if (trackedFrameList->SetCustomString(fieldName.c_str(), updatedFieldValue.c_str()) != PLUS_SUCCESS)
+    if (outputFrameList->SetCustomString(fieldName.c_str(), updatedFieldValue.c_str()) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to update field '" << fieldName << "' with value '" << updatedFieldValue << "'");
       return EXIT_FAILURE;
     }
   }
   break;
-  case ADD_TRANSFORM:
+  default:
+    break;
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Read, edit, and write the frames in chunks
+
+  // The frame size and pixel type of the output is determined from the first written chunk, therefore
+  // the first chunk is written only when it contains a valid image (if there is any image data)
+  bool inputContainsImageData = false;
+  for (unsigned int i = 0; i < inputs.size(); i++)
   {
-    // Add transform
-    LOG_INFO("Add transform '" << transformNamesToAdd << "' using device set configuration file '" << deviceSetConfigurationFileName << "'");
-    std::vector<std::string> transformNamesList;
-    PlusCommon::SplitStringIntoTokens(transformNamesToAdd, ',', transformNamesList);
-    if (AddTransform(trackedFrameList, transformNamesList, deviceSetConfigurationFileName) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Failed to add transform '" << transformNamesToAdd << "' using device set configuration file '" << deviceSetConfigurationFileName << "'");
-      return EXIT_FAILURE;
-    }
+    inputContainsImageData |= inputs[i].ContainsImageData;
   }
-  break;
-  case FILL_IMAGE_RECTANGLE:
+  bool pendingFramesContainValidImage = false;
+
+  LOG_INFO("Save output sequence file to: " << outputFileName);
+  unsigned int mergedFrameIndex = 0;
+  double timestampOffset = 0;
+  for (unsigned int i = 0; i < inputs.size(); i++)
   {
-    if (rectOriginPix.size() != 2 || rectSizePix.size() != 2)
+    InputSequence& input = inputs[i];
+    if (!input.FrameByFrame)
     {
-      LOG_ERROR("Incorrect size of vector for rectangle origin or size. Aborting.");
-      return PLUS_FAIL;
+      // Individual frames cannot be read from this file, read all the frames now
+      if (input.Reader->Read() != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Couldn't read sequence file: " << input.FileName);
+        return EXIT_FAILURE;
+      }
+      input.NumberOfFrames = input.Reader->GetTrackedFrameList()->GetNumberOfTrackedFrames();
     }
-    if (rectOriginPix[0] < 0 || rectOriginPix[1] < 0 || rectSizePix[0] < 0 || rectSizePix[1] < 0)
+
+    for (unsigned int frameIndex = 0; frameIndex < input.NumberOfFrames; frameIndex++, mergedFrameIndex++)
     {
-      LOG_ERROR("Negative value for rectangle origin or size entered. Aborting.");
-      return PLUS_FAIL;
+      if (mergedFrameIndex < firstSelectedFrameIndex || mergedFrameIndex > lastSelectedFrameIndex
+          || (mergedFrameIndex - firstSelectedFrameIndex) % frameIndexStep != 0)
+      {
+        continue;
+      }
+
+      if (ReadInputFrame(input, frameIndex, !output.PixelDataPassThrough, output.Frames) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Couldn't read sequence file: " << input.FileName);
+        return EXIT_FAILURE;
+      }
+      PlusTrackedFrame* trackedFrame = output.Frames->GetTrackedFrame(output.Frames->GetNumberOfTrackedFrames() - 1);
+      if (incrementTimestamps)
+      {
+        trackedFrame->SetTimestamp(timestampOffset + trackedFrame->GetTimestamp());
+      }
+      pendingFramesContainValidImage |= trackedFrame->GetImageData()->IsImageValid();
+
+      if (chunkSize > 0 && output.Frames->GetNumberOfTrackedFrames() >= static_cast<unsigned int>(chunkSize)
+          && (output.HeaderPrepared || output.PixelDataPassThrough || !inputContainsImageData || pendingFramesContainValidImage))
+      {
+        if (EditFrames(output.Frames, frameEdit) != PLUS_SUCCESS || WriteFrames(output) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Couldn't write sequence file: " << outputFileName);
+          return EXIT_FAILURE;
+        }
+        pendingFramesContainValidImage = false;
+      }
     }
-    std::vector<unsigned int> rectOriginPixUint(rectOriginPix.begin(), rectOriginPix.end());
-    std::vector<unsigned int> rectSizePixUint(rectSizePix.begin(), rectSizePix.end());
-    // Fill a rectangular region in the image with a solid color
-    if (FillRectangle(trackedFrameList, rectOriginPixUint, rectSizePixUint, fillGrayLevel) != PLUS_SUCCESS)
+
+    if (incrementTimestamps && input.NumberOfFrames > 0)
     {
-      LOG_ERROR("Failed to fill rectangle");
-      return EXIT_FAILURE;
+      // Timestamps of the next file continue from the last timestamp of this file
+      vtkPlusTrackedFrameList* inputFrameList = input.Reader->GetTrackedFrameList();
+      if (input.NumberOfFrames <= inputFrameList->GetNumberOfTrackedFrames())
+      {
+        timestampOffset += inputFrameList->GetTrackedFrame(input.NumberOfFrames - 1)->GetTimestamp();
+      }
     }
-  }
-  break;
-  case CROP:
-  {
-    // Crop a rectangular region from the image
-    PlusVideoFrame::FlipInfoType flipInfo;
-    flipInfo.hFlip = flipX;
-    flipInfo.vFlip = flipY;
-    flipInfo.eFlip = flipZ;
-    if (CropRectangle(trackedFrameList, flipInfo, rectOriginPix, rectSizePix) != PLUS_SUCCESS)
+
+    if (!input.FrameByFrame)
     {
-      LOG_ERROR("Failed to fill rectangle");
-      return EXIT_FAILURE;
+      // Free the memory of the frames that are already written
+      input.Reader->GetTrackedFrameList()->Clear();
     }
   }
-  break;
-  case REMOVE_IMAGE_DATA:
-    // No processing is needed, image data is removed when writing the output
-    break;
-  default:
+
+  if (EditFrames(output.Frames, frameEdit) != PLUS_SUCCESS || WriteFrames(output) != PLUS_SUCCESS)
   {
-    LOG_WARNING("Unknown operation is specified");
+    LOG_ERROR("Couldn't write sequence file: " << outputFileName);
     return EXIT_FAILURE;
   }
-  }
 
+  // All frames are read, close the input files before replacing the output file
+  inputs.clear();
 
-  //////////////////////////////////////////////////////////////////
-  // Convert files to the new file format
+  if (vtksys::SystemTools::FileExists(outputFileName.c_str()))
+  {
+    // Remove the file before replacing it
+    vtksys::SystemTools::RemoveFile(outputFileName.c_str());
+  }
+  if (CloseOutputSequence(output) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't write sequence file: " << outputFileName);
+    return EXIT_FAILURE;
+  }
 
-  if (!strUpdatedReferenceTransformName.empty())
+  LOG_INFO("Sequence file editing was successful!");
+  return EXIT_SUCCESS;
+}
+
+//-------------------------------------------------------
+PlusStatus OpenInputSequence(const std::string& fileName, InputSequence& input)
+{
+  if (!vtksys::SystemTools::FileExists(fileName.c_str()))
   {
-    PlusTransformName referenceTransformName;
-    if (referenceTransformName.SetTransformName(strUpdatedReferenceTransformName.c_str()) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Reference transform name is invalid: " << strUpdatedReferenceTransformName);
-      return EXIT_FAILURE;
-    }
+    LOG_ERROR("File: " << fileName << " does not exist.");
+    return PLUS_FAIL;
+  }
 
-    for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
-    {
-      PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(i);
+  input.FileName = fileName;
+  if (vtkPlusMetaImageSequenceIO::CanReadFile(fileName))
+  {
+    input.Reader = vtkSmartPointer<vtkPlusMetaImageSequenceIO>::New();
+  }
+  else if (vtkPlusNrrdSequenceIO::CanReadFile(fileName))
+  {
+    input.Reader = vtkSmartPointer<vtkPlusNrrdSequenceIO>::New();
+  }
+  else
+  {
+    LOG_ERROR("No reader for file: " << fileName);
+    return PLUS_FAIL;
+  }
 
-      vtkSmartPointer<vtkMatrix4x4> referenceToTrackerMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-      if (trackedFrame->GetCustomFrameTransform(referenceTransformName, referenceToTrackerMatrix) != PLUS_SUCCESS)
-      {
-        LOG_WARNING("Couldn't get reference transform with name: " << strUpdatedReferenceTransformName);
-        continue;
-      }
+  input.Reader->SetFileName(fileName);
+  if (input.Reader->ReadHeader() != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
 
-      std::vector<PlusTransformName> transformNameList;
-      trackedFrame->GetCustomFrameTransformNameList(transformNameList);
+  unsigned int* dimensions = input.Reader->GetDimensions();
+  input.ContainsImageData = (dimensions[0] > 0 && dimensions[1] > 0 && dimensions[2] > 0);
+  input.FrameByFrame = input.Reader->CanReadFramePixels();
+  input.NumberOfFrames = input.Reader->GetTrackedFrameList()->GetNumberOfTrackedFrames();
+  if (input.ContainsImageData && dimensions[3] > input.NumberOfFrames)
+  {
+    // Frames that have pixel data but no fields in the header
+    input.NumberOfFrames = dimensions[3];
+  }
 
-      vtkSmartPointer<vtkTransform> toolToTrackerTransform = vtkSmartPointer<vtkTransform>::New();
-      vtkSmartPointer<vtkMatrix4x4> toolToReferenceMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-      for (unsigned int n = 0; n < transformNameList.size(); ++n)
-      {
-        // No need to change the reference transform
-        if (transformNameList[n] == referenceTransformName)
-        {
-          continue;
-        }
+  return PLUS_SUCCESS;
+}
 
-        TrackedFrameFieldStatus status = FIELD_INVALID;
-        if (trackedFrame->GetCustomFrameTransform(transformNameList[n], toolToReferenceMatrix) != PLUS_SUCCESS)
-        {
-          std::string strTransformName;
-          transformNameList[i].GetTransformName(strTransformName);
-          LOG_ERROR("Failed to get custom frame transform: " << strTransformName);
-          continue;
-        }
+//-------------------------------------------------------
+PlusStatus ReadInputFrame(InputSequence& input, unsigned int frameIndex, bool readPixelData, vtkPlusTrackedFrameList* outputFrameList)
+{
+  vtkPlusTrackedFrameList* inputFrameList = input.Reader->GetTrackedFrameList();
 
-        if (trackedFrame->GetCustomFrameTransformStatus(transformNameList[n], status) != PLUS_SUCCESS)
-        {
-          std::string strTransformName;
-          transformNameList[i].GetTransformName(strTransformName);
-          LOG_ERROR("Failed to get custom frame transform status: " << strTransformName);
-          continue;
-        }
+  // Fields of the frame are already read from the header (with the pixel data, if the whole file is read)
+  PlusTrackedFrame emptyFrame;
+  PlusTrackedFrame* inputFrame = &emptyFrame;
+  if (frameIndex < inputFrameList->GetNumberOfTrackedFrames())
+  {
+    inputFrame = inputFrameList->GetTrackedFrame(frameIndex);
+  }
+  if (outputFrameList->AddTrackedFrame(inputFrame, vtkPlusTrackedFrameList::ADD_INVALID_FRAME) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to add tracked frame to the list!");
+    return PLUS_FAIL;
+  }
 
-        // Compute ToolToTracker transform from ToolToReference
-        toolToTrackerTransform->Identity();
-        toolToTrackerTransform->Concatenate(referenceToTrackerMatrix);
-        toolToTrackerTransform->Concatenate(toolToReferenceMatrix);
+  if (!input.FrameByFrame || !input.ContainsImageData || !readPixelData || frameIndex >= input.Reader->GetDimensions()[3])
+  {
+    // Pixel data is already read or not needed
+    return PLUS_SUCCESS;
+  }
 
-        // Update the name to ToolToTracker
-        PlusTransformName toolToTracker(transformNameList[n].From().c_str(), "Tracker");
-        // Set the new custom transform
-        if (trackedFrame->SetCustomFrameTransform(toolToTracker, toolToTrackerTransform->GetMatrix()) != PLUS_SUCCESS)
-        {
-          std::string strTransformName;
-          transformNameList[i].GetTransformName(strTransformName);
-          LOG_ERROR("Failed to set custom frame transform: " << strTransformName);
-          continue;
-        }
+  // Image status is determined by trackedFrame->GetImageData()->IsImageValid(), the same way as when the whole file is read
+  PlusTrackedFrame* trackedFrame = outputFrameList->GetTrackedFrame(outputFrameList->GetNumberOfTrackedFrames() - 1);
+  bool imageValid = true;
+  const char* imageStatus = trackedFrame->GetCustomFrameField(FIELD_NAME_IMAGE_STATUS);
+  if (imageStatus != NULL)
+  {
+    imageValid = (STRCASECMP(imageStatus, "OK") == 0);
+    trackedFrame->DeleteCustomFrameField(FIELD_NAME_IMAGE_STATUS);
+  }
+  if (!imageValid)
+  {
+    LOG_DEBUG("Frame #" << frameIndex << " image data is invalid, no need to read the pixel data.");
+    return PLUS_SUCCESS;
+  }
 
-        // Use the same status as it was before
-        if (trackedFrame->SetCustomFrameTransformStatus(toolToTracker, status) != PLUS_SUCCESS)
-        {
-          std::string strTransformName;
-          transformNameList[i].GetTransformName(strTransformName);
-          LOG_ERROR("Failed to set custom frame transform status: " << strTransformName);
-          continue;
-        }
+  if (input.Reader->ReadFramePixels(frameIndex, *trackedFrame->GetImageData()) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read pixel data of frame #" << frameIndex << " from " << input.FileName);
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
 
-        // Delete old transform and status fields
-        std::string oldTransformName, oldTransformStatus;
-        transformNameList[n].GetTransformName(oldTransformName);
-        // Append Transform to the end of the transform name
-        vtksys::RegularExpression isTransform("Transform$");
-        if (!isTransform.find(oldTransformName))
-        {
-          oldTransformName.append("Transform");
-        }
-        oldTransformStatus = oldTransformName;
-        oldTransformStatus.append("Status");
-        trackedFrame->DeleteCustomFrameField(oldTransformName.c_str());
-        trackedFrame->DeleteCustomFrameField(oldTransformStatus.c_str());
+//-------------------------------------------------------
+PlusStatus EditFrames(vtkPlusTrackedFrameList* trackedFrameList, FrameEdit& frameEdit)
+{
+  if (trackedFrameList->GetNumberOfTrackedFrames() == 0)
+  {
+    return PLUS_SUCCESS;
+  }
 
+  switch (frameEdit.Operation)
+  {
+  case UPDATE_FRAME_FIELD_NAME:
+  case UPDATE_FRAME_FIELD_VALUE:
+  {
+    frameEdit.FieldUpdate.TrackedFrameList = trackedFrameList;
+    if (UpdateFrameFieldValue(frameEdit.FieldUpdate) != PLUS_SUCCESS)
+    {
+      if (frameEdit.Operation == UPDATE_FRAME_FIELD_NAME)
+      {
+        LOG_ERROR("Failed to update frame field name '" << frameEdit.FieldUpdate.FieldName << "' to '" << frameEdit.FieldUpdate.UpdatedFieldName << "'");
+      }
+      else
+      {
+        LOG_ERROR("Failed to update frame field value");
       }
+      return PLUS_FAIL;
     }
   }
+  break;
+  case DELETE_FRAME_FIELD:
+  {
+    if (DeleteFrameField(trackedFrameList, frameEdit.FieldName) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to delete frame field");
+      return PLUS_FAIL;
+    }
+  }
+  break;
+  case ADD_TRANSFORM:
+  {
+    if (AddTransform(trackedFrameList, frameEdit.TransformNamesToAdd, frameEdit.DeviceSetConfiguration) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add transforms to the frames");
+      return PLUS_FAIL;
+    }
+  }
+  break;
+  case FILL_IMAGE_RECTANGLE:
+  {
+    // Fill a rectangular region in the image with a solid color
+    if (FillRectangle(trackedFrameList, frameEdit.FillRectOrigin, frameEdit.FillRectSize, frameEdit.FillGrayLevel) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to fill rectangle");
+      return PLUS_FAIL;
+    }
+  }
+  break;
+  case CROP:
+  {
+    // Crop a rectangular region from the image
+    if (CropRectangle(trackedFrameList, frameEdit.FlipInfo, frameEdit.CropRectOrigin, frameEdit.CropRectSize) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to crop rectangle");
+      return PLUS_FAIL;
+    }
+  }
+  break;
+  default:
+    // No per-frame processing is needed
+    break;
+  }
 
-  ///////////////////////////////////////////////////////////////////
-  // Save output file to file
-
-  LOG_INFO("Save output sequence file to: " << outputFileName);
-  if (vtkPlusSequenceIO::Write(outputFileName, trackedFrameList, trackedFrameList->GetImageOrientation(), useCompression, operation != REMOVE_IMAGE_DATA) != PLUS_SUCCESS)
+  // Convert files to the new file format
+  if (frameEdit.UpdateReferenceTransform)
   {
-    LOG_ERROR("Couldn't write sequence file: " <<  outputFileName);
-    return EXIT_FAILURE;
+    if (UpdateReferenceTransform(trackedFrameList, frameEdit.ReferenceTransformName) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
   }
 
-  LOG_INFO("Sequence file editing was successful!");
-  return EXIT_SUCCESS;
+  return PLUS_SUCCESS;
 }
 
 //-------------------------------------------------------
-PlusStatus TrimSequenceFile(vtkPlusTrackedFrameList* aTrackedFrameList, unsigned int aFirstFrameIndex, unsigned int aLastFrameIndex)
+PlusStatus WriteFrames(OutputSequence& output)
 {
-  LOG_INFO("Trim sequence file from frame #: " << aFirstFrameIndex << " to frame #" << aLastFrameIndex);
-  if (aLastFrameIndex >= aTrackedFrameList->GetNumberOfTrackedFrames() || aFirstFrameIndex > aLastFrameIndex)
+  vtkPlusSequenceIOBase* writer = output.Writer;
+  vtkPlusTrackedFrameList* trackedFrameList = output.Frames;
+
+  if (!output.HeaderPrepared)
   {
-    LOG_ERROR("Invalid input range: (" << aFirstFrameIndex << ", " << aLastFrameIndex << ")" << " Permitted range within (0, " << aTrackedFrameList->GetNumberOfTrackedFrames() - 1 << ")");
-    return PLUS_FAIL;
+    // Header fields that describe the image data are determined from the first chunk
+    if (!output.PixelDataPassThrough && trackedFrameList->IsContainingValidImageData())
+    {
+      writer->SetImageOrientationInFile(trackedFrameList->GetImageOrientation());
+    }
+    if (writer->PrepareHeader() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to prepare the header.");
+      return PLUS_FAIL;
+    }
+    if (output.PixelDataPassThrough)
+    {
+      output.IsData3D = (writer->GetDimensions()[2] > 1);
+    }
+    else
+    {
+      output.IsData3D = (trackedFrameList->GetNumberOfTrackedFrames() > 0 && trackedFrameList->GetTrackedFrame(0)->GetFrameSize()[2] > 1);
+    }
+    output.HeaderPrepared = true;
+  }
+  else if (writer->GetEnableImageDataWrite() && !output.PixelDataPassThrough)
+  {
+    // Frame size is set in the header by the first chunk, images of the other chunks must have the same size
+    unsigned int* frameSize = writer->GetDimensions();
+    for (unsigned int frameNumber = 0; frameNumber < trackedFrameList->GetNumberOfTrackedFrames(); frameNumber++)
+    {
+      PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(frameNumber);
+      unsigned int* currFrameSize = trackedFrame->GetFrameSize();
+      if (trackedFrame->GetImageData()->IsImageValid()
+          && (frameSize[0] != currFrameSize[0] || frameSize[1] != currFrameSize[1] || frameSize[2] != currFrameSize[2]))
+      {
+        LOG_ERROR("Frame size mismatch: expected size (" << frameSize[0] << "x" << frameSize[1] << "x" << frameSize[2]
+                  << ") differ from actual size (" << currFrameSize[0] << "x" << currFrameSize[1] << "x" << currFrameSize[2] << ") for frame #" << output.NumberOfFramesWritten + frameNumber);
+        return PLUS_FAIL;
+      }
+    }
   }
 
-  if (aLastFrameIndex != aTrackedFrameList->GetNumberOfTrackedFrames() - 1)
+  if (trackedFrameList->GetNumberOfTrackedFrames() == 0)
   {
-    aTrackedFrameList->RemoveTrackedFrameRange(aLastFrameIndex + 1, aTrackedFrameList->GetNumberOfTrackedFrames() - 1);
+    return PLUS_SUCCESS;
   }
 
-  if (aFirstFrameIndex != 0)
+  if (writer->AppendImagesToHeader() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to append images to the header.");
+    return PLUS_FAIL;
+  }
+  if (writer->WriteImages() != PLUS_SUCCESS)
   {
-    aTrackedFrameList->RemoveTrackedFrameRange(0, aFirstFrameIndex - 1);
+    LOG_ERROR("Unable to write images.");
+    return PLUS_FAIL;
   }
 
+  output.NumberOfFramesWritten += trackedFrameList->GetNumberOfTrackedFrames();
+  LOG_DEBUG(output.NumberOfFramesWritten << " frames are written");
+
+  // Fields of the whole sequence are kept
+  trackedFrameList->Clear();
   return PLUS_SUCCESS;
 }
 
 //-------------------------------------------------------
-PlusStatus DecimateSequenceFile(vtkPlusTrackedFrameList* aTrackedFrameList, unsigned int decimationFactor)
+PlusStatus CloseOutputSequence(OutputSequence& output)
 {
-  LOG_INFO("Decimate sequence file: keep 1 frame out of every " << decimationFactor << " frames");
-  if (decimationFactor < 2)
+  vtkPlusSequenceIOBase* writer = output.Writer;
+
+  // Update the fields that depend on the number of frames
+  writer->UpdateDimensionsCustomStrings(output.NumberOfFramesWritten, output.IsData3D);
+  if (writer->UpdateFieldInImageHeader(writer->GetDimensionSizeString()) != PLUS_SUCCESS
+      || writer->UpdateFieldInImageHeader(writer->GetDimensionKindsString()) != PLUS_SUCCESS)
   {
-    LOG_ERROR("Invalid decimation factor: " << decimationFactor << ". It must be an integer larger or equal than 2.");
+    LOG_ERROR("Unable to update the number of frames in the header.");
     return PLUS_FAIL;
   }
-  for (unsigned int i = 0; i < aTrackedFrameList->GetNumberOfTrackedFrames() - 1; i++)
+  if (writer->FinalizeHeader() != PLUS_SUCCESS)
   {
-    unsigned int removeFirstFrameIndex = i + 1;
-    unsigned int removeLastFrameIndex = i + decimationFactor - 1;
-    if (removeLastFrameIndex >= aTrackedFrameList->GetNumberOfTrackedFrames())
-    {
-      removeLastFrameIndex = aTrackedFrameList->GetNumberOfTrackedFrames() - 1;
-      if (removeLastFrameIndex < removeFirstFrameIndex)
-      {
-        removeLastFrameIndex = removeFirstFrameIndex;
-      }
-    }
-    aTrackedFrameList->RemoveTrackedFrameRange(removeFirstFrameIndex, removeLastFrameIndex);
+    LOG_ERROR("Unable to finalize the header.");
+    return PLUS_FAIL;
   }
-  return PLUS_SUCCESS;
+  return writer->Close();
 }
 
 //-------------------------------------------------------
@@ -724,7 +1073,6 @@ PlusStatus DeleteFrameField(vtkPlusTrackedFrameList* trackedFrameList, std::stri
     return PLUS_FAIL;
   }
 
-  LOG_INFO("Delete frame field: " << fieldName);
   int numberOfErrors(0);
   for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
   {
@@ -748,18 +1096,11 @@ PlusStatus DeleteFrameField(vtkPlusTrackedFrameList* trackedFrameList, std::stri
 //-------------------------------------------------------
 PlusStatus UpdateFrameFieldValue(FrameFieldUpdate& fieldUpdate)
 {
-  LOG_INFO("Update frame field");
   int numberOfErrors(0);
 
-  // Set the start scalar value
-  double scalarVariable = fieldUpdate.FrameScalarStart;
-
-  // Set the start transform matrix
-  vtkSmartPointer<vtkTransform> frameTransform = vtkSmartPointer<vtkTransform>::New();
-  if (fieldUpdate.FrameTransformStart != NULL)
-  {
-    frameTransform->SetMatrix(fieldUpdate.FrameTransformStart);
-  }
+  // Scalar value and transform matrix continue from the previous chunk of frames
+  double& scalarVariable = fieldUpdate.NextFrameScalar;
+  vtkTransform* frameTransform = fieldUpdate.NextFrameTransform;
 
   for (unsigned int i = 0; i < fieldUpdate.TrackedFrameList->GetNumberOfTrackedFrames(); ++i)
   {
@@ -877,7 +1218,7 @@ PlusStatus ConvertStringToMatrix(std::string& strMatrix, vtkMatrix4x4* matrix)
 }
 
 //-------------------------------------------------------
-PlusStatus AddTransform(vtkPlusTrackedFrameList* trackedFrameList, std::vector<std::string> transformNamesToAdd, std::string deviceSetConfigurationFileName)
+PlusStatus AddTransform(vtkPlusTrackedFrameList* trackedFrameList, std::vector<std::string> transformNamesToAdd, vtkXMLDataElement* configRootElement)
 {
   if (trackedFrameList == NULL)
   {
@@ -885,23 +1226,9 @@ PlusStatus AddTransform(vtkPlusTrackedFrameList* trackedFrameList, std::vector<s
     return PLUS_FAIL;
   }
 
-  if (transformNamesToAdd.empty())
-  {
-    LOG_ERROR("No transform names are specified to be added");
-    return PLUS_FAIL;
-  }
-
-  if (deviceSetConfigurationFileName.empty())
+  if (configRootElement == NULL)
   {
-    LOG_ERROR("Used device set configuration file name is empty");
-    return PLUS_FAIL;
-  }
-
-  // Read configuration
-  vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::New();
-  if (PlusXmlUtils::ReadDeviceSetConfigurationFromFile(configRootElement, deviceSetConfigurationFileName.c_str()) == PLUS_FAIL)
-  {
-    LOG_ERROR("Unable to read configuration from file " << deviceSetConfigurationFileName.c_str());
+    LOG_ERROR("Device set configuration is invalid");
     return PLUS_FAIL;
   }
 
@@ -1054,6 +1381,99 @@ PlusStatus CropRectangle(vtkPlusTrackedFrameList* trackedFrameList, PlusVideoFra
   return PLUS_SUCCESS;
 }
 
+//-------------------------------------------------------
+PlusStatus UpdateReferenceTransform(vtkPlusTrackedFrameList* trackedFrameList, const PlusTransformName& referenceTransformName)
+{
+  if (trackedFrameList == NULL)
+  {
+    LOG_ERROR("Tracked frame list is NULL!");
+    return PLUS_FAIL;
+  }
+
+  for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
+  {
+    PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(i);
+
+    vtkSmartPointer<vtkMatrix4x4> referenceToTrackerMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    if (trackedFrame->GetCustomFrameTransform(referenceTransformName, referenceToTrackerMatrix) != PLUS_SUCCESS)
+    {
+      std::string strReferenceTransformName;
+      referenceTransformName.GetTransformName(strReferenceTransformName);
+      LOG_WARNING("Couldn't get reference transform with name: " << strReferenceTransformName);
+      continue;
+    }
+
+    std::vector<PlusTransformName> transformNameList;
+    trackedFrame->GetCustomFrameTransformNameList(transformNameList);
+
+    vtkSmartPointer<vtkTransform> toolToTrackerTransform = vtkSmartPointer<vtkTransform>::New();
+    vtkSmartPointer<vtkMatrix4x4> toolToReferenceMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    for (unsigned int n = 0; n < transformNameList.size(); ++n)
+    {
+      // No need to change the reference transform
+      if (transformNameList[n] == referenceTransformName)
+      {
+        continue;
+      }
+
+      TrackedFrameFieldStatus status = FIELD_INVALID;
+      if (trackedFrame->GetCustomFrameTransform(transformNameList[n], toolToReferenceMatrix) != PLUS_SUCCESS)
+      {
+        std::string strTransformName;
+        transformNameList[n].GetTransformName(strTransformName);
+        LOG_ERROR("Failed to get custom frame transform: " << strTransformName);
+        continue;
+      }
+
+      if (trackedFrame->GetCustomFrameTransformStatus(transformNameList[n], status) != PLUS_SUCCESS)
+      {
+        std::string strTransformName;
+        transformNameList[n].GetTransformName(strTransformName);
+        LOG_ERROR("Failed to get custom frame transform status: " << strTransformName);
+        continue;
+      }
+
+      // Compute ToolToTracker transform from ToolToReference
+      toolToTrackerTransform->Identity();
+      toolToTrackerTransform->Concatenate(referenceToTrackerMatrix);
+      toolToTrackerTransform->Concatenate(toolToReferenceMatrix);
+
+      // Update the name to ToolToTracker
+      PlusTransformName toolToTracker(transformNameList[n].From().c_str(), "Tracker");
+      // Set the new custom transform
+      if (trackedFrame->SetCustomFrameTransform(toolToTracker, toolToTrackerTransform->GetMatrix()) != PLUS_SUCCESS)
+      {
+        std::string strTransformName;
+        transformNameList[n].GetTransformName(strTransformName);
+        LOG_ERROR("Failed to set custom frame transform: " << strTransformName);
+        continue;
+      }
+
+      // Use the same status as it was before
+      if (trackedFrame->SetCustomFrameTransformStatus(toolToTracker, status) != PLUS_SUCCESS)
+      {
+        std::string strTransformName;
+        transformNameList[n].GetTransformName(strTransformName);
+        LOG_ERROR("Failed to set custom frame transform status: " << strTransformName);
+        continue;
+      }
 
+      // Delete old transform and status fields
+      std::string oldTransformName, oldTransformStatus;
+      transformNameList[n].GetTransformName(oldTransformName);
+      // Append Transform to the end of the transform name
+      vtksys::RegularExpression isTransform("Transform$");
+      if (!isTransform.find(oldTransformName))
+      {
+        oldTransformName.append("Transform");
+      }
+      oldTransformStatus = oldTransformName;
+      oldTransformStatus.append("Status");
+      trackedFrame->DeleteCustomFrameField(oldTransformName.c_str());
+      trackedFrame->DeleteCustomFrameField(oldTransformStatus.c_str());
 
+    }
+  }
 
+  return PLUS_SUCCESS;
+}
@@ -16,8 +16,12 @@ See License.txt for details.
 #include "vtkPlusLogger.h"
 #include "vtkPlusRecursiveCriticalSection.h"
 #include "vtksys/SystemTools.hxx"
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <sstream>
 #include <string>
+#include <vector>
 
 //-----------------------------------------------------------------------------
 
@@ -31,8 +35,179 @@ vtkStandardNewMacro(vtkPlusLoggerOutputWindow);
 namespace
 {
   vtkPlusSimpleRecursiveCriticalSection LoggerCreationCriticalSection;
+
+  /*! Maximum number of records in the lock-free asynchronous logging queue (must be a power of 2) */
+  const size_t ASYNCHRONOUS_QUEUE_SIZE = 4096;
+  /*! Maximum number of records in the overflow queue that is used when the lock-free queue is full */
+  const size_t ASYNCHRONOUS_OVERFLOW_QUEUE_SIZE = 4096;
+  /*! Maximum number of records written by the asynchronous logging thread before flushing the log file */
+  const int ASYNCHRONOUS_WRITE_BATCH_SIZE = 256;
 }
 
+//-----------------------------------------------------------------------------
+/*! Fully formatted log message, ready to be written to the console and the log file */
+class vtkPlusLogger::LogRecord
+{
+public:
+  LogRecord()
+    : Level(LOG_LEVEL_INFO)
+    , OnlyShowMessage(false)
+    , IsWide(false)
+  {
+  }
+
+  void Swap(LogRecord& other)
+  {
+    std::swap(this->Level, other.Level);
+    std::swap(this->OnlyShowMessage, other.OnlyShowMessage);
+    std::swap(this->IsWide, other.IsWide);
+    this->Timestamp.swap(other.Timestamp);
+    this->Message.swap(other.Message);
+    this->Line.swap(other.Line);
+    this->WideMessage.swap(other.WideMessage);
+    this->WideLine.swap(other.WideLine);
+  }
+
+  LogLevelType Level;
+  /*! If true then only the message is displayed on the console (without level, time, location) */
+  bool OnlyShowMessage;
+  /*! If true then the WideMessage and WideLine members are used instead of Message and Line */
+  bool IsWide;
+  /*! Date and time string when the message was logged */
+  std::string Timestamp;
+  std::string Message;
+  std::string Line;
+  std::wstring WideMessage;
+  std::wstring WideLine;
+};
+
+//-----------------------------------------------------------------------------
+/*!
+  Multiple-producer single-consumer queue of log records.
+  The bounded lock-free ring buffer is based on Dmitry Vyukov's bounded queue algorithm: each slot stores a
+  sequence number that tells if the slot is ready for writing (by the producers) or reading (by the consumer).
+  If the ring is full then records are added to a bounded overflow queue that is protected by a critical section.
+  While the overflow queue is not empty all records are added to it, to preserve the order of messages logged by the same thread.
+  If the overflow queue is full too then the record is dropped.
+*/
+class vtkPlusLogger::LogRecordQueue
+{
+public:
+  LogRecordQueue()
+    : Slots(ASYNCHRONOUS_QUEUE_SIZE)
+    , EnqueuePosition(0)
+    , DequeuePosition(0)
+    , OverflowQueueSize(0)
+    , NumberOfDroppedRecords(0)
+  {
+    for (size_t i = 0; i < ASYNCHRONOUS_QUEUE_SIZE; ++i)
+    {
+      this->Slots[i].Sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /*! Add a record to the queue. The contents of the record are moved into the queue. Can be called from any thread. */
+  void Push(LogRecord& record)
+  {
+    if (this->OverflowQueueSize.load(std::memory_order_acquire) == 0 && this->TryPushToRing(record))
+    {
+      return;
+    }
+    PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> overflowGuard(&this->OverflowCriticalSection);
+    if (this->OverflowQueue.size() >= ASYNCHRONOUS_OVERFLOW_QUEUE_SIZE)
+    {
+      this->NumberOfDroppedRecords++;
+      return;
+    }
+    this->OverflowQueue.push_back(LogRecord());
+    this->OverflowQueue.back().Swap(record);
+    this->OverflowQueueSize.store(this->OverflowQueue.size(), std::memory_order_release);
+  }
+
+  /*! Get the next record from the queue. Must be called only from the consumer thread. */
+  bool Pop(LogRecord& record)
+  {
+    Slot& slot = this->Slots[this->DequeuePosition & (ASYNCHRONOUS_QUEUE_SIZE - 1)];
+    size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+    if (sequence == this->DequeuePosition + 1)
+    {
+      record.Swap(slot.Record);
+      slot.Sequence.store(this->DequeuePosition + ASYNCHRONOUS_QUEUE_SIZE, std::memory_order_release);
+      this->DequeuePosition++;
+      return true;
+    }
+    // The ring is empty (all records that were pushed to the ring before the overflow records are already consumed)
+    if (this->OverflowQueueSize.load(std::memory_order_acquire) == 0)
+    {
+      return false;
+    }
+    PlusLockGuard<vtkPlusSimpleRecursiveCriticalSection> overflowGuard(&this->OverflowCriticalSection);
+    if (this->OverflowQueue.empty())
+    {
+      return false;
+    }
+    record.Swap(this->OverflowQueue.front());
+    this->OverflowQueue.pop_front();
+    this->OverflowQueueSize.store(this->OverflowQueue.size(), std::memory_order_release);
+    return true;
+  }
+
+  unsigned long GetNumberOfDroppedRecords()
+  {
+    return this->NumberOfDroppedRecords.load();
+  }
+
+protected:
+  bool TryPushToRing(LogRecord& record)
+  {
+    size_t position = this->EnqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot = NULL;
+    for (;;)
+    {
+      slot = &this->Slots[position & (ASYNCHRONOUS_QUEUE_SIZE - 1)];
+      size_t sequence = slot->Sequence.load(std::memory_order_acquire);
+      if (sequence == position)
+      {
+        // slot is free, try to reserve it
+        if (this->EnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (sequence < position)
+      {
+        // the consumer has not read this slot yet, the ring is full
+        return false;
+      }
+      else
+      {
+        // another producer reserved this slot, try the next one
+        position = this->EnqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+    slot->Record.Swap(record);
+    slot->Sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  struct Slot
+  {
+    std::atomic<size_t> Sequence;
+    LogRecord Record;
+  };
+
+  std::vector<Slot> Slots;
+  std::atomic<size_t> EnqueuePosition;
+  /*! Only accessed by the consumer thread */
+  size_t DequeuePosition;
+
+  vtkPlusSimpleRecursiveCriticalSection OverflowCriticalSection;
+  std::deque<LogRecord> OverflowQueue;
+  std::atomic<size_t> OverflowQueueSize;
+
+  std::atomic<unsigned long> NumberOfDroppedRecords;
+};
+
 //-----------------------------------------------------------------------------
 
 void vtkPlusLoggerOutputWindow::ReplaceNewlineBySeparator(std::string& str)
@@ -130,6 +305,12 @@ void vtkPlusLoggerOutputWindow::PrintSelf(ostream& os, vtkIndent indent)
 
 //-------------------------------------------------------
 vtkPlusLogger::vtkPlusLogger()
+  : m_AsynchronousQueue(NULL)
+  , m_Threader(vtkMultiThreader::New())
+  , m_AsynchronousLoggingThreadId(-1)
+  , m_AsynchronousLoggingActive(false)
+  , m_NumberOfAsynchronousProducers(0)
+  , m_AsynchronousRecordsPending(false)
 {
   m_CriticalSection = vtkPlusRecursiveCriticalSection::New();
 
@@ -145,6 +326,18 @@ vtkPlusLogger::vtkPlusLogger()
 //-------------------------------------------------------
 vtkPlusLogger::~vtkPlusLogger()
 {
+  // Write all pending messages
+  this->SetAsynchronousLogging(false);
+
+  if (this->m_Threader != NULL)
+  {
+    this->m_Threader->Delete();
+    this->m_Threader = NULL;
+  }
+
+  delete this->m_AsynchronousQueue;
+  this->m_AsynchronousQueue = NULL;
+
   // Disconnect VTK error logging from the Plus logger (restore default VTK logging)
   vtkOutputWindow::SetInstance(NULL);
 
@@ -349,88 +542,14 @@ void vtkPlusLogger::LogMessage(LogLevelType level, const char* msg, const char*
     log << "| in " << fileName << "(" << lineNumber << ")"; // add filename and line number
   }
 
-  {
-    PlusLockGuard<vtkPlusRecursiveCriticalSection> critSectionGuard(this->m_CriticalSection);
-
-    if (m_LogLevel >= level)
-    {
-
-#ifdef _WIN32
-
-      // Set the text color to highlight error and warning messages (supported only on windows)
-      switch (level)
-      {
-        case LOG_LEVEL_ERROR:
-        {
-          HANDLE hStdout = GetStdHandle(STD_ERROR_HANDLE);
-          SetConsoleTextAttribute(hStdout, FOREGROUND_RED | FOREGROUND_INTENSITY);
-        }
-        break;
-        case LOG_LEVEL_WARNING:
-        {
-          HANDLE hStdout = GetStdHandle(STD_ERROR_HANDLE);
-          SetConsoleTextAttribute(hStdout, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY);
-        }
-        break;
-        default:
-        {
-          HANDLE hStdout = GetStdHandle(STD_OUTPUT_HANDLE);
-          SetConsoleTextAttribute(hStdout, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
-        }
-        break;
-      }
-#endif
-
-      if (level > LOG_LEVEL_WARNING)
-      {
-        if (onlyShowMessage)
-        {
-          std::cout << msg << std::endl;
-        }
-        else
-        {
-          std::cout << log.str() << std::endl;
-        }
-      }
-      else
-      {
-        if (onlyShowMessage)
-        {
-          std::cerr << msg << std::endl;
-        }
-        else
-        {
-          std::cerr << log.str() << std::endl;
-        }
-      }
-
-#ifdef _WIN32
-      // Revert the text color (supported only on windows)
-      if (level == LOG_LEVEL_ERROR || level == LOG_LEVEL_WARNING)
-      {
-        HANDLE hStdout = GetStdHandle(STD_ERROR_HANDLE);
-        SetConsoleTextAttribute(hStdout, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
-      }
-#endif
-
-      // Call display message callbacks if higher priority than trace
-      if (level < LOG_LEVEL_TRACE)
-      {
-        std::ostringstream callDataStream;
-        callDataStream << level << "|" << log.str();
-
-        InvokeEvent(vtkCommand::UserEvent, (void*)(callDataStream.str().c_str()));
-      }
-
-      // Add to log stream (file)
-      std::string logStr(log.str());
-      std::wstring logWStr(logStr.begin(), logStr.end());
-      this->m_LogStream << std::setw(17) << std::left << std::wstring(timestamp.begin(), timestamp.end()) << logWStr;
-      this->m_LogStream << std::endl;
-    }
-  }
-
-  this->Flush();
+  LogRecord record;
+  record.Level = level;
+  record.OnlyShowMessage = onlyShowMessage;
+  record.IsWide = false;
+  record.Timestamp = timestamp;
+  record.Message = msg;
+  record.Line = log.str();
+  this->DispatchLogRecord(record);
 }
 
 //----------------------------------------------------------------------------
@@ -492,84 +611,242 @@ void vtkPlusLogger::LogMessage(LogLevelType level, const wchar_t* msg, const cha
     log << L"| in " << fileName << L"(" << lineNumber << L")"; // add filename and line number
   }
 
+  LogRecord record;
+  record.Level = level;
+  record.OnlyShowMessage = onlyShowMessage;
+  record.IsWide = true;
+  record.Timestamp = timestamp;
+  record.WideMessage = msg;
+  record.WideLine = log.str();
+  this->DispatchLogRecord(record);
+}
+
+//-------------------------------------------------------
+void vtkPlusLogger::DispatchLogRecord(LogRecord& record)
+{
+  // The producer count is incremented before the mode is checked, so that when asynchronous logging is disabled
+  // the queue can be drained after the last record has been pushed
+  this->m_NumberOfAsynchronousProducers++;
+  if (this->m_AsynchronousLoggingActive)
+  {
+    this->m_AsynchronousQueue->Push(record);
+    this->m_NumberOfAsynchronousProducers--;
+    if (!this->m_AsynchronousRecordsPending.exchange(true))
+    {
+      // the logging thread may be waiting, wake it up
+      std::lock_guard<std::mutex> wakeUpGuard(this->m_AsynchronousLoggingMutex);
+      this->m_AsynchronousLoggingCondition.notify_one();
+    }
+    return;
+  }
+  this->m_NumberOfAsynchronousProducers--;
+
   {
     PlusLockGuard<vtkPlusRecursiveCriticalSection> critSectionGuard(this->m_CriticalSection);
+    if (m_LogLevel >= record.Level)
+    {
+      this->WriteLogRecord(record);
+    }
+  }
+
+  this->Flush();
+}
+
+//-------------------------------------------------------
+void vtkPlusLogger::WriteLogRecord(const LogRecord& record)
+{
+  // the caller must have locked the critical section
 
-    if (m_LogLevel >= level)
+#ifdef _WIN32
+  // Set the text color to highlight error and warning messages (supported only on windows)
+  switch (record.Level)
+  {
+    case LOG_LEVEL_ERROR:
+    {
+      HANDLE hStdout = GetStdHandle(STD_ERROR_HANDLE);
+      SetConsoleTextAttribute(hStdout, FOREGROUND_RED | FOREGROUND_INTENSITY);
+    }
+    break;
+    case LOG_LEVEL_WARNING:
     {
+      HANDLE hStdout = GetStdHandle(STD_ERROR_HANDLE);
+      SetConsoleTextAttribute(hStdout, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY);
+    }
+    break;
+    default:
+    {
+      HANDLE hStdout = GetStdHandle(STD_OUTPUT_HANDLE);
+      SetConsoleTextAttribute(hStdout, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+    }
+    break;
+  }
+#endif
+
+  if (record.IsWide)
+  {
+    std::wostream& console = (record.Level > LOG_LEVEL_WARNING) ? std::wcout : std::wcerr;
+    console << (record.OnlyShowMessage ? record.WideMessage : record.WideLine) << std::endl;
+  }
+  else
+  {
+    std::ostream& console = (record.Level > LOG_LEVEL_WARNING) ? std::cout : std::cerr;
+    console << (record.OnlyShowMessage ? record.Message : record.Line) << std::endl;
+  }
+
 #ifdef _WIN32
-      // Set the text color to highlight error and warning messages (supported only on windows)
-      switch (level)
-      {
-        case LOG_LEVEL_ERROR:
-        {
-          HANDLE hStdout = GetStdHandle(STD_ERROR_HANDLE);
-          SetConsoleTextAttribute(hStdout, FOREGROUND_RED | FOREGROUND_INTENSITY);
-        }
-        break;
-        case LOG_LEVEL_WARNING:
-        {
-          HANDLE hStdout = GetStdHandle(STD_ERROR_HANDLE);
-          SetConsoleTextAttribute(hStdout, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY);
-        }
-        break;
-        default:
-        {
-          HANDLE hStdout = GetStdHandle(STD_OUTPUT_HANDLE);
-          SetConsoleTextAttribute(hStdout, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
-        }
-        break;
-      }
+  // Revert the text color (supported only on windows)
+  if (record.Level == LOG_LEVEL_ERROR || record.Level == LOG_LEVEL_WARNING)
+  {
+    HANDLE hStdout = GetStdHandle(STD_ERROR_HANDLE);
+    SetConsoleTextAttribute(hStdout, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+  }
 #endif
 
-      if (level > LOG_LEVEL_WARNING)
-      {
-        if (onlyShowMessage)
-        {
-          std::wcout << msg << std::endl;
-        }
-        else
-        {
-          std::wcout << log.str() << std::endl;
-        }
-      }
-      else
+  // Call display message callbacks if higher priority than trace
+  if (record.Level < LOG_LEVEL_TRACE)
+  {
+    if (record.IsWide)
+    {
+      std::wostringstream callDataStream;
+      callDataStream << record.Level << L"|" << record.WideLine;
+      InvokeEvent(vtkCommand::UserEvent, (void*)(callDataStream.str().c_str()));
+    }
+    else
+    {
+      std::ostringstream callDataStream;
+      callDataStream << record.Level << "|" << record.Line;
+      InvokeEvent(vtkCommand::UserEvent, (void*)(callDataStream.str().c_str()));
+    }
+  }
+
+  // Add to log stream (file), this may introduce conversion issues going from wstring to string
+  this->m_LogStream << std::setw(17) << std::left << std::wstring(record.Timestamp.begin(), record.Timestamp.end());
+  if (record.IsWide)
+  {
+    this->m_LogStream << record.WideLine;
+  }
+  else
+  {
+    this->m_LogStream << std::wstring(record.Line.begin(), record.Line.end());
+  }
+  this->m_LogStream << std::endl;
+}
+
+//-------------------------------------------------------
+int vtkPlusLogger::WriteQueuedLogRecords()
+{
+  int numberOfWrittenRecords(0);
+  LogRecord record;
+  bool queueEmpty(false);
+  while (!queueEmpty)
+  {
+    {
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> critSectionGuard(this->m_CriticalSection);
+      for (int i = 0; i < ASYNCHRONOUS_WRITE_BATCH_SIZE; ++i)
       {
-        if (onlyShowMessage)
+        if (!this->m_AsynchronousQueue->Pop(record))
         {
-          std::wcerr << msg << std::endl;
-        }
-        else
-        {
-          std::wcerr << log.str() << std::endl;
+          queueEmpty = true;
+          break;
         }
+        this->WriteLogRecord(record);
+        numberOfWrittenRecords++;
       }
+    }
+    this->Flush();
+  }
+  return numberOfWrittenRecords;
+}
 
-#ifdef _WIN32
-      // Revert the text color (supported only on windows)
-      if (level == LOG_LEVEL_ERROR || level == LOG_LEVEL_WARNING)
+//-------------------------------------------------------
+void* vtkPlusLogger::AsynchronousLoggingThread(vtkMultiThreader::ThreadInfo* data)
+{
+  vtkPlusLogger* self = (vtkPlusLogger*)(data->UserData);
+
+  unsigned long numberOfReportedDroppedRecords(0);
+  for (;;)
+  {
+    {
+      // Wait until records are queued or asynchronous logging is disabled
+      std::unique_lock<std::mutex> wakeUpLock(self->m_AsynchronousLoggingMutex);
+      self->m_AsynchronousLoggingCondition.wait(wakeUpLock, [self]() { return self->m_AsynchronousRecordsPending.load() || !self->m_AsynchronousLoggingActive.load(); });
+      if (!self->m_AsynchronousLoggingActive)
       {
-        HANDLE hStdout = GetStdHandle(STD_ERROR_HANDLE);
-        SetConsoleTextAttribute(hStdout, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+        // the remaining records are written by SetAsynchronousLogging
+        break;
       }
-#endif
+      self->m_AsynchronousRecordsPending = false;
+    }
 
-      // Call display message callbacks if higher priority than trace
-      if (level < LOG_LEVEL_TRACE)
-      {
-        std::wostringstream callDataStream;
-        callDataStream << level << L"|" << log.str();
+    self->WriteQueuedLogRecords();
 
-        InvokeEvent(vtkCommand::UserEvent, (void*)(callDataStream.str().c_str()));
-      }
+    unsigned long numberOfDroppedRecords = self->m_AsynchronousQueue->GetNumberOfDroppedRecords();
+    if (numberOfDroppedRecords != numberOfReportedDroppedRecords)
+    {
+      std::ostringstream msg;
+      msg << "Asynchronous logging queue is full, " << numberOfDroppedRecords - numberOfReportedDroppedRecords << " log messages have been dropped";
+      numberOfReportedDroppedRecords = numberOfDroppedRecords;
+      self->LogMessage(LOG_LEVEL_WARNING, msg.str(), "vtkPlusLogger", __LINE__);
+    }
+  }
+
+  return NULL;
+}
+
+//-------------------------------------------------------
+void vtkPlusLogger::SetAsynchronousLogging(bool enable)
+{
+  if (enable == (this->m_AsynchronousLoggingThreadId >= 0))
+  {
+    // no change
+    return;
+  }
 
-      // Add to log stream (file), this may introduce conversion issues going from wstring to string
-      this->m_LogStream << std::setw(17) << std::left << std::wstring(timestamp.begin(), timestamp.end()) << log.str();
-      this->m_LogStream << std::endl;
+  if (enable)
+  {
+    if (this->m_AsynchronousQueue == NULL)
+    {
+      this->m_AsynchronousQueue = new LogRecordQueue;
     }
+    this->m_AsynchronousLoggingActive = true;
+    this->m_AsynchronousLoggingThreadId = this->m_Threader->SpawnThread((vtkThreadFunctionType)&AsynchronousLoggingThread, this);
+    return;
   }
 
-  this->Flush();
+  // Stop accepting new records into the queue, messages are written synchronously from now on
+  {
+    std::lock_guard<std::mutex> wakeUpGuard(this->m_AsynchronousLoggingMutex);
+    this->m_AsynchronousLoggingActive = false;
+    this->m_AsynchronousLoggingCondition.notify_one();
+  }
+  // Wait until the thread stops
+  this->m_Threader->TerminateThread(this->m_AsynchronousLoggingThreadId);
+  this->m_AsynchronousLoggingThreadId = -1;
+
+  // Producers that saw the asynchronous mode before it was disabled may still be pushing a record,
+  // wait until they are done so that no record is left in the queue
+  while (this->m_NumberOfAsynchronousProducers > 0)
+  {
+    vtkPlusAccurateTimer::Delay(0.001);
+  }
+  this->WriteQueuedLogRecords();
+  this->m_AsynchronousRecordsPending = false;
+}
+
+//-------------------------------------------------------
+bool vtkPlusLogger::GetAsynchronousLogging()
+{
+  return this->m_AsynchronousLoggingThreadId >= 0;
+}
+
+//-------------------------------------------------------
+unsigned long vtkPlusLogger::GetNumberOfDroppedMessages()
+{
+  if (this->m_AsynchronousQueue == NULL)
+  {
+    return 0;
+  }
+  return this->m_AsynchronousQueue->GetNumberOfDroppedRecords();
 }
 
 //-------------------------------------------------------
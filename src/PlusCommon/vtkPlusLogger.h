@@ -9,9 +9,13 @@
 
 #include "vtkPlusCommonExport.h"
 
+#include "vtkMultiThreader.h"
 #include "vtkObject.h"
 #include "vtkOutputWindow.h"
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 
 class vtkPlusRecursiveCriticalSection;
@@ -169,13 +173,47 @@ public:
   /*! Get the name of the file where the messages are logged to */
   std::string GetLogFileName();
 
+  /*!
+    Enable/disable asynchronous logging.
+    In asynchronous mode messages are formatted on the calling thread and then pushed into a lock-free queue.
+    A background thread, which is woken up when messages are queued, writes the queued messages to the console and the log file in batches, therefore
+    logging does not block time-critical threads (such as acquisition threads) even at DEBUG or TRACE level.
+    Message callbacks (UserEvent) are invoked from the background thread in this mode.
+    When asynchronous logging is disabled all the queued messages are written before the method returns.
+    Must be called from the main thread.
+  */
+  void SetAsynchronousLogging(bool enable);
+  /*! Returns true if asynchronous logging is enabled */
+  bool GetAsynchronousLogging();
+
+  /*!
+    Get the number of messages that were lost in asynchronous logging mode because
+    both the message queue and the overflow queue were full.
+  */
+  unsigned long GetNumberOfDroppedMessages();
+
 protected:
   vtkPlusLogger();
   ~vtkPlusLogger();
 
+  class LogRecord;
+  class LogRecordQueue;
+
   /*! Writes the messages that are cached in memory to the log file and clears the cache. */
   void Flush();
 
+  /*! Write the record synchronously or add it to the asynchronous queue, depending on the current logging mode */
+  void DispatchLogRecord(LogRecord& record);
+
+  /*! Write a log record to the console and to the log stream and call the message callbacks */
+  void WriteLogRecord(const LogRecord& record);
+
+  /*! Write all the log records from the asynchronous queue. Returns the number of written records. */
+  int WriteQueuedLogRecords();
+
+  /*! Background thread that writes the queued log records in asynchronous mode */
+  static void* AsynchronousLoggingThread(vtkMultiThreader::ThreadInfo* data);
+
 private:
   vtkPlusLogger(vtkPlusLogger const&);
   vtkPlusLogger& operator=(vtkPlusLogger const&);
@@ -197,6 +235,22 @@ private:
     threads simultaneously.
   */
   vtkPlusRecursiveCriticalSection* m_CriticalSection;
+
+  /*! Queue of messages that have not been written yet in asynchronous logging mode */
+  LogRecordQueue*         m_AsynchronousQueue;
+  /*! Threader for the asynchronous logging thread */
+  vtkMultiThreader*       m_Threader;
+  /*! Identifier of the asynchronous logging thread, negative if the thread is not running */
+  int                     m_AsynchronousLoggingThreadId;
+  /*! If true then new log records are added to the asynchronous queue, otherwise they are written synchronously */
+  std::atomic<bool>       m_AsynchronousLoggingActive;
+  /*! Number of threads that are currently adding a record to the asynchronous queue */
+  std::atomic<int>        m_NumberOfAsynchronousProducers;
+  /*! Set by the producers when a record is added to the queue, cleared by the asynchronous logging thread */
+  std::atomic<bool>       m_AsynchronousRecordsPending;
+  /*! Mutex and condition variable for waking up the asynchronous logging thread */
+  std::mutex              m_AsynchronousLoggingMutex;
+  std::condition_variable m_AsynchronousLoggingCondition;
 };
 
 #endif
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include "vtkPlusTransformRepository.h"
 #include "vtkXMLUtilities.h"
 #include "vtksys/SystemTools.hxx"
+#include <algorithm>
 #include <math.h>
 
 //----------------------------------------------------------------------------
@@ -26,7 +27,11 @@ vtkStandardNewMacro(vtkPlusTrackedFrameList);
 
 //----------------------------------------------------------------------------
 vtkPlusTrackedFrameList::vtkPlusTrackedFrameList()
+  : TimestampIndexValid(false)
+  , ValidatedFrameTransformParsed(false)
+  , ValidationTransformRepository(vtkSmartPointer<vtkPlusTransformRepository>::New())
 {
+  this->ValidatedFrameTransform.Frame = NULL;
   this->SetNumberOfUniqueFrames(5);
 
   this->MinRequiredTranslationDifferenceMm = 0.0;
@@ -52,6 +57,7 @@ PlusStatus vtkPlusTrackedFrameList::RemoveTrackedFrame(int frameNumber)
     return PLUS_FAIL;
   }
 
+  this->RemoveFromValidationCache(this->TrackedFrameList[frameNumber]);
   delete this->TrackedFrameList[frameNumber];
   this->TrackedFrameList.erase(this->TrackedFrameList.begin() + frameNumber);
 
@@ -69,6 +75,7 @@ PlusStatus vtkPlusTrackedFrameList::RemoveTrackedFrameRange(unsigned int frameNu
 
   for (unsigned int i = frameNumberFrom; i <= frameNumberTo; ++i)
   {
+    this->RemoveFromValidationCache(this->TrackedFrameList[i]);
     delete this->TrackedFrameList[i];
   }
 
@@ -89,6 +96,67 @@ void vtkPlusTrackedFrameList::Clear()
     }
   }
   this->TrackedFrameList.clear();
+  this->ResetValidationCache();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTrackedFrameList::ResetValidationCache()
+{
+  this->TimestampIndex.clear();
+  this->TimestampIndexValid = false;
+  this->ValidationTransformCache.clear();
+  this->ValidatedFrameTransformParsed = false;
+  this->ValidatedFrameTransform.Frame = NULL;
+  if (this->ValidationTransformRepository != NULL)
+  {
+    this->ValidationTransformRepository->Clear();
+  }
+  this->ValidationTransformRepositoryNames.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTrackedFrameList::UpdateValidationCache(PlusTrackedFrame* validatedFrame, PlusTrackedFrame* addedFrame)
+{
+  if (this->TimestampIndexValid)
+  {
+    this->TimestampIndex.insert(addedFrame->GetTimestamp());
+  }
+
+  // Only use the parsed transform if it was parsed when validating this frame
+  if (this->ValidatedFrameTransformParsed && this->ValidatedFrameTransform.Frame == validatedFrame)
+  {
+    ValidationTransformCacheEntry entry = this->ValidatedFrameTransform;
+    entry.Frame = addedFrame;
+    this->ValidationTransformCache.push_back(entry);
+    const size_t maxCacheSize = static_cast<size_t>(std::max(this->NumberOfUniqueFrames, 1));
+    while (this->ValidationTransformCache.size() > maxCacheSize)
+    {
+      this->ValidationTransformCache.pop_front();
+    }
+  }
+  this->ValidatedFrameTransformParsed = false;
+  this->ValidatedFrameTransform.Frame = NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTrackedFrameList::RemoveFromValidationCache(PlusTrackedFrame* removedFrame)
+{
+  if (this->TimestampIndexValid)
+  {
+    std::multiset<double>::iterator timestampIt = this->TimestampIndex.find(removedFrame->GetTimestamp());
+    if (timestampIt != this->TimestampIndex.end())
+    {
+      this->TimestampIndex.erase(timestampIt);
+    }
+  }
+  for (std::deque<ValidationTransformCacheEntry>::iterator entryIt = this->ValidationTransformCache.begin(); entryIt != this->ValidationTransformCache.end(); ++entryIt)
+  {
+    if (entryIt->Frame == removedFrame)
+    {
+      this->ValidationTransformCache.erase(entryIt);
+      break;
+    }
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -174,6 +242,7 @@ PlusStatus vtkPlusTrackedFrameList::AddTrackedFrame(PlusTrackedFrame* trackedFra
   // Make a copy and add frame to the list
   PlusTrackedFrame* pTrackedFrame = new PlusTrackedFrame(*trackedFrame);
   this->TrackedFrameList.push_back(pTrackedFrame);
+  this->UpdateValidationCache(trackedFrame, pTrackedFrame);
   return PLUS_SUCCESS;
 }
 
@@ -208,6 +277,7 @@ PlusStatus vtkPlusTrackedFrameList::TakeTrackedFrame(PlusTrackedFrame* trackedFr
 
   // Make a copy and add frame to the list
   this->TrackedFrameList.push_back(trackedFrame);
+  this->UpdateValidationCache(trackedFrame, trackedFrame);
   return PLUS_SUCCESS;
 }
 
@@ -221,6 +291,10 @@ bool vtkPlusTrackedFrameList::ValidateData(PlusTrackedFrame* trackedFrame)
     return true;
   }
 
+  // The validation transform of the new frame is parsed when it is first needed
+  this->ValidatedFrameTransform.Frame = trackedFrame;
+  this->ValidatedFrameTransformParsed = false;
+
   if (this->ValidationRequirements & REQUIRE_UNIQUE_TIMESTAMP)
   {
     if (! this->ValidateTimestamp(trackedFrame))
@@ -278,7 +352,16 @@ bool vtkPlusTrackedFrameList::ValidateTimestamp(PlusTrackedFrame* trackedFrame)
     // the existing list is empty, so any frame has unique timestamp and therefore valid
     return true;
   }
-  const bool isTimestampUnique = std::find_if(this->TrackedFrameList.begin(), this->TrackedFrameList.end(), TrackedFrameTimestampFinder(trackedFrame)) == this->TrackedFrameList.end();
+  if (!this->TimestampIndexValid)
+  {
+    this->TimestampIndex.clear();
+    for (TrackedFrameListType::iterator it = this->TrackedFrameList.begin(); it != this->TrackedFrameList.end(); ++it)
+    {
+      this->TimestampIndex.insert((*it)->GetTimestamp());
+    }
+    this->TimestampIndexValid = true;
+  }
+  const bool isTimestampUnique = this->TimestampIndex.find(trackedFrame->GetTimestamp()) == this->TimestampIndex.end();
   // validation passed if the timestamp is unique
   return isTimestampUnique;
 }
@@ -310,6 +393,12 @@ bool vtkPlusTrackedFrameList::ValidateEncoderPosition(PlusTrackedFrame* trackedF
 //----------------------------------------------------------------------------
 bool vtkPlusTrackedFrameList::ValidateTransform(PlusTrackedFrame* trackedFrame)
 {
+  if (this->MinRequiredTranslationDifferenceMm <= 0 || this->MinRequiredAngleDifferenceDeg <= 0)
+  {
+    // threshold is zero, so the frames are different for sure
+    return true;
+  }
+
   TrackedFrameListType::iterator searchIndex;
   const int containerSize = this->TrackedFrameList.size();
   if (containerSize < this->NumberOfUniqueFrames)
@@ -320,13 +409,34 @@ bool vtkPlusTrackedFrameList::ValidateTransform(PlusTrackedFrame* trackedFrame)
   {
     searchIndex = this->TrackedFrameList.end() - this->NumberOfUniqueFrames;
   }
+  if (searchIndex == this->TrackedFrameList.end())
+  {
+    return true;
+  }
 
-  if (std::find_if(searchIndex, this->TrackedFrameList.end(), TrackedFrameTransformFinder(trackedFrame, this->FrameTransformNameForValidation,
-                   this->MinRequiredTranslationDifferenceMm, this->MinRequiredAngleDifferenceDeg)) != this->TrackedFrameList.end())
+  vtkSmartPointer<vtkMatrix4x4> baseTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  if (this->GetValidationTransform(trackedFrame, baseTransformMatrix) != PLUS_SUCCESS)
   {
-    // We've already inserted this frame
-    LOG_DEBUG("Tracked frame transform validation result: we've already inserted this frame to container!");
-    return false;
+    LOG_ERROR("Unable to find base frame transform name for tracked frame validation!");
+    return true;
+  }
+
+  vtkSmartPointer<vtkMatrix4x4> listTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (; searchIndex != this->TrackedFrameList.end(); ++searchIndex)
+  {
+    if (this->GetValidationTransform(*searchIndex, listTransformMatrix) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to find frame transform name for tracked frame validation!");
+      continue;
+    }
+    double positionDifference = PlusMath::GetPositionDifference(baseTransformMatrix, listTransformMatrix);
+    double angleDifference = PlusMath::GetOrientationDifference(baseTransformMatrix, listTransformMatrix);
+    if (fabs(positionDifference) < this->MinRequiredTranslationDifferenceMm && fabs(angleDifference) < this->MinRequiredAngleDifferenceDeg)
+    {
+      // We've already inserted this frame
+      LOG_DEBUG("Tracked frame transform validation result: we've already inserted this frame to container!");
+      return false;
+    }
   }
 
   return true;
@@ -335,14 +445,32 @@ bool vtkPlusTrackedFrameList::ValidateTransform(PlusTrackedFrame* trackedFrame)
 //----------------------------------------------------------------------------
 bool vtkPlusTrackedFrameList::ValidateStatus(PlusTrackedFrame* trackedFrame)
 {
-  vtkPlusTransformRepository* repo = vtkPlusTransformRepository::New();
-  repo->SetTransforms(*trackedFrame);
+  if (trackedFrame->IsCustomFrameTransformNameDefined(this->FrameTransformNameForValidation))
+  {
+    // The transform is stored in the frame, its status can be read directly
+    TrackedFrameFieldStatus status = FIELD_INVALID;
+    if (trackedFrame->GetCustomFrameTransformStatus(this->FrameTransformNameForValidation, status) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to retrieve transform \'" << this->FrameTransformNameForValidation.GetTransformName() << "\' status.");
+    }
+    return status == FIELD_OK;
+  }
+
+  // The transform has to be computed from the transforms of the frame. The repository is reused,
+  // it only has to be cleared if the frame contains a different set of transforms than the previous one.
+  std::vector<PlusTransformName> transformNames;
+  trackedFrame->GetCustomFrameTransformNameList(transformNames);
+  if (transformNames != this->ValidationTransformRepositoryNames)
+  {
+    this->ValidationTransformRepository->Clear();
+    this->ValidationTransformRepositoryNames = transformNames;
+  }
+  this->ValidationTransformRepository->SetTransforms(*trackedFrame);
   bool isValid(false);
-  if (repo->GetTransformValid(this->FrameTransformNameForValidation, isValid) != PLUS_SUCCESS)
+  if (this->ValidationTransformRepository->GetTransformValid(this->FrameTransformNameForValidation, isValid) != PLUS_SUCCESS)
   {
     LOG_ERROR("Unable to retrieve transform \'" << this->FrameTransformNameForValidation.GetTransformName() << "\'.");
   }
-  repo->Delete();
 
   return isValid;
 }
@@ -367,12 +495,7 @@ bool vtkPlusTrackedFrameList::ValidateSpeed(PlusTrackedFrame* trackedFrame)
   }
 
   vtkSmartPointer<vtkMatrix4x4> inputTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  double inputTransformVector[16] = {0};
-  if (trackedFrame->GetCustomFrameTransform(this->FrameTransformNameForValidation, inputTransformVector))
-  {
-    inputTransformMatrix->DeepCopy(inputTransformVector);
-  }
-  else
+  if (this->GetValidationTransform(trackedFrame, inputTransformMatrix) != PLUS_SUCCESS)
   {
     std::string strFrameTransformName;
     this->FrameTransformNameForValidation.GetTransformName(strFrameTransformName);
@@ -381,12 +504,7 @@ bool vtkPlusTrackedFrameList::ValidateSpeed(PlusTrackedFrame* trackedFrame)
   }
 
   vtkSmartPointer<vtkMatrix4x4> latestTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  double latestTransformVector[16] = {0};
-  if ((*latestFrameInList)->GetCustomFrameTransform(this->FrameTransformNameForValidation, latestTransformVector))
-  {
-    latestTransformMatrix->DeepCopy(latestTransformVector);
-  }
-  else
+  if (this->GetValidationTransform(*latestFrameInList, latestTransformMatrix) != PLUS_SUCCESS)
   {
     LOG_ERROR("Unable to get default frame transform for latest frame!");
     return false;
@@ -419,6 +537,37 @@ bool vtkPlusTrackedFrameList::ValidateSpeed(PlusTrackedFrame* trackedFrame)
   return true;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusTrackedFrameList::GetValidationTransform(PlusTrackedFrame* trackedFrame, vtkMatrix4x4* transformMatrix)
+{
+  if (trackedFrame == this->ValidatedFrameTransform.Frame && this->ValidatedFrameTransformParsed)
+  {
+    transformMatrix->DeepCopy(this->ValidatedFrameTransform.Matrix);
+    return PLUS_SUCCESS;
+  }
+  for (std::deque<ValidationTransformCacheEntry>::reverse_iterator entryIt = this->ValidationTransformCache.rbegin(); entryIt != this->ValidationTransformCache.rend(); ++entryIt)
+  {
+    if (entryIt->Frame == trackedFrame)
+    {
+      transformMatrix->DeepCopy(entryIt->Matrix);
+      return PLUS_SUCCESS;
+    }
+  }
+
+  double transformVector[16] = {0};
+  if (trackedFrame->GetCustomFrameTransform(this->FrameTransformNameForValidation, transformVector) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  transformMatrix->DeepCopy(transformVector);
+  if (trackedFrame == this->ValidatedFrameTransform.Frame)
+  {
+    std::copy(transformVector, transformVector + 16, this->ValidatedFrameTransform.Matrix);
+    this->ValidatedFrameTransformParsed = true;
+  }
+  return PLUS_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 int vtkPlusTrackedFrameList::GetNumberOfBitsPerScalar()
 {
@@ -452,10 +601,11 @@ int vtkPlusTrackedFrameList::GetNumberOfBitsPerPixel()
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusTrackedFrameList::SaveToSequenceMetafile(const std::string& filename, US_IMAGE_ORIENTATION orientationInFile /*= US_IMG_ORIENT_MF*/, bool useCompression /*=true*/, bool enableImageDataWrite /*=true*/)
+PlusStatus vtkPlusTrackedFrameList::SaveToSequenceMetafile(const std::string& filename, US_IMAGE_ORIENTATION orientationInFile /*= US_IMG_ORIENT_MF*/, bool useCompression /*=true*/, bool enableImageDataWrite /*=true*/, bool parallelCompression /*=false*/)
 {
   vtkSmartPointer<vtkPlusMetaImageSequenceIO> writer = vtkSmartPointer<vtkPlusMetaImageSequenceIO>::New();
   writer->SetUseCompression(useCompression);
+  writer->SetParallelCompression(parallelCompression);
   writer->SetFileName(filename);
   writer->SetImageOrientationInFile(orientationInFile);
   writer->SetTrackedFrameList(this);
@@ -500,10 +650,11 @@ PlusStatus vtkPlusTrackedFrameList::ReadFromSequenceMetafile(const std::string&
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusTrackedFrameList::SaveToNrrdFile(const std::string& filename, US_IMAGE_ORIENTATION orientationInFile /*= US_IMG_ORIENT_MF*/, bool useCompression /*= true*/, bool enableImageDataWrite /*= true*/)
+PlusStatus vtkPlusTrackedFrameList::SaveToNrrdFile(const std::string& filename, US_IMAGE_ORIENTATION orientationInFile /*= US_IMG_ORIENT_MF*/, bool useCompression /*= true*/, bool enableImageDataWrite /*= true*/, bool parallelCompression /*= false*/)
 {
   vtkSmartPointer<vtkPlusNrrdSequenceIO> writer = vtkSmartPointer<vtkPlusNrrdSequenceIO>::New();
   writer->SetUseCompression(useCompression);
+  writer->SetParallelCompression(parallelCompression);
   writer->SetFileName(filename);
   writer->SetImageOrientationInFile(orientationInFile);
   writer->SetTrackedFrameList(this);
@@ -12,12 +12,16 @@
 
 #include "PlusVideoFrame.h" // for US_IMAGE_ORIENTATION
 #include "vtkObject.h"
+#include "vtkSmartPointer.h"
 
 #include <deque>
+#include <set>
+#include <vector>
 
 class vtkXMLDataElement;
 class PlusTrackedFrame;
 class vtkMatrix4x4;
+class vtkPlusTransformRepository;
 
 
 /*!
@@ -76,14 +80,14 @@ public:
   }
   virtual unsigned int Size() { return this->TrackedFrameList.size(); }
 
-  /*! Save the tracked data to sequence metafile */
-  PlusStatus SaveToSequenceMetafile(const std::string& filename, US_IMAGE_ORIENTATION orientationInFile = US_IMG_ORIENT_MF, bool useCompression = true, bool enableImageDataWrite = true);
+  /*! Save the tracked data to sequence metafile. If parallelCompression is enabled then blocks of frames are compressed in parallel. */
+  PlusStatus SaveToSequenceMetafile(const std::string& filename, US_IMAGE_ORIENTATION orientationInFile = US_IMG_ORIENT_MF, bool useCompression = true, bool enableImageDataWrite = true, bool parallelCompression = false);
 
   /*! Read the tracked data from sequence metafile */
   virtual PlusStatus ReadFromSequenceMetafile(const std::string& trackedSequenceDataFileName);
 
-  /*! Save the tracked data to Nrrd file */
-  PlusStatus SaveToNrrdFile(const std::string& filename, US_IMAGE_ORIENTATION orientationInFile = US_IMG_ORIENT_MF, bool useCompression = true, bool enableImageDataWrite = true);
+  /*! Save the tracked data to Nrrd file. If parallelCompression is enabled then blocks of frames are compressed in parallel. */
+  PlusStatus SaveToNrrdFile(const std::string& filename, US_IMAGE_ORIENTATION orientationInFile = US_IMG_ORIENT_MF, bool useCompression = true, bool enableImageDataWrite = true, bool parallelCompression = false);
 
   /*! Read the tracked data from Nrrd file */
   virtual PlusStatus ReadFromNrrdFile(const std::string& trackedSequenceDataFileName);
@@ -111,6 +115,12 @@ public:
   /*! Clear tracked frame list and free memory */
   virtual void Clear();
 
+  /*!
+    Discard the timestamp index and the parsed transforms that are used for validating new frames.
+    It has to be called if the timestamp or the validation transform of a frame in the list is modified.
+  */
+  void ResetValidationCache();
+
   /*! Set the number of following unique frames needed in the tracked frame list */
   vtkSetMacro(NumberOfUniqueFrames, int);
 
@@ -155,6 +165,7 @@ public:
   void SetFrameTransformNameForValidation(const PlusTransformName& aTransformName)
   {
     this->FrameTransformNameForValidation = aTransformName;
+    this->ResetValidationCache();
   }
 
   /*! Get frame transform name used for transform validation */
@@ -258,6 +269,25 @@ protected:
   bool ValidateEncoderPosition(PlusTrackedFrame* trackedFrame);
   bool ValidateSpeed(PlusTrackedFrame* trackedFrame);
 
+  /*!
+    Get the validation transform of a frame. The transform of the frame that is being validated and the transforms of
+    the most recent frames of the list are parsed only once.
+  */
+  PlusStatus GetValidationTransform(PlusTrackedFrame* trackedFrame, vtkMatrix4x4* transformMatrix);
+
+  /*! Update the timestamp index and the transform cache after a frame is added to the list */
+  void UpdateValidationCache(PlusTrackedFrame* validatedFrame, PlusTrackedFrame* addedFrame);
+
+  /*! Remove a frame from the timestamp index and the transform cache before it is deleted */
+  void RemoveFromValidationCache(PlusTrackedFrame* removedFrame);
+
+  /*! Parsed validation transform of a frame */
+  struct ValidationTransformCacheEntry
+  {
+    PlusTrackedFrame* Frame;
+    double Matrix[16];
+  };
+
   TrackedFrameListType TrackedFrameList;
   FieldMapType CustomFields;
 
@@ -275,6 +305,21 @@ protected:
   long ValidationRequirements;
   PlusTransformName FrameTransformNameForValidation;
 
+  /*! Timestamps of all frames in the list, for checking uniqueness in logarithmic time. Built at the first timestamp validation. */
+  std::multiset<double> TimestampIndex;
+  bool TimestampIndexValid;
+
+  /*! Parsed validation transforms of the most recently added frames, in the order of the frames in the list */
+  std::deque<ValidationTransformCacheEntry> ValidationTransformCache;
+  /*! Parsed validation transform of the frame that is currently being validated */
+  ValidationTransformCacheEntry ValidatedFrameTransform;
+  bool ValidatedFrameTransformParsed;
+
+  /*! Transform repository for checking the status of validation transforms that are computed from other transforms */
+  vtkSmartPointer<vtkPlusTransformRepository> ValidationTransformRepository;
+  /*! Transforms that are currently set in ValidationTransformRepository */
+  std::vector<PlusTransformName> ValidationTransformRepositoryNames;
+
 private:
   vtkPlusTrackedFrameList(const vtkPlusTrackedFrameList&);
   void operator=(const vtkPlusTrackedFrameList&);
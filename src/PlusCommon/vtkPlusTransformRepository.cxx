@@ -6,12 +6,15 @@
 
 #include "PlusConfigure.h"
 #include "PlusTrackedFrame.h"
+#include "vtkMatrix4x4.h"
 #include "vtkObjectFactory.h"
 #include "vtkPlusRecursiveCriticalSection.h"
 #include "vtkTransform.h"
 #include "vtkPlusTransformRepository.h"
 #include "vtksys/SystemTools.hxx"
 
+#include <algorithm>
+
 //----------------------------------------------------------------------------
 
 vtkStandardNewMacro(vtkPlusTransformRepository);
@@ -73,9 +76,18 @@ vtkPlusTransformRepository::TransformInfo& vtkPlusTransformRepository::Transform
   return *this;
 }
 
+//----------------------------------------------------------------------------
+vtkPlusTransformRepository::TransformPlan::TransformPlan()
+  : m_ResultEpoch(0)
+  , m_IsValid(false)
+{
+  vtkMatrix4x4::Identity(m_Matrix);
+}
+
 //----------------------------------------------------------------------------
 vtkPlusTransformRepository::vtkPlusTransformRepository()
-  : CriticalSection(vtkPlusRecursiveCriticalSection::New())
+  : UpdateEpoch(1)
+  , CriticalSection(vtkPlusRecursiveCriticalSection::New())
 {
 
 }
@@ -211,6 +223,8 @@ PlusStatus vtkPlusTransformRepository::SetTransform(const PlusTransformName& aTr
     }
 
     // This is an original transform that already exists, just update it
+    // The topology is unchanged, so the compiled paths remain usable, only the memoized results have to be recomputed
+    this->UpdateEpoch++;
     // Update the matrix (the inverse matrix is automatically updated using vtkTransform pipeline)
     if (matrix != NULL)
     {
@@ -243,6 +257,9 @@ PlusStatus vtkPlusTransformRepository::SetTransform(const PlusTransformName& aTr
     return PLUS_FAIL;
   }
 
+  // A new edge is added to the transform graph, the compiled paths have to be searched again
+  this->InvalidateTransformPlans();
+
   // Create the from->to transform
   CoordFrameToTransformMapType& fromCoordFrame = this->CoordinateFrames[aTransformName.From()];
   fromCoordFrame[aTransformName.To()].m_IsComputed = false;
@@ -298,40 +315,85 @@ PlusStatus vtkPlusTransformRepository::GetTransform(const PlusTransformName& aTr
   PlusLockGuard<vtkPlusRecursiveCriticalSection> accessGuard(this->CriticalSection);
 
   // Check if we can find the transform by combining the input transforms
-  // To improve performance the already found paths could be stored in a map of transform name -> transformInfoList
-  TransformInfoListType transformInfoList;
-  if (FindPath(aTransformName, transformInfoList) != PLUS_SUCCESS)
+  TransformPlan* plan = GetTransformPlan(aTransformName);
+  if (plan == NULL)
   {
     // the transform cannot be computed, error has been already logged by FindPath
-    *isValid = false;
+    if (isValid != NULL)
+    {
+      (*isValid) = false;
+    }
     return PLUS_FAIL;
   }
 
-  // Create transform chain and compute transform status
-  vtkSmartPointer<vtkTransform> combinedTransform = vtkSmartPointer<vtkTransform>::New();
-  bool combinedTransformValid(true);
-  for (TransformInfoListType::iterator transformInfo = transformInfoList.begin(); transformInfo != transformInfoList.end(); ++transformInfo)
+  if (plan->m_ResultEpoch != this->UpdateEpoch)
   {
-    combinedTransform->Concatenate((*transformInfo)->m_Transform);
-    if (!(*transformInfo)->m_IsValid)
+    // Transforms have been changed since the last evaluation, compute the transform chain and transform status
+    double combinedMatrix[16];
+    vtkMatrix4x4::Identity(combinedMatrix);
+    bool combinedTransformValid(true);
+    for (std::vector<TransformInfo*>::iterator transformInfo = plan->m_Path.begin(); transformInfo != plan->m_Path.end(); ++transformInfo)
     {
-      combinedTransformValid = false;
+      double transformMatrix[16];
+      vtkMatrix4x4::DeepCopy(transformMatrix, (*transformInfo)->m_Transform->GetMatrix());
+      double product[16];
+      vtkMatrix4x4::Multiply4x4(combinedMatrix, transformMatrix, product);
+      std::copy(product, product + 16, combinedMatrix);
+      if (!(*transformInfo)->m_IsValid)
+      {
+        combinedTransformValid = false;
+      }
     }
+    std::copy(combinedMatrix, combinedMatrix + 16, plan->m_Matrix);
+    plan->m_IsValid = combinedTransformValid;
+    plan->m_ResultEpoch = this->UpdateEpoch;
   }
+
   // Save the results
   if (matrix != NULL)
   {
-    matrix->DeepCopy(combinedTransform->GetMatrix());
+    matrix->DeepCopy(plan->m_Matrix);
   }
 
   if (isValid != NULL)
   {
-    (*isValid) = combinedTransformValid;
+    (*isValid) = plan->m_IsValid;
   }
 
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+vtkPlusTransformRepository::TransformPlan* vtkPlusTransformRepository::GetTransformPlan(const PlusTransformName& aTransformName, bool silent /*=false*/)
+{
+  std::pair<std::string, std::string> planKey(aTransformName.From(), aTransformName.To());
+  TransformPlanMapType::iterator planIt = this->TransformPlans.find(planKey);
+  if (planIt != this->TransformPlans.end())
+  {
+    return &(planIt->second);
+  }
+
+  TransformInfoListType transformInfoList;
+  if (FindPath(aTransformName, transformInfoList, NULL, silent) != PLUS_SUCCESS)
+  {
+    // Missing paths are not cached, they are expected to be rare and they may be logged
+    return NULL;
+  }
+
+  // TransformInfo objects are stored in std::map nodes, so the pointers remain valid until a transform is removed,
+  // which invalidates all the plans
+  TransformPlan& plan = this->TransformPlans[planKey];
+  plan.m_Path.assign(transformInfoList.begin(), transformInfoList.end());
+  return &plan;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTransformRepository::InvalidateTransformPlans()
+{
+  this->TransformPlans.clear();
+  this->UpdateEpoch++;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusTransformRepository::GetTransformValid(const PlusTransformName& aTransformName, bool& isValid)
 {
@@ -552,8 +614,7 @@ PlusStatus vtkPlusTransformRepository::IsExistingTransform(PlusTransformName aTr
     return PLUS_SUCCESS;
   }
   PlusLockGuard<vtkPlusRecursiveCriticalSection> accessGuard(this->CriticalSection);
-  TransformInfoListType transformInfoList;
-  return FindPath(aTransformName, transformInfoList, NULL, aSilent);
+  return (GetTransformPlan(aTransformName, aSilent) != NULL ? PLUS_SUCCESS : PLUS_FAIL);
 }
 
 //----------------------------------------------------------------------------
@@ -567,6 +628,9 @@ PlusStatus vtkPlusTransformRepository::DeleteTransform(const PlusTransformName&
 
   PlusLockGuard<vtkPlusRecursiveCriticalSection> accessGuard(this->CriticalSection);
 
+  // Compiled paths may refer to the transforms that are about to be erased
+  this->InvalidateTransformPlans();
+
   CoordFrameToTransformMapType& fromCoordFrame = this->CoordinateFrames[aTransformName.From()];
   CoordFrameToTransformMapType::iterator fromToTransformInfoIt = fromCoordFrame.find(aTransformName.To());
 
@@ -608,6 +672,8 @@ PlusStatus vtkPlusTransformRepository::DeleteTransform(const PlusTransformName&
 //----------------------------------------------------------------------------
 void vtkPlusTransformRepository::Clear()
 {
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> accessGuard(this->CriticalSection);
+  this->InvalidateTransformPlans();
   this->CoordinateFrames.clear();
 }
 
@@ -12,6 +12,7 @@ See License.txt for details.
 #include "vtkObject.h"
 #include <list>
 #include <map>
+#include <vector>
 
 class PlusTrackedFrame;
 class vtkMatrix4x4;
@@ -189,6 +190,29 @@ protected:
   /*! List of transforms */
   typedef std::list<TransformInfo*> TransformInfoListType;
 
+  /*!
+    \class TransformPlan
+    \brief Transform path compiled for a (from, to) coordinate frame pair and the memoized result of its last evaluation
+    \ingroup PlusLibCommon
+  */
+  class TransformPlan
+  {
+  public:
+    TransformPlan();
+
+    /*! Transforms that have to be concatenated (in this order) to get the from->to transform */
+    std::vector<TransformInfo*> m_Path;
+    /*! Value of the repository update epoch when m_Matrix and m_IsValid were computed (0 if not computed yet) */
+    unsigned long m_ResultEpoch;
+    /*! Memoized combined transform matrix */
+    double m_Matrix[16];
+    /*! Memoized combined transform validity */
+    bool m_IsValid;
+  };
+
+  /*! For each (from, to) coordinate frame name pair stores the compiled transform path */
+  typedef std::map<std::pair<std::string, std::string>, TransformPlan> TransformPlanMapType;
+
   /*! Get a user-defined original input transform (or its inverse). Does not combine user-defined input transforms. */
   TransformInfo* GetOriginalTransform(const PlusTransformName& aTransformName);
 
@@ -202,8 +226,24 @@ protected:
   */
   PlusStatus FindPath(const PlusTransformName& aTransformName, TransformInfoListType& transformInfoList, const char* skipCoordFrameName = NULL, bool silent = false);
 
+  /*!
+    Get the compiled transform path between the specified coordinate frames. The path is searched by FindPath
+    the first time the transform is requested and then reused until the topology of the transform graph changes.
+    \return the compiled plan or NULL if no path can be found
+  */
+  TransformPlan* GetTransformPlan(const PlusTransformName& aTransformName, bool silent = false);
+
+  /*! Discard all the compiled transform paths. Must be called whenever a transform is added or removed. */
+  void InvalidateTransformPlans();
+
   CoordFrameToCoordFrameToTransformMapType CoordinateFrames;
 
+  /*! Compiled transform paths */
+  TransformPlanMapType TransformPlans;
+
+  /*! Incremented whenever any transform matrix or status changes. Memoized transform plan results are valid only within the same epoch. */
+  unsigned long UpdateEpoch;
+
   vtkPlusRecursiveCriticalSection* CriticalSection;
 
   TransformInfo TransformToSelf;
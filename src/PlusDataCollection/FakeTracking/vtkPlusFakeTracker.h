@@ -60,6 +60,8 @@ public:
 
   virtual bool IsTracker() const { return true; }
 
+  virtual bool IsParallelConnectSafe() const { return true; }
+
   /*! Set counter value used for translating landmark points */
   vtkSetMacro(Counter, int);
 
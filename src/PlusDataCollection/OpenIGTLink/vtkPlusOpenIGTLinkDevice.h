@@ -47,6 +47,9 @@ public:
   /*! Write configuration to xml data */
   virtual PlusStatus WriteConfiguration(vtkXMLDataElement* config);
 
+  /*! Only opens a socket when connecting, so it can be connected in parallel with other devices */
+  virtual bool IsParallelConnectSafe() const { return true; }
+
   /*! Send a message to the connected server */
   bool SendMessage(igtl::MessageBase::Pointer packedMessage);
 
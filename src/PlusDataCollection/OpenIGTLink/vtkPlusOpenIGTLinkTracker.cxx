@@ -15,6 +15,8 @@ See License.txt for details.
 #include "vtkPlusDataSource.h"
 #include "vtkPlusIgtlMessageCommon.h"
 
+#include <string.h>
+
 vtkStandardNewMacro(vtkPlusOpenIGTLinkTracker);
 
 //----------------------------------------------------------------------------
@@ -22,6 +24,7 @@ vtkPlusOpenIGTLinkTracker::vtkPlusOpenIGTLinkTracker()
   : TrackerInternalCoordinateSystemName(NULL)
   , UseLastTransformsOnReceiveTimeout(false)
   , IgtlMessageFactory(vtkSmartPointer<vtkPlusIgtlMessageFactory>::New())
+  , MulticastPort(-1)
 {
   SetTrackerInternalCoordinateSystemName("Reference");
 }
@@ -38,10 +41,40 @@ void vtkPlusOpenIGTLinkTracker::PrintSelf(ostream& os, vtkIndent indent)
   Superclass::PrintSelf(os, indent);
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkTracker::InternalConnect()
+{
+  if (!this->IsMulticastEnabled())
+  {
+    return Superclass::InternalConnect();
+  }
+
+  LOG_TRACE("vtkPlusOpenIGTLinkTracker::InternalConnect (multicast)");
+
+  // Clear buffers on connect
+  this->ClearAllBuffers();
+
+  int multicastPort = (this->MulticastPort < 0 ? this->ServerPort : this->MulticastPort);
+  if (this->MulticastChannel.OpenReceiver(this->MulticastGroupAddress, multicastPort, this->MulticastInterfaceAddress) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Cannot join multicast group (" << this->MulticastGroupAddress << ":" << multicastPort << ").");
+    return PLUS_FAIL;
+  }
+  LOG_DEBUG("Tracker joined multicast group (" << this->MulticastGroupAddress << ":" << multicastPort << ").");
+  return PLUS_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusOpenIGTLinkTracker::InternalDisconnect()
 {
   LOG_TRACE("vtkPlusOpenIGTLinkTracker::Disconnect");
+  if (this->IsMulticastEnabled())
+  {
+    // There is no connection to the server, nothing to stop
+    this->MulticastChannel.Close();
+    return this->StopRecording();
+  }
+
   if (this->IsTDataMessageType())
   {
     // If we need TDATA, request server to stop streaming.
@@ -78,7 +111,11 @@ PlusStatus vtkPlusOpenIGTLinkTracker::InternalUpdate()
     return PLUS_FAIL;
   }
 
-  if (this->IsTDataMessageType())
+  if (this->IsMulticastEnabled())
+  {
+    return this->InternalUpdateMulticast();
+  }
+  else if (this->IsTDataMessageType())
   {
     return this->InternalUpdateTData();
   }
@@ -157,6 +194,12 @@ PlusStatus vtkPlusOpenIGTLinkTracker::InternalUpdateTData()
     return PLUS_FAIL;
   }
 
+  return this->ProcessTrackingDataMessage(tdataMsg);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkTracker::ProcessTrackingDataMessage(igtl::TrackingDataMessage* tdataMsg)
+{
   // for now just use system time, all coordinates will be sequential.
   double unfilteredTimestamp = vtkPlusAccurateTimer::GetSystemTime();
   double filteredTimestamp = unfilteredTimestamp; // No need to filter already filtered timestamped items received over OpenIGTLink
@@ -317,6 +360,12 @@ PlusStatus vtkPlusOpenIGTLinkTracker::ProcessTransformMessageGeneral(bool& moreM
     return PLUS_SUCCESS;
   }
 
+  return this->StoreReceivedTransform(igtlTransformName, toolMatrix, unfilteredTimestampUtc);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkTracker::StoreReceivedTransform(const std::string& igtlTransformName, vtkMatrix4x4* toolMatrix, double unfilteredTimestampUtc)
+{
   // Set transform name
   PlusTransformName transformName;
   if (transformName.SetTransformName(igtlTransformName.c_str()) != PLUS_SUCCESS)
@@ -352,6 +401,138 @@ PlusStatus vtkPlusOpenIGTLinkTracker::ProcessTransformMessageGeneral(bool& moreM
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkTracker::InternalUpdateMulticast()
+{
+  LOG_TRACE("vtkPlusOpenIGTLinkTracker::InternalUpdateMulticast");
+
+  double unfilteredTimestamp = vtkPlusAccurateTimer::GetSystemTime();
+
+  double maxAllocatedProcessingTime = 2.0;
+  // set maxAllocatedProcessingTime to 2 acquisition periods to allow reading all transforms even when there are slight delays
+  if (this->GetAcquisitionRate() > 2.0 / maxAllocatedProcessingTime)
+  {
+    maxAllocatedProcessingTime = 2.0 / this->GetAcquisitionRate();
+  }
+
+  // Wait for the first message for at most one acquisition period, then process the messages that have already arrived.
+  // Lost messages are not waited for: the next message contains more recent data anyway.
+  double receiveTimeoutSec = this->ReceiveTimeoutSec;
+  if (this->GetAcquisitionRate() > 1.0 / receiveTimeoutSec)
+  {
+    receiveTimeoutSec = 1.0 / this->GetAcquisitionRate();
+  }
+  unsigned int numberOfLostMessages = 0;
+  while (this->MulticastChannel.Receive(this->MulticastMessageData, receiveTimeoutSec, &numberOfLostMessages) == PLUS_SUCCESS)
+  {
+    if (numberOfLostMessages > 0)
+    {
+      LOG_DEBUG(numberOfLostMessages << " multicast messages were lost in device " << this->GetDeviceId());
+    }
+    // Errors are logged, but the other messages are still processed
+    this->ProcessMulticastMessage(this->MulticastMessageData);
+
+    receiveTimeoutSec = 0;
+    if (vtkPlusAccurateTimer::GetSystemTime() - unfilteredTimestamp > maxAllocatedProcessingTime)
+    {
+      // no more time for processing messages in this iteration
+      break;
+    }
+  }
+
+  if (this->UseLastTransformsOnReceiveTimeout)
+  {
+    // Store all the other transforms with the last known value
+    // that has not been updated in this update iteration
+    StoreMostRecentTransformValues(unfilteredTimestamp);
+  }
+  else
+  {
+    // Set all those transforms to invalid that contains stale transform values
+    StoreInvalidTransforms(unfilteredTimestamp);
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkTracker::ProcessMulticastMessage(const std::vector<unsigned char>& messageData)
+{
+  igtl::MessageHeader::Pointer headerMsg = this->MessageFactory->CreateHeaderMessage(IGTL_HEADER_VERSION_1);
+  size_t headerSize = headerMsg->GetBufferSize();
+  if (messageData.size() < headerSize)
+  {
+    LOG_DEBUG("Ignored incomplete multicast message in device " << this->GetDeviceId());
+    return PLUS_FAIL;
+  }
+  memcpy(headerMsg->GetBufferPointer(), &messageData[0], headerSize);
+  headerMsg->Unpack(this->IgtlMessageCrcCheckEnabled);
+  if (messageData.size() != headerSize + headerMsg->GetBodySizeToRead())
+  {
+    LOG_DEBUG("Ignored multicast message with inconsistent size in device " << this->GetDeviceId());
+    return PLUS_FAIL;
+  }
+
+  igtl::MessageBase::Pointer bodyMsg = this->IgtlMessageFactory->CreateReceiveMessage(headerMsg);
+  if (bodyMsg.IsNull()
+      || (typeid(*bodyMsg) != typeid(igtl::TransformMessage) && typeid(*bodyMsg) != typeid(igtl::PositionMessage) && typeid(*bodyMsg) != typeid(igtl::TrackingDataMessage)))
+  {
+    // Only tracking data is processed
+    return PLUS_SUCCESS;
+  }
+
+  bodyMsg->SetMessageHeader(headerMsg);
+  bodyMsg->AllocateBuffer();
+  memcpy(bodyMsg->GetBufferBodyPointer(), &messageData[headerSize], bodyMsg->GetBufferBodySize());
+  int c = bodyMsg->Unpack(this->IgtlMessageCrcCheckEnabled);
+  if (!(c & igtl::MessageHeader::UNPACK_BODY))
+  {
+    LOG_ERROR("Couldn't unpack " << headerMsg->GetMessageType() << " message received from multicast group!");
+    return PLUS_FAIL;
+  }
+
+  if (typeid(*bodyMsg) == typeid(igtl::TrackingDataMessage))
+  {
+    return this->ProcessTrackingDataMessage(dynamic_cast<igtl::TrackingDataMessage*>(bodyMsg.GetPointer()));
+  }
+
+  igtl::Matrix4x4 igtlMatrix;
+  igtl::IdentityMatrix(igtlMatrix);
+  if (typeid(*bodyMsg) == typeid(igtl::TransformMessage))
+  {
+    igtl::TransformMessage* transformMsg = dynamic_cast<igtl::TransformMessage*>(bodyMsg.GetPointer());
+    transformMsg->GetMatrix(igtlMatrix);
+  }
+  else
+  {
+    igtl::PositionMessage* positionMsg = dynamic_cast<igtl::PositionMessage*>(bodyMsg.GetPointer());
+    float position[3] = {0};
+    positionMsg->GetPosition(position);
+    float quaternion[4] = {0, 0, 0, 1};
+    positionMsg->GetQuaternion(quaternion);
+    igtl::QuaternionToMatrix(quaternion, igtlMatrix);
+    for (int r = 0; r < 3; r++)
+    {
+      igtlMatrix[r][3] = position[r];
+    }
+  }
+
+  // convert igtl matrix to vtk matrix
+  vtkSmartPointer<vtkMatrix4x4> toolMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (int r = 0; r < 4; r++)
+  {
+    for (int c = 0; c < 4; c++)
+    {
+      toolMatrix->SetElement(r, c, igtlMatrix[r][c]);
+    }
+  }
+
+  igtl::TimeStamp::Pointer igtlTimestamp = igtl::TimeStamp::New();
+  bodyMsg->GetTimeStamp(igtlTimestamp);
+
+  return this->StoreReceivedTransform(bodyMsg->GetDeviceName(), toolMatrix, igtlTimestamp->GetTimeStamp());
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusOpenIGTLinkTracker::SendRequestedMessageTypes()
 {
@@ -483,6 +664,9 @@ PlusStatus vtkPlusOpenIGTLinkTracker::ReadConfiguration(vtkXMLDataElement* rootC
   XML_FIND_DEVICE_ELEMENT_REQUIRED_FOR_READING(deviceConfig, rootConfigElement);
   XML_READ_CSTRING_ATTRIBUTE_OPTIONAL(TrackerInternalCoordinateSystemName, deviceConfig);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(UseLastTransformsOnReceiveTimeout, deviceConfig);
+  XML_READ_STRING_ATTRIBUTE_OPTIONAL(MulticastGroupAddress, deviceConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, MulticastPort, deviceConfig);
+  XML_READ_STRING_ATTRIBUTE_OPTIONAL(MulticastInterfaceAddress, deviceConfig);
   return PLUS_SUCCESS;
 }
 
@@ -492,6 +676,12 @@ PlusStatus vtkPlusOpenIGTLinkTracker::WriteConfiguration(vtkXMLDataElement* root
   XML_FIND_DEVICE_ELEMENT_REQUIRED_FOR_WRITING(deviceConfig, rootConfigElement);
   deviceConfig->SetAttribute("TrackerInternalCoordinateSystemName", this->TrackerInternalCoordinateSystemName);
   deviceConfig->SetAttribute("UseLastTransformsOnReceiveTimeout", this->UseLastTransformsOnReceiveTimeout ? "true" : "false");
+  if (this->IsMulticastEnabled())
+  {
+    deviceConfig->SetAttribute("MulticastGroupAddress", this->MulticastGroupAddress.c_str());
+    deviceConfig->SetIntAttribute("MulticastPort", this->MulticastPort);
+    XML_WRITE_STRING_ATTRIBUTE_IF_NOT_EMPTY(MulticastInterfaceAddress, deviceConfig);
+  }
   return PLUS_SUCCESS;
 }
 
@@ -504,3 +694,15 @@ bool vtkPlusOpenIGTLinkTracker::IsTDataMessageType()
   }
   return (std::string(this->MessageType).compare("TDATA") == 0);
 }
+
+//----------------------------------------------------------------------------
+bool vtkPlusOpenIGTLinkTracker::IsMulticastEnabled() const
+{
+  return !this->MulticastGroupAddress.empty();
+}
+
+//----------------------------------------------------------------------------
+uint64_t vtkPlusOpenIGTLinkTracker::GetNumberOfLostMulticastMessages() const
+{
+  return this->MulticastChannel.GetNumberOfLostMessages();
+}
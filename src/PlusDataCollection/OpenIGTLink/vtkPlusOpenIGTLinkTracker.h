@@ -11,11 +11,23 @@
 #include "vtkPlusDataCollectionExport.h"
 #include "vtkPlusOpenIGTLinkDevice.h"
 #include "vtkPlusIgtlMessageFactory.h"
+#include "PlusIgtlMulticastChannel.h"
+
+class vtkMatrix4x4;
+
+namespace igtl
+{
+  class TrackingDataMessage;
+}
 
 /*!
 \class vtkPlusOpenIGTLinkTracker
 \brief OpenIGTLink tracker client
 
+If MulticastGroupAddress is set then the tracker does not connect to the server, but receives
+TRANSFORM, POSITION, and TDATA messages from the multicast group (see PlusIgtlMulticastChannel).
+Lost messages are not waited for and late messages are dropped.
+
 \ingroup PlusLibDataCollection
 */
 class vtkPlusDataCollectionExport vtkPlusOpenIGTLinkTracker : public vtkPlusOpenIGTLinkDevice
@@ -25,6 +37,9 @@ public:
   vtkTypeMacro( vtkPlusOpenIGTLinkTracker, vtkPlusOpenIGTLinkDevice );
   virtual void PrintSelf( ostream& os, vtkIndent indent );
 
+  /*! Connect to device (or join the multicast group) */
+  virtual PlusStatus InternalConnect();
+
   /*! Disconnect from device */
   virtual PlusStatus InternalDisconnect();
 
@@ -50,6 +65,21 @@ public:
   /*! Get the internal tracker coordinate system name */
   vtkGetStringMacro( TrackerInternalCoordinateSystemName );
 
+  /*! Multicast group to receive the tracking data from. If empty then the data is received through the connection to the server. */
+  vtkSetStdStringMacro( MulticastGroupAddress );
+  vtkGetStdStringMacro( MulticastGroupAddress );
+
+  /*! UDP port of the multicast group. If negative then the server port is used. */
+  vtkSetMacro( MulticastPort, int );
+  vtkGetMacro( MulticastPort, int );
+
+  /*! Address of the network interface for receiving multicast messages. If empty then the default interface is used. */
+  vtkSetStdStringMacro( MulticastInterfaceAddress );
+  vtkGetStdStringMacro( MulticastInterfaceAddress );
+
+  /*! Get the number of multicast messages that were lost since connecting */
+  uint64_t GetNumberOfLostMulticastMessages() const;
+
 protected:
   vtkPlusOpenIGTLinkTracker();
   virtual ~vtkPlusOpenIGTLinkTracker();
@@ -67,6 +97,20 @@ protected:
   /*! Process a TDATA message (add all the received transforms to the buffers) */
   PlusStatus InternalUpdateTData();
 
+  /*! Add all the transforms of an unpacked TDATA message to the buffers */
+  PlusStatus ProcessTrackingDataMessage( igtl::TrackingDataMessage* tdataMsg );
+
+  /*! Add a transform received in a TRANSFORM or POSITION message to the buffer */
+  PlusStatus StoreReceivedTransform( const std::string& igtlTransformName, vtkMatrix4x4* toolMatrix, double unfilteredTimestampUtc );
+
+  /*! Process all TRANSFORM, POSITION, and TDATA messages received from the multicast group */
+  PlusStatus InternalUpdateMulticast();
+
+  /*! Unpack and process a single message received from the multicast group */
+  PlusStatus ProcessMulticastMessage( const std::vector<unsigned char>& messageData );
+
+  bool IsMulticastEnabled() const;
+
   /*!
     Store the latest transforms again in the buffers with the provided timestamp.
     If no transforms are defined then identity transform will be stored.
@@ -95,6 +139,21 @@ protected:
   /*! igtl Factory for message handling */
   vtkSmartPointer<vtkPlusIgtlMessageFactory> IgtlMessageFactory;
 
+  /*! Multicast group address, empty if tracking data is received from the server connection */
+  std::string MulticastGroupAddress;
+
+  /*! UDP port of the multicast group (negative: same as the server port) */
+  int MulticastPort;
+
+  /*! Network interface for receiving multicast messages */
+  std::string MulticastInterfaceAddress;
+
+  /*! Multicast receiver, only used by the tracker thread while connected */
+  PlusIgtlMulticastChannel MulticastChannel;
+
+  /*! Buffer for the received multicast message */
+  std::vector<unsigned char> MulticastMessageData;
+
 private:
   vtkPlusOpenIGTLinkTracker( const vtkPlusOpenIGTLinkTracker& );
   void operator=( const vtkPlusOpenIGTLinkTracker& );
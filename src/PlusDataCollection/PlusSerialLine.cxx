@@ -7,11 +7,109 @@
 #include "PlusConfigure.h"
 #include "PlusSerialLine.h"
 
+#ifndef _WIN32
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <poll.h>
+  #include <string.h>
+  #include <sys/ioctl.h>
+  #include <termios.h>
+  #include <unistd.h>
+  #if defined(__linux__)
+    #include <linux/serial.h>
+  #endif
+#endif
+
+#ifndef _WIN32
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Returns the termios speed constant corresponding to a baud rate, B0 if the baud rate is not supported
+  speed_t GetTermiosSpeed(SerialLine::DWORD speed)
+  {
+    switch (speed)
+    {
+      case 1200: return B1200;
+      case 2400: return B2400;
+      case 4800: return B4800;
+      case 9600: return B9600;
+      case 19200: return B19200;
+      case 38400: return B38400;
+      case 57600: return B57600;
+      case 115200: return B115200;
+      case 230400: return B230400;
+#ifdef B460800
+      case 460800: return B460800;
+#endif
+#ifdef B921600
+      case 921600: return B921600;
+#endif
+      default: return B0;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Returns the number of milliseconds left until the deadline (0 if the deadline has passed)
+  int GetRemainingTimeMsec(const struct timespec& deadline)
+  {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long remainingMsec = (deadline.tv_sec - now.tv_sec) * 1000LL + (deadline.tv_nsec - now.tv_nsec) / 1000000LL;
+    return remainingMsec > 0 ? static_cast<int>(remainingMsec) : 0;
+  }
+
+  //----------------------------------------------------------------------------
+  struct timespec GetDeadline(int timeoutMsec)
+  {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeoutMsec / 1000;
+    deadline.tv_nsec += (timeoutMsec % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+      deadline.tv_sec += 1;
+      deadline.tv_nsec -= 1000000000L;
+    }
+    return deadline;
+  }
+
+  //----------------------------------------------------------------------------
+  // Waits until the requested event (POLLIN or POLLOUT) is signaled on the file descriptor or the deadline is reached.
+  // Returns false on timeout or error.
+  bool WaitForEvent(int fd, short events, const struct timespec& deadline)
+  {
+    while (true)
+    {
+      struct pollfd pfd;
+      pfd.fd = fd;
+      pfd.events = events;
+      pfd.revents = 0;
+      int result = poll(&pfd, 1, GetRemainingTimeMsec(deadline));
+      if (result > 0)
+      {
+        return (pfd.revents & events) != 0;
+      }
+      if (result == 0)
+      {
+        // timeout
+        return false;
+      }
+      if (errno != EINTR)
+      {
+        return false;
+      }
+      // interrupted by a signal, wait for the remaining time
+    }
+  }
+}
+#endif
+
 //----------------------------------------------------------------------------
 SerialLine::SerialLine()
   : MaxReplyTime(1000)
   , SerialPortSpeed(9600)
   , CommHandle(INVALID_HANDLE_VALUE)
+  , LowLatencyEnabled(false)
 {
 
 }
@@ -33,6 +131,11 @@ void SerialLine::Close()
   {
     CloseHandle(CommHandle);
   }
+#else
+  if (CommHandle != INVALID_HANDLE_VALUE)
+  {
+    close(CommHandle);
+  }
 #endif
   CommHandle = INVALID_HANDLE_VALUE;
 }
@@ -90,9 +193,76 @@ bool SerialLine::Open()
 
   return true;
 #else
-  LOG_ERROR("SerialLine::Open() is only implemented on Windows");
-  CommHandle = INVALID_HANDLE_VALUE;
-  return false;
+  speed_t speed = GetTermiosSpeed(SerialPortSpeed);
+  if (speed == B0)
+  {
+    LOG_ERROR("Serial port speed " << SerialPortSpeed << " is not supported");
+    return false;
+  }
+
+  // The port is opened in non-blocking mode, reads and writes wait for data using poll()
+  CommHandle = open(this->PortName.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (CommHandle == INVALID_HANDLE_VALUE)
+  {
+    LOG_ERROR("Failed to open serial port " << this->PortName << ": " << strerror(errno));
+    return false;
+  }
+
+  // Not allowed to share ports
+  if (ioctl(CommHandle, TIOCEXCL) != 0)
+  {
+    LOG_DEBUG("Failed to get exclusive access to serial port " << this->PortName << ": " << strerror(errno));
+  }
+
+  // Raw mode, 8 data bits, no parity, one stop bit, no flow control
+  struct termios options;
+  if (tcgetattr(CommHandle, &options) != 0)
+  {
+    LOG_ERROR("Failed to get serial port attributes of " << this->PortName << ": " << strerror(errno));
+    Close();
+    return false;
+  }
+  cfmakeraw(&options);
+  options.c_cflag &= ~(CSIZE | PARENB | CSTOPB | CRTSCTS);
+  options.c_cflag |= CS8 | CLOCAL | CREAD;
+  options.c_iflag &= ~(IXON | IXOFF | IXANY);
+  options.c_cc[VMIN] = 0;
+  options.c_cc[VTIME] = 0;
+  cfsetispeed(&options, speed);
+  cfsetospeed(&options, speed);
+  if (tcsetattr(CommHandle, TCSANOW, &options) != 0)
+  {
+    LOG_ERROR("Failed to set serial port attributes of " << this->PortName << ": " << strerror(errno));
+    Close();
+    return false;
+  }
+
+  if (LowLatencyEnabled)
+  {
+#if defined(__linux__) && defined(ASYNC_LOW_LATENCY)
+    // Ask the driver to push received bytes immediately instead of buffering them (mainly for USB-serial adapters)
+    struct serial_struct serialInfo;
+    if (ioctl(CommHandle, TIOCGSERIAL, &serialInfo) == 0)
+    {
+      serialInfo.flags |= ASYNC_LOW_LATENCY;
+      if (ioctl(CommHandle, TIOCSSERIAL, &serialInfo) != 0)
+      {
+        LOG_INFO("Low latency mode could not be enabled on serial port " << this->PortName << ": " << strerror(errno));
+      }
+    }
+    else
+    {
+      LOG_INFO("Low latency mode is not supported by serial port " << this->PortName);
+    }
+#else
+    LOG_INFO("Low latency mode is not supported on this platform");
+#endif
+  }
+
+  // Discard any data that was received or queued before the port was opened
+  tcflush(CommHandle, TCIOFLUSH);
+
+  return true;
 #endif
 }
 
@@ -129,8 +299,35 @@ int SerialLine::Write(const BYTE* data, int numberOfBytesToWrite)
   }
   return numberOfBytesWrittenTotal;
 #else
-  LOG_ERROR("SerialLine::Write() is only implemented on Windows");
-  return 0;
+  // Write as much data as possible until the max reply time is reached
+  struct timespec deadline = GetDeadline(MaxReplyTime);
+  int numberOfBytesWrittenTotal = 0;
+  while (numberOfBytesToWrite > 0)
+  {
+    ssize_t numberOfBytesWritten = write(CommHandle, &data[numberOfBytesWrittenTotal], numberOfBytesToWrite);
+    if (numberOfBytesWritten < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+      {
+        LOG_ERROR("Failed to write to serial port " << this->PortName << ": " << strerror(errno));
+        return numberOfBytesWrittenTotal;
+      }
+      // output buffer is full, wait until it can accept more data
+      if (!WaitForEvent(CommHandle, POLLOUT, deadline))
+      {
+        // timed out
+        return numberOfBytesWrittenTotal;
+      }
+      continue;
+    }
+    numberOfBytesToWrite -= numberOfBytesWritten;
+    numberOfBytesWrittenTotal += numberOfBytesWritten;
+  }
+  return numberOfBytesWrittenTotal;
 #endif
 }
 
@@ -173,8 +370,39 @@ int SerialLine::Read(BYTE* data, int maxNumberOfBytesToRead)
   }
   return numberOfBytesReadTotal;
 #else
-  LOG_ERROR("SerialLine::Read() is only implemented on Windows");
-  return 0;
+  // Read all the requested data, waiting for incoming bytes until the max reply time is reached
+  struct timespec deadline = GetDeadline(MaxReplyTime);
+  int numberOfBytesReadTotal = 0;
+  while (maxNumberOfBytesToRead > 0)
+  {
+    ssize_t numberOfBytesRead = read(CommHandle, &data[numberOfBytesReadTotal], maxNumberOfBytesToRead);
+    if (numberOfBytesRead < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+      {
+        // other error
+        return numberOfBytesReadTotal;
+      }
+      numberOfBytesRead = 0;
+    }
+    if (numberOfBytesRead == 0)
+    {
+      // no data available yet, wait for it
+      if (!WaitForEvent(CommHandle, POLLIN, deadline))
+      {
+        // no characters received, timed out
+        return numberOfBytesReadTotal;
+      }
+      continue;
+    }
+    maxNumberOfBytesToRead -= numberOfBytesRead;
+    numberOfBytesReadTotal += numberOfBytesRead;
+  }
+  return numberOfBytesReadTotal;
 #endif
 }
 
@@ -193,7 +421,7 @@ SerialLine::DWORD SerialLine::ClearError()
   ClearCommError(CommHandle, &dwErrors, &comStat);
   return dwErrors;
 #else
-  LOG_ERROR("SerialLine::ClearError() is only implemented on Windows");
+  // Errors are reported by the read and write calls directly, there is no error flag to clear
   return 0;
 #endif
 }
@@ -216,6 +444,18 @@ int SerialLine::GetMaxReplyTime() const
   return MaxReplyTime;
 }
 
+//----------------------------------------------------------------------------
+void SerialLine::SetLowLatencyEnabled(bool enabled)
+{
+  LowLatencyEnabled = enabled;
+}
+
+//----------------------------------------------------------------------------
+bool SerialLine::GetLowLatencyEnabled() const
+{
+  return LowLatencyEnabled;
+}
+
 //----------------------------------------------------------------------------
 bool SerialLine::IsHandleAlive() const
 {
@@ -231,7 +471,11 @@ unsigned int SerialLine::GetNumberOfBytesAvailableForReading() const
   ClearCommError(CommHandle, &dwErrorFlags, &comStat);
   return ((int) comStat.cbInQue);
 #else
-  LOG_ERROR("SerialLine::GetNumberOfBytesAvailableForReading() is only implemented on Windows");
-  return 0;
+  int numberOfBytesAvailable = 0;
+  if (ioctl(CommHandle, FIONREAD, &numberOfBytesAvailable) != 0)
+  {
+    return 0;
+  }
+  return numberOfBytesAvailable;
 #endif
 }
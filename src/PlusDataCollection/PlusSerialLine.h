@@ -20,8 +20,10 @@
 \class SerialLine
 \brief Class for reading and writing data through the serial (RS-232) port
 
-The class currently only works on Windows. If serial communication is needed on other platforms then
-sample code can be found in src\Utilities\ndicapi\ndicapi_serial.* or at https://github.com/wjwwood/serial.
+On Windows the port name is the COM port name (e.g., COM1). On other platforms the port name is the
+device file name (e.g., /dev/ttyS0 or /dev/ttyUSB0) and the port is accessed through termios in non-blocking
+mode: reads and writes wait for the port to become ready using poll() and give up when MaxReplyTime
+has elapsed since the start of the call.
 
 \ingroup PlusLibDataCollection
 */
@@ -74,6 +76,15 @@ public:
   /*! Get the serial port max reply time */
   int GetMaxReplyTime() const;;
 
+  /*!
+    Enable low latency mode. Received bytes are delivered immediately by the driver instead of being buffered
+    (reduces reply delay of USB-serial adapters). Only has effect on Linux and must be set before Open() is called.
+  */
+  void SetLowLatencyEnabled(bool enabled);
+
+  /*! Get the low latency mode */
+  bool GetLowLatencyEnabled() const;
+
   /*! Check the handle alive status */
   bool IsHandleAlive() const;;
 
@@ -88,6 +99,7 @@ private:
   std::string PortName;
   DWORD       SerialPortSpeed;
   int         MaxReplyTime;
+  bool        LowLatencyEnabled;
 };
 
 #endif
\ No newline at end of file
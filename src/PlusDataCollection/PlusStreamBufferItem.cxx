@@ -6,7 +6,20 @@
 
 #include "PlusConfigure.h"
 #include "PlusStreamBufferItem.h"
+#include "vtkImageData.h"
 #include "vtkMatrix4x4.h"
+#include "vtk_zlib.h"
+
+//----------------------------------------------------------------------------
+StreamBufferItem::CompressedFrameType::CompressedFrameType()
+  : UncompressedSizeInBytes( 0 )
+  , PixelType( VTK_VOID )
+  , NumberOfScalarComponents( 0 )
+{
+  this->FrameSize[0] = 0;
+  this->FrameSize[1] = 0;
+  this->FrameSize[2] = 0;
+}
 
 //----------------------------------------------------------------------------
 //            DataBufferItem
@@ -45,6 +58,7 @@ StreamBufferItem& StreamBufferItem::operator=( StreamBufferItem const& dataItem
   }
 
   this->Frame = dataItem.Frame;
+  this->CompressedFrame = dataItem.CompressedFrame;
   this->FilteredTimeStamp = dataItem.FilteredTimeStamp;
   this->UnfilteredTimeStamp = dataItem.UnfilteredTimeStamp;
   this->Index = dataItem.Index;
@@ -60,7 +74,7 @@ StreamBufferItem& StreamBufferItem::operator=( StreamBufferItem const& dataItem
 //----------------------------------------------------------------------------
 void StreamBufferItem::SetCustomFrameField( std::string fieldName, std::string fieldValue )
 {
-  this->CustomFrameFields[fieldName] = fieldValue;
+  this->CustomFrameFields.SetValue( fieldName, fieldValue );
 }
 
 //----------------------------------------------------------------------------
@@ -77,6 +91,80 @@ PlusStatus StreamBufferItem::DeepCopy( StreamBufferItem* dataItem )
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus StreamBufferItem::CompressFrame( const PlusVideoFrame& frame, int compressionLevel, CompressedFrameType& compressedFrame )
+{
+  if ( !frame.IsImageValid() )
+  {
+    LOG_ERROR( "Failed to compress frame - image is invalid!" );
+    return PLUS_FAIL;
+  }
+
+  compressedFrame.UncompressedSizeInBytes = frame.GetFrameSizeInBytes();
+  frame.GetFrameSize( compressedFrame.FrameSize );
+  compressedFrame.PixelType = frame.GetVTKScalarPixelType();
+  compressedFrame.NumberOfScalarComponents = frame.GetNumberOfScalarComponents();
+
+  uLongf compressedSize = compressBound( compressedFrame.UncompressedSizeInBytes );
+  compressedFrame.CompressedPixels.resize( compressedSize );
+  int result = compress2( &compressedFrame.CompressedPixels[0], &compressedSize,
+                          reinterpret_cast<const Bytef*>( frame.GetScalarPointer() ), compressedFrame.UncompressedSizeInBytes, compressionLevel );
+  if ( result != Z_OK )
+  {
+    LOG_ERROR( "Failed to compress frame (zlib error code: " << result << ")" );
+    compressedFrame.CompressedPixels.clear();
+    return PLUS_FAIL;
+  }
+  compressedFrame.CompressedPixels.resize( compressedSize );
+  compressedFrame.CompressedPixels.shrink_to_fit();
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void StreamBufferItem::SetCompressedFrame( std::shared_ptr<const CompressedFrameType> compressedFrame )
+{
+  this->CompressedFrame = compressedFrame;
+  if ( this->CompressedFrame.get() != NULL && this->Frame.GetImage() != NULL )
+  {
+    // Release the pixel data, the image is reallocated when the frame is decompressed or overwritten
+    this->Frame.GetImage()->Initialize();
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus StreamBufferItem::DecompressFrame()
+{
+  if ( this->CompressedFrame.get() == NULL )
+  {
+    // not compressed
+    return PLUS_SUCCESS;
+  }
+
+  // Keep a reference, as the compressed data may be shared with other items
+  std::shared_ptr<const CompressedFrameType> compressedFrame = this->CompressedFrame;
+  this->CompressedFrame.reset();
+
+  if ( this->Frame.AllocateFrame( compressedFrame->FrameSize, compressedFrame->PixelType, compressedFrame->NumberOfScalarComponents ) != PLUS_SUCCESS
+       || this->Frame.GetFrameSizeInBytes() != compressedFrame->UncompressedSizeInBytes )
+  {
+    LOG_ERROR( "Failed to allocate memory for the decompressed frame!" );
+    return PLUS_FAIL;
+  }
+
+  uLongf uncompressedSize = compressedFrame->UncompressedSizeInBytes;
+  int result = uncompress( reinterpret_cast<Bytef*>( this->Frame.GetScalarPointer() ), &uncompressedSize,
+                           &compressedFrame->CompressedPixels[0], compressedFrame->CompressedPixels.size() );
+  if ( result != Z_OK || uncompressedSize != compressedFrame->UncompressedSizeInBytes )
+  {
+    LOG_ERROR( "Failed to decompress frame (zlib error code: " << result << ")" );
+    return PLUS_FAIL;
+  }
+  this->Frame.GetImage()->Modified();
+
+  return PLUS_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus StreamBufferItem::SetMatrix( vtkMatrix4x4* matrix )
 {
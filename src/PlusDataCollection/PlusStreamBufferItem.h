@@ -10,10 +10,12 @@ See License.txt for details.
 #include "vtkPlusDataCollectionExport.h"
 
 #include "PlusCommon.h"
+#include "PlusFieldMap.h"
 #include "PlusVideoFrame.h"
 
 #include "vtkSmartPointer.h"
 
+#include <memory>
 #include <vector>
 
 class vtkMatrix4x4;
@@ -51,7 +53,18 @@ enum ToolStatus
 class vtkPlusDataCollectionExport StreamBufferItem
 {
 public:
-  typedef std::map<std::string, std::string> FieldMapType;
+  typedef PlusFieldMap FieldMapType;
+
+  /*! Losslessly compressed pixel data of a video frame, with the format that is needed for restoring the frame */
+  struct CompressedFrameType
+  {
+    CompressedFrameType();
+    std::vector<unsigned char> CompressedPixels;
+    unsigned long UncompressedSizeInBytes;
+    unsigned int FrameSize[3];
+    PlusCommon::VTKScalarPixelType PixelType;
+    int NumberOfScalarComponents;
+  };
 
   StreamBufferItem();
   virtual ~StreamBufferItem();
@@ -98,11 +111,10 @@ public:
       return NULL;
     }
 
-    FieldMapType::iterator fieldIterator;
-    fieldIterator = this->CustomFrameFields.find( fieldName );
-    if ( fieldIterator != this->CustomFrameFields.end() )
+    const std::string* fieldValue = this->CustomFrameFields.GetValue( fieldName );
+    if ( fieldValue != NULL )
     {
-      return fieldIterator->second.c_str();
+      return fieldValue->c_str();
     }
     return NULL;
   }
@@ -135,6 +147,33 @@ public:
 
   PlusVideoFrame& GetFrame() { return this->Frame; };
 
+  /*!
+    Compress the pixel data of a video frame with zlib.
+    \param compressionLevel 1 (fastest) to 9 (smallest)
+  */
+  static PlusStatus CompressFrame( const PlusVideoFrame& frame, int compressionLevel, CompressedFrameType& compressedFrame );
+
+  /*!
+    Store the video frame in compressed form and release the memory of the uncompressed image.
+    The compressed data is shared (not copied) when the item is copied.
+  */
+  void SetCompressedFrame( std::shared_ptr<const CompressedFrameType> compressedFrame );
+
+  /*! Restore the uncompressed video frame from the compressed data */
+  PlusStatus DecompressFrame();
+
+  /*! Discard the compressed data. The frame image has to be reallocated before it is used again. */
+  void ClearCompressedFrame() { this->CompressedFrame.reset(); }
+
+  /*! Returns true if the video frame is stored in compressed form, i.e., GetFrame() contains no pixel data */
+  bool IsFrameCompressed() const { return this->CompressedFrame.get() != NULL; }
+
+  /*! Returns the size of the compressed pixel data, 0 if the frame is not compressed */
+  size_t GetCompressedFrameSizeInBytes() const
+  {
+    return ( this->CompressedFrame.get() != NULL ) ? this->CompressedFrame->CompressedPixels.size() : 0;
+  }
+
   /*! Set tracker matrix */
   PlusStatus SetMatrix( vtkMatrix4x4* matrix );
   /*! Get tracker matrix */
@@ -150,7 +189,7 @@ public:
   bool HasValidFieldData() const;
   bool HasValidVideoData() const
   {
-    return Frame.IsImageValid();
+    return Frame.IsImageValid() || IsFrameCompressed();
   }
 
 protected:
@@ -168,6 +207,8 @@ protected:
 
   bool ValidTransformData;
   PlusVideoFrame Frame;
+  /*! Pixel data of the frame if the frame is stored in compressed form */
+  std::shared_ptr<const CompressedFrameType> CompressedFrame;
   vtkSmartPointer<vtkMatrix4x4> Matrix;
   ToolStatus Status;
 };
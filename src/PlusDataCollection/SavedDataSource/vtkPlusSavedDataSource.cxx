@@ -8,6 +8,7 @@ See License.txt for details.
 #include "vtkImageData.h"
 #include "vtkMatrix4x4.h"
 #include "vtkPlusSequenceIO.h"
+#include "vtkPlusSequenceIOBase.h"
 #include "vtkObjectFactory.h"
 #include "vtkPlusBuffer.h"
 #include "vtkPlusChannel.h"
@@ -16,6 +17,8 @@ See License.txt for details.
 #include "vtkPlusTrackedFrameList.h"
 #include "vtksys/SystemTools.hxx"
 
+#include <set>
+
 vtkStandardNewMacro(vtkPlusSavedDataSource);
 
 //----------------------------------------------------------------------------
@@ -31,6 +34,16 @@ vtkPlusSavedDataSource::vtkPlusSavedDataSource()
   , LastAddedFrameUid(0)
   , LastAddedLoopIndex(0)
   , SimulatedStream(VIDEO_STREAM)
+  , StreamingEnabled(false)
+  , StreamingWindowSize(16)
+  , StreamingReader(NULL)
+  , StreamingReaderMutex(vtkPlusRecursiveCriticalSection::New())
+  , PrefetchStartUid(0)
+  , PrefetchMutex(vtkPlusRecursiveCriticalSection::New())
+  , PrefetchThreader(vtkMultiThreader::New())
+  , PrefetchThreadId(-1)
+  , PrefetchThreadRequested(false)
+  , PrefetchThreadRunning(false)
 {
   // No callback function provided by the device, so the data capture thread will be used to poll the hardware and add new items to the buffer
   this->StartThreadForInternalUpdates = true;
@@ -44,7 +57,11 @@ vtkPlusSavedDataSource::~vtkPlusSavedDataSource()
   {
     this->Disconnect();
   }
+  this->CloseStreamingReader();
   DeleteLocalBuffers();
+  DELETE_IF_NOT_NULL(this->PrefetchThreader);
+  DELETE_IF_NOT_NULL(this->PrefetchMutex);
+  DELETE_IF_NOT_NULL(this->StreamingReaderMutex);
 }
 
 //----------------------------------------------------------------------------
@@ -178,7 +195,18 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateOriginalTimestamp(BufferItemUid
         {
           fieldMap = dataBufferItemToBeAdded.GetCustomFrameFieldMap();
         }
-        if (this->AddVideoItemToVideoSources(this->GetVideoSources(), dataBufferItemToBeAdded.GetFrame(), this->FrameNumber, unfilteredTimestamp, filteredTimestamp, &fieldMap) != PLUS_SUCCESS)
+        const PlusVideoFrame* frame = &dataBufferItemToBeAdded.GetFrame();
+        std::shared_ptr<PlusVideoFrame> streamedFrame;
+        if (this->StreamingReader != NULL)
+        {
+          if (this->GetStreamedFrame(frameToBeAddedUid, streamedFrame) != PLUS_SUCCESS)
+          {
+            status = PLUS_FAIL;
+            break;
+          }
+          frame = streamedFrame.get();
+        }
+        if (this->AddVideoItemToVideoSources(this->GetVideoSources(), *frame, this->FrameNumber, unfilteredTimestamp, filteredTimestamp, &fieldMap) != PLUS_SUCCESS)
         {
           status = PLUS_FAIL;
         }
@@ -279,7 +307,18 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateCurrentTimestamp(BufferItemUidT
       {
         fieldMap = dataBufferItemToBeAdded.GetCustomFrameFieldMap();
       }
-      if (this->AddVideoItemToVideoSources(this->GetVideoSources(), dataBufferItemToBeAdded.GetFrame(), this->FrameNumber, UNDEFINED_TIMESTAMP, UNDEFINED_TIMESTAMP, &fieldMap) != PLUS_SUCCESS)
+      const PlusVideoFrame* frame = &dataBufferItemToBeAdded.GetFrame();
+      std::shared_ptr<PlusVideoFrame> streamedFrame;
+      if (this->StreamingReader != NULL)
+      {
+        if (this->GetStreamedFrame(frameToBeAddedUid, streamedFrame) != PLUS_SUCCESS)
+        {
+          status = PLUS_FAIL;
+          break;
+        }
+        frame = streamedFrame.get();
+      }
+      if (this->AddVideoItemToVideoSources(this->GetVideoSources(), *frame, this->FrameNumber, UNDEFINED_TIMESTAMP, UNDEFINED_TIMESTAMP, &fieldMap) != PLUS_SUCCESS)
       {
         // UNDEFINED_TIMESTAMP => use current timestamp
         status = PLUS_FAIL;
@@ -381,8 +420,21 @@ PlusStatus vtkPlusSavedDataSource::InternalConnect()
 
   vtkSmartPointer<vtkPlusTrackedFrameList> savedDataBuffer = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
 
-  // Read sequence file into tracked frame list
-  vtkPlusSequenceIO::Read(foundAbsoluteImagePath, savedDataBuffer);
+  this->CloseStreamingReader();
+  if (this->StreamingEnabled)
+  {
+    // Read only the frame fields now, image data is read from the file during playback
+    if (this->OpenStreamingReader(foundAbsoluteImagePath, savedDataBuffer) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+  }
+
+  if (this->StreamingReader == NULL)
+  {
+    // Read sequence file into tracked frame list
+    vtkPlusSequenceIO::Read(foundAbsoluteImagePath, savedDataBuffer);
+  }
 
   if (savedDataBuffer->GetNumberOfTrackedFrames() < 1)
   {
@@ -398,6 +450,8 @@ PlusStatus vtkPlusSavedDataSource::InternalConnect()
       break;
     case TRACKER_STREAM:
       status = InternalConnectTracker(savedDataBuffer);
+      // Tracker streams only use the frame fields, so there is no need to keep the file open
+      this->CloseStreamingReader();
       break;
     default:
       LOG_ERROR("Unknown stream type: " << this->SimulatedStream);
@@ -405,12 +459,14 @@ PlusStatus vtkPlusSavedDataSource::InternalConnect()
 
   if (status != PLUS_SUCCESS)
   {
+    this->CloseStreamingReader();
     return PLUS_FAIL;
   }
 
   if (GetLocalBuffer() == NULL)
   {
     LOG_ERROR("Local buffer is invalid");
+    this->CloseStreamingReader();
     return PLUS_FAIL;
   }
 
@@ -453,6 +509,12 @@ PlusStatus vtkPlusSavedDataSource::InternalConnect()
   this->LastAddedFrameUid = this->LoopFirstFrameUid - 1;
   this->LastAddedLoopIndex = 0;
 
+  if (this->StreamingReader != NULL)
+  {
+    this->ResetPrefetch();
+    this->StartPrefetchThread();
+  }
+
   return PLUS_SUCCESS;
 }
 
@@ -465,7 +527,37 @@ PlusStatus vtkPlusSavedDataSource::InternalConnectVideo(vtkPlusTrackedFrameList*
   {
     return PLUS_FAIL;
   }
-  if (outputDataSource->SetImageType(savedDataBuffer->GetImageType()) != PLUS_SUCCESS)
+
+  // Image properties are taken from the reader in streaming mode, as the saved data buffer contains no image data then
+  US_IMAGE_TYPE imageType = US_IMG_TYPE_XX;
+  US_IMAGE_ORIENTATION imageOrientation = US_IMG_ORIENT_XX;
+  unsigned int frameSize[3] = {0, 0, 0};
+  int numberOfScalarComponents = 1;
+  PlusCommon::VTKScalarPixelType pixelType = VTK_VOID;
+  if (this->StreamingReader != NULL)
+  {
+    imageType = this->StreamingReader->GetImageType();
+    imageOrientation = this->StreamingReader->GetImageOrientationInMemory();
+    for (int i = 0; i < 3; i++)
+    {
+      frameSize[i] = this->StreamingReader->GetDimensions()[i];
+    }
+    numberOfScalarComponents = this->StreamingReader->GetNumberOfScalarComponents();
+    pixelType = this->StreamingReader->GetPixelType();
+  }
+  else
+  {
+    imageType = savedDataBuffer->GetImageType();
+    imageOrientation = savedDataBuffer->GetImageOrientation();
+    for (int i = 0; i < 3; i++)
+    {
+      frameSize[i] = savedDataBuffer->GetFrameSize()[i];
+    }
+    numberOfScalarComponents = savedDataBuffer->GetTrackedFrame(0)->GetNumberOfScalarComponents();
+    pixelType = savedDataBuffer->GetTrackedFrame(0)->GetImageData()->GetVTKScalarPixelType();
+  }
+
+  if (outputDataSource->SetImageType(imageType) != PLUS_SUCCESS)
   {
     LOG_ERROR("Failed to set video buffer image type");
     return PLUS_FAIL;
@@ -474,14 +566,25 @@ PlusStatus vtkPlusSavedDataSource::InternalConnectVideo(vtkPlusTrackedFrameList*
   // Saved data buffer contains data read directly from file, set up a new local buffer
   DeleteLocalBuffers();
   this->LocalVideoBuffer = vtkPlusBuffer::New();
-  this->LocalVideoBuffer->SetImageOrientation(savedDataBuffer->GetImageOrientation());
-  this->LocalVideoBuffer->SetImageType(savedDataBuffer->GetImageType());
-  this->LocalVideoBuffer->SetFrameSize(savedDataBuffer->GetFrameSize());
-  this->LocalVideoBuffer->SetNumberOfScalarComponents(savedDataBuffer->GetTrackedFrame(0)->GetNumberOfScalarComponents());
-  this->LocalVideoBuffer->SetPixelType(savedDataBuffer->GetTrackedFrame(0)->GetImageData()->GetVTKScalarPixelType());
-  this->LocalVideoBuffer->SetBufferSize(savedDataBuffer->GetNumberOfTrackedFrames());
+  this->LocalVideoBuffer->SetImageOrientation(imageOrientation);
+  this->LocalVideoBuffer->SetImageType(imageType);
   this->LocalVideoBuffer->SetLocalTimeOffsetSec(0.0);   // the time offset is copied from the output, so reset it to 0
-  this->LocalVideoBuffer->CopyImagesFromTrackedFrameList(savedDataBuffer, vtkPlusBuffer::READ_FILTERED_IGNORE_UNFILTERED_TIMESTAMPS, this->UseAllFrameFields);
+  if (this->StreamingReader != NULL)
+  {
+    // Don't set the frame size, so that no memory is allocated for image data in the local buffer
+    if (this->CopyStreamingTimelineToLocalBuffer(savedDataBuffer) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+  }
+  else
+  {
+    this->LocalVideoBuffer->SetFrameSize(frameSize);
+    this->LocalVideoBuffer->SetNumberOfScalarComponents(numberOfScalarComponents);
+    this->LocalVideoBuffer->SetPixelType(pixelType);
+    this->LocalVideoBuffer->SetBufferSize(savedDataBuffer->GetNumberOfTrackedFrames());
+    this->LocalVideoBuffer->CopyImagesFromTrackedFrameList(savedDataBuffer, vtkPlusBuffer::READ_FILTERED_IGNORE_UNFILTERED_TIMESTAMPS, this->UseAllFrameFields);
+  }
   savedDataBuffer->Clear();
 
   PlusStatus result(PLUS_SUCCESS);
@@ -489,21 +592,21 @@ PlusStatus vtkPlusSavedDataSource::InternalConnectVideo(vtkPlusTrackedFrameList*
   {
     vtkPlusDataSource* source(it->second);
 
-    if (source->SetInputImageOrientation(this->LocalVideoBuffer->GetImageOrientation()) != PLUS_SUCCESS)
+    if (source->SetInputImageOrientation(imageOrientation) != PLUS_SUCCESS)
     {
       LOG_ERROR(source->GetId() << ": Failed to set video image orientation");
       result = PLUS_FAIL;
       continue;
     }
 
-    if (source->SetInputFrameSize(this->LocalVideoBuffer->GetFrameSize()) != PLUS_SUCCESS)
+    if (source->SetInputFrameSize(frameSize) != PLUS_SUCCESS)
     {
       LOG_ERROR(source->GetId() << ": Failed to set video image orientation");
       result = PLUS_FAIL;
       continue;
     }
 
-    if (source->SetNumberOfScalarComponents(this->LocalVideoBuffer->GetNumberOfScalarComponents()) != PLUS_SUCCESS)
+    if (source->SetNumberOfScalarComponents(numberOfScalarComponents) != PLUS_SUCCESS)
     {
       LOG_ERROR(source->GetId() << ": Failed to set video image orientation");
       result = PLUS_FAIL;
@@ -512,14 +615,14 @@ PlusStatus vtkPlusSavedDataSource::InternalConnectVideo(vtkPlusTrackedFrameList*
 
     source->Clear();
 
-    if (source->SetInputFrameSize(this->LocalVideoBuffer->GetFrameSize()) != PLUS_SUCCESS)
+    if (source->SetInputFrameSize(frameSize) != PLUS_SUCCESS)
     {
       LOG_ERROR(source->GetId() << ": Failed to set video image orientation");
       result = PLUS_FAIL;
       continue;
     }
 
-    if (source->SetPixelType(this->LocalVideoBuffer->GetPixelType()) != PLUS_SUCCESS)
+    if (source->SetPixelType(pixelType) != PLUS_SUCCESS)
     {
       LOG_ERROR(source->GetId() << ": Failed to set video image orientation");
       result = PLUS_FAIL;
@@ -595,10 +698,281 @@ PlusStatus vtkPlusSavedDataSource::InternalConnectTracker(vtkPlusTrackedFrameLis
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusSavedDataSource::InternalDisconnect()
 {
+  this->CloseStreamingReader();
   DeleteLocalBuffers();
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSavedDataSource::OpenStreamingReader(const std::string& filePath, vtkPlusTrackedFrameList* savedDataBuffer)
+{
+  vtkPlusSequenceIOBase* reader = vtkPlusSequenceIO::CreateSequenceHandlerForFile(filePath);
+  if (reader == NULL)
+  {
+    LOG_ERROR("Unable to connect to saved data video source: no reader for sequence file " << filePath);
+    return PLUS_FAIL;
+  }
+  if (!reader->CanReadFramePixels())
+  {
+    LOG_WARNING("Streaming is not supported for sequence file " << filePath << ", all frames are read into memory");
+    reader->Delete();
+    return PLUS_SUCCESS;
+  }
+
+  reader->SetFileName(filePath);
+  reader->SetTrackedFrameList(savedDataBuffer);
+  if (reader->ReadHeader() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to connect to saved data video source: failed to read header of sequence file " << filePath);
+    reader->Delete();
+    return PLUS_FAIL;
+  }
+  // The reader keeps using the global fields of the saved data buffer, the frames are cleared after connect
+
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> readerGuardedLock(this->StreamingReaderMutex);
+  this->StreamingReader = reader;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSavedDataSource::CloseStreamingReader()
+{
+  this->StopPrefetchThread();
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(this->PrefetchMutex);
+    this->PrefetchedFrames.clear();
+  }
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> readerGuardedLock(this->StreamingReaderMutex);
+  DELETE_IF_NOT_NULL(this->StreamingReader);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSavedDataSource::CopyStreamingTimelineToLocalBuffer(vtkPlusTrackedFrameList* savedDataBuffer)
+{
+  const int numberOfFrames = savedDataBuffer->GetNumberOfTrackedFrames();
+  if (this->LocalVideoBuffer->SetBufferSize(numberOfFrames) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to set local video buffer size");
+    return PLUS_FAIL;
+  }
+
+  int numberOfErrors = 0;
+  for (int frameNumber = 0; frameNumber < numberOfFrames; frameNumber++)
+  {
+    PlusTrackedFrame* trackedFrame = savedDataBuffer->GetTrackedFrame(frameNumber);
+
+    // Frames without valid image data are not replayed, the same way as when all the frames are read into memory
+    const char* imageStatus = trackedFrame->GetCustomFrameField("ImageStatus");
+    if (imageStatus != NULL && STRCASECMP(imageStatus, "OK") != 0)
+    {
+      LOG_DEBUG("Frame #" << frameNumber << " image data is invalid, it is not replayed");
+      continue;
+    }
+
+    double timestamp(0);
+    const char* strTimestamp = trackedFrame->GetCustomFrameField("Timestamp");
+    if (strTimestamp == NULL || PlusCommon::StringToDouble(strTimestamp, timestamp) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to read Timestamp field of frame #" << frameNumber);
+      numberOfErrors++;
+      continue;
+    }
+
+    // The fields are stored even if they are not provided in the output, as the buffer item needs at least one field.
+    // Skip the same special fields as vtkPlusBuffer::CopyImagesFromTrackedFrameList.
+    StreamBufferItem::FieldMapType customFields = trackedFrame->GetCustomFields();
+    customFields.erase("ImageStatus");
+    customFields.erase("TimeStamp");
+    customFields.erase("UnfilteredTimestamp");
+    customFields.erase("FrameNumber");
+
+    // The frame number in the file is stored as buffer item index, it is used for reading the image data
+    if (this->LocalVideoBuffer->AddItem(customFields, frameNumber, timestamp, timestamp) != PLUS_SUCCESS)
+    {
+      LOG_WARNING("Failed to add frame #" << frameNumber << " to the local video buffer");
+    }
+  }
+
+  return (numberOfErrors > 0 ? PLUS_FAIL : PLUS_SUCCESS);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSavedDataSource::StartPrefetchThread()
+{
+  if (this->PrefetchThreadId >= 0)
+  {
+    // already running
+    return;
+  }
+  this->PrefetchThreadRequested = true;
+  // Set it before spawning, so that stopping right after starting still waits for the thread
+  this->PrefetchThreadRunning = true;
+  this->PrefetchThreadId = this->PrefetchThreader->SpawnThread((vtkThreadFunctionType)&PrefetchThread, this);
+  if (this->PrefetchThreadId < 0)
+  {
+    LOG_ERROR("Failed to start the prefetch thread, frames will be read on demand");
+    this->PrefetchThreadRequested = false;
+    this->PrefetchThreadRunning = false;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSavedDataSource::StopPrefetchThread()
+{
+  if (this->PrefetchThreadId < 0)
+  {
+    // not running
+    return;
+  }
+  this->PrefetchThreadRequested = false;
+  while (this->PrefetchThreadRunning)
+  {
+    // Wait until the thread stops
+    vtkPlusAccurateTimer::Delay(0.01);
+  }
+  this->PrefetchThreadId = -1;
+  LOG_DEBUG("Prefetch thread stopped");
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSavedDataSource::ResetPrefetch()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(this->PrefetchMutex);
+  this->PrefetchedFrames.clear();
+  this->PrefetchStartUid = this->LoopFirstFrameUid;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSavedDataSource::GetStreamedFrame(BufferItemUidType frameUid, std::shared_ptr<PlusVideoFrame>& frame)
+{
+  bool prefetched = false;
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(this->PrefetchMutex);
+    std::map<BufferItemUidType, std::shared_ptr<PlusVideoFrame> >::iterator frameIt = this->PrefetchedFrames.find(frameUid);
+    if (frameIt != this->PrefetchedFrames.end())
+    {
+      frame = frameIt->second;
+      prefetched = true;
+      this->PrefetchedFrames.erase(frameIt);
+    }
+    // Move the prefetch window forward (wrapping around at the end of the loop is done by the prefetch thread)
+    this->PrefetchStartUid = frameUid + 1;
+  }
+
+  if (prefetched)
+  {
+    if (frame.get() == NULL)
+    {
+      LOG_ERROR("vtkPlusSavedDataSource: Failed to read image data from the sequence file, UID=" << frameUid);
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  // Playback is faster than prefetching, read the frame now
+  unsigned long frameNumberInFile = 0;
+  if (this->LocalVideoBuffer->GetIndex(frameUid, frameNumberInFile) != ITEM_OK)
+  {
+    LOG_ERROR("vtkPlusSavedDataSource: Failed to retrieve item from the buffer, UID=" << frameUid);
+    return PLUS_FAIL;
+  }
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> readerGuardedLock(this->StreamingReaderMutex);
+  {
+    // The prefetch thread may have read the frame while this thread was waiting for the reader
+    // (it stores the frame before releasing the reader lock)
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(this->PrefetchMutex);
+    std::map<BufferItemUidType, std::shared_ptr<PlusVideoFrame> >::iterator frameIt = this->PrefetchedFrames.find(frameUid);
+    if (frameIt != this->PrefetchedFrames.end() && frameIt->second.get() != NULL)
+    {
+      frame = frameIt->second;
+      this->PrefetchedFrames.erase(frameIt);
+      return PLUS_SUCCESS;
+    }
+  }
+  frame = std::make_shared<PlusVideoFrame>();
+  if (this->StreamingReader == NULL || this->StreamingReader->ReadFramePixels(frameNumberInFile, *frame) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("vtkPlusSavedDataSource: Failed to read image data from the sequence file, UID=" << frameUid);
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void* vtkPlusSavedDataSource::PrefetchThread(vtkMultiThreader::ThreadInfo* data)
+{
+  vtkPlusSavedDataSource* self = (vtkPlusSavedDataSource*)(data->UserData);
+  while (self->PrefetchThreadRequested)
+  {
+    // Find the first frame in the window ahead of the playback position that has not been read yet
+    // and discard the frames that are not in the window anymore
+    BufferItemUidType frameUidToRead = 0;
+    bool frameToReadFound = false;
+    {
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(self->PrefetchMutex);
+      std::set<BufferItemUidType> windowFrameUids;
+      BufferItemUidType frameUid = self->PrefetchStartUid;
+      for (int i = 0; i < self->StreamingWindowSize; i++)
+      {
+        if (frameUid > self->LoopLastFrameUid || frameUid < self->LoopFirstFrameUid)
+        {
+          if (!self->RepeatEnabled && frameUid > self->LoopLastFrameUid)
+          {
+            break;
+          }
+          frameUid = self->LoopFirstFrameUid;
+        }
+        if (!windowFrameUids.insert(frameUid).second)
+        {
+          // the window is longer than the loop
+          break;
+        }
+        if (!frameToReadFound && self->PrefetchedFrames.find(frameUid) == self->PrefetchedFrames.end())
+        {
+          frameUidToRead = frameUid;
+          frameToReadFound = true;
+        }
+        frameUid++;
+      }
+      for (std::map<BufferItemUidType, std::shared_ptr<PlusVideoFrame> >::iterator frameIt = self->PrefetchedFrames.begin(); frameIt != self->PrefetchedFrames.end();)
+      {
+        if (windowFrameUids.find(frameIt->first) == windowFrameUids.end())
+        {
+          self->PrefetchedFrames.erase(frameIt++);
+        }
+        else
+        {
+          ++frameIt;
+        }
+      }
+    }
+
+    if (!frameToReadFound)
+    {
+      // All frames in the window are available, wait for the playback to proceed
+      vtkPlusAccurateTimer::Delay(0.005);
+      continue;
+    }
+
+    // The frame is stored while the reader lock is still held, so GetStreamedFrame finds it
+    // if it was waiting for the reader to read the same frame
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> readerGuardedLock(self->StreamingReaderMutex);
+    std::shared_ptr<PlusVideoFrame> frame = std::make_shared<PlusVideoFrame>();
+    unsigned long frameNumberInFile = 0;
+    if (self->LocalVideoBuffer->GetIndex(frameUidToRead, frameNumberInFile) != ITEM_OK
+        || self->StreamingReader == NULL || self->StreamingReader->ReadFramePixels(frameNumberInFile, *frame) != PLUS_SUCCESS)
+    {
+      frame.reset();
+    }
+
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(self->PrefetchMutex);
+    self->PrefetchedFrames[frameUidToRead] = frame;
+  }
+
+  self->PrefetchThreadRunning = false;
+  return NULL;
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusSavedDataSource::ReadConfiguration(vtkXMLDataElement* rootConfigElement)
 {
@@ -652,6 +1026,13 @@ PlusStatus vtkPlusSavedDataSource::ReadConfiguration(vtkXMLDataElement* rootConf
 
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(RepeatEnabled, deviceConfig);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(UseOriginalTimestamps, deviceConfig);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(StreamingEnabled, deviceConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, StreamingWindowSize, deviceConfig);
+  if (this->StreamingWindowSize < 1)
+  {
+    LOG_WARNING("Invalid StreamingWindowSize: " << this->StreamingWindowSize << ", using 1 instead");
+    this->StreamingWindowSize = 1;
+  }
 
   const char* useData = deviceConfig->GetAttribute("UseData");
   if (useData != NULL)
@@ -689,6 +1070,11 @@ PlusStatus vtkPlusSavedDataSource::WriteConfiguration(vtkXMLDataElement* rootCon
   XML_WRITE_CSTRING_ATTRIBUTE_IF_NOT_NULL(SequenceFile, imageAcquisitionConfig);
   XML_WRITE_BOOL_ATTRIBUTE(RepeatEnabled, imageAcquisitionConfig);
   XML_WRITE_BOOL_ATTRIBUTE(UseOriginalTimestamps, imageAcquisitionConfig);
+  if (this->StreamingEnabled)
+  {
+    XML_WRITE_BOOL_ATTRIBUTE(StreamingEnabled, imageAcquisitionConfig);
+    imageAcquisitionConfig->SetIntAttribute("StreamingWindowSize", this->StreamingWindowSize);
+  }
 
   if (this->UseAllFrameFields)
   {
@@ -750,6 +1136,9 @@ void vtkPlusSavedDataSource::GetLoopTimeRange(double& loopStartTime, double& loo
 //-----------------------------------------------------------------------------
 void vtkPlusSavedDataSource::SetLoopTimeRange(double loopStartTime, double loopStopTime)
 {
+  // The prefetch thread uses the loop range
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(this->PrefetchMutex);
+
   this->LoopStartTime_Local = loopStartTime;
   this->LoopStopTime_Local = loopStopTime;
 
@@ -758,6 +1147,11 @@ void vtkPlusSavedDataSource::SetLoopTimeRange(double loopStartTime, double loopS
 
   this->LastAddedFrameUid = this->LoopFirstFrameUid - 1;
   this->LastAddedLoopIndex = 0;
+
+  if (this->StreamingReader != NULL)
+  {
+    this->ResetPrefetch();
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -11,7 +11,12 @@ See License.txt for details.
 
 #include "vtkPlusDevice.h"
 
+#include <atomic>
+#include <map>
+#include <memory>
+
 class vtkPlusBuffer;
+class vtkPlusSequenceIOBase;
 
 class vtkPlusDataCollectionExport vtkPlusSavedDataSource;
 
@@ -27,6 +32,11 @@ Attributes:
 \li UseOriginalTimestamps: if true then the original timestamps (recorded originally in the source file)
   will be replayed exactly, otherwise only the timestamp difference will be replayed exactly,
   starting from the current time (TRUE|FALSE)
+\li StreamingEnabled: if true then only the frame fields are read from the file on connect and the image data
+  is read during playback, a few frames ahead of the playback position. Memory usage is then proportional to the
+  StreamingWindowSize instead of the length of the sequence. Only supported for MetaImage sequence files,
+  other files are read into memory completely. (TRUE|FALSE, default: FALSE)
+\li StreamingWindowSize: number of frames that are read ahead of the playback position if StreamingEnabled is true (default: 16)
 
 */
 class vtkPlusDataCollectionExport vtkPlusSavedDataSource : public vtkPlusDevice
@@ -73,11 +83,29 @@ public:
   /*! Read the timestamps from the file and use provide them in the output (instead of the current time) */
   vtkBooleanMacro( UseOriginalTimestamps, bool );
 
-  /*! Get local video buffer */
+  /*! Read the image data from the file during playback instead of reading all the frames on connect */
+  vtkGetMacro( StreamingEnabled, bool );
+  /*! Read the image data from the file during playback instead of reading all the frames on connect */
+  vtkSetMacro( StreamingEnabled, bool );
+  /*! Read the image data from the file during playback instead of reading all the frames on connect */
+  vtkBooleanMacro( StreamingEnabled, bool );
+
+  /*! Number of frames that are read ahead of the playback position in streaming mode */
+  vtkGetMacro( StreamingWindowSize, int );
+  /*! Number of frames that are read ahead of the playback position in streaming mode */
+  vtkSetMacro( StreamingWindowSize, int );
+
+  /*!
+    Get local video buffer. In streaming mode the buffer items contain only the frame fields and timestamps,
+    the image data is read from the file during playback.
+  */
   vtkGetObjectMacro( LocalVideoBuffer, vtkPlusBuffer );
 
   virtual bool IsTracker() const;
 
+  /*! Only reads the sequence file when connecting, so it can be connected in parallel with other devices */
+  virtual bool IsParallelConnectSafe() const { return true; }
+
   /*!
     Perform any completion tasks once configured
   */
@@ -104,6 +132,36 @@ protected:
   /*! Disconnect from device */
   virtual PlusStatus InternalDisconnect();
 
+  /*!
+    Open the sequence file for streaming and read its header into the tracked frame list.
+    If streaming is not supported for the file format then StreamingReader remains NULL.
+  */
+  PlusStatus OpenStreamingReader( const std::string& filePath, vtkPlusTrackedFrameList* savedDataBuffer );
+
+  /*! Stop the prefetch thread and close the sequence file that is used for streaming */
+  void CloseStreamingReader();
+
+  /*! Add the timestamps and fields of the frames to the local video buffer, the image data is read later from the file */
+  PlusStatus CopyStreamingTimelineToLocalBuffer( vtkPlusTrackedFrameList* savedDataBuffer );
+
+  /*! Start the thread that reads frames ahead of the playback position */
+  void StartPrefetchThread();
+
+  /*! Stop the thread that reads frames ahead of the playback position */
+  void StopPrefetchThread();
+
+  /*! Discard all prefetched frames and restart prefetching from the first frame of the loop */
+  void ResetPrefetch();
+
+  /*!
+    Get the image data of a frame in streaming mode. The frame is taken from the prefetched frames if available,
+    otherwise it is read from the file immediately.
+  */
+  PlusStatus GetStreamedFrame( BufferItemUidType frameUid, std::shared_ptr<PlusVideoFrame>& frame );
+
+  /*! Thread that reads frames from the file ahead of the playback position */
+  static void* PrefetchThread( vtkMultiThreader::ThreadInfo* data );
+
   /*! The internal function which actually does the grab.  */
   PlusStatus InternalUpdate();
 
@@ -181,6 +239,39 @@ protected:
 
   SimulatedStreamType SimulatedStream;
 
+  /*! Read the image data from the file during playback instead of reading all the frames on connect */
+  bool StreamingEnabled;
+
+  /*! Number of frames that are read ahead of the playback position in streaming mode */
+  int StreamingWindowSize;
+
+  /*! Reader of the sequence file in streaming mode, NULL if all the frames are read into memory on connect */
+  vtkPlusSequenceIOBase* StreamingReader;
+
+  /*! Mutex for serializing access to the StreamingReader */
+  vtkPlusRecursiveCriticalSection* StreamingReaderMutex;
+
+  /*! Frames that have been read ahead of the playback position, indexed by the local buffer item UID. NULL frame means that reading failed. */
+  std::map<BufferItemUidType, std::shared_ptr<PlusVideoFrame> > PrefetchedFrames;
+
+  /*! UID of the next frame that will be played, prefetching starts from this frame */
+  BufferItemUidType PrefetchStartUid;
+
+  /*! Mutex for PrefetchedFrames and PrefetchStartUid */
+  vtkPlusRecursiveCriticalSection* PrefetchMutex;
+
+  /*! Multithreader for the prefetch thread */
+  vtkMultiThreader* PrefetchThreader;
+
+  /*! Prefetch thread ID, -1 if the thread is not running */
+  int PrefetchThreadId;
+
+  /*! The prefetch thread is requested to run */
+  std::atomic<bool> PrefetchThreadRequested;
+
+  /*! The prefetch thread is running */
+  std::atomic<bool> PrefetchThreadRunning;
+
 private:
   static vtkPlusSavedDataSource* Instance;
   vtkPlusSavedDataSource( const vtkPlusSavedDataSource& ); // Not implemented.
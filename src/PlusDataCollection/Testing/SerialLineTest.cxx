@@ -0,0 +1,292 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file SerialLineTest.cxx
+  \brief Test reading and writing through SerialLine on a pseudo-terminal pair
+
+  The test opens the slave side of a pseudo-terminal with SerialLine, while a simulated device
+  is running on the master side. The simulated device replies to each received line:
+  - "PING": replies "PONG" immediately
+  - "DELAY": replies "DELAYED" after ReplyDelaySec
+  - "SILENT": does not reply
+  - any other text: echoes the text back
+*/
+
+#include "PlusConfigure.h"
+#include "PlusSerialLine.h"
+#include "vtkPlusAccurateTimer.h"
+
+#include <vtkMultiThreader.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#if defined(__APPLE__)
+  #include <util.h>
+#else
+  #include <pty.h>
+#endif
+
+namespace
+{
+  const double ReplyDelaySec = 0.2;
+
+  struct DeviceEmulator
+  {
+    int MasterFd;
+    std::pair<bool, bool> ThreadActive;
+  };
+
+  //----------------------------------------------------------------------------
+  void WriteToMaster(int masterFd, const std::string& text)
+  {
+    size_t numberOfBytesWritten = 0;
+    while (numberOfBytesWritten < text.size())
+    {
+      ssize_t result = write(masterFd, text.c_str() + numberOfBytesWritten, text.size() - numberOfBytesWritten);
+      if (result < 0)
+      {
+        if (errno == EINTR || errno == EAGAIN)
+        {
+          continue;
+        }
+        return;
+      }
+      numberOfBytesWritten += result;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void* DeviceEmulatorThread(vtkMultiThreader::ThreadInfo* data)
+  {
+    DeviceEmulator* emulator = static_cast<DeviceEmulator*>(data->UserData);
+    emulator->ThreadActive.second = true;
+
+    std::string receivedLine;
+    while (emulator->ThreadActive.first)
+    {
+      struct pollfd pfd;
+      pfd.fd = emulator->MasterFd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      if (poll(&pfd, 1, 20) <= 0 || (pfd.revents & POLLIN) == 0)
+      {
+        continue;
+      }
+      char c = 0;
+      if (read(emulator->MasterFd, &c, 1) != 1)
+      {
+        continue;
+      }
+      if (c != '\r')
+      {
+        receivedLine.push_back(c);
+        continue;
+      }
+
+      // Complete command received
+      if (receivedLine == "PING")
+      {
+        WriteToMaster(emulator->MasterFd, "PONG\r");
+      }
+      else if (receivedLine == "DELAY")
+      {
+        vtkPlusAccurateTimer::Delay(ReplyDelaySec);
+        WriteToMaster(emulator->MasterFd, "DELAYED\r");
+      }
+      else if (receivedLine != "SILENT")
+      {
+        WriteToMaster(emulator->MasterFd, receivedLine + "\r");
+      }
+      receivedLine.clear();
+    }
+
+    emulator->ThreadActive.second = false;
+    return NULL;
+  }
+
+  //----------------------------------------------------------------------------
+  bool SendCommand(SerialLine& serial, const std::string& command)
+  {
+    std::string text = command + "\r";
+    return serial.Write(reinterpret_cast<const SerialLine::BYTE*>(text.c_str()), text.size()) == static_cast<int>(text.size());
+  }
+
+  //----------------------------------------------------------------------------
+  std::string ReceiveReply(SerialLine& serial, int expectedLength)
+  {
+    std::vector<SerialLine::BYTE> buffer(expectedLength + 1, 0);
+    int numberOfBytesRead = serial.Read(&buffer[0], expectedLength);
+    return std::string(buffer.begin(), buffer.begin() + numberOfBytesRead);
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int masterFd = -1;
+  int slaveFd = -1;
+  char slaveName[256] = {0};
+  if (openpty(&masterFd, &slaveFd, slaveName, NULL, NULL) != 0)
+  {
+    LOG_ERROR("Failed to create pseudo-terminal pair");
+    return EXIT_FAILURE;
+  }
+
+  int numberOfErrors = 0;
+
+  SerialLine serial;
+  serial.SetPortName(slaveName);
+  serial.SetSerialPortSpeed(115200);
+  serial.SetMaxReplyTime(1000);
+  serial.SetLowLatencyEnabled(true);
+  if (!serial.Open())
+  {
+    LOG_ERROR("Failed to open serial line on pseudo-terminal " << slaveName);
+    close(slaveFd);
+    close(masterFd);
+    return EXIT_FAILURE;
+  }
+
+  DeviceEmulator emulator;
+  emulator.MasterFd = masterFd;
+  emulator.ThreadActive = std::make_pair(true, false);
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  int threadId = threader->SpawnThread((vtkThreadFunctionType)&DeviceEmulatorThread, &emulator);
+
+  // Immediate reply
+  if (!SendCommand(serial, "PING"))
+  {
+    LOG_ERROR("Failed to write PING command");
+    numberOfErrors++;
+  }
+  std::string reply = ReceiveReply(serial, 5);
+  if (reply != "PONG\r")
+  {
+    LOG_ERROR("Unexpected reply to PING: '" << reply << "'");
+    numberOfErrors++;
+  }
+
+  // Bytes available for reading
+  if (!SendCommand(serial, "ECHO1234"))
+  {
+    LOG_ERROR("Failed to write echo command");
+    numberOfErrors++;
+  }
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  while (serial.GetNumberOfBytesAvailableForReading() < 9 && vtkPlusAccurateTimer::GetSystemTime() - startTime < 1.0)
+  {
+    vtkPlusAccurateTimer::Delay(0.005);
+  }
+  if (serial.GetNumberOfBytesAvailableForReading() != 9)
+  {
+    LOG_ERROR("Unexpected number of bytes available for reading: " << serial.GetNumberOfBytesAvailableForReading() << " (expected 9)");
+    numberOfErrors++;
+  }
+  std::string echoReply;
+  SerialLine::BYTE d = 0;
+  while (serial.Read(d))
+  {
+    echoReply.push_back(d);
+    if (d == '\r')
+    {
+      break;
+    }
+  }
+  if (echoReply != "ECHO1234\r")
+  {
+    LOG_ERROR("Unexpected echo reply: '" << echoReply << "'");
+    numberOfErrors++;
+  }
+
+  // Delayed reply: the read must wait for the data, but must return as soon as it arrives
+  SendCommand(serial, "DELAY");
+  startTime = vtkPlusAccurateTimer::GetSystemTime();
+  reply = ReceiveReply(serial, 8);
+  double elapsedTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+  if (reply != "DELAYED\r")
+  {
+    LOG_ERROR("Unexpected reply to DELAY: '" << reply << "'");
+    numberOfErrors++;
+  }
+  if (elapsedTimeSec < ReplyDelaySec * 0.5 || elapsedTimeSec > ReplyDelaySec + 0.5)
+  {
+    LOG_ERROR("Delayed reply received after " << elapsedTimeSec << " sec, expected about " << ReplyDelaySec << " sec");
+    numberOfErrors++;
+  }
+
+  // No reply: the read must time out after the max reply time
+  const int maxReplyTimeMsec = 150;
+  serial.SetMaxReplyTime(maxReplyTimeMsec);
+  SendCommand(serial, "SILENT");
+  startTime = vtkPlusAccurateTimer::GetSystemTime();
+  reply = ReceiveReply(serial, 4);
+  elapsedTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+  if (!reply.empty())
+  {
+    LOG_ERROR("Unexpected reply to SILENT: '" << reply << "'");
+    numberOfErrors++;
+  }
+  if (elapsedTimeSec < maxReplyTimeMsec * 0.001 * 0.9 || elapsedTimeSec > maxReplyTimeMsec * 0.001 + 0.5)
+  {
+    LOG_ERROR("Read timed out after " << elapsedTimeSec << " sec, expected " << maxReplyTimeMsec * 0.001 << " sec");
+    numberOfErrors++;
+  }
+
+  // Stop the emulator
+  emulator.ThreadActive.first = false;
+  while (emulator.ThreadActive.second)
+  {
+    vtkPlusAccurateTimer::Delay(0.01);
+  }
+  threader->TerminateThread(threadId);
+
+  serial.Close();
+  if (serial.IsHandleAlive())
+  {
+    LOG_ERROR("Serial line handle is still alive after Close()");
+    numberOfErrors++;
+  }
+
+  close(slaveFd);
+  close(masterFd);
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed with " << numberOfErrors << " errors");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
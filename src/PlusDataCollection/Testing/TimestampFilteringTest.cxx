@@ -20,6 +20,7 @@ See License.txt for details.
 // VTK includes
 #include <vtksys/CommandLineArguments.hxx>
 #include <vtksys/SystemTools.hxx>
+#include <vtkDoubleArray.h>
 #include <vtkTable.h>
 
 
@@ -88,6 +89,7 @@ int main(int argc, char** argv)
   LOG_INFO("Copy buffer to tracker buffer...");
   vtkSmartPointer<vtkPlusBuffer> trackerBuffer = vtkSmartPointer<vtkPlusBuffer>::New();
   trackerBuffer->SetTimeStampReporting(true);
+  trackerBuffer->SetAveragedItemsForFiltering(inputAveragedItemsForFiltering);
   // compute filtered timestamps now to test the filtering
   if (trackerBuffer->CopyTransformFromTrackedFrameList(trackerFrameList, vtkPlusBuffer::READ_UNFILTERED_COMPUTE_FILTERED_TIMESTAMPS, transformName) != PLUS_SUCCESS)
   {
@@ -185,6 +187,59 @@ int main(int argc, char** argv)
     numberOfErrors++;
   }
 
+  // 3. The incrementally computed filtered timestamps shall match the line fitted directly to the last AveragedItemsForFiltering items
+  vtkDoubleArray* reportFrameNumbers = vtkDoubleArray::SafeDownCast(timestampReportTable->GetColumnByName("FrameNumber"));
+  vtkDoubleArray* reportUnfilteredTimestamps = vtkDoubleArray::SafeDownCast(timestampReportTable->GetColumnByName("UnfilteredTimestamp"));
+  vtkDoubleArray* reportFilteredTimestamps = vtkDoubleArray::SafeDownCast(timestampReportTable->GetColumnByName("FilteredTimestamp"));
+  if (reportFrameNumbers == NULL || reportUnfilteredTimestamps == NULL || reportFilteredTimestamps == NULL)
+  {
+    LOG_ERROR("Time stamp report table does not contain the expected columns!");
+    numberOfErrors++;
+  }
+  else
+  {
+    const double maxAllowedFilteringErrorSec = 1e-6;
+    double maxFilteringErrorSec = 0;
+    for (vtkIdType row = inputAveragedItemsForFiltering - 1; row < timestampReportTable->GetNumberOfRows(); ++row)
+    {
+      // Ordinary least squares fit of timestamp = a * frameNumber + b, computed in extended precision
+      long double xMean = 0;
+      long double yMean = 0;
+      for (vtkIdType i = row - inputAveragedItemsForFiltering + 1; i <= row; ++i)
+      {
+        xMean += reportFrameNumbers->GetValue(i);
+        yMean += reportUnfilteredTimestamps->GetValue(i);
+      }
+      xMean /= inputAveragedItemsForFiltering;
+      yMean /= inputAveragedItemsForFiltering;
+      long double covarianceXY = 0;
+      long double varianceX = 0;
+      for (vtkIdType i = row - inputAveragedItemsForFiltering + 1; i <= row; ++i)
+      {
+        long double xiMinusXmean = reportFrameNumbers->GetValue(i) - xMean;
+        covarianceXY += xiMinusXmean * (reportUnfilteredTimestamps->GetValue(i) - yMean);
+        varianceX += xiMinusXmean * xiMinusXmean;
+      }
+      if (varianceX <= 0)
+      {
+        continue;
+      }
+      long double a = covarianceXY / varianceX;
+      double expectedFilteredTimestamp = static_cast<double>(yMean + a * (reportFrameNumbers->GetValue(row) - xMean));
+      double filteringErrorSec = fabs(reportFilteredTimestamps->GetValue(row) - expectedFilteredTimestamp);
+      if (filteringErrorSec > maxFilteringErrorSec)
+      {
+        maxFilteringErrorSec = filteringErrorSec;
+      }
+    }
+    LOG_INFO("Maximum difference from directly fitted filtered timestamps: " << maxFilteringErrorSec * 1e6 << "us");
+    if (maxFilteringErrorSec > maxAllowedFilteringErrorSec)
+    {
+      LOG_ERROR("Filtered timestamps differ from the directly fitted values more than the threshold (difference: " << maxFilteringErrorSec * 1e6 << "us, threshold: " << maxAllowedFilteringErrorSec * 1e6 << "us)");
+      numberOfErrors++;
+    }
+  }
+
   std::string reportFile = vtksys::SystemTools::GetCurrentWorkingDirectory() + std::string("/TimestampReport.txt");
 
   if (PlusPlotter::WriteTableToFile(*timestampReportTable, reportFile.c_str()) != PLUS_SUCCESS)
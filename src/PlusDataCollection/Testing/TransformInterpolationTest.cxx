@@ -162,6 +162,52 @@ int main(int argc, char **argv)
     prevmatrix->DeepCopy(matrix);      
   }
 
+  // Check that batch interpolation gives the same results as individual queries
+  //****************************
+
+  std::vector<double> requestedTimes;
+  for ( double newTime = startTime; newTime < endTime; newTime += 1.0 / (frameRate * 5.0) )
+  {
+    requestedTimes.push_back(newTime); 
+  }
+  std::vector<double> batchMatrixElements(16 * requestedTimes.size()); 
+  std::vector<ToolStatus> batchToolStatuses(requestedTimes.size()); 
+  std::vector<ItemStatus> batchItemStatuses(requestedTimes.size()); 
+  if ( !requestedTimes.empty() && trackerBuffer->GetInterpolatedTransformsFromTimes(&requestedTimes[0], requestedTimes.size(), &batchMatrixElements[0], &batchToolStatuses[0], &batchItemStatuses[0]) != PLUS_SUCCESS )
+  {
+    LOG_ERROR("Failed to get interpolated transforms for multiple timestamps!"); 
+    numberOfErrors++; 
+  }
+  vtkSmartPointer<vtkMatrix4x4> batchMatrix = vtkSmartPointer<vtkMatrix4x4>::New(); 
+  for ( unsigned int timeIndex = 0; timeIndex < requestedTimes.size(); ++timeIndex )
+  {
+    StreamBufferItem bufferItem;
+    ItemStatus itemStatus = trackerBuffer->GetStreamBufferItemFromTime(requestedTimes[timeIndex], &bufferItem, vtkPlusBuffer::INTERPOLATED); 
+    if ( itemStatus != batchItemStatuses[timeIndex] )
+    {
+      LOG_ERROR("Batch and individual item status mismatch (timestamp=" << std::fixed << requestedTimes[timeIndex] << ")!"); 
+      numberOfErrors++; 
+      continue; 
+    }
+    if ( itemStatus != ITEM_OK )
+    {
+      continue; 
+    }
+    if ( bufferItem.GetStatus() != batchToolStatuses[timeIndex] )
+    {
+      LOG_ERROR("Batch and individual tool status mismatch (timestamp=" << std::fixed << requestedTimes[timeIndex] << ")!"); 
+      numberOfErrors++; 
+      continue; 
+    }
+    bufferItem.GetMatrix(matrix); 
+    batchMatrix->DeepCopy(&batchMatrixElements[16 * timeIndex]); 
+    if ( PlusMath::GetPositionDifference(matrix, batchMatrix) > 1e-6 || PlusMath::GetOrientationDifference(matrix, batchMatrix) > 1e-6 )
+    {
+      LOG_ERROR("Batch and individual interpolated transform mismatch (timestamp=" << std::fixed << requestedTimes[timeIndex] << ")!"); 
+      numberOfErrors++; 
+    }
+  }
+
   if ( numberOfErrors != 0 )
   {
     LOG_INFO("Test failed!");
@@ -0,0 +1,243 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file VideoBufferHistoryCompressionTest.cxx
+  \brief Test compressed storage of older frames in a video buffer
+
+  Frames are added to a video buffer with history compression enabled. The test checks that
+  the frames older than the most recent NumberOfUncompressedItems frames are compressed, and that all
+  the frames are retrieved with their original pixel data, timestamps, indices, and UIDs,
+  also after the buffer wraps around and the slots of compressed frames are reused.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusAccurateTimer.h"
+#include "vtkPlusBuffer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+namespace
+{
+  const unsigned int FRAME_SIZE[3] = { 320, 240, 1 };
+  const double FRAME_PERIOD_SEC = 0.05;
+  const double COMPRESSION_TIMEOUT_SEC = 10.0;
+
+  //----------------------------------------------------------------------------
+  unsigned char GetPixelValue(long frameNumber, unsigned int x, unsigned int y)
+  {
+    return static_cast<unsigned char>((x / 4 + y / 8 + frameNumber * 3) & 0xFF);
+  }
+
+  //----------------------------------------------------------------------------
+  double GetFrameTimestamp(long frameNumber)
+  {
+    // Timestamps must be positive, as they must be newer than the initial buffer timestamp
+    return (frameNumber + 1) * FRAME_PERIOD_SEC;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus AddFrames(vtkPlusBuffer* buffer, long firstFrameNumber, int numberOfFrames)
+  {
+    std::vector<unsigned char> pixels(FRAME_SIZE[0] * FRAME_SIZE[1]);
+    const int noClip[3] = { PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP };
+    for (long frameNumber = firstFrameNumber; frameNumber < firstFrameNumber + numberOfFrames; ++frameNumber)
+    {
+      for (unsigned int y = 0; y < FRAME_SIZE[1]; ++y)
+      {
+        for (unsigned int x = 0; x < FRAME_SIZE[0]; ++x)
+        {
+          pixels[y * FRAME_SIZE[0] + x] = GetPixelValue(frameNumber, x, y);
+        }
+      }
+      double timestamp = GetFrameTimestamp(frameNumber);
+      if (buffer->AddItem(&pixels[0], US_IMG_ORIENT_MF, FRAME_SIZE, VTK_UNSIGNED_CHAR, 1, US_IMG_BRIGHTNESS, 0, frameNumber, noClip, noClip, timestamp, timestamp) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add frame " << frameNumber);
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  bool WaitForCompression(vtkPlusBuffer* buffer, int expectedNumberOfCompressedItems)
+  {
+    double startTime = vtkPlusAccurateTimer::GetSystemTime();
+    while (buffer->GetNumberOfCompressedItems() < expectedNumberOfCompressedItems)
+    {
+      if (vtkPlusAccurateTimer::GetSystemTime() - startTime > COMPRESSION_TIMEOUT_SEC)
+      {
+        LOG_ERROR("Only " << buffer->GetNumberOfCompressedItems() << " items were compressed in " << COMPRESSION_TIMEOUT_SEC
+                  << " sec, expected " << expectedNumberOfCompressedItems);
+        return false;
+      }
+      vtkPlusAccurateTimer::Delay(0.01);
+    }
+    if (buffer->GetNumberOfCompressedItems() != expectedNumberOfCompressedItems)
+    {
+      LOG_ERROR(buffer->GetNumberOfCompressedItems() << " items were compressed, expected " << expectedNumberOfCompressedItems);
+      return false;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  int CheckFrames(vtkPlusBuffer* buffer)
+  {
+    int numberOfErrors = 0;
+    StreamBufferItem bufferItem;
+    for (BufferItemUidType uid = buffer->GetOldestItemUidInBuffer(); uid <= buffer->GetLatestItemUidInBuffer(); ++uid)
+    {
+      if (buffer->GetStreamBufferItem(uid, &bufferItem) != ITEM_OK)
+      {
+        LOG_ERROR("Failed to get buffer item " << uid);
+        numberOfErrors++;
+        continue;
+      }
+      long frameNumber = static_cast<long>(bufferItem.GetIndex());
+      if (bufferItem.GetUid() != uid || bufferItem.IsFrameCompressed() || !bufferItem.GetFrame().IsImageValid())
+      {
+        LOG_ERROR("Buffer item " << uid << " is invalid (UID: " << bufferItem.GetUid() << ", compressed: " << bufferItem.IsFrameCompressed() << ")");
+        numberOfErrors++;
+        continue;
+      }
+      if (fabs(bufferItem.GetFilteredTimestamp(buffer->GetLocalTimeOffsetSec()) - GetFrameTimestamp(frameNumber)) > 1e-6)
+      {
+        LOG_ERROR("Timestamp of buffer item " << uid << " is incorrect: " << bufferItem.GetFilteredTimestamp(buffer->GetLocalTimeOffsetSec())
+                  << ", expected " << GetFrameTimestamp(frameNumber));
+        numberOfErrors++;
+      }
+      unsigned int frameSize[3] = { 0, 0, 0 };
+      bufferItem.GetFrame().GetFrameSize(frameSize);
+      if (frameSize[0] != FRAME_SIZE[0] || frameSize[1] != FRAME_SIZE[1] || frameSize[2] != FRAME_SIZE[2])
+      {
+        LOG_ERROR("Frame size of buffer item " << uid << " is incorrect: " << frameSize[0] << "x" << frameSize[1] << "x" << frameSize[2]);
+        numberOfErrors++;
+        continue;
+      }
+      const unsigned char* pixels = static_cast<const unsigned char*>(bufferItem.GetFrame().GetScalarPointer());
+      bool pixelsMatch = true;
+      for (unsigned int y = 0; y < FRAME_SIZE[1] && pixelsMatch; ++y)
+      {
+        for (unsigned int x = 0; x < FRAME_SIZE[0]; ++x)
+        {
+          if (pixels[y * FRAME_SIZE[0] + x] != GetPixelValue(frameNumber, x, y))
+          {
+            LOG_ERROR("Pixel (" << x << ", " << y << ") of buffer item " << uid << " is incorrect");
+            pixelsMatch = false;
+            break;
+          }
+        }
+      }
+      if (!pixelsMatch)
+      {
+        numberOfErrors++;
+      }
+    }
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+  int bufferSize = 100;
+  int numberOfUncompressedItems = 10;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--buffer-size", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &bufferSize, "Number of frames in the buffer (default: 100)");
+  args.AddArgument("--number-of-uncompressed-items", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfUncompressedItems, "Number of most recent frames that are not compressed (default: 10)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (numberOfUncompressedItems < 1 || numberOfUncompressedItems >= bufferSize)
+  {
+    LOG_ERROR("Number of uncompressed items must be between 1 and the buffer size");
+    return EXIT_FAILURE;
+  }
+
+  vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+  buffer->SetFrameSize(FRAME_SIZE[0], FRAME_SIZE[1], FRAME_SIZE[2]);
+  buffer->SetPixelType(VTK_UNSIGNED_CHAR);
+  buffer->SetNumberOfScalarComponents(1);
+  buffer->SetImageType(US_IMG_BRIGHTNESS);
+  buffer->SetImageOrientation(US_IMG_ORIENT_MF);
+  buffer->SetBufferSize(bufferSize);
+  buffer->SetNumberOfUncompressedItems(numberOfUncompressedItems);
+  if (buffer->SetHistoryCompressionEnabled(true) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to enable history compression");
+    return EXIT_FAILURE;
+  }
+
+  int numberOfErrors = 0;
+
+  // Fill the buffer, all but the most recent frames are compressed
+  if (AddFrames(buffer, 0, bufferSize) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  if (!WaitForCompression(buffer, bufferSize - numberOfUncompressedItems))
+  {
+    numberOfErrors++;
+  }
+  size_t compressedSizeInBytes = 0;
+  int numberOfCompressedItems = buffer->GetNumberOfCompressedItems(&compressedSizeInBytes);
+  size_t uncompressedSizeInBytes = numberOfCompressedItems * FRAME_SIZE[0] * FRAME_SIZE[1] * FRAME_SIZE[2];
+  LOG_INFO("Compressed " << numberOfCompressedItems << " frames from " << uncompressedSizeInBytes << " to " << compressedSizeInBytes << " bytes");
+  if (compressedSizeInBytes == 0 || compressedSizeInBytes >= uncompressedSizeInBytes)
+  {
+    LOG_ERROR("Compressed frames are not smaller than the uncompressed frames");
+    numberOfErrors++;
+  }
+  numberOfErrors += CheckFrames(buffer);
+
+  // Wrap around, the slots of compressed frames are reused for new frames
+  if (AddFrames(buffer, bufferSize, bufferSize / 2) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  if (!WaitForCompression(buffer, bufferSize - numberOfUncompressedItems))
+  {
+    numberOfErrors++;
+  }
+  numberOfErrors += CheckFrames(buffer);
+
+  // Compressed frames remain available after compression is disabled
+  buffer->SetHistoryCompressionEnabled(false);
+  if (AddFrames(buffer, bufferSize + bufferSize / 2, numberOfUncompressedItems) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  numberOfErrors += CheckFrames(buffer);
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed with " << numberOfErrors << " errors");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -6,18 +6,337 @@ See License.txt for details.
 
 #include "PlusConfigure.h"
 #include "vtksys/CommandLineArguments.hxx"
+#include <algorithm>
 #include <iomanip>
 
 #include "vtkSmartPointer.h"
 #include "vtkMatrix4x4.h"
 
 #include "vtkPlusMetaImageSequenceIO.h"
+#include "vtkPlusNrrdSequenceIO.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtksys/SystemTools.hxx"
 #include "itkImage.h"
 
 #include "vtkPlusTrackedFrameList.h"
 #include "PlusTrackedFrame.h"
 
 
+///////////////////////////////////////////////////////////////////
+
+// Read each frame individually (first in increasing, then in decreasing frame number order)
+// and compare them to the frames that are read all at once
+int TestReadFramePixels(const std::string& fileName)
+{
+  int numberOfFailures = 0;
+
+  vtkSmartPointer<vtkPlusMetaImageSequenceIO> fullReader = vtkSmartPointer<vtkPlusMetaImageSequenceIO>::New();
+  fullReader->SetFileName(fileName);
+  if (fullReader->Read() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't read sequence metafile: " << fileName);
+    return 1;
+  }
+
+  vtkSmartPointer<vtkPlusMetaImageSequenceIO> frameReader = vtkSmartPointer<vtkPlusMetaImageSequenceIO>::New();
+  frameReader->SetFileName(fileName);
+  if (frameReader->ReadHeader() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't read sequence metafile header: " << fileName);
+    return 1;
+  }
+
+  int numberOfFrames = fullReader->GetTrackedFrameList()->GetNumberOfTrackedFrames();
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (int i = 0; i < numberOfFrames; i++)
+    {
+      int frameNumber = (pass == 0 ? i : numberOfFrames - 1 - i);
+      PlusVideoFrame* expectedFrame = fullReader->GetTrackedFrameList()->GetTrackedFrame(frameNumber)->GetImageData();
+      if (!expectedFrame->IsImageValid())
+      {
+        continue;
+      }
+      PlusVideoFrame frame;
+      if (frameReader->ReadFramePixels(frameNumber, frame) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Couldn't read pixel data of frame " << frameNumber << " from " << fileName);
+        numberOfFailures++;
+        continue;
+      }
+      if (frame.GetFrameSizeInBytes() != expectedFrame->GetFrameSizeInBytes()
+          || memcmp(frame.GetScalarPointer(), expectedFrame->GetScalarPointer(), frame.GetFrameSizeInBytes()) != 0)
+      {
+        LOG_ERROR("Pixel data of frame " << frameNumber << " is different when read individually from " << fileName);
+        numberOfFailures++;
+      }
+    }
+  }
+
+  return numberOfFailures;
+}
+
+///////////////////////////////////////////////////////////////////
+
+// Read only some of the frame fields from the header and compare them to the fields that are read when all fields are read
+int TestReadSelectedFrameFields(const std::string& fileName)
+{
+  int numberOfFailures = 0;
+
+  vtkSmartPointer<vtkPlusMetaImageSequenceIO> fullReader = vtkSmartPointer<vtkPlusMetaImageSequenceIO>::New();
+  fullReader->SetFileName(fileName);
+  if (fullReader->ReadHeader() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't read sequence metafile header: " << fileName);
+    return 1;
+  }
+
+  std::vector<std::string> fieldNamesToRead;
+  fieldNamesToRead.push_back("Timestamp");
+  fieldNamesToRead.push_back("ToolToTrackerTransform");
+  vtkSmartPointer<vtkPlusMetaImageSequenceIO> selectiveReader = vtkSmartPointer<vtkPlusMetaImageSequenceIO>::New();
+  selectiveReader->SetFileName(fileName);
+  selectiveReader->SetFrameFieldNamesToRead(fieldNamesToRead);
+  if (selectiveReader->ReadHeader() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't read sequence metafile header: " << fileName);
+    return 1;
+  }
+
+  vtkPlusTrackedFrameList* fullFrameList = fullReader->GetTrackedFrameList();
+  vtkPlusTrackedFrameList* selectiveFrameList = selectiveReader->GetTrackedFrameList();
+  if (selectiveFrameList->GetNumberOfTrackedFrames() != fullFrameList->GetNumberOfTrackedFrames())
+  {
+    LOG_ERROR("Number of frames is " << selectiveFrameList->GetNumberOfTrackedFrames() << " when only selected fields are read from "
+              << fileName << ", expected " << fullFrameList->GetNumberOfTrackedFrames());
+    return 1;
+  }
+  for (unsigned int frameNumber = 0; frameNumber < fullFrameList->GetNumberOfTrackedFrames(); frameNumber++)
+  {
+    PlusTrackedFrame* fullFrame = fullFrameList->GetTrackedFrame(frameNumber);
+    PlusTrackedFrame* selectiveFrame = selectiveFrameList->GetTrackedFrame(frameNumber);
+    for (PlusTrackedFrame::FieldMapType::const_iterator fieldIt = fullFrame->GetCustomFields().begin(); fieldIt != fullFrame->GetCustomFields().end(); ++fieldIt)
+    {
+      // Image status is always read
+      bool expectedToBeRead = (std::find(fieldNamesToRead.begin(), fieldNamesToRead.end(), fieldIt->first) != fieldNamesToRead.end()
+                               || fieldIt->first == "ImageStatus");
+      const char* selectiveValue = selectiveFrame->GetCustomFrameField(fieldIt->first);
+      if (expectedToBeRead && (selectiveValue == NULL || fieldIt->second != selectiveValue))
+      {
+        LOG_ERROR("Field " << fieldIt->first << " of frame " << frameNumber << " is different when only selected fields are read from " << fileName);
+        numberOfFailures++;
+      }
+      else if (!expectedToBeRead && selectiveValue != NULL)
+      {
+        LOG_ERROR("Field " << fieldIt->first << " of frame " << frameNumber << " is read, although it is not selected, from " << fileName);
+        numberOfFailures++;
+      }
+    }
+  }
+
+  return numberOfFailures;
+}
+
+///////////////////////////////////////////////////////////////////
+
+// Write a tracking-only sequence where the trailing frames contain none of the selected fields,
+// and check that the frames are still read when only selected fields are read
+int TestReadSelectedFrameFieldsMissingOnTrailingFrames(const std::string& fileName)
+{
+  const int numberOfFrames = 8;
+  const int numberOfFramesWithSelectedFields = 5;
+  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  for (int frameNumber = 0; frameNumber < numberOfFrames; frameNumber++)
+  {
+    PlusTrackedFrame frame;
+    std::ostringstream frameNumberStr;
+    frameNumberStr << frameNumber;
+    frame.SetCustomFrameField("FrameNumber", frameNumberStr.str());
+    frame.SetTimestamp(1.0 + frameNumber * 0.1);
+    if (frameNumber < numberOfFramesWithSelectedFields)
+    {
+      vtkSmartPointer<vtkMatrix4x4> toolToTrackerMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      toolToTrackerMatrix->SetElement(0, 3, frameNumber);
+      frame.SetCustomFrameTransform(PlusTransformName("Tool", "Tracker"), toolToTrackerMatrix);
+    }
+    trackedFrameList->AddTrackedFrame(&frame, vtkPlusTrackedFrameList::ADD_INVALID_FRAME);
+  }
+
+  // Without image data the ImageStatus field is not written, so the trailing frames have no ToolToTrackerTransform or ImageStatus field
+  vtkSmartPointer<vtkPlusMetaImageSequenceIO> writer = vtkSmartPointer<vtkPlusMetaImageSequenceIO>::New();
+  writer->SetFileName(fileName);
+  writer->SetTrackedFrameList(trackedFrameList);
+  writer->SetEnableImageDataWrite(false);
+  if (writer->Write() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't write sequence metafile: " << fileName);
+    return 1;
+  }
+
+  int numberOfFailures = TestReadSelectedFrameFields(fileName);
+
+  std::vector<std::string> fieldNamesToRead;
+  fieldNamesToRead.push_back("ToolToTrackerTransform");
+  vtkSmartPointer<vtkPlusMetaImageSequenceIO> selectiveReader = vtkSmartPointer<vtkPlusMetaImageSequenceIO>::New();
+  selectiveReader->SetFileName(fileName);
+  selectiveReader->SetFrameFieldNamesToRead(fieldNamesToRead);
+  if (selectiveReader->ReadHeader() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't read sequence metafile header: " << fileName);
+    return numberOfFailures + 1;
+  }
+  if (selectiveReader->GetTrackedFrameList()->GetNumberOfTrackedFrames() != numberOfFrames)
+  {
+    LOG_ERROR("Number of frames is " << selectiveReader->GetTrackedFrameList()->GetNumberOfTrackedFrames() << " when only selected fields are read from "
+              << fileName << ", expected " << numberOfFrames);
+    numberOfFailures++;
+  }
+
+  return numberOfFailures;
+}
+
+///////////////////////////////////////////////////////////////////
+
+// Write a sequence with sequential and parallel compression into MetaImage and NRRD files
+// (at once and in chunks of frames, as the virtual capture device does),
+// and compare the frames that are read back from the files to the original frames
+int TestParallelCompression(const std::string& outputFileNameBase)
+{
+  int numberOfFailures = 0;
+
+  // Frames are large enough that the pixel data is compressed in multiple blocks
+  const int frameSize[3] = {640, 480, 1};
+  const int numberOfFrames = 30;
+  const int invalidFrameNumber = 7;
+  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  for (int frameNumber = 0; frameNumber < numberOfFrames; frameNumber++)
+  {
+    PlusTrackedFrame frame;
+    if (frameNumber != invalidFrameNumber)
+    {
+      frame.GetImageData()->AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1);
+      unsigned char* pixels = static_cast<unsigned char*>(frame.GetImageData()->GetScalarPointer());
+      for (int y = 0; y < frameSize[1]; y++)
+      {
+        for (int x = 0; x < frameSize[0]; x++)
+        {
+          pixels[y * frameSize[0] + x] = static_cast<unsigned char>(x / 3 + y / 5 + frameNumber * 7 + (x * y) % 11);
+        }
+      }
+    }
+    std::ostringstream frameNumberStr;
+    frameNumberStr << frameNumber;
+    frame.SetCustomFrameField("FrameNumber", frameNumberStr.str());
+    frame.SetTimestamp(1.0 + frameNumber * 0.1);
+    trackedFrameList->AddTrackedFrame(&frame);
+  }
+
+  const int framesPerChunk = 4;
+  const char* fileNameSuffixes[5] = {"Sequential.mha", "Parallel.mha", "Parallel.nrrd", "ParallelChunked.mha", "ParallelChunked.nrrd"};
+  for (int testCase = 0; testCase < 5; testCase++)
+  {
+    std::string fileName = outputFileNameBase + fileNameSuffixes[testCase];
+    bool nrrd = (testCase == 2 || testCase == 4);
+    bool chunked = (testCase >= 3);
+    vtkSmartPointer<vtkPlusSequenceIOBase> writer;
+    if (nrrd)
+    {
+      writer.TakeReference(vtkPlusNrrdSequenceIO::New());
+    }
+    else
+    {
+      writer.TakeReference(vtkPlusMetaImageSequenceIO::New());
+    }
+    writer->UseCompressionOn();
+    writer->SetParallelCompression(testCase > 0);
+    writer->SetNumberOfThreads(4);
+    if (!chunked)
+    {
+      writer->SetFileName(fileName);
+      writer->SetTrackedFrameList(trackedFrameList);
+      if (writer->Write() != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Couldn't write sequence file: " << fileName);
+        numberOfFailures++;
+        continue;
+      }
+    }
+    else
+    {
+      // Each WriteImages call continues the same compressed stream
+      vtkSmartPointer<vtkPlusTrackedFrameList> chunkTrackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+      writer->SetTrackedFrameList(chunkTrackedFrameList);
+      writer->SetFileName(fileName);
+      bool writeFailed = false;
+      for (int firstFrameNumber = 0; firstFrameNumber < numberOfFrames && !writeFailed; firstFrameNumber += framesPerChunk)
+      {
+        chunkTrackedFrameList->Clear();
+        for (int frameNumber = firstFrameNumber; frameNumber < std::min(firstFrameNumber + framesPerChunk, numberOfFrames); frameNumber++)
+        {
+          chunkTrackedFrameList->AddTrackedFrame(trackedFrameList->GetTrackedFrame(frameNumber), vtkPlusTrackedFrameList::ADD_INVALID_FRAME);
+        }
+        if ((firstFrameNumber == 0 && writer->PrepareHeader() != PLUS_SUCCESS)
+            || writer->AppendImagesToHeader() != PLUS_SUCCESS
+            || writer->WriteImages() != PLUS_SUCCESS)
+        {
+          writeFailed = true;
+        }
+      }
+      if (writeFailed
+          || writer->UpdateDimensionsCustomStrings(numberOfFrames, false) != PLUS_SUCCESS
+          || writer->UpdateFieldInImageHeader(writer->GetDimensionSizeString()) != PLUS_SUCCESS
+          || writer->UpdateFieldInImageHeader(writer->GetDimensionKindsString()) != PLUS_SUCCESS
+          || writer->FinalizeHeader() != PLUS_SUCCESS
+          || writer->Close() != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Couldn't write sequence file in chunks: " << fileName);
+        numberOfFailures++;
+        continue;
+      }
+    }
+
+    vtkSmartPointer<vtkPlusTrackedFrameList> readTrackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    if (vtkPlusSequenceIO::Read(fileName, readTrackedFrameList) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Couldn't read sequence file: " << fileName);
+      numberOfFailures++;
+      continue;
+    }
+    if (readTrackedFrameList->GetNumberOfTrackedFrames() != numberOfFrames)
+    {
+      LOG_ERROR("Number of frames read from " << fileName << " is " << readTrackedFrameList->GetNumberOfTrackedFrames() << ", expected " << numberOfFrames);
+      numberOfFailures++;
+      continue;
+    }
+    for (int frameNumber = 0; frameNumber < numberOfFrames; frameNumber++)
+    {
+      PlusTrackedFrame* expectedFrame = trackedFrameList->GetTrackedFrame(frameNumber);
+      PlusTrackedFrame* frame = readTrackedFrameList->GetTrackedFrame(frameNumber);
+      if (std::string(frame->GetCustomFrameField("FrameNumber")) != expectedFrame->GetCustomFrameField("FrameNumber")
+          || fabs(frame->GetTimestamp() - expectedFrame->GetTimestamp()) > 1e-6)
+      {
+        LOG_ERROR("Fields of frame " << frameNumber << " are different when read from " << fileName);
+        numberOfFailures++;
+      }
+      if (frame->GetImageData()->IsImageValid() != expectedFrame->GetImageData()->IsImageValid())
+      {
+        LOG_ERROR("Image status of frame " << frameNumber << " is different when read from " << fileName);
+        numberOfFailures++;
+        continue;
+      }
+      if (expectedFrame->GetImageData()->IsImageValid()
+          && (frame->GetImageData()->GetFrameSizeInBytes() != expectedFrame->GetImageData()->GetFrameSizeInBytes()
+              || memcmp(frame->GetImageData()->GetScalarPointer(), expectedFrame->GetImageData()->GetScalarPointer(), frame->GetImageData()->GetFrameSizeInBytes()) != 0))
+      {
+        LOG_ERROR("Pixel data of frame " << frameNumber << " is different when read from " << fileName);
+        numberOfFailures++;
+      }
+    }
+  }
+
+  return numberOfFailures;
+}
+
 ///////////////////////////////////////////////////////////////////
 
 int main(int argc, char **argv)
@@ -209,6 +528,30 @@ int main(int argc, char **argv)
 
   }
 
+  // ******************************************************************************
+  // Test reading individual frames from uncompressed and compressed files
+
+  LOG_INFO("Test ReadFramePixels method ...");
+  numberOfFailures += TestReadFramePixels(inputImageSequenceFileName);
+  numberOfFailures += TestReadFramePixels(outputImageSequenceFileName);
+
+  // ******************************************************************************
+  // Test reading only selected frame fields
+
+  LOG_INFO("Test SetFrameFieldNamesToRead method ...");
+  numberOfFailures += TestReadSelectedFrameFields(outputImageSequenceFileName);
+
+  // ******************************************************************************
+  // Test writing with parallel compression
+
+  LOG_INFO("Test parallel compression ...");
+  std::string outputFileNameBase = vtksys::SystemTools::GetFilenamePath(outputImageSequenceFileName) + "/"
+                                   + vtksys::SystemTools::GetFilenameWithoutLastExtension(outputImageSequenceFileName);
+  numberOfFailures += TestParallelCompression(outputFileNameBase);
+
+  LOG_INFO("Test SetFrameFieldNamesToRead method with fields missing from the trailing frames ...");
+  numberOfFailures += TestReadSelectedFrameFieldsMissingOnTrailingFrames(outputFileNameBase + "TrackingOnly.mha");
+
   // ****************************************************************************** 
   // Test image status 
 
@@ -0,0 +1,226 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkSavedDataSourceStreamingTest.cxx
+  \brief This program tests if a compressed sequence file is replayed correctly by vtkPlusSavedDataSource in streaming mode.
+
+  A compressed sequence file is written, then it is replayed repeatedly (so that the playback wraps around at the end
+  of the loop). Each replayed frame is compared to the corresponding frame that is read by vtkPlusSequenceIO::Read.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusTrackedFrame.h"
+#include "vtkPlusChannel.h"
+#include "vtkPlusDataCollector.h"
+#include "vtkPlusDataSource.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtkSmartPointer.h"
+#include "vtkXMLUtilities.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+namespace
+{
+  const char SOURCE_FRAME_INDEX_FIELD_NAME[] = "SourceFrameIndex";
+}
+
+//----------------------------------------------------------------------------
+PlusStatus WriteTestSequence(const std::string& fileName, int numberOfFrames)
+{
+  const int frameSize[3] = {320, 240, 1};
+  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  for (int frameIndex = 0; frameIndex < numberOfFrames; frameIndex++)
+  {
+    PlusTrackedFrame frame;
+    frame.GetImageData()->AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1);
+    unsigned char* pixels = static_cast<unsigned char*>(frame.GetImageData()->GetScalarPointer());
+    for (int y = 0; y < frameSize[1]; y++)
+    {
+      for (int x = 0; x < frameSize[0]; x++)
+      {
+        pixels[y * frameSize[0] + x] = static_cast<unsigned char>(x / 2 + y / 3 + frameIndex * 13 + (x * y) % 7);
+      }
+    }
+    std::ostringstream frameIndexStr;
+    frameIndexStr << frameIndex;
+    frame.SetCustomFrameField(SOURCE_FRAME_INDEX_FIELD_NAME, frameIndexStr.str());
+    frame.SetTimestamp(1.0 + frameIndex * 0.05);
+    trackedFrameList->AddTrackedFrame(&frame);
+  }
+  return vtkPlusSequenceIO::Write(fileName, trackedFrameList, US_IMG_ORIENT_MF, true);
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  std::string outputFileName("SavedDataSourceStreamingTest.mha");
+  int numberOfFrames = 10;
+  int numberOfLoops = 3;
+  int streamingWindowSize = 2;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--output-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &outputFileName, "Name of the compressed sequence file that is written and then replayed.");
+  args.AddArgument("--number-of-frames", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfFrames, "Number of frames in the sequence file.");
+  args.AddArgument("--number-of-loops", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfLoops, "Number of times the sequence is replayed.");
+  args.AddArgument("--streaming-window-size", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &streamingWindowSize, "Number of frames that are read ahead of the playback position.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments." << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (numberOfFrames < 2 || numberOfLoops < 2)
+  {
+    LOG_ERROR("At least 2 frames and 2 loops are needed to test the wrap-around at the end of the loop");
+    exit(EXIT_FAILURE);
+  }
+
+  std::string sequenceFilePath = vtkPlusConfig::GetInstance()->GetOutputPath(outputFileName);
+  if (WriteTestSequence(sequenceFilePath, numberOfFrames) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to write test sequence file: " << sequenceFilePath);
+    exit(EXIT_FAILURE);
+  }
+
+  // Reference frames
+  vtkSmartPointer<vtkPlusTrackedFrameList> expectedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (vtkPlusSequenceIO::Read(sequenceFilePath, expectedFrameList) != PLUS_SUCCESS
+      || expectedFrameList->GetNumberOfTrackedFrames() != numberOfFrames)
+  {
+    LOG_ERROR("Failed to read test sequence file: " << sequenceFilePath);
+    exit(EXIT_FAILURE);
+  }
+
+  // Replay the file in streaming mode. Each update adds the next frame, so all the frames are replayed in order.
+  const int numberOfFramesToReplay = numberOfFrames * numberOfLoops;
+  std::ostringstream config;
+  config << "<PlusConfiguration version=\"2.1\">"
+         << "<DataCollection StartupDelaySec=\"1.0\">"
+         << "<DeviceSet Name=\"SavedDataSourceStreamingTest\" Description=\"Replay a compressed sequence file in streaming mode\" />"
+         << "<Device Id=\"VideoDevice\" Type=\"SavedDataSource\" SequenceFile=\"" << sequenceFilePath << "\""
+         << " UseData=\"IMAGE_AND_TRANSFORM\" UseOriginalTimestamps=\"FALSE\" RepeatEnabled=\"TRUE\""
+         << " StreamingEnabled=\"TRUE\" StreamingWindowSize=\"" << streamingWindowSize << "\" AcquisitionRate=\"50\">"
+         << "<DataSources><DataSource Type=\"Video\" Id=\"Video\" PortUsImageOrientation=\"MF\" BufferSize=\"" << numberOfFramesToReplay * 2 << "\" /></DataSources>"
+         << "<OutputChannels><OutputChannel Id=\"VideoStream\" VideoDataSourceId=\"Video\" /></OutputChannels>"
+         << "</Device>"
+         << "</DataCollection>"
+         << "</PlusConfiguration>";
+  vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(config.str().c_str()));
+  if (configRootElement == NULL)
+  {
+    LOG_ERROR("Failed to parse device set configuration");
+    exit(EXIT_FAILURE);
+  }
+  vtkPlusConfig::GetInstance()->SetDeviceSetConfigurationData(configRootElement);
+
+  vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+  if (dataCollector->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read device set configuration");
+    exit(EXIT_FAILURE);
+  }
+  if (dataCollector->Connect() != PLUS_SUCCESS || dataCollector->Start() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to start data collection");
+    exit(EXIT_FAILURE);
+  }
+
+  vtkPlusDevice* device = NULL;
+  vtkPlusChannel* channel = NULL;
+  vtkPlusDataSource* videoSource = NULL;
+  if (dataCollector->GetDevice(device, "VideoDevice") != PLUS_SUCCESS
+      || device->GetOutputChannelByName(channel, "VideoStream") != PLUS_SUCCESS
+      || channel->GetVideoSource(videoSource) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to locate the video source of the saved data source device");
+    dataCollector->Disconnect();
+    exit(EXIT_FAILURE);
+  }
+
+  const double timeoutSec = 20.0;
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  while (videoSource->GetNumberOfItems() < numberOfFramesToReplay)
+  {
+    if (vtkPlusAccurateTimer::GetSystemTime() - startTime > timeoutSec)
+    {
+      LOG_ERROR("Only " << videoSource->GetNumberOfItems() << " frames were replayed in " << timeoutSec << "s, expected " << numberOfFramesToReplay);
+      dataCollector->Disconnect();
+      exit(EXIT_FAILURE);
+    }
+    vtkPlusAccurateTimer::Delay(0.05);
+  }
+  dataCollector->Stop();
+
+  int numberOfFailures = 0;
+  int numberOfWrapArounds = 0;
+  int previousFrameIndex = -1;
+  BufferItemUidType oldestUid = videoSource->GetOldestItemUidInBuffer();
+  for (BufferItemUidType uid = oldestUid; uid < oldestUid + numberOfFramesToReplay; uid++)
+  {
+    StreamBufferItem bufferItem;
+    if (videoSource->GetStreamBufferItem(uid, &bufferItem) != ITEM_OK)
+    {
+      LOG_ERROR("Failed to get replayed frame from the buffer, UID=" << uid);
+      numberOfFailures++;
+      continue;
+    }
+    const char* frameIndexStr = bufferItem.GetCustomFrameField(SOURCE_FRAME_INDEX_FIELD_NAME);
+    int frameIndex = -1;
+    if (frameIndexStr == NULL || PlusCommon::StringToInt(frameIndexStr, frameIndex) != PLUS_SUCCESS
+        || frameIndex < 0 || frameIndex >= numberOfFrames)
+    {
+      LOG_ERROR("Replayed frame UID=" << uid << " has no valid " << SOURCE_FRAME_INDEX_FIELD_NAME << " field");
+      numberOfFailures++;
+      continue;
+    }
+
+    // Frames must be replayed in order, starting over from the first frame at the end of the loop
+    if (previousFrameIndex >= 0 && frameIndex != (previousFrameIndex + 1) % numberOfFrames)
+    {
+      LOG_ERROR("Frame " << frameIndex << " is replayed after frame " << previousFrameIndex);
+      numberOfFailures++;
+    }
+    if (previousFrameIndex == numberOfFrames - 1 && frameIndex == 0)
+    {
+      numberOfWrapArounds++;
+    }
+    previousFrameIndex = frameIndex;
+
+    PlusVideoFrame* expectedFrame = expectedFrameList->GetTrackedFrame(frameIndex)->GetImageData();
+    PlusVideoFrame& frame = bufferItem.GetFrame();
+    if (frame.GetFrameSizeInBytes() != expectedFrame->GetFrameSizeInBytes()
+        || memcmp(frame.GetScalarPointer(), expectedFrame->GetScalarPointer(), frame.GetFrameSizeInBytes()) != 0)
+    {
+      LOG_ERROR("Pixel data of replayed frame " << frameIndex << " (UID=" << uid << ") differs from the frame in the sequence file");
+      numberOfFailures++;
+    }
+  }
+
+  if (numberOfWrapArounds == 0)
+  {
+    LOG_ERROR("The playback did not wrap around at the end of the loop");
+    numberOfFailures++;
+  }
+
+  dataCollector->Disconnect();
+
+  if (numberOfFailures > 0)
+  {
+    LOG_ERROR("Test failed, number of failures: " << numberOfFailures);
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
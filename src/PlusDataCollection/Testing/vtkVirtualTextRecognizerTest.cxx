@@ -7,8 +7,10 @@
 #include "PlusConfigure.h"
 #include "vtkPlusDataCollector.h"
 #include "vtkPlusVirtualTextRecognizer.h"
+#include "vtkXMLDataElement.h"
 #include "vtksys/CommandLineArguments.hxx"
 #include <map>
+#include <vector>
 
 int main(int argc, char **argv)
 {
@@ -16,6 +18,7 @@ int main(int argc, char **argv)
   std::string inputConfigFileName;
   std::string deviceId;
   std::string fieldValue;
+  int numberOfFields(1);
 
   vtksys::CommandLineArguments args;
   args.Initialize(argc, argv);
@@ -26,6 +29,7 @@ int main(int argc, char **argv)
   args.AddArgument("--config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputConfigFileName, "Config file to test with.");
   args.AddArgument("--device-id", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &deviceId, "Id of the text recognizer device.");
   args.AddArgument("--field-value", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &fieldValue, "Value of the first field.");
+  args.AddArgument("--number-of-fields", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfFields, "Number of fields to recognize. Additional fields are copies of the first field and they are recognized in parallel (default: 1).");
   args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
 
   if ( !args.Parse() )
@@ -56,6 +60,30 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  if( numberOfFields > 1 )
+  {
+    // Add copies of the first field, so that multiple fields of the same channel are recognized in parallel
+    vtkXMLDataElement* dataCollectionElement = configRootElement->FindNestedElementWithName("DataCollection");
+    vtkXMLDataElement* deviceElement = (dataCollectionElement != NULL ? dataCollectionElement->FindNestedElementWithNameAndAttribute("Device", "Id", deviceId.c_str()) : NULL);
+    vtkXMLDataElement* textFieldsElement = (deviceElement != NULL ? deviceElement->FindNestedElementWithName("TextFields") : NULL);
+    vtkXMLDataElement* firstFieldElement = (textFieldsElement != NULL ? textFieldsElement->FindNestedElementWithName("Field") : NULL);
+    if( firstFieldElement == NULL || firstFieldElement->GetAttribute("Name") == NULL )
+    {
+      LOG_ERROR("Unable to find the first text field of device " << deviceId << " in the configuration");
+      return EXIT_FAILURE;
+    }
+    for( int i = 1; i < numberOfFields; ++i )
+    {
+      vtkSmartPointer<vtkXMLDataElement> fieldElement = vtkSmartPointer<vtkXMLDataElement>::New();
+      fieldElement->DeepCopy(firstFieldElement);
+      std::ostringstream fieldName;
+      fieldName << firstFieldElement->GetAttribute("Name") << "Copy" << i;
+      fieldElement->SetAttribute("Name", fieldName.str().c_str());
+      textFieldsElement->AddNestedElement(fieldElement);
+    }
+    deviceElement->SetIntAttribute("NumberOfThreads", numberOfFields);
+  }
+
   vtkPlusConfig::GetInstance()->SetDeviceSetConfigurationData(configRootElement);
 
   vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
@@ -94,28 +122,80 @@ int main(int argc, char **argv)
   }
 
   textRecognizer->SetMissingInputGracePeriodSec(0);
-  
-#ifdef _WIN32
-  Sleep(500);
-#else
-  usleep(500000);
-#endif 
 
   vtkPlusVirtualTextRecognizer::ChannelFieldListMap map = textRecognizer->GetRecognitionFields();
-  vtkPlusVirtualTextRecognizer::FieldListIterator it = map.begin()->second.begin();
-  if( (*it)->LatestParameterValue != fieldValue )
+  std::vector<std::string> parameterNames;
+  for( vtkPlusVirtualTextRecognizer::ChannelFieldListMapIterator mapIt = map.begin(); mapIt != map.end(); ++mapIt )
+  {
+    for( vtkPlusVirtualTextRecognizer::FieldListIterator it = mapIt->second.begin(); it != mapIt->second.end(); ++it )
+    {
+      parameterNames.push_back((*it)->ParameterName);
+    }
+  }
+  if( parameterNames.size() != static_cast<size_t>(numberOfFields) )
   {
-    LOG_ERROR("Direct: Parameter \"" << (*it)->ParameterName << "\" value=\"" << (*it)->LatestParameterValue << "\" does not match expected value=\"" << fieldValue << "\"");
+    LOG_ERROR("Number of text fields is " << parameterNames.size() << ", expected " << numberOfFields);
     return EXIT_FAILURE;
   }
 
+  // The input image is static, so after the first recognition of each field the recognition is skipped.
+  // Wait until all fields are recognized and then skipped at least once.
+  const int maximumNumberOfWaits = 50;
+  bool allFieldsSkipped(false);
+  for( int waitCount = 0; waitCount < maximumNumberOfWaits && !allFieldsSkipped; ++waitCount )
+  {
+#ifdef _WIN32
+    Sleep(100);
+#else
+    usleep(100000);
+#endif
+    allFieldsSkipped = true;
+    for( std::vector<std::string>::iterator nameIt = parameterNames.begin(); nameIt != parameterNames.end(); ++nameIt )
+    {
+      unsigned long numberOfRecognitions(0);
+      unsigned long numberOfSkippedRecognitions(0);
+      if( textRecognizer->GetFieldRecognitionCounts(*nameIt, numberOfRecognitions, numberOfSkippedRecognitions) != PLUS_SUCCESS
+          || numberOfRecognitions == 0 || numberOfSkippedRecognitions == 0 )
+      {
+        allFieldsSkipped = false;
+        break;
+      }
+    }
+  }
+
   PlusTrackedFrame frame;
   (*device->GetOutputChannelsStart())->GetTrackedFrame(frame);
 
-  if( frame.GetCustomFrameField((*it)->ParameterName) == NULL || STRCASECMP(frame.GetCustomFrameField((*it)->ParameterName), fieldValue.c_str()) != 0 )
+  for( vtkPlusVirtualTextRecognizer::ChannelFieldListMapIterator mapIt = map.begin(); mapIt != map.end(); ++mapIt )
   {
-    LOG_ERROR("Tracked Frame: Parameter \"" << (*it)->ParameterName << "\" value=\"" << (*it)->LatestParameterValue << "\" does not match expected value=\"" << fieldValue << "\"");
-    return EXIT_FAILURE;
+    for( vtkPlusVirtualTextRecognizer::FieldListIterator it = mapIt->second.begin(); it != mapIt->second.end(); ++it )
+    {
+      if( (*it)->LatestParameterValue != fieldValue )
+      {
+        LOG_ERROR("Direct: Parameter \"" << (*it)->ParameterName << "\" value=\"" << (*it)->LatestParameterValue << "\" does not match expected value=\"" << fieldValue << "\"");
+        return EXIT_FAILURE;
+      }
+
+      if( frame.GetCustomFrameField((*it)->ParameterName) == NULL || STRCASECMP(frame.GetCustomFrameField((*it)->ParameterName), fieldValue.c_str()) != 0 )
+      {
+        LOG_ERROR("Tracked Frame: Parameter \"" << (*it)->ParameterName << "\" value=\"" << (*it)->LatestParameterValue << "\" does not match expected value=\"" << fieldValue << "\"");
+        return EXIT_FAILURE;
+      }
+
+      unsigned long numberOfRecognitions(0);
+      unsigned long numberOfSkippedRecognitions(0);
+      if( textRecognizer->GetFieldRecognitionCounts((*it)->ParameterName, numberOfRecognitions, numberOfSkippedRecognitions) != PLUS_SUCCESS || numberOfRecognitions == 0 )
+      {
+        LOG_ERROR("Parameter \"" << (*it)->ParameterName << "\" has not been recognized");
+        return EXIT_FAILURE;
+      }
+      LOG_INFO("Parameter \"" << (*it)->ParameterName << "\" recognized " << numberOfRecognitions << " times, skipped " << numberOfSkippedRecognitions << " times (unchanged screen region)");
+      if( numberOfSkippedRecognitions == 0 )
+      {
+        LOG_ERROR("Parameter \"" << (*it)->ParameterName << "\" is recognized again although the input image is static");
+        return EXIT_FAILURE;
+      }
+    }
   }
 
   LOG_INFO("Exit successfully");
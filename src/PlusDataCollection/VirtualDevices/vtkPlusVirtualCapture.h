@@ -76,6 +76,9 @@ public:
   vtkGetMacro(EnableFileCompression, bool);
   void SetEnableFileCompression(bool aFileCompression);
 
+  vtkGetMacro(EnableParallelCompression, bool);
+  vtkSetMacro(EnableParallelCompression, bool);
+
   vtkSetMacro(EnableCapturingOnStart, bool);
   vtkGetMacro(EnableCapturingOnStart, bool);
 
@@ -152,6 +155,9 @@ protected:
   /*! When closing the file, re-read the data from file, and write it compressed */
   bool EnableFileCompression;
 
+  /*! If file compression is enabled then compress the frames of each written chunk in parallel */
+  bool EnableParallelCompression;
+
   /*! Preparing the header requires image data already collected, this flag makes the header preparation wait until valid data is collected */
   bool IsHeaderPrepared;
 
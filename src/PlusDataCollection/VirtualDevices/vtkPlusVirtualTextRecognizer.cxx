@@ -14,6 +14,10 @@ See License.txt for details.
 #include "vtkPlusTrackedFrameList.h"
 #include "vtkPlusVirtualTextRecognizer.h"
 
+#include <algorithm>
+#include <list>
+#include <string.h>
+
 #include <tesseract/baseapi.h>
 #include <tesseract/strngs.h>
 #include <allheaders.h>
@@ -37,12 +41,21 @@ static const char* DEFAULT_LANGUAGE = "eng";
 static const int TEXT_RECOGNIZER_MISSING_INPUT_DEFAULT = 1;
 }
 
+//----------------------------------------------------------------------------
+struct vtkPlusVirtualTextRecognizer::RecognizeFieldsThreadInfo
+{
+  vtkPlusVirtualTextRecognizer* Self;
+  std::vector<TextFieldParameter*> Fields;
+};
+
 //----------------------------------------------------------------------------
 vtkPlusVirtualTextRecognizer::vtkPlusVirtualTextRecognizer()
   : vtkPlusDevice()
   , Language(NULL)
   , TrackedFrames(vtkPlusTrackedFrameList::New())
   , OutputChannel(NULL)
+  , RecognitionThreader(vtkMultiThreader::New())
+  , NumberOfThreads(0)
 {
   // The data capture thread will be used to regularly check the input devices and generate and update the output
   this->StartThreadForInternalUpdates = true;
@@ -57,6 +70,11 @@ void vtkPlusVirtualTextRecognizer::ClearConfiguration()
     for( FieldListIterator fieldIt = it->second.begin(); fieldIt != it->second.end(); ++fieldIt )
     {
       TextFieldParameter* parameter = *fieldIt;
+      delete parameter->TesseractAPI;
+      if (parameter->ReceivedFrame != NULL)
+      {
+        pixDestroy(&parameter->ReceivedFrame);
+      }
       delete parameter;
     }
     it->second.clear();
@@ -69,12 +87,45 @@ vtkPlusVirtualTextRecognizer::~vtkPlusVirtualTextRecognizer()
 {
   TrackedFrames->Delete();
   TrackedFrames = NULL;
+  this->RecognitionThreader->Delete();
+  this->RecognitionThreader = NULL;
 }
 
 //----------------------------------------------------------------------------
 void vtkPlusVirtualTextRecognizer::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << std::endl;
+  for( ChannelFieldListMapIterator it = this->RecognitionFields.begin(); it != this->RecognitionFields.end(); ++it )
+  {
+    for( FieldListIterator fieldIt = it->second.begin(); fieldIt != it->second.end(); ++fieldIt )
+    {
+      os << indent << "Field " << (*fieldIt)->ParameterName << ": " << (*fieldIt)->NumberOfRecognitions << " recognitions, "
+         << (*fieldIt)->NumberOfSkippedRecognitions << " skipped (unchanged screen region)" << std::endl;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualTextRecognizer::GetFieldRecognitionCounts(const std::string& parameterName, unsigned long& numberOfRecognitions, unsigned long& numberOfSkippedRecognitions)
+{
+  // The counters are updated in InternalUpdate
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->UpdateMutex);
+  for( ChannelFieldListMapIterator it = this->RecognitionFields.begin(); it != this->RecognitionFields.end(); ++it )
+  {
+    for( FieldListIterator fieldIt = it->second.begin(); fieldIt != it->second.end(); ++fieldIt )
+    {
+      if( (*fieldIt)->ParameterName == parameterName )
+      {
+        numberOfRecognitions = (*fieldIt)->NumberOfRecognitions;
+        numberOfSkippedRecognitions = (*fieldIt)->NumberOfSkippedRecognitions;
+        return PLUS_SUCCESS;
+      }
+    }
+  }
+  LOG_ERROR("Text field " << parameterName << " is not defined in " << this->GetDeviceId());
+  return PLUS_FAIL;
 }
 
 #ifdef PLUS_TEST_tesseract
@@ -90,37 +141,58 @@ PlusStatus vtkPlusVirtualTextRecognizer::InternalUpdate()
 {
   std::map<double, int> queriedFramesIndexes;
   std::vector<PlusTrackedFrame*> queriedFrames;
+  // Frames are stored in a list, so that the pointers in queriedFrames remain valid when more frames are added
+  std::list<PlusTrackedFrame> frames;
 
   if( !this->HasGracePeriodExpired() )
   {
     return PLUS_SUCCESS;
   }
 
+  // Get the latest frame of each input channel
+  RecognizeFieldsThreadInfo info;
+  info.Self = this;
   for( ChannelFieldListMapIterator it = this->RecognitionFields.begin(); it != this->RecognitionFields.end(); ++it )
   {
-    for( FieldListIterator fieldIt = it->second.begin(); fieldIt != it->second.end(); ++fieldIt )
+    if( it->second.empty() )
     {
-      TextFieldParameter* parameter = *fieldIt;
-      PlusTrackedFrame frame;
+      continue;
+    }
 
-      // Attempt to find the frame already retrieved
-      PlusStatus result = FindOrQueryFrame(frame, queriedFramesIndexes, parameter, queriedFrames);
+    // Attempt to find the frame already retrieved
+    frames.push_back(PlusTrackedFrame());
+    PlusTrackedFrame& frame = frames.back();
+    PlusStatus result = FindOrQueryFrame(frame, queriedFramesIndexes, it->second.front(), queriedFrames);
+    if( result != PLUS_SUCCESS || frame.GetImageData()->GetImage() == NULL)
+    {
+      continue;
+    }
 
-      if( result != PLUS_SUCCESS || frame.GetImageData()->GetImage() == NULL)
+    // Cropping is done on this thread, because the fields of a channel share the input image
+    for( FieldListIterator fieldIt = it->second.begin(); fieldIt != it->second.end(); ++fieldIt )
+    {
+      if( PrepareFieldRecognition(&frame, *fieldIt) )
       {
-        continue;
+        info.Fields.push_back(*fieldIt);
       }
+    }
+  }
 
-      // We have a frame, let's parse it
-      vtkImageDataToPix(frame, parameter);
-
-      this->TesseractAPI->SetImage(parameter->ReceivedFrame);
-      char* text_out = this->TesseractAPI->GetUTF8Text();
-      std::string textStr(text_out);
-      parameter->LatestParameterValue = PlusCommon::Trim(textStr);
-      delete [] text_out;
-
-      frame.SetCustomFrameField(parameter->ParameterName, parameter->LatestParameterValue);
+  // We have the screen regions, let's parse them. Each field has its own tesseract instance and pix, so the fields are independent.
+  int numberOfFields = info.Fields.size();
+  int numberOfThreads = (this->NumberOfThreads > 0 ? this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+  numberOfThreads = std::min(numberOfThreads, numberOfFields);
+  if( numberOfThreads > 1 )
+  {
+    this->RecognitionThreader->SetNumberOfThreads(numberOfThreads);
+    this->RecognitionThreader->SetSingleMethod(RecognizeFieldsThreadFunction, &info);
+    this->RecognitionThreader->SingleMethodExecute();
+  }
+  else
+  {
+    for( int fieldIndex = 0; fieldIndex < numberOfFields; ++fieldIndex )
+    {
+      RecognizeField(info.Fields[fieldIndex]);
     }
   }
 
@@ -144,11 +216,60 @@ PlusStatus vtkPlusVirtualTextRecognizer::InternalUpdate()
 }
 
 //----------------------------------------------------------------------------
-void vtkPlusVirtualTextRecognizer::vtkImageDataToPix(PlusTrackedFrame& frame, TextFieldParameter* parameter)
+VTK_THREAD_RETURN_TYPE vtkPlusVirtualTextRecognizer::RecognizeFieldsThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  RecognizeFieldsThreadInfo* info = static_cast<RecognizeFieldsThreadInfo*>(threadInfo->UserData);
+
+  // Fields are assigned to threads in a round-robin fashion
+  int numberOfFields = info->Fields.size();
+  for( int fieldIndex = threadInfo->ThreadID; fieldIndex < numberOfFields; fieldIndex += threadInfo->NumberOfThreads )
+  {
+    info->Self->RecognizeField(info->Fields[fieldIndex]);
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusVirtualTextRecognizer::PrepareFieldRecognition(PlusTrackedFrame* frame, TextFieldParameter* parameter)
+{
+  if( PlusVideoFrame::GetOrientedClippedImage(frame->GetImageData()->GetImage(), PlusVideoFrame::FlipInfoType(),
+      frame->GetImageData()->GetImageType(), parameter->ScreenRegion, parameter->Origin, parameter->Size) != PLUS_SUCCESS )
+  {
+    LOG_ERROR("Failed to get the screen region of field " << parameter->ParameterName);
+    return false;
+  }
+
+  // Skip recognition if the screen region is the same as at the latest recognition
+  const unsigned char* regionPixels = static_cast<const unsigned char*>(parameter->ScreenRegion->GetScalarPointer());
+  size_t regionSizeInBytes = parameter->ScreenRegion->GetNumberOfPoints() * parameter->ScreenRegion->GetScalarSize() * parameter->ScreenRegion->GetNumberOfScalarComponents();
+  if( parameter->PreviousScreenRegionPixels.size() == regionSizeInBytes && regionSizeInBytes > 0
+      && memcmp(&parameter->PreviousScreenRegionPixels[0], regionPixels, regionSizeInBytes) == 0 )
+  {
+    parameter->NumberOfSkippedRecognitions++;
+    return false;
+  }
+  parameter->PreviousScreenRegionPixels.assign(regionPixels, regionPixels + regionSizeInBytes);
+
+  vtkImageDataToPix(parameter);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusVirtualTextRecognizer::RecognizeField(TextFieldParameter* parameter)
 {
-  PlusVideoFrame::GetOrientedClippedImage(frame.GetImageData()->GetImage(), PlusVideoFrame::FlipInfoType(),
-                                          frame.GetImageData()->GetImageType(), parameter->ScreenRegion, parameter->Origin, parameter->Size);
+  parameter->TesseractAPI->SetImage(parameter->ReceivedFrame);
+  char* text_out = parameter->TesseractAPI->GetUTF8Text();
+  std::string textStr(text_out);
+  parameter->LatestParameterValue = PlusCommon::Trim(textStr);
+  delete [] text_out;
+  parameter->NumberOfRecognitions++;
+}
 
+//----------------------------------------------------------------------------
+void vtkPlusVirtualTextRecognizer::vtkImageDataToPix(TextFieldParameter* parameter)
+{
   unsigned int *data = pixGetData(parameter->ReceivedFrame);
   int wpl = pixGetWpl(parameter->ReceivedFrame);
   int bpl = ( (8*parameter->Size[0]) + 7) / 8;
@@ -223,9 +344,24 @@ PlusStatus vtkPlusVirtualTextRecognizer::FindOrQueryFrame(PlusTrackedFrame& fram
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusVirtualTextRecognizer::InternalConnect()
 {
-  this->TesseractAPI = new tesseract::TessBaseAPI();
-  this->TesseractAPI->Init(NULL, Language, tesseract::OEM_TESSERACT_CUBE_COMBINED);
-  this->TesseractAPI->SetPageSegMode(tesseract::PSM_SINGLE_LINE);
+  for( ChannelFieldListMapIterator it = this->RecognitionFields.begin(); it != this->RecognitionFields.end(); ++it )
+  {
+    for( FieldListIterator fieldIt = it->second.begin(); fieldIt != it->second.end(); ++fieldIt )
+    {
+      TextFieldParameter* parameter = *fieldIt;
+      delete parameter->TesseractAPI;
+      parameter->TesseractAPI = new tesseract::TessBaseAPI();
+      if( parameter->TesseractAPI->Init(NULL, Language, tesseract::OEM_TESSERACT_CUBE_COMBINED) != 0 )
+      {
+        LOG_ERROR("Failed to initialize tesseract for field " << parameter->ParameterName << " with language " << this->Language);
+        return PLUS_FAIL;
+      }
+      parameter->TesseractAPI->SetPageSegMode(tesseract::PSM_SINGLE_LINE);
+      parameter->PreviousScreenRegionPixels.clear();
+      parameter->NumberOfRecognitions = 0;
+      parameter->NumberOfSkippedRecognitions = 0;
+    }
+  }
 
   return PLUS_SUCCESS;
 }
@@ -233,8 +369,16 @@ PlusStatus vtkPlusVirtualTextRecognizer::InternalConnect()
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusVirtualTextRecognizer::InternalDisconnect()
 {
-  delete this->TesseractAPI;
-  this->TesseractAPI = NULL;
+  for( ChannelFieldListMapIterator it = this->RecognitionFields.begin(); it != this->RecognitionFields.end(); ++it )
+  {
+    for( FieldListIterator fieldIt = it->second.begin(); fieldIt != it->second.end(); ++fieldIt )
+    {
+      LOG_DEBUG("Text field " << (*fieldIt)->ParameterName << ": " << (*fieldIt)->NumberOfRecognitions << " recognitions, "
+                << (*fieldIt)->NumberOfSkippedRecognitions << " skipped (unchanged screen region)");
+      delete (*fieldIt)->TesseractAPI;
+      (*fieldIt)->TesseractAPI = NULL;
+    }
+  }
 
   ClearConfiguration();
 
@@ -263,6 +407,7 @@ PlusStatus vtkPlusVirtualTextRecognizer::ReadConfiguration( vtkXMLDataElement* r
 
   this->SetLanguage(DEFAULT_LANGUAGE);
   XML_READ_CSTRING_ATTRIBUTE_OPTIONAL(Language, deviceConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, NumberOfThreads, deviceConfig);
 
   XML_FIND_NESTED_ELEMENT_OPTIONAL(screenFields, deviceConfig, PARAMETER_LIST_TAG_NAME);
 
@@ -326,6 +471,10 @@ PlusStatus vtkPlusVirtualTextRecognizer::WriteConfiguration(vtkXMLDataElement* r
   {
     XML_WRITE_CSTRING_ATTRIBUTE_IF_NOT_NULL(Language, deviceConfig);
   }
+  if( this->NumberOfThreads > 0 )
+  {
+    deviceConfig->SetIntAttribute("NumberOfThreads", this->NumberOfThreads);
+  }
 
   XML_FIND_NESTED_ELEMENT_CREATE_IF_MISSING(screenFields, deviceConfig, PARAMETER_LIST_TAG_NAME);
 
@@ -34,6 +34,11 @@ public:
   {
   public:
     TextFieldParameter()
+      : ReceivedFrame(NULL)
+      , SourceChannel(NULL)
+      , TesseractAPI(NULL)
+      , NumberOfRecognitions(0)
+      , NumberOfSkippedRecognitions(0)
     {
       this->Origin[0] = 0;
       this->Origin[1] = 0;
@@ -53,6 +58,14 @@ public:
     int Origin[3];
     /// This is only 3d for simplicity in passing to clipping function, OCR is 2d only
     int Size[3];
+    /// Each field has its own tesseract instance, so that the fields can be recognized in parallel
+    tesseract::TessBaseAPI* TesseractAPI;
+    /// Pixels of the screen region at the latest recognition. If the region is unchanged then recognition is skipped and LatestParameterValue is kept.
+    std::vector<unsigned char> PreviousScreenRegionPixels;
+    /// Number of times text recognition was run on the field
+    unsigned long NumberOfRecognitions;
+    /// Number of times text recognition was skipped because the screen region was unchanged
+    unsigned long NumberOfSkippedRecognitions;
   };
 
 public:
@@ -96,6 +109,17 @@ public:
   vtkSetObjectMacro(OutputChannel, vtkPlusChannel);
   vtkGetObjectMacro(OutputChannel, vtkPlusChannel);
 
+  /*! Set the number of threads used for recognizing the fields (0 means the default number of threads is used) */
+  vtkSetMacro(NumberOfThreads, int);
+  /*! Get the number of threads used for recognizing the fields */
+  vtkGetMacro(NumberOfThreads, int);
+
+  /*!
+    Get the number of times text recognition was run on a field and the number of times it was skipped
+    because the screen region of the field was unchanged since the latest recognition
+  */
+  PlusStatus GetFieldRecognitionCounts(const std::string& parameterName, unsigned long& numberOfRecognitions, unsigned long& numberOfSkippedRecognitions);
+
 #ifdef PLUS_TEST_tesseract
   ChannelFieldListMap& GetRecognitionFields();
 #endif
@@ -106,8 +130,24 @@ protected:
   /// Remove any configuration data
   void ClearConfiguration();
 
-  /// Convert a vtkImage data to leptonica pix format
-  void vtkImageDataToPix(PlusTrackedFrame& frame, TextFieldParameter* parameter);
+  /// Convert the screen region of a field to leptonica pix format
+  void vtkImageDataToPix(TextFieldParameter* parameter);
+
+  /*!
+    Crop the screen region of a field and convert it to leptonica pix format.
+    Returns false if the region is unchanged since the latest recognition, so recognition can be skipped.
+    Not thread-safe: fields of the same channel share the input image.
+  */
+  bool PrepareFieldRecognition(PlusTrackedFrame* frame, TextFieldParameter* parameter);
+
+  /// Run text recognition on the prepared screen region of a field. Fields can be recognized in parallel.
+  void RecognizeField(TextFieldParameter* parameter);
+
+  /// Input and output of RecognizeFieldsThreadFunction
+  struct RecognizeFieldsThreadInfo;
+
+  /// Thread function that recognizes a subset of the fields
+  static VTK_THREAD_RETURN_TYPE RecognizeFieldsThreadFunction(void* arg);
 
   /// If a frame has been queried for this input channel, reuse it instead of getting a new one
   PlusStatus FindOrQueryFrame(PlusTrackedFrame& frame, std::map<double, int>& queriedFramesIndexes, TextFieldParameter* parameter,
@@ -116,9 +156,6 @@ protected:
   /// Language used for detection
   char* Language;
 
-  /// Main entry point for the tesseract API
-  tesseract::TessBaseAPI* TesseractAPI;
-
   vtkPlusTrackedFrameList* TrackedFrames;
 
   /// Map of channels to fields so that we only have to grab an image once from the each source channel
@@ -127,6 +164,12 @@ protected:
   /// Optional output channel to store recognized fields for broadcasting
   vtkPlusChannel* OutputChannel;
 
+  /// Threader for recognizing the fields in parallel
+  vtkMultiThreader* RecognitionThreader;
+
+  /// Number of threads used for recognizing the fields (0 means the default number of threads is used)
+  int NumberOfThreads;
+
 protected:
   vtkPlusVirtualTextRecognizer();
   virtual ~vtkPlusVirtualTextRecognizer();
@@ -19,8 +19,11 @@ See License.txt for details.
 #include "vtkPlusTrackedFrameList.h"
 #include "vtkUnsignedLongLongArray.h"
 
+#include <algorithm>
+
 static const double NEGLIGIBLE_TIME_DIFFERENCE = 0.00001; // in seconds, used for comparing between exact timestamps
 static const double ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG = 10; // if the interpolated orientation differs from both the interpolated orientation by more than this threshold then display a warning
+static const double HISTORY_COMPRESSION_IDLE_DELAY_SEC = 0.02; // time to wait before checking for new frames to compress if all the history frames are compressed
 
 vtkStandardNewMacro(vtkPlusBuffer);
 
@@ -78,6 +81,13 @@ vtkPlusBuffer::vtkPlusBuffer()
   , StreamBuffer(vtkPlusTimestampedCircularBuffer::New())
   , MaxAllowedTimeDifference(0.5)
   , DescriptiveName(NULL)
+  , HistoryCompressionEnabled(false)
+  , NumberOfUncompressedItems(30)
+  , HistoryCompressionLevel(1)
+  , HistoryCompressionThreader(vtkMultiThreader::New())
+  , HistoryCompressionThreadId(-1)
+  , HistoryCompressionActive(std::make_pair(false, false))
+  , NextItemUidToCompress(0)
 {
   this->FrameSize[0] = 0;
   this->FrameSize[1] = 0;
@@ -92,6 +102,13 @@ vtkPlusBuffer::vtkPlusBuffer()
 //----------------------------------------------------------------------------
 vtkPlusBuffer::~vtkPlusBuffer()
 {
+  this->SetHistoryCompressionEnabled(false);
+  if (this->HistoryCompressionThreader != NULL)
+  {
+    this->HistoryCompressionThreader->Delete();
+    this->HistoryCompressionThreader = NULL;
+  }
+
   if (this->StreamBuffer != NULL)
   {
     this->StreamBuffer->Delete();
@@ -107,6 +124,12 @@ void vtkPlusBuffer::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Scalar pixel type: " << vtkImageScalarTypeNameMacro(this->GetPixelType()) << std::endl;
   os << indent << "Image type: " << PlusVideoFrame::GetStringFromUsImageType(this->GetImageType()) << std::endl;
   os << indent << "Image orientation: " << PlusVideoFrame::GetStringFromUsImageOrientation(this->GetImageOrientation()) << std::endl;
+  os << indent << "History compression: " << (this->HistoryCompressionEnabled ? "enabled" : "disabled") << std::endl;
+  if (this->HistoryCompressionEnabled)
+  {
+    os << indent << "Number of uncompressed items: " << this->NumberOfUncompressedItems << std::endl;
+    os << indent << "History compression level: " << this->HistoryCompressionLevel << std::endl;
+  }
 
   os << indent << "StreamBuffer: " << this->StreamBuffer << "\n";
   if (this->StreamBuffer)
@@ -123,6 +146,11 @@ PlusStatus vtkPlusBuffer::AllocateMemoryForFrames()
 
   for (int i = 0; i < this->StreamBuffer->GetBufferSize(); ++i)
   {
+    if (this->StreamBuffer->GetBufferItemPointerFromBufferIndex(i)->IsFrameCompressed())
+    {
+      // Compressed frames store their own format, memory is allocated when the item is overwritten
+      continue;
+    }
     if (this->StreamBuffer->GetBufferItemPointerFromBufferIndex(i)->GetFrame().AllocateFrame(this->GetFrameSize(), this->GetPixelType(), this->GetNumberOfScalarComponents()) != PLUS_SUCCESS)
     {
       LOCAL_LOG_ERROR("Failed to allocate memory for frame " << i);
@@ -442,6 +470,17 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr,
     return PLUS_FAIL;
   }
 
+  if (newObjectInBuffer->IsFrameCompressed())
+  {
+    // The image memory of compressed frames is released, allocate it again
+    newObjectInBuffer->ClearCompressedFrame();
+    if (newObjectInBuffer->GetFrame().AllocateFrame(this->GetFrameSize(), this->GetPixelType(), this->GetNumberOfScalarComponents()) != PLUS_SUCCESS)
+    {
+      LOCAL_LOG_ERROR("Failed to allocate memory for the new frame in the video buffer!");
+      return PLUS_FAIL;
+    }
+  }
+
   unsigned int receivedFrameSize[3] = { 0, 0, 0 };
   newObjectInBuffer->GetFrame().GetFrameSize(receivedFrameSize);
 
@@ -633,19 +672,28 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItem(BufferItemUidType uid, StreamBuffe
     return ITEM_UNKNOWN_ERROR;
   }
 
-  PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
-
-  StreamBufferItem* dataItem = NULL;
-  ItemStatus itemStatus = this->StreamBuffer->GetBufferItemPointerFromUid(uid, dataItem);
-  if (itemStatus != ITEM_OK)
   {
-    LOCAL_LOG_WARNING("Failed to retrieve data item");
-    return itemStatus;
+    PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+
+    StreamBufferItem* dataItem = NULL;
+    ItemStatus itemStatus = this->StreamBuffer->GetBufferItemPointerFromUid(uid, dataItem);
+    if (itemStatus != ITEM_OK)
+    {
+      LOCAL_LOG_WARNING("Failed to retrieve data item");
+      return itemStatus;
+    }
+
+    if (bufferItem->DeepCopy(dataItem) != PLUS_SUCCESS)
+    {
+      LOCAL_LOG_WARNING("Failed to copy data item");
+      return ITEM_UNKNOWN_ERROR;
+    }
   }
 
-  if (bufferItem->DeepCopy(dataItem) != PLUS_SUCCESS)
+  // Compressed data is shared by the copy, so it can be decompressed without blocking the buffer
+  if (bufferItem->DecompressFrame() != PLUS_SUCCESS)
   {
-    LOCAL_LOG_WARNING("Failed to copy data item");
+    LOCAL_LOG_WARNING("Failed to decompress data item");
     return ITEM_UNKNOWN_ERROR;
   }
 
@@ -1197,6 +1245,48 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItemFromClosestTime(double time, Stream
   return status;
 }
 
+//----------------------------------------------------------------------------
+// The rotation is interpolated with SLERP interpolation, and the position is interpolated with linear interpolation.
+// itemBweight = 1 - itemAweight
+static void InterpolateTransformMatrix(vtkMatrix4x4* itemAmatrix, vtkMatrix4x4* itemBmatrix, double itemAweight, vtkMatrix4x4* interpolatedMatrix)
+{
+  double itemBweight = 1 - itemAweight;
+
+  double matrixA[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+  double xyzA[3] = {0, 0, 0};
+  double matrixB[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+  double xyzB[3] = {0, 0, 0};
+  for (int i = 0; i < 3; i++)
+  {
+    matrixA[i][0] = itemAmatrix->GetElement(i, 0);
+    matrixA[i][1] = itemAmatrix->GetElement(i, 1);
+    matrixA[i][2] = itemAmatrix->GetElement(i, 2);
+    xyzA[i] = itemAmatrix->GetElement(i, 3);
+    matrixB[i][0] = itemBmatrix->GetElement(i, 0);
+    matrixB[i][1] = itemBmatrix->GetElement(i, 1);
+    matrixB[i][2] = itemBmatrix->GetElement(i, 2);
+    xyzB[i] = itemBmatrix->GetElement(i, 3);
+  }
+
+  double matrixAquat[4] = {0, 0, 0, 0};
+  vtkMath::Matrix3x3ToQuaternion(matrixA, matrixAquat);
+  double matrixBquat[4] = {0, 0, 0, 0};
+  vtkMath::Matrix3x3ToQuaternion(matrixB, matrixBquat);
+  double interpolatedRotationQuat[4] = {0, 0, 0, 0};
+  PlusMath::Slerp(interpolatedRotationQuat, itemBweight, matrixAquat, matrixBquat);
+  double interpolatedRotation[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+  vtkMath::QuaternionToMatrix3x3(interpolatedRotationQuat, interpolatedRotation);
+
+  interpolatedMatrix->Identity();
+  for (int i = 0; i < 3; i++)
+  {
+    interpolatedMatrix->Element[i][0] = interpolatedRotation[i][0];
+    interpolatedMatrix->Element[i][1] = interpolatedRotation[i][1];
+    interpolatedMatrix->Element[i][2] = interpolatedRotation[i][2];
+    interpolatedMatrix->Element[i][3] = xyzA[i] * itemAweight + xyzB[i] * itemBweight;
+  }
+}
+
 //----------------------------------------------------------------------------
 // Interpolate the matrix for the given timestamp from the two nearest
 // transforms in the buffer.
@@ -1258,7 +1348,6 @@ ItemStatus vtkPlusBuffer::GetInterpolatedStreamBufferItemFromTime(double time, S
   }
 
   double itemAweight = fabs(itemBtime - time) / fabs(itemAtime - itemBtime);
-  double itemBweight = 1 - itemAweight;
 
   //============== Get transform matrices ==================
 
@@ -1268,15 +1357,6 @@ ItemStatus vtkPlusBuffer::GetInterpolatedStreamBufferItemFromTime(double time, S
     LOCAL_LOG_ERROR("Failed to get item A matrix");
     return ITEM_UNKNOWN_ERROR;
   }
-  double matrixA[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-  double xyzA[3] = {0, 0, 0};
-  for (int i = 0; i < 3; i++)
-  {
-    matrixA[i][0] = itemAmatrix->GetElement(i, 0);
-    matrixA[i][1] = itemAmatrix->GetElement(i, 1);
-    matrixA[i][2] = itemAmatrix->GetElement(i, 2);
-    xyzA[i] = itemAmatrix->GetElement(i, 3);
-  }
 
   vtkSmartPointer<vtkMatrix4x4> itemBmatrix = vtkSmartPointer<vtkMatrix4x4>::New();
   if (itemB.GetMatrix(itemBmatrix) != PLUS_SUCCESS)
@@ -1284,41 +1364,17 @@ ItemStatus vtkPlusBuffer::GetInterpolatedStreamBufferItemFromTime(double time, S
     LOCAL_LOG_ERROR("Failed to get item B matrix");
     return ITEM_UNKNOWN_ERROR;
   }
-  double matrixB[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-  double xyzB[3] = {0, 0, 0};
-  for (int i = 0; i < 3; i++)
-  {
-    matrixB[i][0] = itemBmatrix->GetElement(i, 0);
-    matrixB[i][1] = itemBmatrix->GetElement(i, 1);
-    matrixB[i][2] = itemBmatrix->GetElement(i, 2);
-    xyzB[i] = itemBmatrix->GetElement(i, 3);
-  }
 
-  //============== Interpolate rotation ==================
-
-  double matrixAquat[4] = {0, 0, 0, 0};
-  vtkMath::Matrix3x3ToQuaternion(matrixA, matrixAquat);
-  double matrixBquat[4] = {0, 0, 0, 0};
-  vtkMath::Matrix3x3ToQuaternion(matrixB, matrixBquat);
-  double interpolatedRotationQuat[4] = {0, 0, 0, 0};
-  PlusMath::Slerp(interpolatedRotationQuat, itemBweight, matrixAquat, matrixBquat);
-  double interpolatedRotation[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-  vtkMath::QuaternionToMatrix3x3(interpolatedRotationQuat, interpolatedRotation);
+  //============== Interpolate rotation and position ==================
 
   vtkSmartPointer<vtkMatrix4x4> interpolatedMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  for (int i = 0; i < 3; i++)
-  {
-    interpolatedMatrix->Element[i][0] = interpolatedRotation[i][0];
-    interpolatedMatrix->Element[i][1] = interpolatedRotation[i][1];
-    interpolatedMatrix->Element[i][2] = interpolatedRotation[i][2];
-    interpolatedMatrix->Element[i][3] = xyzA[i] * itemAweight + xyzB[i] * itemBweight;
-  }
+  InterpolateTransformMatrix(itemAmatrix, itemBmatrix, itemAweight, interpolatedMatrix);
 
   //============== Interpolate time ==================
 
   double itemAunfilteredTimestamp = itemA.GetUnfilteredTimestamp(0.0);   // 0.0 because timestamps in the buffer are in local time
   double itemBunfilteredTimestamp = itemB.GetUnfilteredTimestamp(0.0);   // 0.0 because timestamps in the buffer are in local time
-  double interpolatedUnfilteredTimestamp = itemAunfilteredTimestamp * itemAweight + itemBunfilteredTimestamp * itemBweight;
+  double interpolatedUnfilteredTimestamp = itemAunfilteredTimestamp * itemAweight + itemBunfilteredTimestamp * (1 - itemAweight);
 
   //============== Write interpolated results into the bufferItem ==================
 
@@ -1337,6 +1393,185 @@ ItemStatus vtkPlusBuffer::GetInterpolatedStreamBufferItemFromTime(double time, S
   return ITEM_OK;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::GetInterpolatedTransformsFromTimes(const double* times, int numberOfTimes, double* matrixElements, ToolStatus* toolStatuses, ItemStatus* itemStatuses /*=NULL*/)
+{
+  if (numberOfTimes <= 0)
+  {
+    return PLUS_SUCCESS;
+  }
+  if (times == NULL || matrixElements == NULL || toolStatuses == NULL)
+  {
+    LOCAL_LOG_ERROR("vtkPlusBuffer::GetInterpolatedTransformsFromTimes failed: invalid input or output array");
+    return PLUS_FAIL;
+  }
+  for (int timeIndex = 1; timeIndex < numberOfTimes; ++timeIndex)
+  {
+    if (times[timeIndex] < times[timeIndex - 1])
+    {
+      LOCAL_LOG_ERROR("vtkPlusBuffer::GetInterpolatedTransformsFromTimes failed: requested timestamps are not sorted (" << std::fixed << times[timeIndex - 1] << " is followed by " << times[timeIndex] << ")");
+      return PLUS_FAIL;
+    }
+  }
+
+  // Matrices are reused for all the timestamps to avoid memory allocations
+  vtkSmartPointer<vtkMatrix4x4> itemAmatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  vtkSmartPointer<vtkMatrix4x4> itemBmatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  vtkSmartPointer<vtkMatrix4x4> interpolatedMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+
+  PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+
+  const double localTimeOffsetSec = this->StreamBuffer->GetLocalTimeOffsetSec();
+  const double negligibleTimeDifferenceSec = this->StreamBuffer->GetNegligibleTimeDifferenceSec();
+  const int numberOfItems = this->StreamBuffer->GetNumberOfItems();
+  const BufferItemUidType oldestUid = this->StreamBuffer->GetOldestItemUidInBuffer();
+  const BufferItemUidType latestUid = this->StreamBuffer->GetLatestItemUidInBuffer();
+  double oldestTime(0);
+  double latestTime(0);
+  if (numberOfItems > 0)
+  {
+    this->StreamBuffer->GetTimeStamp(oldestUid, oldestTime);
+    this->StreamBuffer->GetTimeStamp(latestUid, latestTime);
+  }
+
+  // UID of the latest item that is not newer than the current requested time.
+  // As the requested times are sorted, it can only move forward.
+  BufferItemUidType lowerUid = oldestUid;
+  StreamBufferItem* lowerItem = NULL;
+  if (numberOfItems > 0)
+  {
+    this->StreamBuffer->GetBufferItemPointerFromUid(lowerUid, lowerItem);
+  }
+
+  for (int timeIndex = 0; timeIndex < numberOfTimes; ++timeIndex)
+  {
+    const double time = times[timeIndex];
+    double* outputMatrixElements = matrixElements + 16 * timeIndex;
+    vtkMatrix4x4::Identity(outputMatrixElements);
+    toolStatuses[timeIndex] = TOOL_MISSING;
+
+    //============== Find the closest item (itemA) ==================
+
+    // Same tolerance and item selection as in vtkPlusTimestampedCircularBuffer::GetItemUidFromTime
+    ItemStatus itemStatus = ITEM_OK;
+    if (numberOfItems < 1)
+    {
+      itemStatus = ITEM_NOT_AVAILABLE_YET;
+    }
+    else if (numberOfItems > 1 && time < oldestTime - negligibleTimeDifferenceSec)
+    {
+      itemStatus = ITEM_NOT_AVAILABLE_ANYMORE;
+    }
+    else if (numberOfItems > 1 && time > latestTime + negligibleTimeDifferenceSec)
+    {
+      itemStatus = ITEM_NOT_AVAILABLE_YET;
+    }
+    if (itemStatuses != NULL)
+    {
+      itemStatuses[timeIndex] = itemStatus;
+    }
+    if (itemStatus != ITEM_OK)
+    {
+      continue;
+    }
+
+    StreamBufferItem* upperItem = NULL;
+    while (lowerUid < latestUid)
+    {
+      this->StreamBuffer->GetBufferItemPointerFromUid(lowerUid + 1, upperItem);
+      if (upperItem->GetFilteredTimestamp(localTimeOffsetSec) > time)
+      {
+        break;
+      }
+      lowerUid++;
+      lowerItem = upperItem;
+      upperItem = NULL;
+    }
+
+    BufferItemUidType itemAuid = lowerUid;
+    StreamBufferItem* itemA = lowerItem;
+    if (upperItem != NULL)
+    {
+      double lowerTime = lowerItem->GetFilteredTimestamp(localTimeOffsetSec);
+      double upperTime = upperItem->GetFilteredTimestamp(localTimeOffsetSec);
+      if (time - lowerTime > upperTime - time)
+      {
+        itemAuid = lowerUid + 1;
+        itemA = upperItem;
+      }
+    }
+
+    // If interpolation is not possible then the closest item's matrix is returned with missing status
+    if (itemA->GetMatrix(itemAmatrix) != PLUS_SUCCESS)
+    {
+      LOCAL_LOG_ERROR("Failed to get item A matrix");
+      continue;
+    }
+    vtkMatrix4x4::DeepCopy(outputMatrixElements, itemAmatrix);
+
+    if (itemA->GetStatus() != TOOL_OK)
+    {
+      // tracker is out of view, ...
+      continue;
+    }
+
+    double itemAtime = itemA->GetFilteredTimestamp(localTimeOffsetSec);
+    if (fabs(itemAtime - time) < negligibleTimeDifferenceSec)
+    {
+      // No need for interpolation, it's very close to the closest element
+      toolStatuses[timeIndex] = TOOL_OK;
+      continue;
+    }
+    if (fabs(itemAtime - time) > this->GetMaxAllowedTimeDifference())
+    {
+      LOCAL_LOG_DEBUG("vtkPlusBuffer: Cannot perform interpolation, time difference compared to itemA is too big " << std::fixed << fabs(itemAtime - time) << " ( closest item time: " << itemAtime << ", requested time: " << time << ").");
+      continue;
+    }
+
+    //============== Find the item on the other side of the requested time (itemB) ==================
+
+    BufferItemUidType itemBuid = (time < itemAtime) ? itemAuid - 1 : itemAuid + 1;
+    if (itemBuid < oldestUid || itemBuid > latestUid)
+    {
+      LOCAL_LOG_DEBUG("vtkPlusBuffer: Cannot perform interpolation, itemB is not available " << std::fixed << " ( itemBuid: " << itemBuid << ", oldest UID: " << oldestUid << ", latest UID: " << latestUid);
+      continue;
+    }
+    StreamBufferItem* itemB = NULL;
+    this->StreamBuffer->GetBufferItemPointerFromUid(itemBuid, itemB);
+    double itemBtime = itemB->GetFilteredTimestamp(localTimeOffsetSec);
+    if (fabs(itemBtime - time) > this->GetMaxAllowedTimeDifference())
+    {
+      LOCAL_LOG_DEBUG("vtkPlusBuffer: Cannot perform interpolation, time difference compared to itemB is too big " << std::fixed << fabs(itemBtime - time) << " ( itemBtime: " << itemBtime << ", requested time: " << time << ").");
+      continue;
+    }
+    if (itemB->GetStatus() != TOOL_OK)
+    {
+      continue;
+    }
+
+    if (fabs(itemAtime - itemBtime) < negligibleTimeDifferenceSec)
+    {
+      // exact time match, no need for interpolation
+      toolStatuses[timeIndex] = TOOL_OK;
+      continue;
+    }
+
+    //============== Interpolate ==================
+
+    if (itemB->GetMatrix(itemBmatrix) != PLUS_SUCCESS)
+    {
+      LOCAL_LOG_ERROR("Failed to get item B matrix");
+      continue;
+    }
+    double itemAweight = fabs(itemBtime - time) / fabs(itemAtime - itemBtime);
+    InterpolateTransformMatrix(itemAmatrix, itemBmatrix, itemAweight, interpolatedMatrix);
+    vtkMatrix4x4::DeepCopy(outputMatrixElements, interpolatedMatrix);
+    toolStatuses[timeIndex] = TOOL_OK;
+  }
+
+  return PLUS_SUCCESS;
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusBuffer::CopyTransformFromTrackedFrameList(vtkPlusTrackedFrameList* sourceTrackedFrameList, TIMESTAMP_FILTERING_OPTION timestampFiltering, PlusTransformName& transformName)
 {
@@ -1516,6 +1751,157 @@ bool vtkPlusBuffer::GetLatestItemHasValidFieldData()
   return this->StreamBuffer->GetLatestItemHasValidFieldData();
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::SetHistoryCompressionEnabled(bool enable)
+{
+  if (enable && this->HistoryCompressionThreadId < 0)
+  {
+    this->HistoryCompressionActive.first = true;
+    this->HistoryCompressionThreadId = this->HistoryCompressionThreader->SpawnThread((vtkThreadFunctionType)&HistoryCompressionThread, this);
+    if (this->HistoryCompressionThreadId < 0)
+    {
+      LOCAL_LOG_ERROR("Failed to start history compression thread");
+      this->HistoryCompressionActive.first = false;
+      return PLUS_FAIL;
+    }
+  }
+  else if (!enable && this->HistoryCompressionThreadId >= 0)
+  {
+    // Frames that are already compressed are kept in compressed form
+    this->HistoryCompressionActive.first = false;
+    while (this->HistoryCompressionActive.second)
+    {
+      // Wait until the thread stops
+      vtkPlusAccurateTimer::DelayWithEventProcessing(0.01);
+    }
+    this->HistoryCompressionThreader->TerminateThread(this->HistoryCompressionThreadId);
+    this->HistoryCompressionThreadId = -1;
+  }
+  this->HistoryCompressionEnabled = enable;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusBuffer::GetNumberOfCompressedItems(size_t* compressedSizeInBytes /*=NULL*/)
+{
+  PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  int numberOfCompressedItems = 0;
+  size_t totalCompressedSizeInBytes = 0;
+  if (this->StreamBuffer->GetNumberOfItems() > 0)
+  {
+    BufferItemUidType oldestUid = this->StreamBuffer->GetOldestItemUidInBuffer();
+    BufferItemUidType latestUid = this->StreamBuffer->GetLatestItemUidInBuffer();
+    for (BufferItemUidType uid = oldestUid; uid <= latestUid; ++uid)
+    {
+      StreamBufferItem* item = NULL;
+      if (this->StreamBuffer->GetBufferItemPointerFromUid(uid, item) == ITEM_OK && item->IsFrameCompressed())
+      {
+        numberOfCompressedItems++;
+        totalCompressedSizeInBytes += item->GetCompressedFrameSizeInBytes();
+      }
+    }
+  }
+  if (compressedSizeInBytes != NULL)
+  {
+    *compressedSizeInBytes = totalCompressedSizeInBytes;
+  }
+  return numberOfCompressedItems;
+}
+
+//----------------------------------------------------------------------------
+void* vtkPlusBuffer::HistoryCompressionThread(vtkMultiThreader::ThreadInfo* data)
+{
+  vtkPlusBuffer* self = (vtkPlusBuffer*)(data->UserData);
+  self->HistoryCompressionActive.second = true;
+
+  PlusVideoFrame frameToCompress;
+  while (self->HistoryCompressionActive.first)
+  {
+    if (!self->CompressNextHistoryItem(frameToCompress))
+    {
+      vtkPlusAccurateTimer::Delay(HISTORY_COMPRESSION_IDLE_DELAY_SEC);
+    }
+  }
+
+  self->HistoryCompressionActive.second = false;
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusBuffer::CompressNextHistoryItem(PlusVideoFrame& frameToCompress)
+{
+  BufferItemUidType uid = 0;
+  double unfilteredTimestamp = 0;
+
+  // Find the next uncompressed frame and copy it
+  {
+    PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    // The most recent item is always kept uncompressed
+    int numberOfUncompressedItems = std::max(this->NumberOfUncompressedItems, 1);
+    if (this->StreamBuffer->GetNumberOfItems() <= numberOfUncompressedItems)
+    {
+      return false;
+    }
+    BufferItemUidType oldestUid = this->StreamBuffer->GetOldestItemUidInBuffer();
+    BufferItemUidType latestUid = this->StreamBuffer->GetLatestItemUidInBuffer();
+    BufferItemUidType newestUidToCompress = latestUid - numberOfUncompressedItems;
+    if (this->NextItemUidToCompress < oldestUid || this->NextItemUidToCompress > latestUid + 1)
+    {
+      // Items have been removed from the buffer or the buffer has been cleared
+      this->NextItemUidToCompress = oldestUid;
+    }
+
+    StreamBufferItem* item = NULL;
+    for (; this->NextItemUidToCompress <= newestUidToCompress; this->NextItemUidToCompress++)
+    {
+      if (this->StreamBuffer->GetBufferItemPointerFromUid(this->NextItemUidToCompress, item) == ITEM_OK
+          && !item->IsFrameCompressed() && item->GetFrame().IsImageValid())
+      {
+        break;
+      }
+      item = NULL;
+    }
+    if (item == NULL)
+    {
+      return false;
+    }
+
+    uid = this->NextItemUidToCompress;
+    unfilteredTimestamp = item->GetUnfilteredTimestamp(0);
+    frameToCompress = item->GetFrame();
+    this->NextItemUidToCompress++;
+  }
+
+  std::shared_ptr<StreamBufferItem::CompressedFrameType> compressedFrame = std::make_shared<StreamBufferItem::CompressedFrameType>();
+  if (StreamBufferItem::CompressFrame(frameToCompress, this->HistoryCompressionLevel, *compressedFrame) != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_ERROR("Failed to compress frame " << uid << ", it is kept uncompressed");
+    return true;
+  }
+
+  // Replace the uncompressed frame, unless the item has been overwritten or the frame format has changed in the meantime
+  PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  if (this->StreamBuffer->GetNumberOfItems() < 1
+      || uid < this->StreamBuffer->GetOldestItemUidInBuffer()
+      || uid > this->StreamBuffer->GetLatestItemUidInBuffer())
+  {
+    return true;
+  }
+  StreamBufferItem* item = NULL;
+  if (this->StreamBuffer->GetBufferItemPointerFromUid(uid, item) != ITEM_OK
+      || item->GetUid() != uid
+      || item->GetUnfilteredTimestamp(0) != unfilteredTimestamp
+      || item->IsFrameCompressed()
+      || item->GetFrame().GetFrameSizeInBytes() != compressedFrame->UncompressedSizeInBytes
+      || item->GetFrame().GetVTKScalarPixelType() != compressedFrame->PixelType)
+  {
+    return true;
+  }
+  item->SetCompressedFrame(compressedFrame);
+
+  return true;
+}
+
 #undef LOCAL_LOG_ERROR
 #undef LOCAL_LOG_WARNING
 #undef LOCAL_LOG_DEBUG
\ No newline at end of file
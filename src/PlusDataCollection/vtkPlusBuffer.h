@@ -19,6 +19,7 @@ See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
 
 #include "PlusStreamBufferItem.h"
 #include "PlusTrackedFrame.h"
+#include "vtkMultiThreader.h"
 #include "vtkObject.h"
 #include "vtkPlusTimestampedCircularBuffer.h"
 
@@ -155,6 +156,18 @@ public:
   };
   /*! Get a frame that was acquired at the specified time from buffer */
   virtual ItemStatus GetStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem, DataItemTemporalInterpolationType interpolation);
+  /*!
+    Get interpolated transforms for multiple timestamps at once. The result is the same as calling
+    GetStreamBufferItemFromTime with INTERPOLATED option for each timestamp, but the buffer is locked only once,
+    the items are found by a single walk through the buffer and image data is not copied.
+    \param times requested timestamps (global time), must be sorted in ascending order
+    \param numberOfTimes number of requested timestamps
+    \param matrixElements caller-allocated array of 16*numberOfTimes values, the interpolated matrix elements (row-major) are written here
+    \param toolStatuses caller-allocated array of numberOfTimes values, TOOL_MISSING is written if interpolation was not possible
+    \param itemStatuses optional caller-allocated array of numberOfTimes values, for each timestamp it stores if an item was available
+    \return PLUS_FAIL if the input is invalid (e.g., timestamps are not sorted), PLUS_SUCCESS otherwise
+  */
+  virtual PlusStatus GetInterpolatedTransformsFromTimes(const double* times, int numberOfTimes, double* matrixElements, ToolStatus* toolStatuses, ItemStatus* itemStatuses = NULL);
   virtual PlusStatus ModifyBufferItemFrameField(BufferItemUidType uid, const std::string& key, const std::string& value);
 
   /*! Get latest timestamp in the buffer */
@@ -308,6 +321,30 @@ public:
   vtkGetStringMacro(DescriptiveName);
   vtkSetStringMacro(DescriptiveName);
 
+  /*!
+    Enable/disable compression of the video frames in the history of the buffer.
+    If enabled, then a background thread losslessly compresses all the frames except the most recent
+    NumberOfUncompressedItems frames, which allows keeping several minutes of video in memory.
+    Compressed frames are decompressed when they are retrieved, therefore the buffer interface,
+    the timestamps, and the item UIDs are not affected.
+  */
+  PlusStatus SetHistoryCompressionEnabled(bool enable);
+  vtkGetMacro(HistoryCompressionEnabled, bool);
+
+  /*! Set the number of most recent video frames that are kept uncompressed if history compression is enabled (minimum 1) */
+  vtkSetMacro(NumberOfUncompressedItems, int);
+  vtkGetMacro(NumberOfUncompressedItems, int);
+
+  /*! Set the zlib compression level used for history compression: 1 (fastest) to 9 (smallest) */
+  vtkSetClampMacro(HistoryCompressionLevel, int, 1, 9);
+  vtkGetMacro(HistoryCompressionLevel, int);
+
+  /*!
+    Get the number of video frames that are currently stored in compressed form.
+    \param compressedSizeInBytes If not NULL then the total size of the compressed frames is returned here
+  */
+  int GetNumberOfCompressedItems(size_t* compressedSizeInBytes = NULL);
+
 protected:
   vtkPlusBuffer();
   ~vtkPlusBuffer();
@@ -337,6 +374,17 @@ protected:
   /*! Get tracker buffer item from the closest timestamp */
   virtual ItemStatus GetStreamBufferItemFromClosestTime(double time, StreamBufferItem* bufferItem);
 
+  /*! Thread that compresses the video frames that are older than the most recent NumberOfUncompressedItems frames */
+  static void* HistoryCompressionThread(vtkMultiThreader::ThreadInfo* data);
+
+  /*!
+    Compress the oldest uncompressed video frame in the history part of the buffer.
+    The frame is copied and compressed without blocking the buffer, then it replaces the uncompressed frame.
+    \param frameToCompress Working copy of the frame, reused between calls to avoid memory reallocation
+    \return false if there was no frame to compress
+  */
+  bool CompressNextHistoryItem(PlusVideoFrame& frameToCompress);
+
 protected:
   /*! Image frame size in pixel */
   unsigned int FrameSize[3];
@@ -362,6 +410,17 @@ protected:
 
   char* DescriptiveName;
 
+  bool HistoryCompressionEnabled;
+  int NumberOfUncompressedItems;
+  int HistoryCompressionLevel;
+
+  vtkMultiThreader* HistoryCompressionThreader;
+  int HistoryCompressionThreadId;
+  /*! Active flag for the history compression thread (first: request, second: respond) */
+  std::pair<bool, bool> HistoryCompressionActive;
+  /*! UID of the next item that is checked by the history compression thread */
+  BufferItemUidType NextItemUidToCompress;
+
 private:
   vtkPlusBuffer(const vtkPlusBuffer&);
   void operator=(const vtkPlusBuffer&);
@@ -17,18 +17,57 @@ See License.txt for details.
 #include "vtkPlusTrackedFrameList.h"
 
 // VTK includes
+#include <vtkMultiThreader.h>
 #include <vtkObjectFactory.h>
 #include <vtkXMLDataElement.h>
 #include <vtksys/SystemTools.hxx>
 
+// STL includes
+#include <algorithm>
+#include <iomanip>
+
 //----------------------------------------------------------------------------
 
 vtkStandardNewMacro(vtkPlusDataCollector);
 
+namespace
+{
+  //----------------------------------------------------------------------------
+  struct DeviceConnectJob
+  {
+    const DeviceCollection* Devices;
+    /*! Indices of the devices that are connected by the worker threads */
+    std::vector<unsigned int> ParallelDeviceIndices;
+    std::vector<PlusStatus> Results;
+    std::vector<double> ConnectTimesSec;
+  };
+
+  //----------------------------------------------------------------------------
+  void ConnectDevice(DeviceConnectJob& job, unsigned int deviceIndex)
+  {
+    const double connectStartTime = vtkPlusAccurateTimer::GetSystemTime();
+    job.Results[deviceIndex] = (*job.Devices)[deviceIndex]->Connect();
+    job.ConnectTimesSec[deviceIndex] = vtkPlusAccurateTimer::GetSystemTime() - connectStartTime;
+  }
+
+  //----------------------------------------------------------------------------
+  // Each thread connects every N-th parallel device of the job (N is the number of threads)
+  void* ConnectDevicesThread(vtkMultiThreader::ThreadInfo* data)
+  {
+    DeviceConnectJob* job = static_cast<DeviceConnectJob*>(data->UserData);
+    for (unsigned int i = data->ThreadID; i < job->ParallelDeviceIndices.size(); i += data->NumberOfThreads)
+    {
+      ConnectDevice(*job, job->ParallelDeviceIndices[i]);
+    }
+    return NULL;
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkPlusDataCollector::vtkPlusDataCollector()
   : vtkObject()
   , StartupDelaySec(0.0)
+  , ParallelConnectEnabled(true)
   , DeviceFactory(vtkSmartPointer<vtkPlusDeviceFactory>::New())
   , Connected(false)
   , Started(false)
@@ -89,6 +128,8 @@ PlusStatus vtkPlusDataCollector::ReadConfiguration(vtkXMLDataElement* aConfig)
     LOG_DEBUG("StartupDelaySec: " << std::fixed << startupDelaySec);
   }
 
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(ParallelConnectEnabled, dataCollectionElement);
+
   std::set<std::string> existingDeviceIds;
 
   for (int i = 0; i < dataCollectionElement->GetNumberOfNestedElements(); ++i)
@@ -243,6 +284,10 @@ PlusStatus vtkPlusDataCollector::WriteConfiguration(vtkXMLDataElement* aConfig)
   }
 
   dataCollectionConfig->SetDoubleAttribute("StartupDelaySec", GetStartupDelaySec());
+  if (!this->ParallelConnectEnabled)
+  {
+    XML_WRITE_BOOL_ATTRIBUTE(ParallelConnectEnabled, dataCollectionConfig);
+  }
 
   PlusStatus status = PLUS_SUCCESS;
 
@@ -296,9 +341,21 @@ PlusStatus vtkPlusDataCollector::Start()
     device->SetStartTime(startTime);
   }
 
-  LOG_DEBUG("vtkPlusDataCollector::Start -- wait " << std::fixed << this->StartupDelaySec << " sec for buffer init...");
+  LOG_DEBUG("vtkPlusDataCollector::Start -- wait at most " << std::fixed << this->StartupDelaySec << " sec for buffer init...");
 
-  vtkPlusAccurateTimer::DelayWithEventProcessing(this->StartupDelaySec);
+  // Wait until all the output channels provide data, instead of always waiting for the full startup delay
+  const double bufferInitStartTime = vtkPlusAccurateTimer::GetSystemTime();
+  const double readyCheckPeriodSec = 0.01;
+  while (!this->AreAllOutputChannelsReady())
+  {
+    if (vtkPlusAccurateTimer::GetSystemTime() - bufferInitStartTime >= this->StartupDelaySec)
+    {
+      LOG_INFO("Not all output channels provided data within the startup delay of " << std::fixed << this->StartupDelaySec << " sec");
+      break;
+    }
+    vtkPlusAccurateTimer::DelayWithEventProcessing(readyCheckPeriodSec);
+  }
+  LOG_DEBUG("vtkPlusDataCollector::Start -- buffer init completed in " << std::fixed << vtkPlusAccurateTimer::GetSystemTime() - bufferInitStartTime << " sec");
 
   this->Started = true;
 
@@ -321,16 +378,54 @@ PlusStatus vtkPlusDataCollector::Connect()
   LOG_TRACE("vtkPlusDataCollector::Connect()");
 
   PlusStatus status = PLUS_SUCCESS;
+  this->DeviceConnectTimesSec.clear();
 
-  for (DeviceCollectionIterator it = Devices.begin(); it != Devices.end(); ++ it)
+  // Devices are connected in stages: a device is connected after all the devices that provide its input channels.
+  // Devices in the same stage do not depend on each other, so they can be connected in parallel.
+  std::set<vtkPlusDevice*> processedDevices;
+  DeviceCollection remainingDevices = this->Devices;
+  while (!remainingDevices.empty())
   {
-    vtkPlusDevice* device = *it;
+    DeviceCollection stageDevices;
+    DeviceCollection waitingDevices;
+    for (DeviceCollectionIterator it = remainingDevices.begin(); it != remainingDevices.end(); ++it)
+    {
+      vtkPlusDevice* device = *it;
+      bool inputDevicesProcessed = true;
+      for (ChannelContainerConstIterator channelIt = device->GetInputChannelsStart(); channelIt != device->GetInputChannelsEnd(); ++channelIt)
+      {
+        vtkPlusDevice* inputDevice = (*channelIt)->GetOwnerDevice();
+        if (inputDevice != NULL && inputDevice != device && processedDevices.count(inputDevice) == 0)
+        {
+          inputDevicesProcessed = false;
+          break;
+        }
+      }
+      if (inputDevicesProcessed)
+      {
+        stageDevices.push_back(device);
+      }
+      else
+      {
+        waitingDevices.push_back(device);
+      }
+    }
 
-    if (device->Connect() != PLUS_SUCCESS)
+    bool parallel = this->ParallelConnectEnabled;
+    if (stageDevices.empty())
+    {
+      LOG_WARNING("Circular dependency found between the input channels of devices. The remaining devices are connected one by one.");
+      stageDevices.swap(waitingDevices);
+      parallel = false;
+    }
+
+    if (this->ConnectDevices(stageDevices, parallel) != PLUS_SUCCESS)
     {
-      LOG_ERROR("Unable to connect device: " << device->GetDeviceId() << ".");
       status = PLUS_FAIL;
     }
+
+    processedDevices.insert(stageDevices.begin(), stageDevices.end());
+    remainingDevices.swap(waitingDevices);
   }
 
   if (status != PLUS_SUCCESS)
@@ -349,6 +444,95 @@ PlusStatus vtkPlusDataCollector::Connect()
   return status;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDataCollector::ConnectDevices(const DeviceCollection& devices, bool parallel)
+{
+  DeviceConnectJob job;
+  job.Devices = &devices;
+  job.Results.resize(devices.size(), PLUS_FAIL);
+  job.ConnectTimesSec.resize(devices.size(), 0.0);
+
+  // Devices that have not opted in to parallel connection are connected on the calling thread,
+  // as their SDK may require that it is used from the thread where it was initialized
+  std::vector<unsigned int> serialDeviceIndices;
+  for (unsigned int deviceIndex = 0; deviceIndex < devices.size(); ++deviceIndex)
+  {
+    if (parallel && devices[deviceIndex]->IsParallelConnectSafe())
+    {
+      job.ParallelDeviceIndices.push_back(deviceIndex);
+    }
+    else
+    {
+      serialDeviceIndices.push_back(deviceIndex);
+    }
+  }
+  if (job.ParallelDeviceIndices.size() == 1)
+  {
+    // No need for a worker thread
+    serialDeviceIndices.push_back(job.ParallelDeviceIndices.front());
+    job.ParallelDeviceIndices.clear();
+  }
+
+  for (std::vector<unsigned int>::iterator it = serialDeviceIndices.begin(); it != serialDeviceIndices.end(); ++it)
+  {
+    ConnectDevice(job, *it);
+  }
+
+  if (!job.ParallelDeviceIndices.empty())
+  {
+    vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+    threader->SetNumberOfThreads(std::min<int>(job.ParallelDeviceIndices.size(), VTK_MAX_THREADS));
+    threader->SetSingleMethod((vtkThreadFunctionType)&ConnectDevicesThread, &job);
+    // Returns when all the threads are completed
+    threader->SingleMethodExecute();
+  }
+
+  PlusStatus status = PLUS_SUCCESS;
+  for (unsigned int deviceIndex = 0; deviceIndex < devices.size(); ++deviceIndex)
+  {
+    vtkPlusDevice* device = devices[deviceIndex];
+    if (job.Results[deviceIndex] != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to connect device: " << device->GetDeviceId() << ".");
+      status = PLUS_FAIL;
+      continue;
+    }
+    this->DeviceConnectTimesSec[device->GetDeviceId()] = job.ConnectTimesSec[deviceIndex];
+    LOG_INFO("Device " << device->GetDeviceId() << " connected in " << std::fixed << std::setprecision(3) << job.ConnectTimesSec[deviceIndex] << " sec");
+  }
+  return status;
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusDataCollector::GetDeviceConnectTimeSec(const std::string& aDeviceId) const
+{
+  std::map<std::string, double>::const_iterator timeIt = this->DeviceConnectTimesSec.find(aDeviceId);
+  if (timeIt == this->DeviceConnectTimesSec.end())
+  {
+    return -1.0;
+  }
+  return timeIt->second;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusDataCollector::AreAllOutputChannelsReady() const
+{
+  for (DeviceCollectionConstIterator it = this->Devices.begin(); it != this->Devices.end(); ++it)
+  {
+    for (ChannelContainerConstIterator channelIt = (*it)->GetOutputChannelsStart(); channelIt != (*it)->GetOutputChannelsEnd(); ++channelIt)
+    {
+      vtkPlusChannel* channel = *channelIt;
+      if ((channel->GetVideoEnabled() && !channel->GetVideoDataAvailable())
+          || (channel->GetTrackingEnabled() && !channel->GetTrackingDataAvailable())
+          || (channel->GetFieldDataEnabled() && !channel->GetFieldDataAvailable()))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusDataCollector::Disconnect()
 {
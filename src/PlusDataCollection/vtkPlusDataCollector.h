@@ -15,6 +15,9 @@ See License.txt for details.
 // VTK includes
 #include <vtkObject.h>
 
+// STL includes
+#include <map>
+
 class PlusTrackedFrame;
 class vtkPlusChannel;
 class vtkPlusDeviceFactory;
@@ -148,18 +151,50 @@ public:
   */
   bool GetConnected() const;
 
-  /*! Set startup delay in sec to give some time to the buffers for proper initialization */
+  /*! Set maximum startup delay in sec. Start() waits at most this long for all output channels to provide their first valid item. */
   vtkSetMacro(StartupDelaySec, double);
-  /*! Get startup delay in sec to give some time to the buffers for proper initialization */
+  /*! Get maximum startup delay in sec. Start() waits at most this long for all output channels to provide their first valid item. */
   vtkGetMacro(StartupDelaySec, double);
 
+  /*!
+    Connect devices that do not depend on each other in parallel.
+    Only devices that report vtkPlusDevice::IsParallelConnectSafe() are connected on worker threads,
+    all other devices are connected one by one on the calling thread.
+  */
+  vtkSetMacro(ParallelConnectEnabled, bool);
+  /*! Connect devices that do not depend on each other in parallel */
+  vtkGetMacro(ParallelConnectEnabled, bool);
+  /*! Connect devices that do not depend on each other in parallel */
+  vtkBooleanMacro(ParallelConnectEnabled, bool);
+
+  /*! Get the time (in sec) that was needed for connecting the device in the last Connect() call. Returns -1 if the device has not been connected. */
+  double GetDeviceConnectTimeSec(const std::string& aDeviceId) const;
+
 protected:
   vtkPlusDataCollector();
   virtual ~vtkPlusDataCollector();
 
-  /*! The timestamp filtering methods require some time to initialize. Synchronization will ignore data that are acquired during startup delay. */
+  /*!
+    Connect the devices. If parallel is true then the devices that are safe to connect in parallel are connected
+    on worker threads, the others are connected in the calling thread. The devices must not depend on each other.
+  */
+  PlusStatus ConnectDevices(const DeviceCollection& devices, bool parallel);
+
+  /*! Returns true if all the output channels of all devices provide valid data (or they are not expected to provide any) */
+  bool AreAllOutputChannelsReady() const;
+
+  /*!
+    The timestamp filtering methods require some time to initialize. Synchronization will ignore data that are acquired during startup delay.
+    Start() waits until each output channel provides its first valid item, but at most StartupDelaySec.
+  */
   double StartupDelaySec;
 
+  /*! Connect devices that do not depend on each other in parallel */
+  bool ParallelConnectEnabled;
+
+  /*! Time (in sec) that was needed for connecting each device, indexed by device ID */
+  std::map<std::string, double> DeviceConnectTimesSec;
+
   vtkSmartPointer<vtkPlusDeviceFactory> DeviceFactory;
 
   DeviceCollection Devices;
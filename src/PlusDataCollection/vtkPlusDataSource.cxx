@@ -378,6 +378,24 @@ PlusStatus vtkPlusDataSource::ReadConfiguration(vtkXMLDataElement* sourceElement
     LOG_DEBUG("AveragedItemsForFiltering is not defined in source element \"" << this->GetId() << "\". Using default value: " << this->GetBuffer()->GetAveragedItemsForFiltering());
   }
 
+  int numberOfUncompressedItems = 0;
+  if (sourceElement->GetScalarAttribute("NumberOfUncompressedItems", numberOfUncompressedItems))
+  {
+    this->GetBuffer()->SetNumberOfUncompressedItems(numberOfUncompressedItems);
+  }
+  int historyCompressionLevel = 0;
+  if (sourceElement->GetScalarAttribute("HistoryCompressionLevel", historyCompressionLevel))
+  {
+    this->GetBuffer()->SetHistoryCompressionLevel(historyCompressionLevel);
+  }
+  bool historyCompression = this->GetBuffer()->GetHistoryCompressionEnabled();
+  XML_READ_BOOL_ATTRIBUTE_NONMEMBER_OPTIONAL(HistoryCompression, historyCompression, sourceElement);
+  if (this->GetBuffer()->SetHistoryCompressionEnabled(historyCompression) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to set history compression in source element \"" << this->GetId() << "\"");
+    return PLUS_FAIL;
+  }
+
   std::string descName;
   if (!aDescriptiveNameForBuffer.empty())
   {
@@ -439,6 +457,17 @@ PlusStatus vtkPlusDataSource::WriteConfiguration(vtkXMLDataElement* aSourceEleme
     aSourceElement->SetIntAttribute("AveragedItemsForFiltering", this->GetBuffer()->GetAveragedItemsForFiltering());
   }
 
+  if (this->GetBuffer()->GetHistoryCompressionEnabled())
+  {
+    aSourceElement->SetAttribute("HistoryCompression", "TRUE");
+    aSourceElement->SetIntAttribute("NumberOfUncompressedItems", this->GetBuffer()->GetNumberOfUncompressedItems());
+    aSourceElement->SetIntAttribute("HistoryCompressionLevel", this->GetBuffer()->GetHistoryCompressionLevel());
+  }
+  else if (aSourceElement->GetAttribute("HistoryCompression") != NULL)
+  {
+    aSourceElement->SetAttribute("HistoryCompression", "FALSE");
+  }
+
   // Write custom properties
   if (this->CustomProperties.size() > 0)
   {
@@ -836,6 +865,12 @@ ItemStatus vtkPlusDataSource::GetStreamBufferItemFromTime(double time, StreamBuf
   return this->GetBuffer()->GetStreamBufferItemFromTime(time, bufferItem, interpolation);
 }
 
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusDataSource::GetInterpolatedTransformsFromTimes(const double* times, int numberOfTimes, double* matrixElements, ToolStatus* toolStatuses, ItemStatus* itemStatuses /*=NULL*/)
+{
+  return this->GetBuffer()->GetInterpolatedTransformsFromTimes(times, numberOfTimes, matrixElements, toolStatuses, itemStatuses);
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusDataSource::ModifyBufferItemFrameField(BufferItemUidType uid, const std::string& key, const std::string& value)
 {
@@ -140,6 +140,8 @@ public:
   virtual ItemStatus GetOldestStreamBufferItem(StreamBufferItem* bufferItem);
   /*! Get a frame that was acquired at the specified time from buffer */
   virtual ItemStatus GetStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem, vtkPlusBuffer::DataItemTemporalInterpolationType interpolation);
+  /*! Get interpolated transforms for multiple sorted timestamps with a single buffer lock (see vtkPlusBuffer::GetInterpolatedTransformsFromTimes) */
+  virtual PlusStatus GetInterpolatedTransformsFromTimes(const double* times, int numberOfTimes, double* matrixElements, ToolStatus* toolStatuses, ItemStatus* itemStatuses = NULL);
   /*! Update a field in the specified stream buffer item */
   virtual PlusStatus ModifyBufferItemFrameField(BufferItemUidType uid, const std::string& key, const std::string& value);
 
@@ -2215,6 +2215,18 @@ ChannelContainerIterator vtkPlusDevice::GetOutputChannelsEnd()
   return this->OutputChannels.end();
 }
 
+//----------------------------------------------------------------------------
+ChannelContainerConstIterator vtkPlusDevice::GetInputChannelsStart() const
+{
+  return this->InputChannels.begin();
+}
+
+//----------------------------------------------------------------------------
+ChannelContainerConstIterator vtkPlusDevice::GetInputChannelsEnd() const
+{
+  return this->InputChannels.end();
+}
+
 //------------------------------------------------------------------------------
 PlusStatus vtkPlusDevice::GetToolReferenceFrameFromTrackedFrame(PlusTrackedFrame& aFrame, std::string& aToolReferenceFrameName)
 {
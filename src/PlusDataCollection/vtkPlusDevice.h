@@ -154,6 +154,13 @@ public:
 
   virtual bool IsVirtual() const { return false; }
 
+  /*!
+    Returns true if the device can be connected on a worker thread, in parallel with other devices.
+    Devices that set up thread-specific state in InternalConnect (e.g., COM initialization) must keep
+    the default, these are connected on the thread that calls vtkPlusDataCollector::Connect().
+  */
+  virtual bool IsParallelConnectSafe() const { return false; }
+
   /*!
   Reset the device. The actual reset action is defined in subclasses. A reset is typically performed on the users request
   while the device is connected. A reset can be used for zeroing sensors, canceling an operation in progress, etc.
@@ -419,6 +426,10 @@ public:
   /*! Add an input channel */
   PlusStatus AddInputChannel(vtkPlusChannel* aChannel);
 
+  /*! Access the input channels */
+  ChannelContainerConstIterator GetInputChannelsStart() const;
+  ChannelContainerConstIterator GetInputChannelsEnd() const;
+
   /*!
   Perform any completion tasks once configured
   */
@@ -58,6 +58,7 @@ vtkPlusGenericSerialDevice::vtkPlusGenericSerialDevice()
   , BaudRate(9600)
   , MaximumReplyDelaySec(0.100)
   , MaximumReplyDurationSec(0.300)
+  , LowLatencyEnabled(false)
   , Mutex(vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New())
   , FrameNumber(0)
   , FieldDataSource(nullptr)
@@ -103,17 +104,34 @@ PlusStatus vtkPlusGenericSerialDevice::InternalConnect()
     return PLUS_FAIL;
   }
 
-  // COM port name format is different for port number under/over 10 (see Microsoft KB115831)
-  // Port number<10: COMn
-  // Port number>=10: \\.\COMn
   std::ostringstream strComPort;
-  if (this->SerialPort < 10)
+  if (!this->SerialPortName.empty())
   {
-    strComPort << "COM" << this->SerialPort;
+    strComPort << this->SerialPortName;
   }
   else
   {
-    strComPort << "\\\\.\\COM" << this->SerialPort;
+    if (this->SerialPort < 1)
+    {
+      LOG_ERROR("Invalid serial port number: " << this->SerialPort << ". COM port numbers start at 1.");
+      return PLUS_FAIL;
+    }
+    // COM port name format is different for port number under/over 10 (see Microsoft KB115831)
+    // Port number<10: COMn
+    // Port number>=10: \\.\COMn
+#ifdef _WIN32
+    if (this->SerialPort < 10)
+    {
+      strComPort << "COM" << this->SerialPort;
+    }
+    else
+    {
+      strComPort << "\\\\.\\COM" << this->SerialPort;
+    }
+#else
+    // COMn corresponds to /dev/ttyS(n-1). Other devices (e.g., USB to serial converters) can be set in SerialPortName.
+    strComPort << "/dev/ttyS" << this->SerialPort - 1;
+#endif
   }
   this->Serial->SetPortName(strComPort.str());
 
@@ -121,6 +139,8 @@ PlusStatus vtkPlusGenericSerialDevice::InternalConnect()
 
   this->Serial->SetMaxReplyTime(50);   // msec
 
+  this->Serial->SetLowLatencyEnabled(this->LowLatencyEnabled);
+
   if (!this->Serial->Open())
   {
     LOG_ERROR("Cannot open serial port " << strComPort.str());
@@ -287,11 +307,24 @@ PlusStatus vtkPlusGenericSerialDevice::NotifyConfigured()
 PlusStatus vtkPlusGenericSerialDevice::ReadConfiguration(vtkXMLDataElement* rootConfigElement)
 {
   XML_FIND_DEVICE_ELEMENT_REQUIRED_FOR_READING(deviceConfig, rootConfigElement);
-  XML_READ_SCALAR_ATTRIBUTE_REQUIRED(unsigned long, SerialPort, deviceConfig);
+  XML_READ_STRING_ATTRIBUTE_OPTIONAL(SerialPortName, deviceConfig);
+  if (this->SerialPortName.empty())
+  {
+    // Read as signed number, so that negative port numbers are rejected instead of wrapping around
+    int serialPort = 0;
+    XML_READ_SCALAR_ATTRIBUTE_NONMEMBER_REQUIRED(int, SerialPort, serialPort, deviceConfig);
+    if (serialPort < 1)
+    {
+      LOG_ERROR("Invalid SerialPort: " << serialPort << ". COM port numbers start at 1 (or set the device name in SerialPortName).");
+      return PLUS_FAIL;
+    }
+    this->SerialPort = serialPort;
+  }
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(unsigned long, BaudRate, deviceConfig);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, MaximumReplyDelaySec, deviceConfig);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, MaximumReplyDurationSec, deviceConfig);
   XML_READ_CSTRING_ATTRIBUTE_OPTIONAL(LineEnding, deviceConfig);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(LowLatencyEnabled, deviceConfig);
   return PLUS_SUCCESS;
 }
 
@@ -300,10 +333,12 @@ PlusStatus vtkPlusGenericSerialDevice::WriteConfiguration(vtkXMLDataElement* roo
 {
   XML_FIND_DEVICE_ELEMENT_REQUIRED_FOR_WRITING(deviceConfig, rootConfigElement);
   deviceConfig->SetUnsignedLongAttribute("SerialPort", this->SerialPort);
+  XML_WRITE_STRING_ATTRIBUTE_IF_NOT_EMPTY(SerialPortName, deviceConfig);
   deviceConfig->SetUnsignedLongAttribute("BaudRate", this->BaudRate);
   deviceConfig->SetDoubleAttribute("MaximumReplyDelaySec", this->MaximumReplyDelaySec);
   deviceConfig->SetDoubleAttribute("MaximumReplyDurationSec", this->MaximumReplyDurationSec);
   deviceConfig->SetAttribute("LineEnding", this->LineEnding.c_str());
+  XML_WRITE_BOOL_ATTRIBUTE(LowLatencyEnabled, deviceConfig);
   return PLUS_SUCCESS;
 }
 
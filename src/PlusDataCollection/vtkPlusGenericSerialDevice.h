@@ -52,10 +52,19 @@ public:
   virtual bool IsTracker() const { return false; }
 
   vtkSetMacro(SerialPort, unsigned long);
+
+  /*! Serial port device name (e.g., "/dev/ttyUSB0"). If not empty then it is used instead of the name derived from SerialPort. */
+  vtkSetMacro(SerialPortName, std::string);
+  vtkGetMacro(SerialPortName, std::string);
+
   vtkSetMacro(BaudRate, unsigned long);
   vtkSetMacro(MaximumReplyDelaySec, double);
   vtkSetMacro(MaximumReplyDurationSec, double);
 
+  /*! Enable low latency mode of the serial line driver (Linux only, takes effect at the next connect) */
+  vtkSetMacro(LowLatencyEnabled, bool);
+  vtkGetMacro(LowLatencyEnabled, bool);
+
   /*! Line ending in hex encoded form, separated by spaces (e.g., "13 10") */
   void SetLineEnding(const char* lineEndingHex);
   vtkGetMacro(LineEnding, std::string);
@@ -91,6 +100,9 @@ protected:
   /*! Used COM port number for serial communication (ComPort: 1 => Port name: "COM1")*/
   unsigned long SerialPort;
 
+  /*! Serial port device name, overrides SerialPort if not empty (e.g., "/dev/ttyUSB0" or "COM3") */
+  std::string SerialPortName;
+
   /*! Baud rate for serial communication. */
   unsigned long BaudRate;
 
@@ -106,6 +118,9 @@ protected:
   /*! Maximum time to wait for the device to finish replying */
   double MaximumReplyDurationSec;
 
+  /*! If true then the serial line driver delivers received bytes immediately instead of buffering them (reduces reply delay of USB-serial adapters) */
+  bool LowLatencyEnabled;
+
   long FrameNumber;
   vtkPlusDataSource* FieldDataSource;
 
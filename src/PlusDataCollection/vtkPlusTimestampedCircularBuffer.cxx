@@ -34,6 +34,7 @@ vtkPlusTimestampedCircularBuffer::vtkPlusTimestampedCircularBuffer()
   this->FilterContainerTimestampVector.set_size(0);
   this->FilterContainersOldestIndex = 0;
   this->FilterContainersNumberOfValidElements = 0;
+  this->RecomputeFilterSums();
 }
 
 //----------------------------------------------------------------------------
@@ -409,6 +410,13 @@ void vtkPlusTimestampedCircularBuffer::DeepCopy(vtkPlusTimestampedCircularBuffer
   this->FilterContainersOldestIndex = buffer->FilterContainersOldestIndex;
   this->FilterContainerTimestampVector = buffer->FilterContainerTimestampVector;
   this->FilterContainerIndexVector = buffer->FilterContainerIndexVector;
+  this->FilterOriginIndex = buffer->FilterOriginIndex;
+  this->FilterOriginTimestamp = buffer->FilterOriginTimestamp;
+  this->FilterSumX = buffer->FilterSumX;
+  this->FilterSumY = buffer->FilterSumY;
+  this->FilterSumXX = buffer->FilterSumXX;
+  this->FilterSumXY = buffer->FilterSumXY;
+  this->FilterSumsNumberOfUpdates = buffer->FilterSumsNumberOfUpdates;
 
   this->BufferItemContainer = buffer->BufferItemContainer;
   this->Unlock();
@@ -538,16 +546,42 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
     this->FilterContainerTimestampVector.set_size(this->AveragedItemsForFiltering);
     this->FilterContainersOldestIndex = 0;
     this->FilterContainersNumberOfValidElements = 0;
+    this->RecomputeFilterSums();
   }
 
   // We store the last AveragedItemsForFiltering unfiltered timestamp and item indexes, because these are used for computing the filtered timestamp.
+  // Sums of the stored values are updated incrementally, so that the line fitting does not have to iterate through all the stored values.
   if (this->AveragedItemsForFiltering > 1)
   {
+    if (this->FilterContainersNumberOfValidElements == 0)
+    {
+      this->FilterOriginIndex = itemIndex;
+      this->FilterOriginTimestamp = inUnfilteredTimestamp;
+    }
+    else if (this->FilterContainersNumberOfValidElements >= this->AveragedItemsForFiltering)
+    {
+      // The oldest value will be overwritten, remove it from the sums
+      double removedX = this->FilterContainerIndexVector(this->FilterContainersOldestIndex) - this->FilterOriginIndex;
+      double removedY = this->FilterContainerTimestampVector(this->FilterContainersOldestIndex) - this->FilterOriginTimestamp;
+      this->FilterSumX -= removedX;
+      this->FilterSumY -= removedY;
+      this->FilterSumXX -= removedX * removedX;
+      this->FilterSumXY -= removedX * removedY;
+    }
+
     this->FilterContainerIndexVector(this->FilterContainersOldestIndex) = itemIndex;
     this->FilterContainerTimestampVector[this->FilterContainersOldestIndex] = inUnfilteredTimestamp;
     this->FilterContainersNumberOfValidElements++;
     this->FilterContainersOldestIndex++;
 
+    double addedX = itemIndex - this->FilterOriginIndex;
+    double addedY = inUnfilteredTimestamp - this->FilterOriginTimestamp;
+    this->FilterSumX += addedX;
+    this->FilterSumY += addedY;
+    this->FilterSumXX += addedX * addedX;
+    this->FilterSumXY += addedX * addedY;
+    this->FilterSumsNumberOfUpdates++;
+
     if (this->FilterContainersNumberOfValidElements > this->AveragedItemsForFiltering)
     {
       this->FilterContainersNumberOfValidElements = this->AveragedItemsForFiltering;
@@ -557,6 +591,13 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
     {
       this->FilterContainersOldestIndex = 0;
     }
+
+    if (this->FilterSumsNumberOfUpdates >= this->AveragedItemsForFiltering)
+    {
+      // Subtracting removed values accumulates rounding errors and the values drift away from the origin,
+      // therefore recompute the sums once for each full window (this keeps the amortized cost constant)
+      this->RecomputeFilterSums();
+    }
   }
 
   // If we don't have enough unfiltered timestamps or we don't want to use afiltering then just use the unfiltered timestamps
@@ -589,21 +630,29 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
   //   a = sum( (x(i)-xMean) * (y(i)-yMean) ) / sum( (x(i)-xMean) * (x(i)-xMean) )
   //   b = yMean - a*xMean
   //
+  // The sums are computed from the running sums of x(i), y(i), x(i)*x(i), x(i)*y(i):
+  //   sum( (x(i)-xMean) * (y(i)-yMean) ) = sum( x(i)*y(i) ) - sum( x(i) ) * sum( y(i) ) / n
+  //   sum( (x(i)-xMean) * (x(i)-xMean) ) = sum( x(i)*x(i) ) - sum( x(i) ) * sum( x(i) ) / n
+  // x and y values are relative to FilterOriginIndex and FilterOriginTimestamp.
+  //
 
-  double xMean = this->FilterContainerIndexVector.mean();
-  double yMean = this->FilterContainerTimestampVector.mean();
-  double covarianceXY = 0;
-  double varianceX = 0;
-  for (int i = this->FilterContainerTimestampVector.size() - 1; i >= 0; i--)
+  const double numberOfItems = this->FilterContainersNumberOfValidElements;
+  double covarianceXY = this->FilterSumXY - this->FilterSumX * this->FilterSumY / numberOfItems;
+  double varianceX = this->FilterSumXX - this->FilterSumX * this->FilterSumX / numberOfItems;
+  if (varianceX <= 0)
   {
-    double xiMinusXmean = (this->FilterContainerIndexVector(i) - xMean);
-    covarianceXY += xiMinusXmean * (this->FilterContainerTimestampVector(i) - yMean);
-    varianceX += xiMinusXmean * xiMinusXmean;
+    // All the item indexes are the same, the line cannot be fitted
+    LOG_DEBUG("Timestamp filtering is not possible, the frame index is the same for all the last " << this->AveragedItemsForFiltering << " items (" << itemIndex << ")");
+    outFilteredTimestamp = inUnfilteredTimestamp;
+    filteredTimestampProbablyValid = false;
+    AddToTimeStampReport(itemIndex, inUnfilteredTimestamp, outFilteredTimestamp);
+    this->Unlock();
+    return PLUS_SUCCESS;
   }
   double a = covarianceXY / varianceX;
-  double b = yMean - a * xMean;
+  double b = (this->FilterSumY - a * this->FilterSumX) / numberOfItems;
 
-  outFilteredTimestamp = a * itemIndex + b;
+  outFilteredTimestamp = this->FilterOriginTimestamp + a * (itemIndex - this->FilterOriginIndex) + b;
 
   if (this->TimeStampLogging)
   {
@@ -627,6 +676,38 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::RecomputeFilterSums()
+{
+  this->FilterSumX = 0;
+  this->FilterSumY = 0;
+  this->FilterSumXX = 0;
+  this->FilterSumXY = 0;
+  this->FilterSumsNumberOfUpdates = 0;
+
+  if (this->FilterContainersNumberOfValidElements == 0)
+  {
+    this->FilterOriginIndex = 0;
+    this->FilterOriginTimestamp = 0;
+    return;
+  }
+
+  // Use the latest value as origin
+  unsigned int latestIndex = (this->FilterContainersOldestIndex > 0 ? this->FilterContainersOldestIndex : this->FilterContainersNumberOfValidElements) - 1;
+  this->FilterOriginIndex = this->FilterContainerIndexVector(latestIndex);
+  this->FilterOriginTimestamp = this->FilterContainerTimestampVector(latestIndex);
+
+  for (unsigned int i = 0; i < this->FilterContainersNumberOfValidElements; i++)
+  {
+    double x = this->FilterContainerIndexVector(i) - this->FilterOriginIndex;
+    double y = this->FilterContainerTimestampVector(i) - this->FilterOriginTimestamp;
+    this->FilterSumX += x;
+    this->FilterSumY += y;
+    this->FilterSumXX += x * x;
+    this->FilterSumXY += x * y;
+  }
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusTimestampedCircularBuffer::GetTimeStampReportTable(vtkTable* timeStampReportTable)
 {
@@ -128,6 +128,9 @@ public:
   /*!  Get the local time offset in seconds (global = local + offset) */
   vtkGetMacro( LocalTimeOffsetSec, double );
 
+  /*! Get the tolerance that is used when comparing timestamps */
+  vtkGetMacro( NegligibleTimeDifferenceSec, double );
+
   /*!
     Get the frame rate from the buffer based on the number of frames in the buffer
     and the elapsed time.
@@ -174,6 +177,8 @@ public:
     The timing may be inaccurate because the timestamp is attached to the item when Plus receives it
     and so the timestamp is affected by data transfer speed (which may slightly vary).
     A line is fitted to the index and timestamp of the last (AveragedItemsForFiltering) items.
+    The fitting is updated incrementally (using running sums over the sliding window), so the
+    computation time does not depend on the number of averaged items.
     The filtered timestamp is the time value that corresponds to the frame index according to the fitted line.
     If the filtered timestamp is very different from the non-filtered timestamp then
     filteredTimestampProbablyValid will be false and it is recommended not to use that item,
@@ -211,6 +216,12 @@ protected:
   vtkPlusTimestampedCircularBuffer();
   ~vtkPlusTimestampedCircularBuffer();
 
+  /*!
+    Recompute the running sums of the filter from the values stored in the filter containers.
+    Called periodically to prevent accumulation of rounding errors and to move the origin close to the latest samples.
+  */
+  void RecomputeFilterSums();
+
 protected:
   vtkPlusRecursiveCriticalSection* Mutex;
 
@@ -244,6 +255,22 @@ protected:
   /*! Number of valid elements in the frame index and timestamp containers (maximum can be equal to AveragedItemsForFiltering) */
   unsigned int FilterContainersNumberOfValidElements;
 
+  /*!
+    Frame index and timestamp that the running sums are computed relative to.
+    Using values close to the samples in the window keeps the sums small and so avoids loss of precision.
+  */
+  double FilterOriginIndex;
+  double FilterOriginTimestamp;
+
+  /*! Running sums of the (origin-relative) frame indexes (x) and timestamps (y) in the filter containers */
+  double FilterSumX;
+  double FilterSumY;
+  double FilterSumXX;
+  double FilterSumXY;
+
+  /*! Number of incremental updates of the running sums since they were last recomputed from the filter containers */
+  unsigned int FilterSumsNumberOfUpdates;
+
   /*! Number of averaged items used for filtering - read from config files */
   unsigned int AveragedItemsForFiltering;
 
@@ -69,14 +69,14 @@ struct vtkPlusOpenIGTLinkExport PlusIgtlClientInfo
   std::vector<ImageStream> ImageStreams;
 
   /*! A new TDATA is only sent if the time elapsed is at least the resolution
-     value (otherwise we don't send this tracking data to the client) */
+     value in milliseconds (otherwise we don't send this tracking data to the client) */
   int Resolution;
 
   /*! flag for start TDATA transmission request: true on STT, false on STP.
      If the start requested flag is false then don't send TDATA to the client. */
   bool TDATARequested;
 
-  /*! timestamp of the last sent TDATA message. */
+  /*! timestamp of the tracking data in the last sent TDATA message (system time). */
   double LastTDATASentTimeStamp;
 };
 
@@ -0,0 +1,462 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusIgtlMulticastChannel.h"
+#include "vtkPlusAccurateTimer.h"
+
+#include <algorithm>
+#include <random>
+#include <string.h>
+
+#ifdef _WIN32
+  #include <Winsock2.h>
+  #include <Ws2tcpip.h>
+#else
+  #include <arpa/inet.h>
+  #include <errno.h>
+  #include <netinet/in.h>
+  #include <sys/select.h>
+  #include <sys/socket.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+  // Datagram header: magic (4 bytes), sender id (4 bytes), sequence number (8 bytes), all in network byte order
+  const unsigned char DATAGRAM_MAGIC[4] = { 'P', 'L', 'M', 'C' };
+  const size_t DATAGRAM_HEADER_SIZE = 16;
+
+  // Largest UDP payload over IPv4
+  const size_t MAXIMUM_DATAGRAM_SIZE = 65507;
+
+  // Larger receive buffer allows the receiver to catch up after short interruptions
+  const int RECEIVE_BUFFER_SIZE_BYTES = 1024 * 1024;
+
+  //----------------------------------------------------------------------------
+  void WriteUInt32(unsigned char* buffer, uint32_t value)
+  {
+    for (int i = 3; i >= 0; --i)
+    {
+      buffer[i] = static_cast<unsigned char>(value & 0xFF);
+      value >>= 8;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void WriteUInt64(unsigned char* buffer, uint64_t value)
+  {
+    for (int i = 7; i >= 0; --i)
+    {
+      buffer[i] = static_cast<unsigned char>(value & 0xFF);
+      value >>= 8;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  uint32_t ReadUInt32(const unsigned char* buffer)
+  {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+      value = (value << 8) | buffer[i];
+    }
+    return value;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64_t ReadUInt64(const unsigned char* buffer)
+  {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+      value = (value << 8) | buffer[i];
+    }
+    return value;
+  }
+
+  //----------------------------------------------------------------------------
+  int GetLastSocketError()
+  {
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus ParseIpv4Address(const std::string& address, uint32_t& parsedAddress)
+  {
+    struct in_addr addr;
+    if (inet_pton(AF_INET, address.c_str(), &addr) != 1)
+    {
+      return PLUS_FAIL;
+    }
+    parsedAddress = addr.s_addr;
+    return PLUS_SUCCESS;
+  }
+}
+
+const size_t PlusIgtlMulticastChannel::MAXIMUM_MESSAGE_SIZE = MAXIMUM_DATAGRAM_SIZE - DATAGRAM_HEADER_SIZE;
+
+//----------------------------------------------------------------------------
+PlusIgtlMulticastChannel::PlusIgtlMulticastChannel()
+  : Socket(0)
+  , SocketValid(false)
+  , Sender(false)
+  , GroupAddress(0)
+  , Port(0)
+  , InterfaceAddress(htonl(INADDR_ANY))
+  , SenderId(0)
+  , NextSequenceNumber(0)
+  , FirstMessage(true)
+  , NumberOfLostMessages(0)
+  , NumberOfDroppedMessages(0)
+{
+}
+
+//----------------------------------------------------------------------------
+PlusIgtlMulticastChannel::~PlusIgtlMulticastChannel()
+{
+  this->Close();
+}
+
+//----------------------------------------------------------------------------
+bool PlusIgtlMulticastChannel::IsOpen() const
+{
+  return this->SocketValid;
+}
+
+//----------------------------------------------------------------------------
+uint64_t PlusIgtlMulticastChannel::GetNumberOfLostMessages() const
+{
+  return this->NumberOfLostMessages;
+}
+
+//----------------------------------------------------------------------------
+uint64_t PlusIgtlMulticastChannel::GetNumberOfDroppedMessages() const
+{
+  return this->NumberOfDroppedMessages;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIgtlMulticastChannel::SetGroupAddress(const std::string& groupAddress, int port)
+{
+  uint32_t address = 0;
+  if (ParseIpv4Address(groupAddress, address) != PLUS_SUCCESS || !IN_MULTICAST(ntohl(address)))
+  {
+    LOG_ERROR("Invalid multicast group address: " << groupAddress << ". An IPv4 address in the range 224.0.0.0-239.255.255.255 is expected.");
+    return PLUS_FAIL;
+  }
+  if (port <= 0 || port > 65535)
+  {
+    LOG_ERROR("Invalid multicast port: " << port);
+    return PLUS_FAIL;
+  }
+  this->GroupAddress = address;
+  this->Port = static_cast<uint16_t>(port);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIgtlMulticastChannel::CreateSocket()
+{
+  this->Close();
+
+#ifdef _WIN32
+  WSADATA wsaData;
+  if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+  {
+    LOG_ERROR("Failed to initialize Windows sockets");
+    return PLUS_FAIL;
+  }
+  SOCKET newSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (newSocket == INVALID_SOCKET)
+  {
+    LOG_ERROR("Failed to create UDP socket (error " << GetLastSocketError() << ")");
+    WSACleanup();
+    return PLUS_FAIL;
+  }
+#else
+  int newSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (newSocket < 0)
+  {
+    LOG_ERROR("Failed to create UDP socket (error " << GetLastSocketError() << ")");
+    return PLUS_FAIL;
+  }
+#endif
+
+  this->Socket = static_cast<SocketType>(newSocket);
+  this->SocketValid = true;
+  this->NextSequenceNumber = 0;
+  this->FirstMessage = true;
+  this->NumberOfLostMessages = 0;
+  this->NumberOfDroppedMessages = 0;
+  this->DatagramBuffer.resize(MAXIMUM_DATAGRAM_SIZE);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIgtlMulticastChannel::OpenSender(const std::string& groupAddress, int port, int timeToLive /*=1*/, const std::string& interfaceAddress /*=""*/, bool loopbackEnabled /*=true*/)
+{
+  if (this->SetGroupAddress(groupAddress, port) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  uint32_t sendInterfaceAddress = htonl(INADDR_ANY);
+  if (!interfaceAddress.empty() && ParseIpv4Address(interfaceAddress, sendInterfaceAddress) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Invalid multicast interface address: " << interfaceAddress);
+    return PLUS_FAIL;
+  }
+  if (this->CreateSocket() != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  this->Sender = true;
+  this->InterfaceAddress = sendInterfaceAddress;
+
+#ifdef _WIN32
+  DWORD ttl = timeToLive;
+  DWORD loop = loopbackEnabled ? 1 : 0;
+#else
+  unsigned char ttl = static_cast<unsigned char>(timeToLive);
+  unsigned char loop = loopbackEnabled ? 1 : 0;
+#endif
+  if (setsockopt(this->Socket, IPPROTO_IP, IP_MULTICAST_TTL, reinterpret_cast<const char*>(&ttl), sizeof(ttl)) != 0
+      || setsockopt(this->Socket, IPPROTO_IP, IP_MULTICAST_LOOP, reinterpret_cast<const char*>(&loop), sizeof(loop)) != 0)
+  {
+    LOG_ERROR("Failed to set multicast options on UDP socket (error " << GetLastSocketError() << ")");
+    this->CloseSocket();
+    return PLUS_FAIL;
+  }
+  if (!interfaceAddress.empty())
+  {
+    struct in_addr addr;
+    addr.s_addr = this->InterfaceAddress;
+    if (setsockopt(this->Socket, IPPROTO_IP, IP_MULTICAST_IF, reinterpret_cast<const char*>(&addr), sizeof(addr)) != 0)
+    {
+      LOG_ERROR("Failed to select multicast interface " << interfaceAddress << " (error " << GetLastSocketError() << ")");
+      this->CloseSocket();
+      return PLUS_FAIL;
+    }
+  }
+
+  // A new sender id lets the receivers know that the sequence numbers are restarted
+  std::random_device randomDevice;
+  this->SenderId = static_cast<uint32_t>(randomDevice());
+
+  LOG_DEBUG("Multicast sender opened: " << groupAddress << ":" << port << " (TTL: " << timeToLive << ")");
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIgtlMulticastChannel::OpenReceiver(const std::string& groupAddress, int port, const std::string& interfaceAddress /*=""*/)
+{
+  if (this->SetGroupAddress(groupAddress, port) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  uint32_t receiveInterfaceAddress = htonl(INADDR_ANY);
+  if (!interfaceAddress.empty() && ParseIpv4Address(interfaceAddress, receiveInterfaceAddress) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Invalid multicast interface address: " << interfaceAddress);
+    return PLUS_FAIL;
+  }
+  if (this->CreateSocket() != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  this->Sender = false;
+  this->InterfaceAddress = receiveInterfaceAddress;
+
+  // Allow multiple receivers on the same host
+  int reuse = 1;
+  if (setsockopt(this->Socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse)) != 0)
+  {
+    LOG_ERROR("Failed to enable address reuse on UDP socket (error " << GetLastSocketError() << ")");
+    this->CloseSocket();
+    return PLUS_FAIL;
+  }
+#ifdef SO_REUSEPORT
+  setsockopt(this->Socket, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+#endif
+  int receiveBufferSize = RECEIVE_BUFFER_SIZE_BYTES;
+  setsockopt(this->Socket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receiveBufferSize), sizeof(receiveBufferSize));
+
+  struct sockaddr_in localAddress;
+  memset(&localAddress, 0, sizeof(localAddress));
+  localAddress.sin_family = AF_INET;
+  localAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+  localAddress.sin_port = htons(this->Port);
+  if (bind(this->Socket, reinterpret_cast<struct sockaddr*>(&localAddress), sizeof(localAddress)) != 0)
+  {
+    LOG_ERROR("Failed to bind UDP socket to port " << port << " (error " << GetLastSocketError() << ")");
+    this->CloseSocket();
+    return PLUS_FAIL;
+  }
+
+  struct ip_mreq membership;
+  membership.imr_multiaddr.s_addr = this->GroupAddress;
+  membership.imr_interface.s_addr = this->InterfaceAddress;
+  if (setsockopt(this->Socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, reinterpret_cast<const char*>(&membership), sizeof(membership)) != 0)
+  {
+    LOG_ERROR("Failed to join multicast group " << groupAddress << " (error " << GetLastSocketError() << ")");
+    this->CloseSocket();
+    return PLUS_FAIL;
+  }
+
+  LOG_DEBUG("Multicast receiver joined: " << groupAddress << ":" << port);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlMulticastChannel::Close()
+{
+  if (!this->SocketValid)
+  {
+    return;
+  }
+  if (!this->Sender)
+  {
+    struct ip_mreq membership;
+    membership.imr_multiaddr.s_addr = this->GroupAddress;
+    membership.imr_interface.s_addr = this->InterfaceAddress;
+    setsockopt(this->Socket, IPPROTO_IP, IP_DROP_MEMBERSHIP, reinterpret_cast<const char*>(&membership), sizeof(membership));
+  }
+  this->CloseSocket();
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlMulticastChannel::CloseSocket()
+{
+  if (!this->SocketValid)
+  {
+    return;
+  }
+#ifdef _WIN32
+  closesocket(this->Socket);
+  WSACleanup();
+#else
+  close(this->Socket);
+#endif
+  this->SocketValid = false;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIgtlMulticastChannel::Send(const void* data, size_t size)
+{
+  if (!this->SocketValid || !this->Sender)
+  {
+    LOG_ERROR("Multicast channel is not open for sending");
+    return PLUS_FAIL;
+  }
+  if (size > MAXIMUM_MESSAGE_SIZE)
+  {
+    LOG_ERROR("Message is too large for multicast: " << size << " bytes (maximum: " << MAXIMUM_MESSAGE_SIZE << " bytes)");
+    return PLUS_FAIL;
+  }
+
+  unsigned char* datagram = &this->DatagramBuffer[0];
+  memcpy(datagram, DATAGRAM_MAGIC, sizeof(DATAGRAM_MAGIC));
+  WriteUInt32(datagram + 4, this->SenderId);
+  WriteUInt64(datagram + 8, this->NextSequenceNumber);
+  memcpy(datagram + DATAGRAM_HEADER_SIZE, data, size);
+
+  // The sequence number is consumed even if sending fails, so that receivers see the gap
+  this->NextSequenceNumber++;
+
+  struct sockaddr_in groupAddress;
+  memset(&groupAddress, 0, sizeof(groupAddress));
+  groupAddress.sin_family = AF_INET;
+  groupAddress.sin_addr.s_addr = this->GroupAddress;
+  groupAddress.sin_port = htons(this->Port);
+  int datagramSize = static_cast<int>(DATAGRAM_HEADER_SIZE + size);
+  if (sendto(this->Socket, reinterpret_cast<const char*>(datagram), datagramSize, 0, reinterpret_cast<struct sockaddr*>(&groupAddress), sizeof(groupAddress)) != datagramSize)
+  {
+    LOG_DEBUG("Failed to send multicast message (error " << GetLastSocketError() << ")");
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIgtlMulticastChannel::Receive(std::vector<unsigned char>& data, double timeoutSec, unsigned int* numberOfLostMessages /*=NULL*/)
+{
+  if (numberOfLostMessages != NULL)
+  {
+    *numberOfLostMessages = 0;
+  }
+  if (!this->SocketValid || this->Sender)
+  {
+    LOG_ERROR("Multicast channel is not open for receiving");
+    return PLUS_FAIL;
+  }
+
+  double deadline = vtkPlusAccurateTimer::GetSystemTime() + timeoutSec;
+  while (true)
+  {
+    double remainingTimeSec = std::max(deadline - vtkPlusAccurateTimer::GetSystemTime(), 0.0);
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(this->Socket, &readSet);
+    struct timeval timeout;
+    timeout.tv_sec = static_cast<long>(remainingTimeSec);
+    timeout.tv_usec = static_cast<long>((remainingTimeSec - timeout.tv_sec) * 1e6);
+    int selectResult = select(static_cast<int>(this->Socket) + 1, &readSet, NULL, NULL, &timeout);
+    if (selectResult < 0)
+    {
+#ifndef _WIN32
+      if (errno == EINTR)
+      {
+        continue;
+      }
+#endif
+      LOG_ERROR("Failed to wait for multicast messages (error " << GetLastSocketError() << ")");
+      return PLUS_FAIL;
+    }
+    if (selectResult == 0)
+    {
+      // Timeout
+      return PLUS_FAIL;
+    }
+
+    int datagramSize = recv(this->Socket, reinterpret_cast<char*>(&this->DatagramBuffer[0]), static_cast<int>(this->DatagramBuffer.size()), 0);
+    if (datagramSize < static_cast<int>(DATAGRAM_HEADER_SIZE) || memcmp(&this->DatagramBuffer[0], DATAGRAM_MAGIC, sizeof(DATAGRAM_MAGIC)) != 0)
+    {
+      // Not a datagram of a Plus multicast channel, ignore it
+      continue;
+    }
+
+    uint32_t senderId = ReadUInt32(&this->DatagramBuffer[4]);
+    uint64_t sequenceNumber = ReadUInt64(&this->DatagramBuffer[8]);
+    if (this->FirstMessage || senderId != this->SenderId)
+    {
+      // First message or the sender is restarted, start counting from this message
+      this->SenderId = senderId;
+      this->NextSequenceNumber = sequenceNumber;
+      this->FirstMessage = false;
+    }
+    if (sequenceNumber < this->NextSequenceNumber)
+    {
+      // A newer message has been received already, this one is late (or duplicated)
+      this->NumberOfDroppedMessages++;
+      continue;
+    }
+
+    uint64_t lostMessages = sequenceNumber - this->NextSequenceNumber;
+    this->NumberOfLostMessages += lostMessages;
+    this->NextSequenceNumber = sequenceNumber + 1;
+    if (numberOfLostMessages != NULL)
+    {
+      *numberOfLostMessages = static_cast<unsigned int>(lostMessages);
+    }
+
+    data.assign(this->DatagramBuffer.begin() + DATAGRAM_HEADER_SIZE, this->DatagramBuffer.begin() + datagramSize);
+    return PLUS_SUCCESS;
+  }
+}
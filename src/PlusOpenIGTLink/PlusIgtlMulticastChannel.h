@@ -0,0 +1,130 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusIgtlMulticastChannel_h
+#define __PlusIgtlMulticastChannel_h
+
+#include "PlusConfigure.h"
+#include "vtkPlusOpenIGTLinkExport.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*!
+  \class PlusIgtlMulticastChannel
+  \brief Send and receive packed OpenIGTLink messages over UDP multicast
+
+  Each datagram contains a single packed OpenIGTLink message, preceded by a short header
+  that contains the identifier of the sender and the sequence number of the message.
+  The messages are sent once, regardless of the number of receivers. Datagrams are not
+  retransmitted: a receiver detects lost messages from gaps in the sequence numbers,
+  and drops messages that arrive after a newer message has already been received.
+
+  Messages must fit into a single datagram (see MAXIMUM_MESSAGE_SIZE), therefore the channel is
+  intended for small messages, such as TRANSFORM, POSITION, and TDATA.
+
+  A single object must not be used from multiple threads at the same time.
+
+  \ingroup PlusLibOpenIGTLink
+*/
+class vtkPlusOpenIGTLinkExport PlusIgtlMulticastChannel
+{
+public:
+  PlusIgtlMulticastChannel();
+  ~PlusIgtlMulticastChannel();
+
+  /*! Largest message size that fits into a single UDP datagram with the channel header */
+  static const size_t MAXIMUM_MESSAGE_SIZE;
+
+  /*!
+    Open the channel for sending messages to a multicast group.
+    \param groupAddress IPv4 multicast group address (e.g., 239.255.42.99)
+    \param port UDP port of the group
+    \param timeToLive Maximum number of routers the datagrams may pass (1: local network only)
+    \param interfaceAddress Address of the network interface to send on, empty for the default interface
+    \param loopbackEnabled Deliver the sent messages to receivers on the same host
+  */
+  PlusStatus OpenSender(const std::string& groupAddress, int port, int timeToLive = 1, const std::string& interfaceAddress = "", bool loopbackEnabled = true);
+
+  /*!
+    Join a multicast group for receiving messages.
+    \param groupAddress IPv4 multicast group address (e.g., 239.255.42.99)
+    \param port UDP port of the group
+    \param interfaceAddress Address of the network interface to receive on, empty for the default interface
+  */
+  PlusStatus OpenReceiver(const std::string& groupAddress, int port, const std::string& interfaceAddress = "");
+
+  /*! Close the socket and leave the multicast group */
+  void Close();
+
+  bool IsOpen() const;
+
+  /*! Send a packed message with the next sequence number. Only for channels opened by OpenSender(). */
+  PlusStatus Send(const void* data, size_t size);
+
+  /*!
+    Receive the next message. Only for channels opened by OpenReceiver().
+    Messages that are older than the last received message are dropped.
+    \param data Contents of the message
+    \param timeoutSec Maximum time to wait for a message
+    \param numberOfLostMessages If not NULL then the number of messages that were skipped since the previous received message is returned here
+    \return PLUS_FAIL if no message was received within the timeout
+  */
+  PlusStatus Receive(std::vector<unsigned char>& data, double timeoutSec, unsigned int* numberOfLostMessages = NULL);
+
+  /*! Total number of messages lost since the channel was opened */
+  uint64_t GetNumberOfLostMessages() const;
+
+  /*! Total number of messages dropped because they arrived late or duplicated */
+  uint64_t GetNumberOfDroppedMessages() const;
+
+protected:
+  /*! Create the socket and set the options that are common for sending and receiving */
+  PlusStatus CreateSocket();
+
+  /*! Resolve the group address, it must be an IPv4 multicast address */
+  PlusStatus SetGroupAddress(const std::string& groupAddress, int port);
+
+  /*! Close the socket without logging, used for cleaning up after errors */
+  void CloseSocket();
+
+#ifdef _WIN32
+  typedef uintptr_t SocketType;
+#else
+  typedef int SocketType;
+#endif
+
+  SocketType Socket;
+  bool SocketValid;
+  bool Sender;
+
+  /*! Group address (in_addr, in network byte order), port, and interface of the channel */
+  uint32_t GroupAddress;
+  uint16_t Port;
+  uint32_t InterfaceAddress;
+
+  /*! Identifies the sender, so that a receiver can recognize when the sender is restarted */
+  uint32_t SenderId;
+
+  /*! Sequence number of the next message (sender) or the next expected message (receiver) */
+  uint64_t NextSequenceNumber;
+
+  /*! The receiver has not received any message yet from the current sender */
+  bool FirstMessage;
+
+  uint64_t NumberOfLostMessages;
+  uint64_t NumberOfDroppedMessages;
+
+  /*! Buffer for composing and receiving datagrams */
+  std::vector<unsigned char> DatagramBuffer;
+
+private:
+  PlusIgtlMulticastChannel(const PlusIgtlMulticastChannel&);
+  void operator=(const PlusIgtlMulticastChannel&);
+};
+
+#endif
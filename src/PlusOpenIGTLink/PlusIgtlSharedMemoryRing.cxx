@@ -0,0 +1,436 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusIgtlSharedMemoryRing.h"
+#include "vtkPlusAccurateTimer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#if defined(__linux__)
+  #include <climits>
+  #include <linux/futex.h>
+  #include <sys/syscall.h>
+  #include <time.h>
+#endif
+
+namespace
+{
+  const uint32_t RING_MAGIC = 0x474c5450; // "PTLG"
+  const uint32_t RING_VERSION = 1;
+
+  /*! Record size value that indicates that the next record starts at the beginning of the buffer */
+  const uint32_t WRAP_MARKER = 0xFFFFFFFF;
+
+  const uint64_t RECORD_ALIGNMENT = 8;
+  const uint64_t UNKNOWN_SEQUENCE_NUMBER = UINT64_MAX;
+
+  /*! Polling period if readers cannot be woken up by the writer */
+  const double READER_POLLING_PERIOD_SEC = 0.001;
+
+  struct RecordHeader
+  {
+    uint64_t SequenceNumber;
+    uint32_t Size;
+    uint32_t Reserved;
+  };
+
+  //----------------------------------------------------------------------------
+  uint64_t AlignRecordSize(uint64_t size)
+  {
+    return (size + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+  }
+}
+
+const char* PlusIgtlSharedMemoryRing::TRANSPORT_NAME = "SharedMemoryTransport";
+
+//----------------------------------------------------------------------------
+// Shared by all processes, offsets are counted in bytes from the creation of the ring.
+// The atomic members are lock-free, therefore they can be used for synchronization between processes.
+struct PlusIgtlSharedMemoryRing::RingHeader
+{
+  std::atomic<uint32_t> Magic;
+  uint32_t Version;
+  uint64_t Capacity;
+  /*! End of the record that is currently being written, data before ReservedOffset-Capacity may be overwritten */
+  std::atomic<uint64_t> ReservedOffset;
+  /*! End of the last completely written record */
+  std::atomic<uint64_t> CommittedOffset;
+  /*! Start of the last completely written record, readers that are overtaken by the writer continue from here */
+  std::atomic<uint64_t> LatestRecordOffset;
+  std::atomic<uint64_t> NextSequenceNumber;
+  /*! Incremented after each write, readers wait for its change */
+  std::atomic<uint32_t> NotificationCounter;
+  std::atomic<uint32_t> NumberOfWaitingReaders;
+};
+
+//----------------------------------------------------------------------------
+PlusIgtlSharedMemoryRing::PlusIgtlSharedMemoryRing()
+  : Owner(false)
+  , FileDescriptor(-1)
+  , Memory(NULL)
+  , MemorySize(0)
+  , Header(NULL)
+  , Data(NULL)
+  , ReadOffset(0)
+  , ExpectedSequenceNumber(UNKNOWN_SEQUENCE_NUMBER)
+{
+}
+
+//----------------------------------------------------------------------------
+PlusIgtlSharedMemoryRing::~PlusIgtlSharedMemoryRing()
+{
+  this->Close();
+}
+
+//----------------------------------------------------------------------------
+bool PlusIgtlSharedMemoryRing::IsSupported()
+{
+#ifdef _WIN32
+  return false;
+#else
+  return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIgtlSharedMemoryRing::Create(const std::string& name, size_t capacityBytes)
+{
+#ifdef _WIN32
+  LOG_ERROR("Shared memory transport is not supported on this platform");
+  return PLUS_FAIL;
+#else
+  this->Close();
+
+  uint64_t capacity = capacityBytes / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+  if (capacity < 2 * sizeof(RecordHeader))
+  {
+    LOG_ERROR("Failed to create shared memory ring " << name << ": capacity " << capacityBytes << " bytes is too small");
+    return PLUS_FAIL;
+  }
+
+  // Remove the segment that may have been left behind by a crashed process
+  shm_unlink(name.c_str());
+  this->FileDescriptor = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (this->FileDescriptor < 0)
+  {
+    LOG_ERROR("Failed to create shared memory segment " << name << ": " << strerror(errno));
+    return PLUS_FAIL;
+  }
+  this->Name = name;
+  this->Owner = true;
+
+  size_t headerSize = AlignRecordSize(sizeof(RingHeader));
+  this->MemorySize = headerSize + capacity;
+  if (ftruncate(this->FileDescriptor, this->MemorySize) != 0)
+  {
+    LOG_ERROR("Failed to set size of shared memory segment " << name << ": " << strerror(errno));
+    this->Close();
+    return PLUS_FAIL;
+  }
+  this->Memory = mmap(NULL, this->MemorySize, PROT_READ | PROT_WRITE, MAP_SHARED, this->FileDescriptor, 0);
+  if (this->Memory == MAP_FAILED)
+  {
+    LOG_ERROR("Failed to map shared memory segment " << name << ": " << strerror(errno));
+    this->Memory = NULL;
+    this->Close();
+    return PLUS_FAIL;
+  }
+
+  this->Header = new (this->Memory) RingHeader;
+  this->Header->Version = RING_VERSION;
+  this->Header->Capacity = capacity;
+  this->Header->ReservedOffset = 0;
+  this->Header->CommittedOffset = 0;
+  this->Header->LatestRecordOffset = 0;
+  this->Header->NextSequenceNumber = 0;
+  this->Header->NotificationCounter = 0;
+  this->Header->NumberOfWaitingReaders = 0;
+  this->Data = static_cast<unsigned char*>(this->Memory) + headerSize;
+  // Readers only accept the segment after the magic number is set, when all the other fields are initialized
+  this->Header->Magic.store(RING_MAGIC, std::memory_order_release);
+
+  return PLUS_SUCCESS;
+#endif
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIgtlSharedMemoryRing::Open(const std::string& name)
+{
+#ifdef _WIN32
+  LOG_ERROR("Shared memory transport is not supported on this platform");
+  return PLUS_FAIL;
+#else
+  this->Close();
+
+  // Read-write access is needed for registering as a waiting reader
+  this->FileDescriptor = shm_open(name.c_str(), O_RDWR, 0);
+  if (this->FileDescriptor < 0)
+  {
+    LOG_ERROR("Failed to open shared memory segment " << name << ": " << strerror(errno));
+    return PLUS_FAIL;
+  }
+  this->Name = name;
+
+  struct stat segmentInfo;
+  size_t headerSize = AlignRecordSize(sizeof(RingHeader));
+  if (fstat(this->FileDescriptor, &segmentInfo) != 0 || static_cast<size_t>(segmentInfo.st_size) <= headerSize)
+  {
+    LOG_ERROR("Failed to open shared memory segment " << name << ": invalid segment size");
+    this->Close();
+    return PLUS_FAIL;
+  }
+  this->MemorySize = segmentInfo.st_size;
+  this->Memory = mmap(NULL, this->MemorySize, PROT_READ | PROT_WRITE, MAP_SHARED, this->FileDescriptor, 0);
+  if (this->Memory == MAP_FAILED)
+  {
+    LOG_ERROR("Failed to map shared memory segment " << name << ": " << strerror(errno));
+    this->Memory = NULL;
+    this->Close();
+    return PLUS_FAIL;
+  }
+
+  this->Header = static_cast<RingHeader*>(this->Memory);
+  if (this->Header->Magic.load(std::memory_order_acquire) != RING_MAGIC || this->Header->Version != RING_VERSION
+      || this->Header->Capacity != this->MemorySize - headerSize)
+  {
+    LOG_ERROR("Failed to open shared memory segment " << name << ": the segment is not a message ring or it is not initialized yet");
+    this->Header = NULL;
+    this->Close();
+    return PLUS_FAIL;
+  }
+  this->Data = static_cast<unsigned char*>(this->Memory) + headerSize;
+  this->ReadOffset = this->Header->CommittedOffset.load(std::memory_order_acquire);
+  this->ExpectedSequenceNumber = UNKNOWN_SEQUENCE_NUMBER;
+
+  return PLUS_SUCCESS;
+#endif
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlSharedMemoryRing::Close()
+{
+#ifndef _WIN32
+  if (this->Memory != NULL)
+  {
+    munmap(this->Memory, this->MemorySize);
+  }
+  if (this->FileDescriptor >= 0)
+  {
+    close(this->FileDescriptor);
+  }
+  if (this->Owner)
+  {
+    shm_unlink(this->Name.c_str());
+  }
+#endif
+  this->Name.clear();
+  this->Owner = false;
+  this->FileDescriptor = -1;
+  this->Memory = NULL;
+  this->MemorySize = 0;
+  this->Header = NULL;
+  this->Data = NULL;
+}
+
+//----------------------------------------------------------------------------
+bool PlusIgtlSharedMemoryRing::IsOpen() const
+{
+  return this->Header != NULL;
+}
+
+//----------------------------------------------------------------------------
+std::string PlusIgtlSharedMemoryRing::GetName() const
+{
+  return this->Name;
+}
+
+//----------------------------------------------------------------------------
+size_t PlusIgtlSharedMemoryRing::GetCapacity() const
+{
+  return this->Header != NULL ? this->Header->Capacity : 0;
+}
+
+//----------------------------------------------------------------------------
+size_t PlusIgtlSharedMemoryRing::GetMaximumMessageSize() const
+{
+  return this->Header != NULL ? this->Header->Capacity - sizeof(RecordHeader) : 0;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIgtlSharedMemoryRing::Write(const void* data, size_t size)
+{
+  if (this->Header == NULL || !this->Owner)
+  {
+    LOG_ERROR("Failed to write message to shared memory ring: the ring is not created");
+    return PLUS_FAIL;
+  }
+  const uint64_t capacity = this->Header->Capacity;
+  uint64_t recordSize = AlignRecordSize(sizeof(RecordHeader) + size);
+  if (recordSize > capacity || size >= WRAP_MARKER)
+  {
+    LOG_ERROR("Failed to write message to shared memory ring " << this->Name << ": message size (" << size << " bytes) exceeds the ring capacity");
+    return PLUS_FAIL;
+  }
+
+  // Records are stored contiguously, if the record does not fit before the end of the buffer then it is written at the beginning
+  uint64_t writeOffset = this->Header->CommittedOffset.load(std::memory_order_relaxed);
+  uint64_t remainingBytes = capacity - writeOffset % capacity;
+  uint64_t recordOffset = (remainingBytes < recordSize) ? writeOffset + remainingBytes : writeOffset;
+
+  // Tell the readers which data is about to be overwritten before modifying it
+  this->Header->ReservedOffset.store(recordOffset + recordSize, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  if (recordOffset != writeOffset && remainingBytes >= sizeof(RecordHeader))
+  {
+    RecordHeader wrapMarker = {0, WRAP_MARKER, 0};
+    memcpy(this->Data + writeOffset % capacity, &wrapMarker, sizeof(RecordHeader));
+  }
+  RecordHeader recordHeader = {this->Header->NextSequenceNumber.fetch_add(1, std::memory_order_relaxed), static_cast<uint32_t>(size), 0};
+  unsigned char* record = this->Data + recordOffset % capacity;
+  memcpy(record, &recordHeader, sizeof(RecordHeader));
+  memcpy(record + sizeof(RecordHeader), data, size);
+
+  this->Header->LatestRecordOffset.store(recordOffset, std::memory_order_relaxed);
+  this->Header->CommittedOffset.store(recordOffset + recordSize, std::memory_order_release);
+
+  // Wake up the waiting readers
+  this->Header->NotificationCounter.fetch_add(1);
+#if defined(__linux__)
+  if (this->Header->NumberOfWaitingReaders.load() > 0)
+  {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&this->Header->NotificationCounter), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+  }
+#endif
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+bool PlusIgtlSharedMemoryRing::IsOverwritten(uint64_t offset) const
+{
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return this->Header->ReservedOffset.load(std::memory_order_relaxed) - offset > this->Header->Capacity;
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlSharedMemoryRing::WaitForMessage(double deadline)
+{
+  double remainingTimeSec = deadline - vtkPlusAccurateTimer::GetSystemTime();
+  if (remainingTimeSec <= 0)
+  {
+    return;
+  }
+#if defined(__linux__)
+  this->Header->NumberOfWaitingReaders.fetch_add(1);
+  uint32_t notificationCounter = this->Header->NotificationCounter.load();
+  if (this->Header->CommittedOffset.load() == this->ReadOffset)
+  {
+    struct timespec timeout;
+    timeout.tv_sec = static_cast<time_t>(remainingTimeSec);
+    timeout.tv_nsec = static_cast<long>((remainingTimeSec - timeout.tv_sec) * 1e9);
+    // Returns immediately if a message has been written since the counter was read
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&this->Header->NotificationCounter), FUTEX_WAIT, notificationCounter, &timeout, NULL, 0);
+  }
+  this->Header->NumberOfWaitingReaders.fetch_sub(1);
+#else
+  vtkPlusAccurateTimer::Delay(std::min(remainingTimeSec, READER_POLLING_PERIOD_SEC));
+#endif
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIgtlSharedMemoryRing::Read(std::vector<unsigned char>& data, double timeoutSec, unsigned int* numberOfLostMessages /*=NULL*/)
+{
+  if (numberOfLostMessages != NULL)
+  {
+    *numberOfLostMessages = 0;
+  }
+  if (this->Header == NULL || this->Owner)
+  {
+    LOG_ERROR("Failed to read message from shared memory ring: the ring is not opened for reading");
+    return PLUS_FAIL;
+  }
+
+  const uint64_t capacity = this->Header->Capacity;
+  const double deadline = vtkPlusAccurateTimer::GetSystemTime() + timeoutSec;
+  while (true)
+  {
+    uint64_t committedOffset = this->Header->CommittedOffset.load(std::memory_order_acquire);
+    if (committedOffset == this->ReadOffset)
+    {
+      if (vtkPlusAccurateTimer::GetSystemTime() >= deadline)
+      {
+        return PLUS_FAIL;
+      }
+      this->WaitForMessage(deadline);
+      continue;
+    }
+    if (committedOffset - this->ReadOffset > capacity)
+    {
+      // The writer has overtaken this reader, continue from the latest message.
+      // The number of lost messages is determined from the sequence number of the next message.
+      this->ReadOffset = this->Header->LatestRecordOffset.load(std::memory_order_relaxed);
+      continue;
+    }
+
+    uint64_t remainingBytes = capacity - this->ReadOffset % capacity;
+    if (remainingBytes < sizeof(RecordHeader))
+    {
+      // No room for a record header before the end of the buffer, the next record is at the beginning
+      this->ReadOffset += remainingBytes;
+      continue;
+    }
+
+    RecordHeader recordHeader;
+    memcpy(&recordHeader, this->Data + this->ReadOffset % capacity, sizeof(RecordHeader));
+    if (this->IsOverwritten(this->ReadOffset))
+    {
+      this->ReadOffset = this->Header->LatestRecordOffset.load(std::memory_order_acquire);
+      continue;
+    }
+    if (recordHeader.Size == WRAP_MARKER)
+    {
+      this->ReadOffset += remainingBytes;
+      continue;
+    }
+    uint64_t recordSize = AlignRecordSize(sizeof(RecordHeader) + recordHeader.Size);
+    if (recordSize > remainingBytes)
+    {
+      LOG_ERROR("Invalid record found in shared memory ring " << this->Name << ", skip to the latest message");
+      this->ReadOffset = this->Header->LatestRecordOffset.load(std::memory_order_acquire);
+      continue;
+    }
+
+    const unsigned char* recordData = this->Data + this->ReadOffset % capacity + sizeof(RecordHeader);
+    data.assign(recordData, recordData + recordHeader.Size);
+    if (this->IsOverwritten(this->ReadOffset))
+    {
+      // The writer modified the record while it was being copied
+      this->ReadOffset = this->Header->LatestRecordOffset.load(std::memory_order_acquire);
+      continue;
+    }
+    this->ReadOffset += recordSize;
+
+    if (this->ExpectedSequenceNumber != UNKNOWN_SEQUENCE_NUMBER && recordHeader.SequenceNumber > this->ExpectedSequenceNumber && numberOfLostMessages != NULL)
+    {
+      *numberOfLostMessages = static_cast<unsigned int>(recordHeader.SequenceNumber - this->ExpectedSequenceNumber);
+    }
+    this->ExpectedSequenceNumber = recordHeader.SequenceNumber + 1;
+    return PLUS_SUCCESS;
+  }
+}
@@ -0,0 +1,110 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusIgtlSharedMemoryRing_h
+#define __PlusIgtlSharedMemoryRing_h
+
+#include "PlusConfigure.h"
+#include "vtkPlusOpenIGTLinkExport.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*!
+  \class PlusIgtlSharedMemoryRing
+  \brief Ring buffer of packed OpenIGTLink messages in POSIX shared memory
+
+  Allows sending messages to any number of processes on the same host without copying the data
+  through the network stack. There is a single writer process, which creates the shared memory segment,
+  and any number of reader processes, which open the segment by name. Each message is written once
+  into the ring and each reader reads it at its own pace.
+
+  The writer never waits for the readers: if a reader falls behind by more than the ring capacity then
+  the overwritten messages are lost, which the reader can detect from the message sequence numbers.
+  Readers waiting for new messages are woken up by a futex on Linux, on other platforms they poll.
+
+  A single object must not be used from multiple threads at the same time.
+  Shared memory transport is not available on Windows.
+
+  \ingroup PlusLibOpenIGTLink
+*/
+class vtkPlusOpenIGTLinkExport PlusIgtlSharedMemoryRing
+{
+public:
+  PlusIgtlSharedMemoryRing();
+  ~PlusIgtlSharedMemoryRing();
+
+  /*! Returns true if shared memory transport is supported on this platform */
+  static bool IsSupported();
+
+  /*!
+    Create a shared memory segment and open it for writing. An existing segment with the same name is replaced.
+    \param name Name of the shared memory segment, it must start with a slash (e.g., /PlusServer_18944)
+    \param capacityBytes Size of the message buffer, it limits the size of a message
+  */
+  PlusStatus Create(const std::string& name, size_t capacityBytes);
+
+  /*! Open an existing shared memory segment for reading. Only messages written after opening are read. */
+  PlusStatus Open(const std::string& name);
+
+  /*! Close the shared memory segment. The segment is removed if it was created by this object. */
+  void Close();
+
+  bool IsOpen() const;
+
+  /*! Name that clients use for requesting shared memory transport (CLIENTINFO metadata key and reply STRING message device name) */
+  static const char* TRANSPORT_NAME;
+
+  std::string GetName() const;
+
+  /*! Returns the size of the message buffer */
+  size_t GetCapacity() const;
+
+  /*! Returns the size of the largest message that can be written into the ring */
+  size_t GetMaximumMessageSize() const;
+
+  /*! Write a message into the ring and wake up the waiting readers. Only for rings opened by Create(). */
+  PlusStatus Write(const void* data, size_t size);
+
+  /*!
+    Read the next message from the ring. Only for rings opened by Open().
+    \param data Contents of the message
+    \param timeoutSec Maximum time to wait for a new message
+    \param numberOfLostMessages If not NULL then the number of messages that were overwritten before they could be read is returned here
+    \return PLUS_FAIL if no message was received within the timeout
+  */
+  PlusStatus Read(std::vector<unsigned char>& data, double timeoutSec, unsigned int* numberOfLostMessages = NULL);
+
+protected:
+  struct RingHeader;
+
+  /*! Wait until a message is written after the current read position or the deadline (system time) is reached */
+  void WaitForMessage(double deadline);
+
+  /*! Returns true if the data at the specified position may have been overwritten by the writer */
+  bool IsOverwritten(uint64_t offset) const;
+
+  std::string Name;
+  bool Owner;
+  int FileDescriptor;
+  void* Memory;
+  size_t MemorySize;
+  RingHeader* Header;
+  unsigned char* Data;
+
+  /*! Position of the next message to read, counted from the creation of the ring */
+  uint64_t ReadOffset;
+
+  /*! Sequence number of the next message, if it is not lost */
+  uint64_t ExpectedSequenceNumber;
+
+private:
+  PlusIgtlSharedMemoryRing(const PlusIgtlSharedMemoryRing&);
+  void operator=(const PlusIgtlSharedMemoryRing&);
+};
+
+#endif
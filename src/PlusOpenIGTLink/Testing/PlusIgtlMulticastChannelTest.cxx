@@ -0,0 +1,236 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusIgtlMulticastChannelTest.cxx
+  \brief Test sending and receiving messages through PlusIgtlMulticastChannel
+
+  Messages are sent to a multicast group on the loopback interface and received by two receivers.
+  The test checks that all the messages are received in order by all receivers, that lost messages
+  are detected from the sequence numbers, that late messages are dropped, and that receivers
+  follow a restarted sender.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusIgtlMulticastChannel.h"
+#include "vtkPlusAccurateTimer.h"
+
+#include <vtksys/CommandLineArguments.hxx>
+
+namespace
+{
+  const double ReceiveTimeoutSec = 1.0;
+
+  //----------------------------------------------------------------------------
+  /*! Sender that allows simulating lost and reordered messages */
+  class TestMulticastSender : public PlusIgtlMulticastChannel
+  {
+  public:
+    void SetNextSequenceNumber(uint64_t sequenceNumber)
+    {
+      this->NextSequenceNumber = sequenceNumber;
+    }
+    uint64_t GetNextSequenceNumber() const
+    {
+      return this->NextSequenceNumber;
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  std::vector<unsigned char> CreateMessage(unsigned int messageIndex)
+  {
+    std::vector<unsigned char> message(20 + (messageIndex * 37) % 200);
+    for (size_t i = 0; i < message.size(); ++i)
+    {
+      message[i] = static_cast<unsigned char>((messageIndex * 31 + i) & 0xFF);
+    }
+    return message;
+  }
+
+  //----------------------------------------------------------------------------
+  bool SendMessage(PlusIgtlMulticastChannel& sender, unsigned int messageIndex)
+  {
+    std::vector<unsigned char> message = CreateMessage(messageIndex);
+    return sender.Send(&message[0], message.size()) == PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  bool ReceiveMessage(PlusIgtlMulticastChannel& receiver, unsigned int expectedMessageIndex, unsigned int expectedLostMessages)
+  {
+    std::vector<unsigned char> message;
+    unsigned int numberOfLostMessages = 0;
+    if (receiver.Receive(message, ReceiveTimeoutSec, &numberOfLostMessages) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Message " << expectedMessageIndex << " was not received");
+      return false;
+    }
+    if (message != CreateMessage(expectedMessageIndex))
+    {
+      LOG_ERROR("Received message content differs from message " << expectedMessageIndex);
+      return false;
+    }
+    if (numberOfLostMessages != expectedLostMessages)
+    {
+      LOG_ERROR("Message " << expectedMessageIndex << " reported " << numberOfLostMessages << " lost messages, expected " << expectedLostMessages);
+      return false;
+    }
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+  std::string groupAddress = "239.255.42.99";
+  int port = 18950;
+  std::string interfaceAddress = "127.0.0.1";
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--group-address", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &groupAddress, "Multicast group address (default: 239.255.42.99)");
+  args.AddArgument("--port", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &port, "Multicast port (default: 18950)");
+  args.AddArgument("--interface-address", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &interfaceAddress, "Network interface used for multicast (default: 127.0.0.1)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  PlusIgtlMulticastChannel receivers[2];
+  for (int receiverIndex = 0; receiverIndex < 2; ++receiverIndex)
+  {
+    if (receivers[receiverIndex].OpenReceiver(groupAddress, port, interfaceAddress) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to open multicast receiver " << receiverIndex);
+      return EXIT_FAILURE;
+    }
+  }
+  TestMulticastSender sender;
+  if (sender.OpenSender(groupAddress, port, 1, interfaceAddress, true) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to open multicast sender");
+    return EXIT_FAILURE;
+  }
+
+  int numberOfErrors = 0;
+
+  // Messages are received in order by all receivers
+  const unsigned int numberOfInitialMessages = 10;
+  for (unsigned int messageIndex = 0; messageIndex < numberOfInitialMessages; ++messageIndex)
+  {
+    if (!SendMessage(sender, messageIndex))
+    {
+      LOG_ERROR("Failed to send message " << messageIndex);
+      numberOfErrors++;
+    }
+  }
+  for (int receiverIndex = 0; receiverIndex < 2; ++receiverIndex)
+  {
+    for (unsigned int messageIndex = 0; messageIndex < numberOfInitialMessages; ++messageIndex)
+    {
+      if (!ReceiveMessage(receivers[receiverIndex], messageIndex, 0))
+      {
+        LOG_ERROR("Receiver " << receiverIndex << " failed to receive message " << messageIndex);
+        numberOfErrors++;
+      }
+    }
+  }
+
+  // Lost messages are detected from the gap in the sequence numbers
+  const unsigned int numberOfSkippedMessages = 5;
+  uint64_t sequenceNumberBeforeGap = sender.GetNextSequenceNumber();
+  sender.SetNextSequenceNumber(sequenceNumberBeforeGap + numberOfSkippedMessages);
+  SendMessage(sender, 100);
+  for (int receiverIndex = 0; receiverIndex < 2; ++receiverIndex)
+  {
+    if (!ReceiveMessage(receivers[receiverIndex], 100, numberOfSkippedMessages))
+    {
+      LOG_ERROR("Receiver " << receiverIndex << " failed to detect lost messages");
+      numberOfErrors++;
+    }
+  }
+
+  // A message that arrives after a newer message is dropped
+  uint64_t sequenceNumberAfterGap = sender.GetNextSequenceNumber();
+  sender.SetNextSequenceNumber(sequenceNumberBeforeGap);
+  SendMessage(sender, 200);
+  sender.SetNextSequenceNumber(sequenceNumberAfterGap);
+  SendMessage(sender, 201);
+  for (int receiverIndex = 0; receiverIndex < 2; ++receiverIndex)
+  {
+    if (!ReceiveMessage(receivers[receiverIndex], 201, 0))
+    {
+      LOG_ERROR("Receiver " << receiverIndex << " did not drop the late message");
+      numberOfErrors++;
+    }
+    if (receivers[receiverIndex].GetNumberOfDroppedMessages() != 1 || receivers[receiverIndex].GetNumberOfLostMessages() != numberOfSkippedMessages)
+    {
+      LOG_ERROR("Receiver " << receiverIndex << " statistics are incorrect: " << receivers[receiverIndex].GetNumberOfDroppedMessages() << " dropped (expected 1), "
+                << receivers[receiverIndex].GetNumberOfLostMessages() << " lost (expected " << numberOfSkippedMessages << ")");
+      numberOfErrors++;
+    }
+  }
+
+  // Receive times out if no message is sent
+  const double timeoutSec = 0.1;
+  std::vector<unsigned char> message;
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  if (receivers[0].Receive(message, timeoutSec) == PLUS_SUCCESS)
+  {
+    LOG_ERROR("Message received when no message was sent");
+    numberOfErrors++;
+  }
+  double elapsedTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+  if (elapsedTimeSec < timeoutSec * 0.9 || elapsedTimeSec > timeoutSec + 0.5)
+  {
+    LOG_ERROR("Receive timed out after " << elapsedTimeSec << " sec, expected " << timeoutSec << " sec");
+    numberOfErrors++;
+  }
+
+  // Receivers follow a restarted sender, even though its sequence numbers start from the beginning
+  sender.Close();
+  if (sender.OpenSender(groupAddress, port, 1, interfaceAddress, true) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to reopen multicast sender");
+    return EXIT_FAILURE;
+  }
+  SendMessage(sender, 300);
+  for (int receiverIndex = 0; receiverIndex < 2; ++receiverIndex)
+  {
+    if (!ReceiveMessage(receivers[receiverIndex], 300, 0))
+    {
+      LOG_ERROR("Receiver " << receiverIndex << " failed to receive message from the restarted sender");
+      numberOfErrors++;
+    }
+  }
+
+  sender.Close();
+  receivers[0].Close();
+  receivers[1].Close();
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed with " << numberOfErrors << " errors");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusIgtlSharedMemoryRingTest.cxx
+  \brief Test writing and reading messages through PlusIgtlSharedMemoryRing
+
+  Messages are written into a small ring and read by two readers. The test checks that
+  all the messages are received in order by readers that keep up with the writer, that
+  a reader that falls behind skips to the latest message and detects the lost messages,
+  and that a waiting reader is woken up as soon as a message is written.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusIgtlSharedMemoryRing.h"
+#include "vtkPlusAccurateTimer.h"
+
+#include <vtkMultiThreader.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <sstream>
+#include <unistd.h>
+
+namespace
+{
+  const size_t RingCapacityBytes = 4096;
+  const double WriteDelaySec = 0.2;
+
+  //----------------------------------------------------------------------------
+  std::vector<unsigned char> CreateMessage(unsigned int messageIndex, size_t size)
+  {
+    std::vector<unsigned char> message(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+      message[i] = static_cast<unsigned char>((messageIndex * 31 + i) & 0xFF);
+    }
+    return message;
+  }
+
+  //----------------------------------------------------------------------------
+  size_t GetMessageSize(unsigned int messageIndex)
+  {
+    return 16 + (messageIndex * 37) % 300;
+  }
+
+  //----------------------------------------------------------------------------
+  void* DelayedWriterThread(vtkMultiThreader::ThreadInfo* data)
+  {
+    PlusIgtlSharedMemoryRing* writer = static_cast<PlusIgtlSharedMemoryRing*>(data->UserData);
+    vtkPlusAccurateTimer::Delay(WriteDelaySec);
+    std::vector<unsigned char> message = CreateMessage(1000, GetMessageSize(1000));
+    writer->Write(&message[0], message.size());
+    return NULL;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  std::ostringstream ringName;
+  ringName << "/PlusIgtlSharedMemoryRingTest_" << getpid();
+
+  PlusIgtlSharedMemoryRing writer;
+  if (writer.Create(ringName.str(), RingCapacityBytes) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to create shared memory ring");
+    return EXIT_FAILURE;
+  }
+  PlusIgtlSharedMemoryRing fastReader;
+  PlusIgtlSharedMemoryRing slowReader;
+  if (fastReader.Open(ringName.str()) != PLUS_SUCCESS || slowReader.Open(ringName.str()) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to open shared memory ring for reading");
+    return EXIT_FAILURE;
+  }
+
+  int numberOfErrors = 0;
+  std::vector<unsigned char> message;
+  unsigned int numberOfLostMessages = 0;
+
+  // Messages are received in order by all readers
+  const unsigned int numberOfInitialMessages = 5;
+  for (unsigned int messageIndex = 0; messageIndex < numberOfInitialMessages; ++messageIndex)
+  {
+    std::vector<unsigned char> writtenMessage = CreateMessage(messageIndex, GetMessageSize(messageIndex));
+    writer.Write(&writtenMessage[0], writtenMessage.size());
+  }
+  for (unsigned int messageIndex = 0; messageIndex < numberOfInitialMessages; ++messageIndex)
+  {
+    PlusIgtlSharedMemoryRing* readers[2] = { &fastReader, &slowReader };
+    for (int readerIndex = 0; readerIndex < 2; ++readerIndex)
+    {
+      if (readers[readerIndex]->Read(message, 0, &numberOfLostMessages) != PLUS_SUCCESS
+          || message != CreateMessage(messageIndex, GetMessageSize(messageIndex)) || numberOfLostMessages != 0)
+      {
+        LOG_ERROR("Reader " << readerIndex << " failed to receive message " << messageIndex);
+        numberOfErrors++;
+      }
+    }
+  }
+
+  // The ring wraps around many times, the fast reader reads each message right after it is written
+  const unsigned int numberOfWrappingMessages = 200;
+  for (unsigned int messageIndex = numberOfInitialMessages; messageIndex < numberOfInitialMessages + numberOfWrappingMessages; ++messageIndex)
+  {
+    std::vector<unsigned char> writtenMessage = CreateMessage(messageIndex, GetMessageSize(messageIndex));
+    writer.Write(&writtenMessage[0], writtenMessage.size());
+    if (fastReader.Read(message, 0, &numberOfLostMessages) != PLUS_SUCCESS || message != writtenMessage || numberOfLostMessages != 0)
+    {
+      LOG_ERROR("Fast reader failed to receive message " << messageIndex);
+      numberOfErrors++;
+    }
+  }
+
+  // The slow reader was overtaken by the writer: it skips to the next message and reports the lost messages
+  unsigned int nextMessageIndex = numberOfInitialMessages + numberOfWrappingMessages;
+  std::vector<unsigned char> nextMessage = CreateMessage(nextMessageIndex, GetMessageSize(nextMessageIndex));
+  writer.Write(&nextMessage[0], nextMessage.size());
+  if (slowReader.Read(message, 0, &numberOfLostMessages) != PLUS_SUCCESS || message != nextMessage)
+  {
+    LOG_ERROR("Slow reader failed to receive the next message after it was overtaken by the writer");
+    numberOfErrors++;
+  }
+  else if (numberOfLostMessages != numberOfWrappingMessages)
+  {
+    LOG_ERROR("Slow reader reported " << numberOfLostMessages << " lost messages, expected " << numberOfWrappingMessages);
+    numberOfErrors++;
+  }
+  if (fastReader.Read(message, 0) != PLUS_SUCCESS || message != nextMessage)
+  {
+    LOG_ERROR("Fast reader failed to receive message " << nextMessageIndex);
+    numberOfErrors++;
+  }
+
+  // Read times out if no message is written
+  const double timeoutSec = 0.1;
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  if (fastReader.Read(message, timeoutSec) == PLUS_SUCCESS)
+  {
+    LOG_ERROR("Message received when no message was written");
+    numberOfErrors++;
+  }
+  double elapsedTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+  if (elapsedTimeSec < timeoutSec * 0.9 || elapsedTimeSec > timeoutSec + 0.5)
+  {
+    LOG_ERROR("Read timed out after " << elapsedTimeSec << " sec, expected " << timeoutSec << " sec");
+    numberOfErrors++;
+  }
+
+  // Waiting reader receives the message as soon as it is written
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  startTime = vtkPlusAccurateTimer::GetSystemTime();
+  int threadId = threader->SpawnThread((vtkThreadFunctionType)&DelayedWriterThread, &writer);
+  if (fastReader.Read(message, 5.0) != PLUS_SUCCESS || message != CreateMessage(1000, GetMessageSize(1000)))
+  {
+    LOG_ERROR("Failed to receive delayed message");
+    numberOfErrors++;
+  }
+  elapsedTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+  if (elapsedTimeSec < WriteDelaySec * 0.5 || elapsedTimeSec > WriteDelaySec + 0.5)
+  {
+    LOG_ERROR("Delayed message received after " << elapsedTimeSec << " sec, expected about " << WriteDelaySec << " sec");
+    numberOfErrors++;
+  }
+  threader->TerminateThread(threadId);
+
+  fastReader.Close();
+  slowReader.Close();
+  writer.Close();
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed with " << numberOfErrors << " errors");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
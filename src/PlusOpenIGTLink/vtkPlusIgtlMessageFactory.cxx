@@ -287,32 +287,8 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
     // Tracking data message
     else if (typeid(*igtlMessage) == typeid(igtl::TrackingDataMessage))
     {
-      if (clientInfo.TDATARequested && clientInfo.LastTDATASentTimeStamp + clientInfo.Resolution < trackedFrame.GetTimestamp())
-      {
-        std::map<std::string, vtkSmartPointer<vtkMatrix4x4> > transforms;
-        for (std::vector<PlusTransformName>::const_iterator transformNameIterator = clientInfo.TransformNames.begin(); transformNameIterator != clientInfo.TransformNames.end(); ++transformNameIterator)
-        {
-          PlusTransformName transformName = (*transformNameIterator);
-
-          bool isValid = false;
-          vtkSmartPointer<vtkMatrix4x4> mat = vtkSmartPointer<vtkMatrix4x4>::New();
-          transformRepository->GetTransform(transformName, mat, &isValid);
-
-          if (!isValid)
-          {
-            continue;
-          }
-
-          std::string transformNameStr;
-          transformName.GetTransformName(transformNameStr);
-
-          transforms[transformNameStr] = mat;
-        }
-
-        igtl::TrackingDataMessage::Pointer trackingDataMessage = dynamic_cast<igtl::TrackingDataMessage*>(igtlMessage->Clone().GetPointer());
-        vtkPlusIgtlMessageCommon::PackTrackingDataMessage(trackingDataMessage, transforms, trackedFrame.GetTimestamp());
-        igtlMessages.push_back(trackingDataMessage.GetPointer());
-      }
+      // TDATA is streamed from the tracker buffers at the resolution requested by the client, see PackTrackingDataMessage
+      continue;
     }
     // Position message
     else if (typeid(*igtlMessage) == typeid(igtl::PositionMessage))
@@ -418,3 +394,39 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(const PlusIgtlClientInfo& cli
   return (numberOfErrors == 0 ? PLUS_SUCCESS : PLUS_FAIL);
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusIgtlMessageFactory::PackTrackingDataMessage(const PlusIgtlClientInfo& clientInfo, vtkPlusTransformRepository* transformRepository, double timestamp, igtl::MessageBase::Pointer& igtlMessage)
+{
+  if (transformRepository == NULL)
+  {
+    LOG_ERROR("Failed to pack TDATA message - transform repository is NULL");
+    return PLUS_FAIL;
+  }
+
+  igtlMessage = this->CreateSendMessage("TDATA", clientInfo.ClientHeaderVersion);
+  igtl::TrackingDataMessage::Pointer trackingDataMessage = dynamic_cast<igtl::TrackingDataMessage*>(igtlMessage.GetPointer());
+  if (trackingDataMessage.IsNull())
+  {
+    LOG_ERROR("Failed to pack TDATA message - unable to create message instance");
+    return PLUS_FAIL;
+  }
+
+  std::map<std::string, vtkSmartPointer<vtkMatrix4x4> > transforms;
+  for (std::vector<PlusTransformName>::const_iterator transformNameIterator = clientInfo.TransformNames.begin(); transformNameIterator != clientInfo.TransformNames.end(); ++transformNameIterator)
+  {
+    bool isValid = false;
+    vtkSmartPointer<vtkMatrix4x4> mat = vtkSmartPointer<vtkMatrix4x4>::New();
+    transformRepository->GetTransform(*transformNameIterator, mat, &isValid);
+    if (!isValid)
+    {
+      continue;
+    }
+
+    std::string transformNameStr;
+    transformNameIterator->GetTransformName(transformNameStr);
+    transforms[transformNameStr] = mat;
+  }
+
+  return vtkPlusIgtlMessageCommon::PackTrackingDataMessage(trackingDataMessage, transforms, timestamp);
+}
+
@@ -86,6 +86,17 @@ public:
   PlusStatus PackMessages(const PlusIgtlClientInfo& clientInfo, std::vector<igtl::MessageBase::Pointer>& igtMessages, PlusTrackedFrame& trackedFrame, 
     bool packValidTransformsOnly, vtkPlusTransformRepository* transformRepository=NULL); 
 
+  /*!
+  Generate and pack a TDATA message that contains all the valid transforms requested by the client.
+  TDATA messages are not generated by PackMessages, as they are sent at the resolution requested by the client
+  in the STT_TDATA message, independently from the image frames.
+  \param clientInfo Specifies the header version and transform names to send to the client
+  \param transformRepository Transform repository used for computing the selected transforms
+  \param timestamp Timestamp of the tracking data (universal time)
+  \param igtlMessage Output TDATA message
+  */
+  PlusStatus PackTrackingDataMessage(const PlusIgtlClientInfo& clientInfo, vtkPlusTransformRepository* transformRepository, double timestamp, igtl::MessageBase::Pointer& igtlMessage);
+
 protected:
   vtkPlusIgtlMessageFactory();
   virtual ~vtkPlusIgtlMessageFactory();
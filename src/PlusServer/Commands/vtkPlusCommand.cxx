@@ -15,6 +15,12 @@
 const std::string vtkPlusCommand::DEVICE_NAME_COMMAND = "CMD";
 const std::string vtkPlusCommand::DEVICE_NAME_REPLY = "ACK";
 
+const std::string vtkPlusCommand::RESOURCE_ALL = "*";
+const std::string vtkPlusCommand::RESOURCE_DEVICE_COLLECTION = "DeviceCollection";
+const std::string vtkPlusCommand::RESOURCE_TRANSFORM_REPOSITORY = "TransformRepository";
+const std::string vtkPlusCommand::RESOURCE_CONFIGURATION = "Configuration";
+const std::string vtkPlusCommand::RESOURCE_FILE_SYSTEM = "FileSystem";
+
 //----------------------------------------------------------------------------
 vtkPlusCommand::vtkPlusCommand()
   : CommandProcessor(NULL)
@@ -83,6 +89,74 @@ void vtkPlusCommand::SetCommandProcessor(vtkPlusCommandProcessor* processor)
   this->CommandProcessor = processor;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusCommand::GetResourceAccess(ResourceAccessMap& resources)
+{
+  // The resources used by the command are not known, therefore it cannot run concurrently with any other command
+  resources.clear();
+  resources[RESOURCE_ALL] = RESOURCE_WRITE;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusCommand::IsResourceAccessConflicting(const ResourceAccessMap& resources1, const ResourceAccessMap& resources2)
+{
+  if (resources1.empty() || resources2.empty())
+  {
+    // a command that does not use any shared resource never conflicts
+    return false;
+  }
+  if (resources1.find(RESOURCE_ALL) != resources1.end() || resources2.find(RESOURCE_ALL) != resources2.end())
+  {
+    return true;
+  }
+  for (ResourceAccessMap::const_iterator resourceIt = resources1.begin(); resourceIt != resources1.end(); ++resourceIt)
+  {
+    ResourceAccessMap::const_iterator otherResourceIt = resources2.find(resourceIt->first);
+    if (otherResourceIt == resources2.end())
+    {
+      continue;
+    }
+    if (resourceIt->second == RESOURCE_WRITE || otherResourceIt->second == RESOURCE_WRITE)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkPlusCommand::GetDeviceResourceName(const std::string& deviceId)
+{
+  return std::string("Device:") + deviceId;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusCommand::AddResourceAccess(ResourceAccessMap& resources, const std::string& resourceName, ResourceAccessType accessType)
+{
+  ResourceAccessMap::iterator resourceIt = resources.find(resourceName);
+  if (resourceIt == resources.end())
+  {
+    resources[resourceName] = accessType;
+  }
+  else if (accessType == RESOURCE_WRITE)
+  {
+    resourceIt->second = RESOURCE_WRITE;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusCommand::AddDeviceResourceAccess(ResourceAccessMap& resources, const std::string& deviceId)
+{
+  if (deviceId.empty())
+  {
+    AddResourceAccess(resources, RESOURCE_DEVICE_COLLECTION, RESOURCE_WRITE);
+    return;
+  }
+  // Devices are accessed through the device collection, so commands that modify the collection have to wait
+  AddResourceAccess(resources, RESOURCE_DEVICE_COLLECTION, RESOURCE_READ);
+  AddResourceAccess(resources, GetDeviceResourceName(deviceId), RESOURCE_WRITE);
+}
+
 //----------------------------------------------------------------------------
 vtkPlusDataCollector* vtkPlusCommand::GetDataCollector()
 {
@@ -16,6 +16,8 @@ class vtkImageData;
 
 #include "vtkPlusCommandResponse.h"
 
+#include <map>
+
 /*!
   \class vtkPlusCommand
   \brief This is an abstract superclass for commands in the OpenIGTLink network interface for Plus.
@@ -31,6 +33,22 @@ public:
   static const std::string DEVICE_NAME_COMMAND;
   static const std::string DEVICE_NAME_REPLY;
 
+  /*! Shared resource names used for scheduling concurrent command execution */
+  static const std::string RESOURCE_ALL;
+  static const std::string RESOURCE_DEVICE_COLLECTION;
+  static const std::string RESOURCE_TRANSFORM_REPOSITORY;
+  static const std::string RESOURCE_CONFIGURATION;
+  static const std::string RESOURCE_FILE_SYSTEM;
+
+  /*! Type of access that a command needs to a shared resource */
+  enum ResourceAccessType
+  {
+    RESOURCE_READ,
+    RESOURCE_WRITE
+  };
+  /*! Map of resource names to the access type that is needed by the command */
+  typedef std::map<std::string, ResourceAccessType> ResourceAccessMap;
+
   virtual vtkPlusCommand* Clone() = 0;
 
   virtual void PrintSelf(ostream& os, vtkIndent indent);
@@ -64,6 +82,20 @@ public:
   /*! Returns the list of command names that this command can process */
   virtual void GetCommandNames(std::list<std::string>& cmdNames) = 0;
 
+  /*!
+    Get the shared resources that the command accesses during Execute. Called after ReadConfiguration.
+    Commands that access a common resource and at least one of them modifies it are executed in the order
+    they were received, all other commands may be executed concurrently.
+    By default a command requires exclusive access to all resources (RESOURCE_ALL).
+  */
+  virtual void GetResourceAccess(ResourceAccessMap& resources);
+
+  /*! Returns true if two commands with the specified resource access cannot be executed at the same time */
+  static bool IsResourceAccessConflicting(const ResourceAccessMap& resources1, const ResourceAccessMap& resources2);
+
+  /*! Returns the resource name of a device */
+  static std::string GetDeviceResourceName(const std::string& deviceId);
+
   vtkGetMacro(RespondWithCommandMessage, bool);
   vtkSetMacro(RespondWithCommandMessage, bool);
 
@@ -133,6 +165,15 @@ protected:
   /*! Check if the command name is in the list of command names */
   PlusStatus ValidateName();
 
+  /*! Add a resource to the access map. Write access is kept if the resource is already in the map. */
+  static void AddResourceAccess(ResourceAccessMap& resources, const std::string& resourceName, ResourceAccessType accessType);
+
+  /*!
+    Add access to a device. If the device ID is empty (the command finds the device itself) then
+    write access to the whole device collection is added.
+  */
+  static void AddDeviceResourceAccess(ResourceAccessMap& resources, const std::string& deviceId);
+
   /*! Helper method to add a command response to the response queue */
   void QueueCommandResponse(PlusStatus status, const std::string& message, const std::string& error = "", const std::map<std::string, std::string>* keyValuePairs = NULL);
 
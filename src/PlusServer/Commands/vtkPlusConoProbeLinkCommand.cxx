@@ -41,6 +41,13 @@ void vtkPlusConoProbeLinkCommand::GetCommandNames(std::list<std::string>& cmdNam
   cmdNames.push_back(SHOW_CMD);
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusConoProbeLinkCommand::GetResourceAccess(ResourceAccessMap& resources)
+{
+  resources.clear();
+  AddDeviceResourceAccess(resources, this->ConoProbeDeviceId);
+}
+
 //----------------------------------------------------------------------------
 std::string vtkPlusConoProbeLinkCommand::GetDescription(const std::string& commandName)
 {
@@ -47,6 +47,9 @@ public:
   /*! Get all the command names that this class can execute */
   virtual void GetCommandNames(std::list<std::string>& cmdNames);
 
+  /*! Get the shared resources that the command accesses */
+  virtual void GetResourceAccess(ResourceAccessMap& resources);
+
   /*! Gets the description for the specified command name. */
   virtual std::string GetDescription(const std::string& commandName);
 
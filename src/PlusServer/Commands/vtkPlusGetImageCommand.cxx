@@ -47,6 +47,22 @@ void vtkPlusGetImageCommand::GetCommandNames(std::list<std::string>& cmdNames)
   cmdNames.push_back(GET_IMAGE);
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusGetImageCommand::GetResourceAccess(ResourceAccessMap& resources)
+{
+  resources.clear();
+  if (PlusCommon::IsEqualInsensitive(this->Name, GET_IMAGE_META_DATA))
+  {
+    // Meta data is collected from all devices
+    AddResourceAccess(resources, RESOURCE_DEVICE_COLLECTION, RESOURCE_WRITE);
+    return;
+  }
+  // Image ID is the device ID and the image ID within the device, separated by a dash
+  std::string imageIdStr(this->GetImageId());
+  size_t dashFound = imageIdStr.find_last_of(DeviceNameImageIdSeparator);
+  AddDeviceResourceAccess(resources, dashFound != std::string::npos ? imageIdStr.substr(0, dashFound) : std::string(""));
+}
+
 //----------------------------------------------------------------------------
 std::string vtkPlusGetImageCommand::GetDescription(const std::string& commandName)
 {
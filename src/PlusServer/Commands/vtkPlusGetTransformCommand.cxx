@@ -41,6 +41,13 @@ void vtkPlusGetTransformCommand::GetCommandNames(std::list<std::string>& cmdName
   cmdNames.push_back(GET_TRANSFORM_CMD);
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusGetTransformCommand::GetResourceAccess(ResourceAccessMap& resources)
+{
+  resources.clear();
+  AddResourceAccess(resources, RESOURCE_TRANSFORM_REPOSITORY, RESOURCE_READ);
+}
+
 //----------------------------------------------------------------------------
 std::string vtkPlusGetTransformCommand::GetDescription(const std::string& commandName)
 {
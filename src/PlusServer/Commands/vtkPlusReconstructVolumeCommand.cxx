@@ -97,6 +97,15 @@ void vtkPlusReconstructVolumeCommand::GetCommandNames(std::list<std::string>& cm
   cmdNames.push_back(GET_LIVE_RECONSTRUCTION_SNAPSHOT_CMD);
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusReconstructVolumeCommand::GetResourceAccess(ResourceAccessMap& resources)
+{
+  resources.clear();
+  AddDeviceResourceAccess(resources, this->VolumeReconstructorDeviceId);
+  AddResourceAccess(resources, RESOURCE_TRANSFORM_REPOSITORY, RESOURCE_READ);
+  AddResourceAccess(resources, RESOURCE_FILE_SYSTEM, RESOURCE_WRITE);
+}
+
 //----------------------------------------------------------------------------
 std::string vtkPlusReconstructVolumeCommand::GetDescription(const std::string& commandName)
 {
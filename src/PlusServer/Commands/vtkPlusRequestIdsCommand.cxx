@@ -62,6 +62,13 @@ void vtkPlusRequestIdsCommand::GetCommandNames(std::list<std::string>& cmdNames)
   cmdNames.push_back(REQUEST_DEVICE_CHANNEL_IDS_CMD);
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusRequestIdsCommand::GetResourceAccess(ResourceAccessMap& resources)
+{
+  resources.clear();
+  AddResourceAccess(resources, RESOURCE_DEVICE_COLLECTION, RESOURCE_READ);
+}
+
 //----------------------------------------------------------------------------
 std::string vtkPlusRequestIdsCommand::GetDescription(const std::string& commandName)
 {
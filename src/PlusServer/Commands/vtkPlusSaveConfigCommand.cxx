@@ -43,6 +43,16 @@ void vtkPlusSaveConfigCommand::GetCommandNames(std::list<std::string>& cmdNames)
   cmdNames.push_back(SAVE_CONFIG_CMD);
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusSaveConfigCommand::GetResourceAccess(ResourceAccessMap& resources)
+{
+  resources.clear();
+  AddResourceAccess(resources, RESOURCE_DEVICE_COLLECTION, RESOURCE_READ);
+  AddResourceAccess(resources, RESOURCE_TRANSFORM_REPOSITORY, RESOURCE_READ);
+  AddResourceAccess(resources, RESOURCE_CONFIGURATION, RESOURCE_WRITE);
+  AddResourceAccess(resources, RESOURCE_FILE_SYSTEM, RESOURCE_WRITE);
+}
+
 //----------------------------------------------------------------------------
 std::string vtkPlusSaveConfigCommand::GetDescription(const std::string& commandName)
 {
@@ -42,6 +42,13 @@ void vtkPlusSendTextCommand::GetCommandNames(std::list<std::string>& cmdNames)
   cmdNames.push_back(SEND_TEXT_CMD);
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusSendTextCommand::GetResourceAccess(ResourceAccessMap& resources)
+{
+  resources.clear();
+  AddDeviceResourceAccess(resources, this->DeviceId);
+}
+
 //----------------------------------------------------------------------------
 std::string vtkPlusSendTextCommand::GetDescription(const std::string& commandName)
 {
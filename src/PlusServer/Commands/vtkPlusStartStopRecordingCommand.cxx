@@ -54,6 +54,15 @@ void vtkPlusStartStopRecordingCommand::GetCommandNames(std::list<std::string>& c
   cmdNames.push_back(STOP_CMD);
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusStartStopRecordingCommand::GetResourceAccess(ResourceAccessMap& resources)
+{
+  resources.clear();
+  // If the capture device is not specified then it may be created, which modifies the device collection
+  AddDeviceResourceAccess(resources, this->CaptureDeviceId);
+  AddResourceAccess(resources, RESOURCE_FILE_SYSTEM, RESOURCE_WRITE);
+}
+
 //----------------------------------------------------------------------------
 std::string vtkPlusStartStopRecordingCommand::GetDescription(const std::string& commandName)
 {
@@ -49,6 +49,15 @@ void vtkPlusStealthLinkCommand::GetCommandNames(std::list<std::string>& cmdNames
   cmdNames.push_back(GET_STEALTHLINK_EXAM_DATA_CMD);
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusStealthLinkCommand::GetResourceAccess(ResourceAccessMap& resources)
+{
+  resources.clear();
+  AddDeviceResourceAccess(resources, this->StealthLinkDeviceId);
+  AddResourceAccess(resources, RESOURCE_TRANSFORM_REPOSITORY, RESOURCE_READ);
+  AddResourceAccess(resources, RESOURCE_FILE_SYSTEM, RESOURCE_WRITE);
+}
+
 //----------------------------------------------------------------------------
 std::string vtkPlusStealthLinkCommand::GetDescription(const std::string& commandName)
 {
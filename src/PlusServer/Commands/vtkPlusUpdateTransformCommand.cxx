@@ -45,6 +45,13 @@ void vtkPlusUpdateTransformCommand::GetCommandNames(std::list<std::string>& cmdN
   cmdNames.push_back(UPDATE_TRANSFORM_CMD);
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusUpdateTransformCommand::GetResourceAccess(ResourceAccessMap& resources)
+{
+  resources.clear();
+  AddResourceAccess(resources, RESOURCE_TRANSFORM_REPOSITORY, RESOURCE_WRITE);
+}
+
 //----------------------------------------------------------------------------
 std::string vtkPlusUpdateTransformCommand::GetDescription(const std::string& commandName)
 {
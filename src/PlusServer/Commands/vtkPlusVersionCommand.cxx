@@ -42,6 +42,13 @@ void vtkPlusVersionCommand::GetCommandNames(std::list<std::string>& cmdNames)
   cmdNames.push_back(VERSION_CMD);
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusVersionCommand::GetResourceAccess(ResourceAccessMap& resources)
+{
+  // Does not use any shared resource
+  resources.clear();
+}
+
 //----------------------------------------------------------------------------
 std::string vtkPlusVersionCommand::GetDescription(const std::string& commandName)
 {
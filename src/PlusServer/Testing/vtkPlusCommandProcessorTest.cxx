@@ -0,0 +1,218 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusCommandProcessorTest.cxx
+  \brief Test concurrent command execution in vtkPlusCommandProcessor
+
+  Commands that access different resources must be executed concurrently, commands that
+  modify the same resource must be executed one after the other, in the order they were queued.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusCommand.h"
+#include "vtkPlusCommandProcessor.h"
+
+#include <vtkObjectFactory.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <map>
+
+namespace
+{
+  const std::string TEST_COMMAND_NAME = "TestDelay";
+
+  struct ExecutionTime
+  {
+    double Start;
+    double Stop;
+  };
+
+  std::map<std::string, ExecutionTime> ExecutionTimes;
+  vtkSmartPointer<vtkPlusRecursiveCriticalSection> ExecutionTimesMutex = vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New();
+}
+
+//----------------------------------------------------------------------------
+/*! Test command that holds a resource for a specified time */
+class vtkPlusTestDelayCommand : public vtkPlusCommand
+{
+public:
+  static vtkPlusTestDelayCommand* New();
+  vtkTypeMacro(vtkPlusTestDelayCommand, vtkPlusCommand);
+  virtual vtkPlusCommand* Clone() { return New(); }
+
+  virtual PlusStatus ReadConfiguration(vtkXMLDataElement* aConfig)
+  {
+    if (vtkPlusCommand::ReadConfiguration(aConfig) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    this->CommandId = aConfig->GetAttribute("CommandId") ? aConfig->GetAttribute("CommandId") : "";
+    this->Resource = aConfig->GetAttribute("Resource") ? aConfig->GetAttribute("Resource") : "";
+    aConfig->GetScalarAttribute("DelaySec", this->DelaySec);
+    return PLUS_SUCCESS;
+  }
+
+  virtual PlusStatus Execute()
+  {
+    double startTime = vtkPlusAccurateTimer::GetSystemTime();
+    vtkPlusAccurateTimer::Delay(this->DelaySec);
+    double stopTime = vtkPlusAccurateTimer::GetSystemTime();
+    {
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> executionTimesGuardedLock(ExecutionTimesMutex);
+      ExecutionTimes[this->CommandId].Start = startTime;
+      ExecutionTimes[this->CommandId].Stop = stopTime;
+    }
+    this->QueueCommandResponse(PLUS_SUCCESS, this->CommandId);
+    return PLUS_SUCCESS;
+  }
+
+  virtual void GetCommandNames(std::list<std::string>& cmdNames)
+  {
+    cmdNames.clear();
+    cmdNames.push_back(TEST_COMMAND_NAME);
+  }
+
+  virtual void GetResourceAccess(ResourceAccessMap& resources)
+  {
+    resources.clear();
+    if (!this->Resource.empty())
+    {
+      AddResourceAccess(resources, this->Resource, RESOURCE_WRITE);
+    }
+  }
+
+  virtual std::string GetDescription(const std::string& commandName)
+  {
+    return TEST_COMMAND_NAME + ": Wait for the specified time while holding a resource.";
+  }
+
+protected:
+  vtkPlusTestDelayCommand() : DelaySec(0) {}
+
+  std::string CommandId;
+  std::string Resource;
+  double DelaySec;
+};
+
+vtkStandardNewMacro(vtkPlusTestDelayCommand);
+
+//----------------------------------------------------------------------------
+PlusStatus QueueTestCommand(vtkPlusCommandProcessor* processor, const std::string& commandId, const std::string& resource, double delaySec)
+{
+  std::ostringstream commandStr;
+  commandStr << "<Command Name=\"" << TEST_COMMAND_NAME << "\" CommandId=\"" << commandId << "\" Resource=\"" << resource << "\" DelaySec=\"" << delaySec << "\" />";
+  static uint32_t uid = 0;
+  uid++;
+  return processor->QueueCommand(true, 1, TEST_COMMAND_NAME, commandStr.str(), std::string("CMD_") + commandId, uid);
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkPlusCommandProcessor> processor = vtkSmartPointer<vtkPlusCommandProcessor>::New();
+  processor->RegisterPlusCommand(vtkSmartPointer<vtkPlusTestDelayCommand>::New());
+  processor->SetNumberOfCommandExecutionThreads(4);
+  processor->Start();
+
+  // A1, A2, and A3 modify the same resource, B1 and the command without resource can run at any time
+  const int numberOfCommands = 5;
+  QueueTestCommand(processor, "A1", "A", 0.3);
+  QueueTestCommand(processor, "B1", "B", 0.3);
+  QueueTestCommand(processor, "A2", "A", 0.1);
+  QueueTestCommand(processor, "NoResource", "", 0.1);
+  QueueTestCommand(processor, "A3", "A", 0.1);
+
+  // Wait for all the responses
+  PlusCommandResponseList responses;
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  while (responses.size() < numberOfCommands && vtkPlusAccurateTimer::GetSystemTime() - startTime < 5.0)
+  {
+    processor->PopCommandResponses(responses);
+    vtkPlusAccurateTimer::Delay(0.01);
+  }
+  processor->Stop();
+
+  int numberOfErrors = 0;
+  if (responses.size() != numberOfCommands)
+  {
+    LOG_ERROR("Expected " << numberOfCommands << " command responses, received " << responses.size());
+    return EXIT_FAILURE;
+  }
+
+  // Commands that access different resources run concurrently
+  if (ExecutionTimes["B1"].Start >= ExecutionTimes["A1"].Stop)
+  {
+    LOG_ERROR("B1 was not executed concurrently with A1");
+    numberOfErrors++;
+  }
+  if (ExecutionTimes["NoResource"].Start >= ExecutionTimes["A1"].Stop)
+  {
+    LOG_ERROR("Command without resources was not executed concurrently with A1");
+    numberOfErrors++;
+  }
+
+  // Commands that modify the same resource run one after the other, in the queued order
+  if (ExecutionTimes["A2"].Start < ExecutionTimes["A1"].Stop)
+  {
+    LOG_ERROR("A2 was started before A1 was completed");
+    numberOfErrors++;
+  }
+  if (ExecutionTimes["A3"].Start < ExecutionTimes["A2"].Stop)
+  {
+    LOG_ERROR("A3 was started before A2 was completed");
+    numberOfErrors++;
+  }
+
+  // Resource conflict rules
+  vtkPlusCommand::ResourceAccessMap readTransforms;
+  readTransforms[vtkPlusCommand::RESOURCE_TRANSFORM_REPOSITORY] = vtkPlusCommand::RESOURCE_READ;
+  vtkPlusCommand::ResourceAccessMap writeTransforms;
+  writeTransforms[vtkPlusCommand::RESOURCE_TRANSFORM_REPOSITORY] = vtkPlusCommand::RESOURCE_WRITE;
+  vtkPlusCommand::ResourceAccessMap allResources;
+  allResources[vtkPlusCommand::RESOURCE_ALL] = vtkPlusCommand::RESOURCE_WRITE;
+  vtkPlusCommand::ResourceAccessMap noResources;
+  if (vtkPlusCommand::IsResourceAccessConflicting(readTransforms, readTransforms)
+      || !vtkPlusCommand::IsResourceAccessConflicting(readTransforms, writeTransforms)
+      || !vtkPlusCommand::IsResourceAccessConflicting(readTransforms, allResources)
+      || vtkPlusCommand::IsResourceAccessConflicting(noResources, allResources))
+  {
+    LOG_ERROR("Resource access conflict detection failed");
+    numberOfErrors++;
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed with " << numberOfErrors << " errors");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -29,6 +29,8 @@ See License.txt for details.
 #include "vtkPlusVersionCommand.h"
 #include "vtkXMLUtilities.h"
 
+#include <algorithm>
+
 vtkStandardNewMacro(vtkPlusCommandProcessor);
 
 //----------------------------------------------------------------------------
@@ -36,8 +38,9 @@ vtkPlusCommandProcessor::vtkPlusCommandProcessor()
   : PlusServer(NULL)
   , Threader(vtkSmartPointer<vtkMultiThreader>::New())
   , Mutex(vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New())
-  , CommandExecutionActive(std::make_pair(false, false))
-  , CommandExecutionThreadId(-1)
+  , CommandExecutionActive(false)
+  , NumberOfCommandExecutionThreads(4)
+  , NumberOfRunningCommandExecutionThreads(0)
 {
   // Register default commands
   RegisterPlusCommand(vtkSmartPointer<vtkPlusStartStopRecordingCommand>::New());
@@ -83,10 +86,29 @@ void vtkPlusCommandProcessor::PrintSelf(ostream& os, vtkIndent indent)
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusCommandProcessor::Start()
 {
-  if (this->CommandExecutionThreadId < 0)
+  if (this->CommandExecutionThreadIds.empty())
   {
-    this->CommandExecutionActive.first = true;
-    this->CommandExecutionThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&CommandExecutionThread, this);
+    this->CommandExecutionActive = true;
+    int numberOfThreads = std::max(this->NumberOfCommandExecutionThreads, 1);
+    for (int i = 0; i < numberOfThreads; ++i)
+    {
+      // Count the thread before it is spawned, so that Stop() waits for it even if it has not started running yet
+      this->NumberOfRunningCommandExecutionThreads++;
+      int threadId = this->Threader->SpawnThread((vtkThreadFunctionType)&CommandExecutionThread, this);
+      if (threadId < 0)
+      {
+        LOG_ERROR("Failed to start command execution thread");
+        this->NumberOfRunningCommandExecutionThreads--;
+        continue;
+      }
+      this->CommandExecutionThreadIds.push_back(threadId);
+    }
+    if (this->CommandExecutionThreadIds.empty())
+    {
+      this->CommandExecutionActive = false;
+      return PLUS_FAIL;
+    }
+    LOG_DEBUG("Started " << this->CommandExecutionThreadIds.size() << " command execution threads");
   }
   return PLUS_SUCCESS;
 }
@@ -94,19 +116,23 @@ PlusStatus vtkPlusCommandProcessor::Start()
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusCommandProcessor::Stop()
 {
-  // Stop the command execution thread
-  if (this->CommandExecutionThreadId >= 0)
+  // Stop the command execution threads
+  if (!this->CommandExecutionThreadIds.empty())
   {
-    this->CommandExecutionActive.first = false;
-    while (this->CommandExecutionActive.second)
     {
-      // Wait until the thread stops
+      std::lock_guard<std::mutex> queueLock(this->CommandQueueMutex);
+      this->CommandExecutionActive = false;
+    }
+    this->CommandQueueCondition.notify_all();
+    while (this->NumberOfRunningCommandExecutionThreads > 0)
+    {
+      // Wait until the threads stop
       vtkPlusAccurateTimer::Delay(0.2);
     }
-    this->CommandExecutionThreadId = -1;
+    this->CommandExecutionThreadIds.clear();
   }
 
-  LOG_DEBUG("Command execution thread stopped");
+  LOG_DEBUG("Command execution threads stopped");
 
   return PLUS_SUCCESS;
 }
@@ -116,27 +142,82 @@ void* vtkPlusCommandProcessor::CommandExecutionThread(vtkMultiThreader::ThreadIn
 {
   vtkPlusCommandProcessor* self = (vtkPlusCommandProcessor*)(data->UserData);
 
-  self->CommandExecutionActive.second = true;
+  std::unique_lock<std::mutex> queueLock(self->CommandQueueMutex);
 
   // Execute commands until a stop is requested
-  while (self->CommandExecutionActive.first)
+  while (self->CommandExecutionActive)
   {
-    self->ExecuteCommands();
-    // no commands in the queue, wait a bit before checking again
-    const double commandQueuePollIntervalSec = 0.010;
-#ifdef _WIN32
-    Sleep(commandQueuePollIntervalSec * 1000);
-#else
-    usleep(commandQueuePollIntervalSec * 1000000);
-#endif
+    QueuedCommandList::iterator queuedCommandIt = self->GetNextExecutableCommand();
+    if (queuedCommandIt == self->CommandQueue.end())
+    {
+      // No command can be executed now, wait until a command is queued or completed
+      self->CommandQueueCondition.wait(queueLock);
+      continue;
+    }
+
+    // Reserve the resources of the command while it is executed
+    vtkSmartPointer<vtkPlusCommand> cmd = queuedCommandIt->Command;
+    std::list<vtkPlusCommand::ResourceAccessMap>::iterator resourcesIt =
+      self->ExecutingCommandResources.insert(self->ExecutingCommandResources.end(), queuedCommandIt->Resources);
+    self->CommandQueue.erase(queuedCommandIt);
+
+    queueLock.unlock();
+    self->ExecuteCommand(cmd);
+    queueLock.lock();
+
+    // Commands that were waiting for the resources may be executed now
+    self->ExecutingCommandResources.erase(resourcesIt);
+    self->CommandQueueCondition.notify_all();
   }
 
   // Close thread
-  self->CommandExecutionThreadId = -1;
-  self->CommandExecutionActive.second = false;
+  self->NumberOfRunningCommandExecutionThreads--;
   return NULL;
 }
 
+//----------------------------------------------------------------------------
+vtkPlusCommandProcessor::QueuedCommandList::iterator vtkPlusCommandProcessor::GetNextExecutableCommand()
+{
+  for (QueuedCommandList::iterator queuedCommandIt = this->CommandQueue.begin(); queuedCommandIt != this->CommandQueue.end(); ++queuedCommandIt)
+  {
+    bool conflicting = false;
+    for (std::list<vtkPlusCommand::ResourceAccessMap>::iterator resourcesIt = this->ExecutingCommandResources.begin();
+         resourcesIt != this->ExecutingCommandResources.end() && !conflicting; ++resourcesIt)
+    {
+      conflicting = vtkPlusCommand::IsResourceAccessConflicting(queuedCommandIt->Resources, *resourcesIt);
+    }
+    // Conflicting commands must be executed in the order they were queued
+    for (QueuedCommandList::iterator previousCommandIt = this->CommandQueue.begin(); previousCommandIt != queuedCommandIt && !conflicting; ++previousCommandIt)
+    {
+      conflicting = vtkPlusCommand::IsResourceAccessConflicting(queuedCommandIt->Resources, previousCommandIt->Resources);
+    }
+    if (!conflicting)
+    {
+      return queuedCommandIt;
+    }
+  }
+  return this->CommandQueue.end();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusCommandProcessor::ExecuteCommand(vtkPlusCommand* cmd)
+{
+  LOG_DEBUG("Executing command");
+  if (cmd->Execute() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Command execution failed");
+  }
+
+  // move the response objects from the command to the processor's queue
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
+    cmd->PopCommandResponses(this->CommandResponseQueue);
+  }
+
+  // Send the responses right away instead of waiting for the server's data sender thread
+  this->SendQueuedCommandResponses();
+}
+
 //----------------------------------------------------------------------------
 int vtkPlusCommandProcessor::ExecuteCommands()
 {
@@ -145,27 +226,26 @@ int vtkPlusCommandProcessor::ExecuteCommands()
   while (1)
   {
     vtkSmartPointer<vtkPlusCommand> cmd; // next command to be processed
+    std::list<vtkPlusCommand::ResourceAccessMap>::iterator resourcesIt;
     {
-      PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
-      if (this->CommandQueue.empty())
+      std::lock_guard<std::mutex> queueLock(this->CommandQueueMutex);
+      QueuedCommandList::iterator queuedCommandIt = this->GetNextExecutableCommand();
+      if (queuedCommandIt == this->CommandQueue.end())
       {
         return numberOfExecutedCommands;
       }
-      cmd = this->CommandQueue.front();
-      this->CommandQueue.pop_front();
+      cmd = queuedCommandIt->Command;
+      resourcesIt = this->ExecutingCommandResources.insert(this->ExecutingCommandResources.end(), queuedCommandIt->Resources);
+      this->CommandQueue.erase(queuedCommandIt);
     }
 
-    LOG_DEBUG("Executing command");
-    if (cmd->Execute() != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Command execution failed");
-    }
+    this->ExecuteCommand(cmd);
 
-    // move the response objects from the command to the processor's queue
     {
-      PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
-      cmd->PopCommandResponses(this->CommandResponseQueue);
+      std::lock_guard<std::mutex> queueLock(this->CommandQueueMutex);
+      this->ExecutingCommandResources.erase(resourcesIt);
     }
+    this->CommandQueueCondition.notify_all();
 
     numberOfExecutedCommands++;
   }
@@ -268,9 +348,16 @@ PlusStatus vtkPlusCommandProcessor::QueueCommand(bool respondUsingIGTLCommand, u
   cmd->SetId(uid);
   cmd->SetRespondWithCommandMessage(respondUsingIGTLCommand);
 
+  QueuedCommand queuedCommand;
+  queuedCommand.Command = cmd;
+  cmd->GetResourceAccess(queuedCommand.Resources);
+
   // Add command to the execution queue
-  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
-  this->CommandQueue.push_back(cmd);
+  {
+    std::lock_guard<std::mutex> queueLock(this->CommandQueueMutex);
+    this->CommandQueue.push_back(queuedCommand);
+  }
+  this->CommandQueueCondition.notify_one();
 
   return PLUS_SUCCESS;
 }
@@ -293,8 +380,11 @@ PlusStatus vtkPlusCommandProcessor::QueueStringResponse(const PlusStatus& status
   response->SetStatus(status);
 
   // Add response to the command response queue
-  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
-  this->CommandResponseQueue.push_back(response);
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
+    this->CommandResponseQueue.push_back(response);
+  }
+  this->SendQueuedCommandResponses();
 
   return PLUS_SUCCESS;
 }
@@ -315,8 +405,11 @@ PlusStatus vtkPlusCommandProcessor::QueueCommandResponse(const PlusStatus& statu
   response->SetStatus(PLUS_FAIL);
 
   // Add response to the command response queue
-  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
-  this->CommandResponseQueue.push_back(response);
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
+    this->CommandResponseQueue.push_back(response);
+  }
+  this->SendQueuedCommandResponses();
 
   return PLUS_SUCCESS;
 }
@@ -331,9 +424,21 @@ void vtkPlusCommandProcessor::PopCommandResponses(PlusCommandResponseList& respo
   responses.splice(responses.end(), this->CommandResponseQueue, this->CommandResponseQueue.begin(), this->CommandResponseQueue.end());
 }
 
+//------------------------------------------------------------------------------
+void vtkPlusCommandProcessor::SendQueuedCommandResponses()
+{
+  if (this->PlusServer == NULL)
+  {
+    // Responses are retrieved by calling PopCommandResponses
+    return;
+  }
+  this->PlusServer->SendQueuedCommandResponses();
+}
+
 //------------------------------------------------------------------------------
 bool vtkPlusCommandProcessor::IsRunning()
 {
-  return this->CommandExecutionActive.second;
+  // Also report running between Start() and the actual start of the thread, so that callers do not execute commands concurrently
+  return this->CommandExecutionActive || this->NumberOfRunningCommandExecutionThreads > 0;
 }
 
@@ -14,7 +14,11 @@
 #include "vtkPlusCommand.h"
 #include "vtkPlusCommandResponse.h"
 #include "vtkPlusOpenIGTLinkServer.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <vector>
 
 class vtkImageData;
 class vtkMatrix4x4;
@@ -23,7 +27,10 @@ class vtkMatrix4x4;
   \class vtkPlusCommandProcessor 
   \brief Creates a PlusCommand from a string.
   If the commands are to be executed on the main thread then call ExecuteCommands() periodically from the main thread.
-  If the commands are to be executed on a separate thread (to allow background processing, but maybe requiring more synchronization) call Start() to start an internal processing thread. 
+  If the commands are to be executed on separate threads (to allow background processing, but maybe requiring more synchronization) call Start() to start internal processing threads. 
+  The processing threads sleep until a command is queued, and the command responses are sent to the clients as soon as the command is executed.
+  Commands are executed concurrently by the processing threads, except commands that access the same resource (see vtkPlusCommand::GetResourceAccess)
+  and at least one of them modifies it: these are executed one after the other, in the order they were queued.
   Probably one of the processing models would be enough, but at this point it's not clear which one is better.
   TODO: keep only one method and remove the other approach completely once the processing model decision is finalized.
   \ingroup PlusLibPlusServer
@@ -41,15 +48,19 @@ public:
   */
   int ExecuteCommands();
 
-  /*! Start thread for processing the commands in the queue. Must be called from the main thread. */
+  /*! Start threads for processing the commands in the queue. Must be called from the main thread. */
   virtual PlusStatus Start();
 
   /*! Stop command processing. Must be called from the main thread. */
   virtual PlusStatus Stop();
 
-  /*! Returns true if the command processing thread is running. Can be called from any thread. */
+  /*! Returns true if the command processing threads are running. Can be called from any thread. */
   virtual bool IsRunning();
 
+  /*! Set the number of threads that execute commands concurrently. Must be set before Start() is called. */
+  vtkSetMacro(NumberOfCommandExecutionThreads, int);
+  vtkGetMacro(NumberOfCommandExecutionThreads, int);
+
   /*!
     Register custom command. Must be called from the main thread.
     \param cmd It should point to a valid vtkPlusCommand instance. The caller can delete the cmd object after the call.
@@ -84,9 +95,15 @@ public:
 protected:
   vtkPlusCommand* CreatePlusCommand(const std::string& commandName, const std::string &commandStr);
 
-  /*! Thread for client connection handling */ 
+  /*! Thread for executing commands from the queue */ 
   static void* CommandExecutionThread( vtkMultiThreader::ThreadInfo* data );
 
+  /*! Execute a command and send its responses */
+  void ExecuteCommand(vtkPlusCommand* cmd);
+
+  /*! Send the queued responses to the clients if the command processor is attached to a server */
+  void SendQueuedCommandResponses();
+
   vtkPlusCommandProcessor();
   virtual ~vtkPlusCommandProcessor();
 
@@ -100,23 +117,45 @@ private:
   /*! Mutex instance for safe data access */ 
   vtkSmartPointer<vtkPlusRecursiveCriticalSection> Mutex;
 
-  // Active flag for threads (first: request, second: respond )
-  std::pair<bool,bool> CommandExecutionActive;
+  /*! Command execution threads are requested to run */
+  std::atomic<bool> CommandExecutionActive;
+
+  // Thread identifiers
+  std::vector<int> CommandExecutionThreadIds;
 
-  // Thread identifier
-  int  CommandExecutionThreadId;
+  /*! Number of threads that execute commands concurrently */
+  int NumberOfCommandExecutionThreads;
+
+  /*! Number of command execution threads that have been started and have not exited yet */
+  std::atomic<int> NumberOfRunningCommandExecutionThreads;
 
   /*! Map command names and the New() static methods of vtkPlusCommand classes */ 
   std::map<std::string,vtkPlusCommand*> RegisteredCommands; 
 
-  /*! 
-    This queue contains all the active commands. 
-    After a command's execute method is called it may still remain active (remain in the queue),
-    until it signals that it is completed.
-  */	
-  //std::list<vtkPlusCommand*> CommandQueue;
-  typedef std::list< vtkSmartPointer<vtkPlusCommand> > PlusCommandList;
-  PlusCommandList CommandQueue;
+  /*! Command waiting for execution and the resources that it accesses */
+  struct QueuedCommand
+  {
+    vtkSmartPointer<vtkPlusCommand> Command;
+    vtkPlusCommand::ResourceAccessMap Resources;
+  };
+  typedef std::list<QueuedCommand> QueuedCommandList;
+
+  /*!
+    Returns the first command in the queue that can be executed now: it does not conflict with any
+    command that is being executed or any command that was queued earlier. CommandQueueMutex must be locked.
+  */
+  QueuedCommandList::iterator GetNextExecutableCommand();
+
+  /*! This queue contains all the commands that are waiting for execution, in the order they were received. */
+  QueuedCommandList CommandQueue;
+
+  /*! Resources accessed by the commands that are being executed */
+  std::list<vtkPlusCommand::ResourceAccessMap> ExecutingCommandResources;
+
+  /*! Protects the command queue and the executing command list. Signaled when a command is queued or completed. */
+  std::mutex CommandQueueMutex;
+  std::condition_variable CommandQueueCondition;
+
   PlusCommandResponseList CommandResponseQueue;
 
   vtkPlusCommandProcessor(const vtkPlusCommandProcessor&);  // Not implemented.
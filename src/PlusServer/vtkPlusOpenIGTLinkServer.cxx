@@ -25,6 +25,7 @@ See License.txt for details.
 #include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkPolyDataReader.h>
+#include <vtksys/SystemTools.hxx>
 
 // OpenIGTLink includes
 #include <igtlCommandMessage.h>
@@ -40,6 +41,9 @@ See License.txt for details.
 // OpenIGTLinkIO includes
 #include <igtlioPolyDataConverter.h>
 
+// STL includes
+#include <algorithm>
+
 #if defined(WIN32)
   #include "vtkPlusOpenIGTLinkServerWin32.cxx"
 #elif defined(__APPLE__)
@@ -50,6 +54,8 @@ See License.txt for details.
 
 static const double DELAY_ON_SENDING_ERROR_SEC = 0.02;
 static const double DELAY_ON_NO_NEW_FRAMES_SEC = 0.005;
+static const double DELAY_ON_NO_NEW_TRACKING_DATA_SEC = 0.0005;
+static const double TRACKING_TRANSFORM_REPOSITORY_UPDATE_PERIOD_SEC = 1.0;
 static const int NUMBER_OF_RECENT_COMMAND_IDS_STORED = 10;
 static const int IGTL_EMPTY_DATA_SIZE = -1;
 
@@ -78,8 +84,10 @@ vtkPlusOpenIGTLinkServer::vtkPlusOpenIGTLinkServer()
   , MaxNumberOfIgtlMessagesToSend(100)
   , ConnectionActive(std::make_pair(false, false))
   , DataSenderActive(std::make_pair(false, false))
+  , TrackingDataSenderActive(std::make_pair(false, false))
   , ConnectionReceiverThreadId(-1)
   , DataSenderThreadId(-1)
+  , TrackingDataSenderThreadId(-1)
   , IgtlMessageFactory(vtkSmartPointer<vtkPlusIgtlMessageFactory>::New())
   , IgtlClientsMutex(vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New())
   , LastSentTrackedFrameTimestamp(0)
@@ -89,8 +97,21 @@ vtkPlusOpenIGTLinkServer::vtkPlusOpenIGTLinkServer()
   , DefaultClientSendTimeoutSec(CLIENT_SOCKET_TIMEOUT_SEC)
   , DefaultClientReceiveTimeoutSec(CLIENT_SOCKET_TIMEOUT_SEC)
   , IgtlMessageCrcCheckEnabled(0)
+  , CommandExecutionThreadEnabled(false)
+  , CommandResponseSendMutex(vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New())
   , PlusCommandProcessor(vtkSmartPointer<vtkPlusCommandProcessor>::New())
   , MessageResponseQueueMutex(vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New())
+  , PolyDataCacheSizeBytes(0)
+  , MaxPolyDataCacheSizeMb(256.0)
+  , PolyDataCacheMutex(vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New())
+  , SharedMemoryTransportEnabled(false)
+  , SharedMemoryBufferSizeMb(128.0)
+  , MulticastPort(-1)
+  , MulticastTimeToLive(1)
+  , MulticastResolutionMs(0)
+  , MulticastLastSentTimestamp(-1)
+  , PolyDataLoaderActive(std::make_pair(false, false))
+  , PolyDataLoaderThreadId(-1)
   , BroadcastChannel(NULL)
   , LogWarningOnNoDataAvailable(true)
   , KeepAliveIntervalSec(CLIENT_SOCKET_TIMEOUT_SEC / 2.0)
@@ -165,12 +186,55 @@ PlusStatus vtkPlusOpenIGTLinkServer::StartOpenIGTLinkService()
     this->DataSenderThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&DataSenderThread, this);
   }
 
+  if (!this->MulticastGroupAddress.empty() && !this->MulticastChannel.IsOpen())
+  {
+    // The multicast channel must be open before the tracking data sender thread starts
+    int multicastPort = (this->MulticastPort < 0 ? this->ListeningPort : this->MulticastPort);
+    if (this->MulticastChannel.OpenSender(this->MulticastGroupAddress, multicastPort, this->MulticastTimeToLive, this->MulticastInterfaceAddress) != PLUS_SUCCESS)
+    {
+      LOG_WARNING("Failed to open multicast channel, tracking data is only sent through the network connection of each client");
+    }
+    else
+    {
+      LOG_INFO("Tracking data is sent to multicast group " << this->MulticastGroupAddress << ":" << multicastPort);
+    }
+    this->MulticastLastSentTimestamp = -1;
+  }
+
+  if (this->TrackingDataSenderThreadId < 0)
+  {
+    this->TrackingDataSenderActive.first = true;
+    this->TrackingDataSenderThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&TrackingDataSenderThread, this);
+  }
+
+  if (this->PolyDataLoaderThreadId < 0)
+  {
+    this->PolyDataLoaderActive.first = true;
+    this->PolyDataLoaderThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&PolyDataLoaderThread, this);
+  }
+
+  if (this->SharedMemoryTransportEnabled)
+  {
+    if (PlusIgtlSharedMemoryRing::IsSupported())
+    {
+      LOG_INFO("Shared memory transport is available for local clients");
+    }
+    else
+    {
+      LOG_WARNING("Shared memory transport is not supported on this platform, all data is sent through the network");
+    }
+  }
+
   std::ostringstream ss;
   ss << "Data sent by default: ";
   this->DefaultClientInfo.PrintSelf(ss, vtkIndent(0));
   LOG_DEBUG(ss.str());
 
   this->PlusCommandProcessor->SetPlusServer(this);
+  if (this->CommandExecutionThreadEnabled)
+  {
+    this->PlusCommandProcessor->Start();
+  }
 
   this->BroadcastStartTime = vtkPlusAccurateTimer::GetSystemTime();
 
@@ -193,6 +257,45 @@ PlusStatus vtkPlusOpenIGTLinkServer::StopOpenIGTLinkService()
     LOG_DEBUG("ConnectionReceiverThread stopped");
   }
 
+  // Stop tracking data sender thread
+  if (this->TrackingDataSenderThreadId >= 0)
+  {
+    this->TrackingDataSenderActive.first = false;
+    while (this->TrackingDataSenderActive.second)
+    {
+      // Wait until the thread stops
+      vtkPlusAccurateTimer::DelayWithEventProcessing(0.01);
+    }
+    this->TrackingDataSenderThreadId = -1;
+    LOG_DEBUG("TrackingDataSenderThread stopped");
+  }
+  this->MulticastChannel.Close();
+
+  // Stop model loader thread
+  if (this->PolyDataLoaderThreadId >= 0)
+  {
+    {
+      std::lock_guard<std::mutex> requestQueueLock(this->PolyDataRequestQueueMutex);
+      this->PolyDataLoaderActive.first = false;
+      this->PolyDataRequestQueue.clear();
+    }
+    this->PolyDataRequestQueueCondition.notify_all();
+    while (this->PolyDataLoaderActive.second)
+    {
+      // Wait until the thread stops
+      vtkPlusAccurateTimer::DelayWithEventProcessing(0.01);
+    }
+    this->PolyDataLoaderThreadId = -1;
+    LOG_DEBUG("PolyDataLoaderThread stopped");
+  }
+  this->ClearPolyDataCache();
+
+  // Stop command execution thread
+  if (this->PlusCommandProcessor->IsRunning())
+  {
+    this->PlusCommandProcessor->Stop();
+  }
+
   // Disconnect clients (stop receiving thread, close socket)
   std::vector< int > clientIds;
   {
@@ -491,6 +594,9 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendMessageResponses(vtkPlusOpenIGTLinkServ
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusOpenIGTLinkServer::SendCommandResponses(vtkPlusOpenIGTLinkServer& self)
 {
+  // Responses may be sent from the data sender and the command execution thread,
+  // hold the lock while sending so that responses are not reordered.
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> commandResponseSendMutexGuardedLock(self.CommandResponseSendMutex);
   PlusCommandResponseList replies;
   self.PlusCommandProcessor->PopCommandResponses(replies);
   if (!replies.empty())
@@ -587,6 +693,44 @@ void* vtkPlusOpenIGTLinkServer::DataReceiverThread(vtkMultiThreader::ThreadInfo*
         PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(self->IgtlClientsMutex);
         client->ClientInfo = clientInfoMsg->GetClientInfo();
         LOG_DEBUG("Client info message received from client " << clientId);
+
+        std::string sharedMemoryTransportRequested;
+        if (clientInfoMsg->GetHeaderVersion() > IGTL_HEADER_VERSION_1
+            && clientInfoMsg->GetMetaDataElement(PlusIgtlSharedMemoryRing::TRANSPORT_NAME, sharedMemoryTransportRequested)
+            && STRCASECMP(sharedMemoryTransportRequested.c_str(), "TRUE") == 0)
+        {
+          // Each client has its own ring, because the messages are packed differently for each client.
+          // A ring that the client has already attached to is kept.
+          if (client->SharedMemoryRing == NULL && self->SharedMemoryTransportEnabled && PlusIgtlSharedMemoryRing::IsSupported())
+          {
+            std::ostringstream ringName;
+            ringName << "/PlusServer_" << self->ListeningPort << "_" << clientId;
+            std::shared_ptr<PlusIgtlSharedMemoryRing> ring = std::make_shared<PlusIgtlSharedMemoryRing>();
+            if (ring->Create(ringName.str(), static_cast<size_t>(self->SharedMemoryBufferSizeMb * 1024 * 1024)) == PLUS_SUCCESS)
+            {
+              client->SharedMemoryRing = ring;
+            }
+            else
+            {
+              LOG_WARNING("Failed to create shared memory ring for client " << clientId << ", data is sent through the network");
+            }
+          }
+          LOG_DEBUG("Client " << clientId << " requested shared memory transport, " << (client->SharedMemoryRing != NULL ? "waiting for the client to attach" : "not available"));
+
+          // Tell the client where to read the data from, or that it is still sent through the socket.
+          // Data is sent through the ring only after the client acknowledges that it has opened it.
+          igtl::MessageBase::Pointer msg = self->IgtlMessageFactory->CreateSendMessage("STRING", clientInfoMsg->GetHeaderVersion());
+          igtl::StringMessage* replyMsg = dynamic_cast<igtl::StringMessage*>(msg.GetPointer());
+          replyMsg->SetDeviceName(PlusIgtlSharedMemoryRing::TRANSPORT_NAME);
+          replyMsg->SetString(client->SharedMemoryRing != NULL ? client->SharedMemoryRing->GetName() : std::string(""));
+          replyMsg->Pack();
+          self->QueueMessageResponseForClient(client->ClientId, msg);
+        }
+        else
+        {
+          client->SharedMemoryTransportActive = false;
+          client->SharedMemoryRing.reset();
+        }
       }
     }
     else if (typeid(*bodyMessage) == typeid(igtl::GetStatusMessage))
@@ -599,6 +743,30 @@ void* vtkPlusOpenIGTLinkServer::DataReceiverThread(vtkMultiThreader::ThreadInfo*
       replyMsg->Pack();
       clientSocket->Send(replyMsg->GetPackPointer(), replyMsg->GetPackBodySize());
     }
+    else if (typeid(*bodyMessage) == typeid(igtl::StringMessage)
+             && STRCASECMP(headerMsg->GetDeviceName(), PlusIgtlSharedMemoryRing::TRANSPORT_NAME) == 0)
+    {
+      // The client acknowledges that it has attached to its shared memory ring
+      igtl::StringMessage::Pointer stringMsg = dynamic_cast<igtl::StringMessage*>(bodyMessage.GetPointer());
+      stringMsg->SetMessageHeader(headerMsg);
+      stringMsg->AllocateBuffer();
+      clientSocket->Receive(stringMsg->GetPackBodyPointer(), stringMsg->GetPackBodySize());
+
+      int c = stringMsg->Unpack(self->IgtlMessageCrcCheckEnabled);
+      if (c & igtl::MessageHeader::UNPACK_BODY)
+      {
+        PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(self->IgtlClientsMutex);
+        if (client->SharedMemoryRing != NULL && client->SharedMemoryRing->GetName() == std::string(stringMsg->GetString()))
+        {
+          client->SharedMemoryTransportActive = true;
+          LOG_DEBUG("Client " << clientId << " attached to shared memory ring " << client->SharedMemoryRing->GetName() << ", frame data is sent through shared memory");
+        }
+        else
+        {
+          LOG_WARNING("Client " << clientId << " acknowledged an unknown shared memory ring (" << stringMsg->GetString() << "), data is sent through the network");
+        }
+      }
+    }
     else if (typeid(*bodyMessage) == typeid(igtl::StringMessage)
              && vtkPlusCommand::IsCommandDeviceName(headerMsg->GetDeviceName()))
     {
@@ -712,6 +880,7 @@ void* vtkPlusOpenIGTLinkServer::DataReceiverThread(vtkMultiThreader::ThreadInfo*
       if (c & igtl::MessageHeader::UNPACK_BODY)
       {
         client->ClientInfo.Resolution = startTracking->GetResolution();
+        client->ClientInfo.LastTDATASentTimeStamp = -1;
         client->ClientInfo.TDATARequested = true;
       }
       else
@@ -773,33 +942,36 @@ void* vtkPlusOpenIGTLinkServer::DataReceiverThread(vtkMultiThreader::ThreadInfo*
         }
       }
 
-      vtkSmartPointer<vtkPolyDataReader> reader = vtkSmartPointer<vtkPolyDataReader>::New();
-      reader->SetFileName(fileName.c_str());
-      reader->Update();
+      // Cached models are sent right away, others are loaded on the loader thread so that this thread can keep receiving messages
+      igtl::MessageBase::Pointer cachedMsg = self->GetCachedPolyDataMessage(fileName, polyDataMessage->GetHeaderVersion());
+      if (cachedMsg.IsNotNull())
+      {
+        self->QueueMessageResponseForClient(client->ClientId, cachedMsg);
+        continue;
+      }
 
-      auto polyData = reader->GetOutput();
-      if (polyData != nullptr)
+      PolyDataRequest request;
+      request.ClientId = client->ClientId;
+      request.FileName = fileName;
+      request.HeaderVersion = polyDataMessage->GetHeaderVersion();
+      bool requestQueued(false);
       {
-        igtl::MessageBase::Pointer msg = self->IgtlMessageFactory->CreateSendMessage("POLYDATA", polyDataMessage->GetHeaderVersion());
-        igtl::PolyDataMessage* polyMsg = dynamic_cast<igtl::PolyDataMessage*>(msg.GetPointer());
-
-        igtlio::PolyDataConverter::MessageContent content;
-        content.deviceName = "PlusServer";
-        content.polydata = polyData;
-        igtlio::PolyDataConverter::VTKToIGTL(content, (igtl::PolyDataMessage::Pointer*)&msg);
-        if (!msg->SetMetaDataElement("fileName", IANA_TYPE_US_ASCII, fileName))
+        std::lock_guard<std::mutex> requestQueueLock(self->PolyDataRequestQueueMutex);
+        if (self->PolyDataLoaderActive.first)
         {
-          LOG_ERROR("Filename too long to be sent back to client. Aborting.");
-          continue;
+          self->PolyDataRequestQueue.push_back(request);
+          requestQueued = true;
         }
-        self->QueueMessageResponseForClient(client->ClientId, msg);
-        continue;
       }
-
-      igtl::MessageBase::Pointer msg = self->IgtlMessageFactory->CreateSendMessage("RTS_POLYDATA", polyDataMessage->GetHeaderVersion());
-      igtl::RTSPolyDataMessage* rtsPolyMsg = dynamic_cast<igtl::RTSPolyDataMessage*>(msg.GetPointer());
-      rtsPolyMsg->SetStatus(false);
-      self->QueueMessageResponseForClient(client->ClientId, rtsPolyMsg);
+      if (requestQueued)
+      {
+        self->PolyDataRequestQueueCondition.notify_one();
+      }
+      else
+      {
+        // Loader thread is not running, load the model on this thread
+        self->QueuePolyDataResponseForClient(request.ClientId, request.FileName, request.HeaderVersion);
+      }
     }
     else if (typeid(*bodyMessage) == typeid(igtl::StatusMessage))
     {
@@ -870,6 +1042,12 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendTrackedFrame(PlusTrackedFrame& trackedF
         {
           continue;
         }
+        if (clientIterator->SharedMemoryTransportActive && igtlMessage->GetBufferSize() <= clientIterator->SharedMemoryRing->GetMaximumMessageSize()
+            && clientIterator->SharedMemoryRing->Write(igtlMessage->GetBufferPointer(), igtlMessage->GetBufferSize()) == PLUS_SUCCESS)
+        {
+          // The message is in the client's shared memory ring, it is not sent through the socket
+          continue;
+        }
         /*-----------------------------------
         //For latency and frame loss rate evaluatoin
         FILE* pEvalFile = NULL;
@@ -923,8 +1101,6 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendTrackedFrame(PlusTrackedFrame& trackedF
         pEvalFile = NULL;
         //-----------------------------------
         */
-        // Update the TDATA timestamp, even if TDATA isn't sent (cheaper than checking for existing TDATA message type)
-        clientIterator->ClientInfo.LastTDATASentTimeStamp = trackedFrame.GetTimestamp();
       }
     }
   }
@@ -941,6 +1117,365 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendTrackedFrame(PlusTrackedFrame& trackedF
   return (numberOfErrors == 0 ? PLUS_SUCCESS : PLUS_FAIL);
 }
 
+//----------------------------------------------------------------------------
+void* vtkPlusOpenIGTLinkServer::TrackingDataSenderThread(vtkMultiThreader::ThreadInfo* data)
+{
+  vtkPlusOpenIGTLinkServer* self = (vtkPlusOpenIGTLinkServer*)(data->UserData);
+  self->TrackingDataSenderActive.second = true;
+
+  // The server's transform repository is updated by the data sender thread, so tracking data is computed in a separate repository
+  vtkSmartPointer<vtkPlusTransformRepository> trackingTransformRepository = vtkSmartPointer<vtkPlusTransformRepository>::New();
+  double lastRepositoryCopyTime = -TRACKING_TRANSFORM_REPOSITORY_UPDATE_PERIOD_SEC;
+
+  while (self->TrackingDataSenderActive.first)
+  {
+    double delaySec = self->SendLatestTrackingDataToClients(trackingTransformRepository, lastRepositoryCopyTime);
+    if (delaySec > 0)
+    {
+      vtkPlusAccurateTimer::Delay(delaySec);
+    }
+  }
+
+  // Close thread
+  self->TrackingDataSenderThreadId = -1;
+  self->TrackingDataSenderActive.second = false;
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusOpenIGTLinkServer::SendLatestTrackingDataToClients(vtkPlusTransformRepository* trackingTransformRepository, double& lastRepositoryCopyTime)
+{
+  // The broadcast channel is set by the data sender thread
+  vtkPlusChannel* channel = this->BroadcastChannel;
+  if (channel == NULL || channel->ToolCount() == 0 || !channel->GetTrackingDataAvailable())
+  {
+    return DELAY_ON_NO_NEW_FRAMES_SEC;
+  }
+
+  // Find the time of the most recent tracking data that is available for all tools
+  double latestTrackingTimestamp = UNDEFINED_TIMESTAMP;
+  for (DataSourceContainerIterator it = channel->GetToolsStartIterator(); it != channel->GetToolsEndIterator(); ++it)
+  {
+    double toolTimestamp(0);
+    if (it->second->GetLatestTimeStamp(toolTimestamp) != ITEM_OK)
+    {
+      return DELAY_ON_NO_NEW_FRAMES_SEC;
+    }
+    latestTrackingTimestamp = std::min(latestTrackingTimestamp, toolTimestamp);
+  }
+
+  // Find the clients that are due to receive new tracking data
+  std::vector<int> dueClientIds;
+  double nextDueTimestamp = UNDEFINED_TIMESTAMP;
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+    for (std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
+    {
+      const PlusIgtlClientInfo& clientInfo = clientIterator->ClientInfo;
+      if (!clientInfo.TDATARequested)
+      {
+        continue;
+      }
+      double dueTimestamp = clientInfo.LastTDATASentTimeStamp + clientInfo.Resolution * 0.001;
+      if (latestTrackingTimestamp > clientInfo.LastTDATASentTimeStamp && latestTrackingTimestamp >= dueTimestamp)
+      {
+        dueClientIds.push_back(clientIterator->ClientId);
+      }
+      else
+      {
+        nextDueTimestamp = std::min(nextDueTimestamp, dueTimestamp);
+      }
+    }
+  }
+  bool multicastDue = false;
+  if (this->MulticastChannel.IsOpen())
+  {
+    double dueTimestamp = this->MulticastLastSentTimestamp + this->MulticastResolutionMs * 0.001;
+    if (latestTrackingTimestamp > this->MulticastLastSentTimestamp && latestTrackingTimestamp >= dueTimestamp)
+    {
+      multicastDue = true;
+    }
+    else
+    {
+      nextDueTimestamp = std::min(nextDueTimestamp, dueTimestamp);
+    }
+  }
+  if (dueClientIds.empty() && !multicastDue)
+  {
+    if (nextDueTimestamp == UNDEFINED_TIMESTAMP)
+    {
+      // No client requested tracking data
+      return DELAY_ON_NO_NEW_FRAMES_SEC;
+    }
+    return std::min(std::max(nextDueTimestamp - latestTrackingTimestamp, DELAY_ON_NO_NEW_TRACKING_DATA_SEC), DELAY_ON_NO_NEW_FRAMES_SEC);
+  }
+
+  // Persistent transforms (calibrations) rarely change, copy them only periodically
+  double currentTime = vtkPlusAccurateTimer::GetSystemTime();
+  if (this->TransformRepository != NULL && currentTime - lastRepositoryCopyTime > TRACKING_TRANSFORM_REPOSITORY_UPDATE_PERIOD_SEC)
+  {
+    trackingTransformRepository->DeepCopy(this->TransformRepository, false);
+    lastRepositoryCopyTime = currentTime;
+  }
+
+  // Get all tools in one frame, without image data, so that tracking data is not delayed by the video
+  PlusTrackedFrame trackedFrame;
+  if (channel->GetTrackedFrame(latestTrackingTimestamp, trackedFrame, false) != PLUS_SUCCESS
+      || trackingTransformRepository->SetTransforms(trackedFrame) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to get tracking data at time " << std::fixed << latestTrackingTimestamp);
+    return DELAY_ON_SENDING_ERROR_SEC;
+  }
+  double timestampUniversal = vtkPlusAccurateTimer::GetUniversalTimeFromSystemTime(latestTrackingTimestamp);
+
+  if (multicastDue)
+  {
+    // Sent before the clients, as it does not have to wait for any slow client socket
+    this->MulticastLastSentTimestamp = latestTrackingTimestamp;
+    this->SendTrackingDataToMulticastGroup(trackingTransformRepository, trackedFrame, timestampUniversal);
+  }
+
+  std::vector<int> disconnectedClientIds;
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+    for (std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
+    {
+      if (std::find(dueClientIds.begin(), dueClientIds.end(), clientIterator->ClientId) == dueClientIds.end())
+      {
+        continue;
+      }
+      clientIterator->ClientInfo.LastTDATASentTimeStamp = latestTrackingTimestamp;
+
+      igtl::MessageBase::Pointer igtlMessage;
+      if (this->IgtlMessageFactory->PackTrackingDataMessage(clientIterator->ClientInfo, trackingTransformRepository, timestampUniversal, igtlMessage) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to pack TDATA message for client " << clientIterator->ClientId);
+        continue;
+      }
+
+      int retValue = 0;
+      RETRY_UNTIL_TRUE((retValue = clientIterator->ClientSocket->Send(igtlMessage->GetBufferPointer(), igtlMessage->GetBufferSize())) != 0, this->NumberOfRetryAttempts, this->DelayBetweenRetryAttemptsSec);
+      if (retValue == 0)
+      {
+        LOG_INFO("Client disconnected - could not send TDATA message to client " << clientIterator->ClientId);
+        disconnectedClientIds.push_back(clientIterator->ClientId);
+      }
+    }
+  }
+
+  // Clean up disconnected clients
+  for (std::vector<int>::iterator it = disconnectedClientIds.begin(); it != disconnectedClientIds.end(); ++it)
+  {
+    DisconnectClient(*it);
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkServer::SendTrackingDataToMulticastGroup(vtkPlusTransformRepository* trackingTransformRepository, PlusTrackedFrame& trackedFrame, double timestampUniversal)
+{
+  // TRANSFORM and POSITION messages are packed the same way as for the clients, TDATA is packed separately
+  PlusIgtlClientInfo clientInfo = this->MulticastClientInfo;
+  bool trackingDataMessageRequested = false;
+  std::vector<std::string>::iterator messageTypeIterator = std::find(clientInfo.IgtlMessageTypes.begin(), clientInfo.IgtlMessageTypes.end(), "TDATA");
+  if (messageTypeIterator != clientInfo.IgtlMessageTypes.end())
+  {
+    trackingDataMessageRequested = true;
+    clientInfo.IgtlMessageTypes.erase(messageTypeIterator);
+  }
+
+  std::vector<igtl::MessageBase::Pointer> igtlMessages;
+  if (!clientInfo.IgtlMessageTypes.empty())
+  {
+    trackedFrame.SetTimestamp(timestampUniversal);
+    if (this->IgtlMessageFactory->PackMessages(clientInfo, igtlMessages, trackedFrame, this->SendValidTransformsOnly, trackingTransformRepository) != PLUS_SUCCESS)
+    {
+      LOG_WARNING("Failed to pack all tracking data messages for multicast");
+    }
+  }
+  if (trackingDataMessageRequested)
+  {
+    igtl::MessageBase::Pointer trackingDataMessage;
+    if (this->IgtlMessageFactory->PackTrackingDataMessage(clientInfo, trackingTransformRepository, timestampUniversal, trackingDataMessage) == PLUS_SUCCESS)
+    {
+      igtlMessages.push_back(trackingDataMessage);
+    }
+    else
+    {
+      LOG_WARNING("Failed to pack TDATA message for multicast");
+    }
+  }
+
+  int numberOfErrors = 0;
+  for (std::vector<igtl::MessageBase::Pointer>::iterator igtlMessageIterator = igtlMessages.begin(); igtlMessageIterator != igtlMessages.end(); ++igtlMessageIterator)
+  {
+    igtl::MessageBase::Pointer igtlMessage = (*igtlMessageIterator);
+    if (igtlMessage.IsNull())
+    {
+      continue;
+    }
+    // A failed send is not retried: the receivers detect the lost message and the next sample replaces it anyway
+    if (this->MulticastChannel.Send(igtlMessage->GetBufferPointer(), igtlMessage->GetBufferSize()) != PLUS_SUCCESS)
+    {
+      numberOfErrors++;
+    }
+  }
+  if (numberOfErrors > 0)
+  {
+    LOG_DEBUG("Failed to send " << numberOfErrors << " tracking data messages by multicast");
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void* vtkPlusOpenIGTLinkServer::PolyDataLoaderThread(vtkMultiThreader::ThreadInfo* data)
+{
+  vtkPlusOpenIGTLinkServer* self = (vtkPlusOpenIGTLinkServer*)(data->UserData);
+  self->PolyDataLoaderActive.second = true;
+
+  while (true)
+  {
+    PolyDataRequest request;
+    {
+      std::unique_lock<std::mutex> requestQueueLock(self->PolyDataRequestQueueMutex);
+      self->PolyDataRequestQueueCondition.wait(requestQueueLock, [self]
+      {
+        return !self->PolyDataLoaderActive.first || !self->PolyDataRequestQueue.empty();
+      });
+      if (!self->PolyDataLoaderActive.first)
+      {
+        break;
+      }
+      request = self->PolyDataRequestQueue.front();
+      self->PolyDataRequestQueue.pop_front();
+    }
+    self->QueuePolyDataResponseForClient(request.ClientId, request.FileName, request.HeaderVersion);
+  }
+
+  self->PolyDataLoaderActive.second = false;
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+igtl::MessageBase::Pointer vtkPlusOpenIGTLinkServer::GetCachedPolyDataMessage(const std::string& fileName, int headerVersion)
+{
+  std::string resolvedPath = vtksys::SystemTools::CollapseFullPath(fileName);
+  if (!vtksys::SystemTools::FileExists(resolvedPath, true))
+  {
+    return NULL;
+  }
+  long modifiedTime = vtksys::SystemTools::ModifiedTime(resolvedPath);
+  unsigned long fileSize = vtksys::SystemTools::FileLength(resolvedPath);
+
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> cacheGuardedLock(this->PolyDataCacheMutex);
+  for (std::list<PolyDataCacheEntry>::iterator entryIt = this->PolyDataCache.begin(); entryIt != this->PolyDataCache.end(); ++entryIt)
+  {
+    if (entryIt->ResolvedPath != resolvedPath || entryIt->RequestedFileName != fileName || entryIt->HeaderVersion != headerVersion)
+    {
+      continue;
+    }
+    if (entryIt->ModifiedTime != modifiedTime || entryIt->FileSize != fileSize)
+    {
+      LOG_DEBUG("Model file " << resolvedPath << " has been modified since it was cached");
+      this->PolyDataCacheSizeBytes -= entryIt->Message->GetBufferSize();
+      this->PolyDataCache.erase(entryIt);
+      return NULL;
+    }
+    // Move to the front, so that the least recently used entries are removed first
+    this->PolyDataCache.splice(this->PolyDataCache.begin(), this->PolyDataCache, entryIt);
+    return this->PolyDataCache.front().Message;
+  }
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+igtl::MessageBase::Pointer vtkPlusOpenIGTLinkServer::LoadPolyDataMessage(const std::string& fileName, int headerVersion)
+{
+  // The model may have been loaded since the request was queued
+  igtl::MessageBase::Pointer cachedMsg = this->GetCachedPolyDataMessage(fileName, headerVersion);
+  if (cachedMsg.IsNotNull())
+  {
+    return cachedMsg;
+  }
+
+  PolyDataCacheEntry entry;
+  entry.ResolvedPath = vtksys::SystemTools::CollapseFullPath(fileName);
+  entry.RequestedFileName = fileName;
+  entry.HeaderVersion = headerVersion;
+  if (!vtksys::SystemTools::FileExists(entry.ResolvedPath, true))
+  {
+    LOG_ERROR("Requested model file not found: " << entry.ResolvedPath);
+    return NULL;
+  }
+  // Get the file properties before reading, so that changes during reading are detected at the next request
+  entry.ModifiedTime = vtksys::SystemTools::ModifiedTime(entry.ResolvedPath);
+  entry.FileSize = vtksys::SystemTools::FileLength(entry.ResolvedPath);
+
+  vtkSmartPointer<vtkPolyDataReader> reader = vtkSmartPointer<vtkPolyDataReader>::New();
+  reader->SetFileName(entry.ResolvedPath.c_str());
+  reader->Update();
+  vtkPolyData* polyData = reader->GetOutput();
+  if (polyData == NULL || reader->GetErrorCode() != 0)
+  {
+    LOG_ERROR("Failed to read model file: " << entry.ResolvedPath);
+    return NULL;
+  }
+
+  entry.Message = this->IgtlMessageFactory->CreateSendMessage("POLYDATA", headerVersion);
+  igtlio::PolyDataConverter::MessageContent content;
+  content.deviceName = "PlusServer";
+  content.polydata = polyData;
+  igtlio::PolyDataConverter::VTKToIGTL(content, (igtl::PolyDataMessage::Pointer*)&entry.Message);
+  if (!entry.Message->SetMetaDataElement("fileName", IANA_TYPE_US_ASCII, fileName))
+  {
+    LOG_ERROR("Filename too long to be sent back to client. Aborting.");
+    return NULL;
+  }
+  // Pack again to include the metadata, the message is sent as is for all later requests
+  entry.Message->Pack();
+
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> cacheGuardedLock(this->PolyDataCacheMutex);
+  size_t maxCacheSizeBytes = static_cast<size_t>(std::max(0.0, this->MaxPolyDataCacheSizeMb) * 1024 * 1024);
+  size_t messageSizeBytes = entry.Message->GetBufferSize();
+  if (messageSizeBytes > maxCacheSizeBytes)
+  {
+    LOG_DEBUG("Model file " << entry.ResolvedPath << " is not cached, message size (" << messageSizeBytes << " bytes) exceeds the cache size limit");
+    return entry.Message;
+  }
+  this->PolyDataCache.push_front(entry);
+  this->PolyDataCacheSizeBytes += messageSizeBytes;
+  while (this->PolyDataCacheSizeBytes > maxCacheSizeBytes)
+  {
+    this->PolyDataCacheSizeBytes -= this->PolyDataCache.back().Message->GetBufferSize();
+    this->PolyDataCache.pop_back();
+  }
+  return entry.Message;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::QueuePolyDataResponseForClient(int clientId, const std::string& fileName, int headerVersion)
+{
+  igtl::MessageBase::Pointer msg = this->LoadPolyDataMessage(fileName, headerVersion);
+  if (msg.IsNull())
+  {
+    msg = this->IgtlMessageFactory->CreateSendMessage("RTS_POLYDATA", headerVersion);
+    igtl::RTSPolyDataMessage* rtsPolyMsg = dynamic_cast<igtl::RTSPolyDataMessage*>(msg.GetPointer());
+    rtsPolyMsg->SetStatus(false);
+    rtsPolyMsg->Pack();
+  }
+  this->QueueMessageResponseForClient(clientId, msg);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::ClearPolyDataCache()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> cacheGuardedLock(this->PolyDataCacheMutex);
+  this->PolyDataCache.clear();
+  this->PolyDataCacheSizeBytes = 0;
+}
+
 //----------------------------------------------------------------------------
 void vtkPlusOpenIGTLinkServer::DisconnectClient(int clientId)
 {
@@ -1109,6 +1644,15 @@ PlusStatus vtkPlusOpenIGTLinkServer::ReadConfiguration(vtkXMLDataElement* server
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(SendValidTransformsOnly, serverElement);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(IgtlMessageCrcCheckEnabled, serverElement);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(LogWarningOnNoDataAvailable, serverElement);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(CommandExecutionThreadEnabled, serverElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, MaxPolyDataCacheSizeMb, serverElement);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(SharedMemoryTransportEnabled, serverElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, SharedMemoryBufferSizeMb, serverElement);
+  XML_READ_STRING_ATTRIBUTE_OPTIONAL(MulticastGroupAddress, serverElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, MulticastPort, serverElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, MulticastTimeToLive, serverElement);
+  XML_READ_STRING_ATTRIBUTE_OPTIONAL(MulticastInterfaceAddress, serverElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, MulticastResolutionMs, serverElement);
 
   this->DefaultClientInfo.IgtlMessageTypes.clear();
   this->DefaultClientInfo.TransformNames.clear();
@@ -1126,6 +1670,34 @@ PlusStatus vtkPlusOpenIGTLinkServer::ReadConfiguration(vtkXMLDataElement* server
     }
   }
 
+  // Multicast content is the default client info, unless it is specified separately
+  this->MulticastClientInfo = this->DefaultClientInfo;
+  vtkXMLDataElement* multicastClientInfo = serverElement->FindNestedElementWithName("MulticastClientInfo");
+  if (multicastClientInfo != NULL)
+  {
+    this->MulticastClientInfo = PlusIgtlClientInfo();
+    if (this->MulticastClientInfo.SetClientInfoFromXmlData(multicastClientInfo) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+  }
+  // Only tracking data is sent by multicast
+  std::vector<std::string> multicastMessageTypes;
+  for (std::vector<std::string>::iterator it = this->MulticastClientInfo.IgtlMessageTypes.begin(); it != this->MulticastClientInfo.IgtlMessageTypes.end(); ++it)
+  {
+    if (*it == "TRANSFORM" || *it == "POSITION" || *it == "TDATA")
+    {
+      multicastMessageTypes.push_back(*it);
+    }
+  }
+  if (multicastMessageTypes.empty())
+  {
+    multicastMessageTypes.push_back("TRANSFORM");
+  }
+  this->MulticastClientInfo.IgtlMessageTypes = multicastMessageTypes;
+  this->MulticastClientInfo.ImageStreams.clear();
+  this->MulticastClientInfo.StringNames.clear();
+
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(float, DefaultClientSendTimeoutSec, serverElement);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(float, DefaultClientReceiveTimeoutSec, serverElement);
 
@@ -1137,9 +1709,20 @@ PlusStatus vtkPlusOpenIGTLinkServer::ReadConfiguration(vtkXMLDataElement* server
 //------------------------------------------------------------------------------
 int vtkPlusOpenIGTLinkServer::ProcessPendingCommands()
 {
+  if (this->PlusCommandProcessor->IsRunning())
+  {
+    // Commands are executed by the command execution thread
+    return 0;
+  }
   return this->PlusCommandProcessor->ExecuteCommands();
 }
 
+//------------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkServer::SendQueuedCommandResponses()
+{
+  return SendCommandResponses(*this);
+}
+
 //------------------------------------------------------------------------------
 bool vtkPlusOpenIGTLinkServer::HasGracePeriodExpired()
 {
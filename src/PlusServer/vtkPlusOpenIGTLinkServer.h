@@ -10,6 +10,8 @@
 // Local includes
 #include "vtkPlusServerExport.h"
 #include "PlusIgtlClientInfo.h"
+#include "PlusIgtlMulticastChannel.h"
+#include "PlusIgtlSharedMemoryRing.h"
 #include "vtkPlusDataCollector.h"
 #include "vtkPlusIgtlMessageFactory.h"
 #include "vtkPlusTransformRepository.h"
@@ -20,7 +22,11 @@
 #include <vtkSmartPointer.h>
 
 // STL includes
+#include <condition_variable>
 #include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
 
 // OS includes
 #if (_MSC_VER == 1500)
@@ -47,6 +53,7 @@ struct ClientData
     , ClientSocket(NULL)
     , DataReceiverActive(std::make_pair(false, false))
     , DataReceiverThreadId(-1)
+    , SharedMemoryTransportActive(false)
     , Server(NULL)
   {
   }
@@ -67,6 +74,13 @@ struct ClientData
 
   PlusIgtlClientInfo ClientInfo;
 
+  /// Shared memory ring of the client, created when the client requests shared memory transport
+  std::shared_ptr<PlusIgtlSharedMemoryRing> SharedMemoryRing;
+
+  /// If true then frame data is sent to the client through its shared memory ring instead of the socket.
+  /// Only set after the client acknowledged that it has attached to the ring.
+  bool SharedMemoryTransportActive;
+
   vtkPlusOpenIGTLinkServer* Server;
 };
 
@@ -83,6 +97,22 @@ struct ClientData
   requested image and tracking information in the same format as in the DefaultClientInfo element in the device set
   configuration file.
 
+  If SharedMemoryTransportEnabled is set then clients running on the same host may request the frame data to be sent
+  through shared memory, by setting the SharedMemoryTransport metadata element to TRUE in the CLIENTINFO message.
+  The server creates a shared memory ring for the client (see PlusIgtlSharedMemoryRing) and replies with a
+  SharedMemoryTransport STRING message that contains the name of the segment, or an empty string if the data is
+  still sent through the socket. After opening the ring the client sends a SharedMemoryTransport STRING message that
+  contains the segment name. Frame data is sent through the socket until this acknowledgement is received, so no frame
+  is lost while the client attaches. Each client has its own ring, which only contains the messages that were packed
+  for that client (with its subscriptions and header version).
+  Command responses, keep-alive and TDATA messages are always sent through the socket.
+
+  If MulticastGroupAddress is set then tracking data (TRANSFORM, POSITION, and TDATA messages) is also sent
+  to a UDP multicast group, once for all the receivers (see PlusIgtlMulticastChannel). The content is defined by the
+  MulticastClientInfo element, in the same format as DefaultClientInfo (DefaultClientInfo is used if it is not specified),
+  and it is sent at most once in every MulticastResolutionMs. Datagrams are not retransmitted, so lost messages
+  do not delay the subsequent ones.
+
   \ingroup PlusLibPlusServer
 */
 class vtkPlusServerExport vtkPlusOpenIGTLinkServer: public vtkObject
@@ -126,6 +156,49 @@ public:
   vtkSetMacro(DefaultClientReceiveTimeoutSec, float);
   vtkGetMacroConst(DefaultClientReceiveTimeoutSec, float);
 
+  /*!
+    If enabled then commands are executed on a dedicated thread as soon as they are received.
+    If disabled then commands are only executed when ProcessPendingCommands() is called.
+    Disabled by default, as PlusServer executes the commands from its main loop.
+  */
+  vtkSetMacro(CommandExecutionThreadEnabled, bool);
+  vtkGetMacroConst(CommandExecutionThreadEnabled, bool);
+
+  /*!
+    Maximum memory used for caching packed POLYDATA messages (in MB).
+    If set to 0 then model files are read from disk for each GET_POLYDATA request.
+  */
+  vtkSetMacro(MaxPolyDataCacheSizeMb, double);
+  vtkGetMacroConst(MaxPolyDataCacheSizeMb, double);
+
+  /*! If enabled then local clients can request to receive frame data through shared memory */
+  vtkSetMacro(SharedMemoryTransportEnabled, bool);
+  vtkGetMacroConst(SharedMemoryTransportEnabled, bool);
+
+  /*! Size of the shared memory ring of each client (in MB), it must be larger than the largest message */
+  vtkSetMacro(SharedMemoryBufferSizeMb, double);
+  vtkGetMacroConst(SharedMemoryBufferSizeMb, double);
+
+  /*! Multicast group address for tracking data. If empty then tracking data is not sent by multicast. */
+  vtkSetStdStringMacro(MulticastGroupAddress);
+  vtkGetStdStringMacro(MulticastGroupAddress);
+
+  /*! UDP port of the multicast group. If negative then the listening port is used. */
+  vtkSetMacro(MulticastPort, int);
+  vtkGetMacroConst(MulticastPort, int);
+
+  /*! Maximum number of routers that multicast datagrams may pass (1: local network only) */
+  vtkSetMacro(MulticastTimeToLive, int);
+  vtkGetMacroConst(MulticastTimeToLive, int);
+
+  /*! Address of the network interface used for sending multicast datagrams. If empty then the default interface is used. */
+  vtkSetStdStringMacro(MulticastInterfaceAddress);
+  vtkGetStdStringMacro(MulticastInterfaceAddress);
+
+  /*! Minimum time between tracking data sent by multicast (in milliseconds). If 0 then each new tracker sample is sent. */
+  vtkSetMacro(MulticastResolutionMs, int);
+  vtkGetMacroConst(MulticastResolutionMs, int);
+
   /*! Set data collector instance */
   vtkSetMacro(DataCollector, vtkPlusDataCollector*);
   vtkGetMacroConst(DataCollector, vtkPlusDataCollector*);
@@ -153,11 +226,15 @@ public:
   vtkGetMacro(IGTLProtocolVersion, int);
 
   /*!
-    Execute all commands in the queue from the current thread (useful if commands should be executed from the main thread)
+    Execute all commands in the queue from the current thread (useful if commands should be executed from the main thread).
+    Does nothing if the commands are executed on the command execution thread.
     \return Number of executed commands
   */
   int ProcessPendingCommands();
 
+  /*! Send the queued command responses to the clients immediately. Can be called from any thread. */
+  PlusStatus SendQueuedCommandResponses();
+
 protected:
   vtkPlusOpenIGTLinkServer();
   virtual ~vtkPlusOpenIGTLinkServer();
@@ -183,6 +260,40 @@ protected:
   /*! Thread for receiving control data from clients */
   static void* DataReceiverThread(vtkMultiThreader::ThreadInfo* data);
 
+  /*! Thread for streaming TDATA messages from the tracker buffers to clients that requested it by STT_TDATA */
+  static void* TrackingDataSenderThread(vtkMultiThreader::ThreadInfo* data);
+
+  /*!
+    Send the latest tracking data to all clients that requested TDATA and their requested resolution time has elapsed.
+    \param trackingTransformRepository Transform repository that is only used by the tracking data sender thread
+    \param lastRepositoryCopyTime System time when the persistent transforms were last copied into trackingTransformRepository
+    \return Time to wait before calling this method again (in seconds)
+  */
+  double SendLatestTrackingDataToClients(vtkPlusTransformRepository* trackingTransformRepository, double& lastRepositoryCopyTime);
+
+  /*!
+    Send the tracking data in the multicast client info to the multicast group.
+    \param trackingTransformRepository Transform repository that is already updated with the tracked frame
+    \param trackedFrame Tracking data, without image
+    \param timestampUniversal Time of the tracking data in UTC
+  */
+  PlusStatus SendTrackingDataToMulticastGroup(vtkPlusTransformRepository* trackingTransformRepository, PlusTrackedFrame& trackedFrame, double timestampUniversal);
+
+  /*! Thread for loading model files requested by GET_POLYDATA messages that are not found in the cache */
+  static void* PolyDataLoaderThread(vtkMultiThreader::ThreadInfo* data);
+
+  /*! Returns the cached POLYDATA message of a model file. Returns NULL if the file is not cached or it has been modified since it was cached. */
+  igtl::MessageBase::Pointer GetCachedPolyDataMessage(const std::string& fileName, int headerVersion);
+
+  /*! Reads a model file and creates a packed POLYDATA message from it. The message is added to the cache. Returns NULL on failure. */
+  igtl::MessageBase::Pointer LoadPolyDataMessage(const std::string& fileName, int headerVersion);
+
+  /*! Queues the POLYDATA message of a model file for sending to a client, or a failure RTS_POLYDATA message if the file cannot be loaded */
+  void QueuePolyDataResponseForClient(int clientId, const std::string& fileName, int headerVersion);
+
+  /*! Removes all messages from the POLYDATA message cache */
+  void ClearPolyDataCache();
+
   /*! Tracked frame interface, sends the selected message type and data to all clients */
   virtual PlusStatus SendTrackedFrame(PlusTrackedFrame& trackedFrame);
 
@@ -254,10 +365,12 @@ private:
   // Active flag for threads (first: request, second: respond )
   std::pair<bool, bool> ConnectionActive;
   std::pair<bool, bool> DataSenderActive;
+  std::pair<bool, bool> TrackingDataSenderActive;
 
   // Thread IDs
   int ConnectionReceiverThreadId;
   int DataSenderThreadId;
+  int TrackingDataSenderThreadId;
 
   /*! List of connected clients */
   std::list<ClientData> IgtlClients;
@@ -292,6 +405,12 @@ private:
   /*! Flag for IGTL CRC check */
   bool IgtlMessageCrcCheckEnabled;
 
+  /*! Execute commands on the command processor's thread instead of in ProcessPendingCommands() */
+  bool CommandExecutionThreadEnabled;
+
+  /*! Mutex to keep command responses in order when they are sent from multiple threads */
+  vtkSmartPointer<vtkPlusRecursiveCriticalSection> CommandResponseSendMutex;
+
   /*! Factory to generate commands that are invoked remotely */
   vtkSmartPointer<vtkPlusCommandProcessor> PlusCommandProcessor;
 
@@ -301,6 +420,79 @@ private:
   /*! Mutex to protect access to the message response list */
   vtkSmartPointer<vtkPlusRecursiveCriticalSection> MessageResponseQueueMutex;
 
+  /*! Packed POLYDATA message that was created from a model file */
+  struct PolyDataCacheEntry
+  {
+    /*! Full path of the model file */
+    std::string ResolvedPath;
+    /*! File name as it was requested by the client (it is sent back in the message metadata) */
+    std::string RequestedFileName;
+    int HeaderVersion;
+    /*! Modification time and size of the file when it was read, used for detecting changes */
+    long ModifiedTime;
+    unsigned long FileSize;
+    igtl::MessageBase::Pointer Message;
+  };
+
+  /*! Cached POLYDATA messages, the most recently used message is the first */
+  std::list<PolyDataCacheEntry> PolyDataCache;
+
+  /*! Total size of the messages in the POLYDATA message cache (in bytes) */
+  size_t PolyDataCacheSizeBytes;
+
+  /*! Maximum size of the POLYDATA message cache (in MB) */
+  double MaxPolyDataCacheSizeMb;
+
+  /*! Mutex to protect access to the POLYDATA message cache */
+  vtkSmartPointer<vtkPlusRecursiveCriticalSection> PolyDataCacheMutex;
+
+  /*! GET_POLYDATA request that is waiting for the model file to be loaded */
+  struct PolyDataRequest
+  {
+    int ClientId;
+    std::string FileName;
+    int HeaderVersion;
+  };
+
+  /*! Enable shared memory transport for local clients */
+  bool SharedMemoryTransportEnabled;
+
+  /*! Size of the shared memory ring of each client (in MB) */
+  double SharedMemoryBufferSizeMb;
+
+  /*! Multicast group address for tracking data, empty if multicast is disabled */
+  std::string MulticastGroupAddress;
+
+  /*! UDP port of the multicast group (negative: same as the listening port) */
+  int MulticastPort;
+
+  /*! Time-to-live of the multicast datagrams */
+  int MulticastTimeToLive;
+
+  /*! Network interface for sending multicast datagrams */
+  std::string MulticastInterfaceAddress;
+
+  /*! Minimum time between tracking data sent by multicast (in milliseconds) */
+  int MulticastResolutionMs;
+
+  /*! Transforms and message types sent by multicast. Only TRANSFORM, POSITION, and TDATA message types are used. */
+  PlusIgtlClientInfo MulticastClientInfo;
+
+  /*! Multicast sender. Only used by the tracking data sender thread while the service is running. */
+  PlusIgtlMulticastChannel MulticastChannel;
+
+  /*! Tracker time of the last tracking data sent by multicast */
+  double MulticastLastSentTimestamp;
+
+  /*! GET_POLYDATA requests to be processed by the loader thread */
+  std::deque<PolyDataRequest> PolyDataRequestQueue;
+  std::mutex PolyDataRequestQueueMutex;
+  std::condition_variable PolyDataRequestQueueCondition;
+
+  /*! Active flag for the model loader thread (first: request, second: respond) */
+  std::pair<bool, bool> PolyDataLoaderActive;
+  int PolyDataLoaderThreadId;
+
   /*! Channel ID to request the data from */
   std::string OutputChannelId;
 
@@ -7,6 +7,7 @@
 #include <math.h>
 #include <time.h>
 #include <limits>
+#include <random>
 #include "ParametersEstimator.h"
 #include "itkMultiThreader.h"
 #include "itkSimpleFastMutexLock.h"
@@ -68,6 +69,17 @@ public:
   void SetNumberOfThreads( unsigned int numberOfThreads );
   unsigned int GetNumberOfThreads();
 
+  /**
+   * Set the seed of the random number generator used for selecting the
+   * subsets. If a seed is set then Compute() gives the same result for the 
+   * same input (when a single thread is used), otherwise the generator is 
+   * seeded with the current time.
+   * Each RANSAC object has its own random number generator, therefore 
+   * multiple objects can be used in parallel.
+   */
+  void SetRandomSeed( unsigned int seed );
+  void ClearRandomSeed();
+
   /**
    * Set the function object that is able to estimate the desired parametric 
    * entity (e.g. PlaneParametersEstimator).
@@ -145,6 +157,11 @@ private:
                  //number of threads used in computing the RANSAC hypotheses
   unsigned int numberOfThreads;
 
+                 //seed of the random number generators of the threads
+  bool randomSeedSet;
+  unsigned int randomSeed;
+  unsigned int computeRandomSeed;
+
        //the following variables are shared by all threads used in the RANSAC
        //computation
 
@@ -8,6 +8,9 @@ template<class T, class S>
 RANSAC<T,S>::RANSAC( )
 {
   this->numberOfThreads = 1;
+  this->randomSeedSet = false;
+  this->randomSeed = 0;
+  this->computeRandomSeed = 0;
 }
 
 
@@ -36,6 +39,21 @@ unsigned int RANSAC<T,S>::GetNumberOfThreads()
 }
 
 
+template<class T, class S>
+void RANSAC<T,S>::SetRandomSeed( unsigned int seed )
+{
+  this->randomSeed = seed;
+  this->randomSeedSet = true;
+}
+
+
+template<class T, class S>
+void RANSAC<T,S>::ClearRandomSeed()
+{
+  this->randomSeedSet = false;
+}
+
+
 template<class T, class S>
 void RANSAC<T,S>::SetParametersEstimator( typename ParametersEstimator<T,S>::Pointer paramEstimator )
 {
@@ -95,15 +113,27 @@ double RANSAC<T,S>::Compute( std::vector<S> &parameters,
   this->numerator = log( 1.0-desiredProbabilityForNoOutliers );
   
 
-  srand( (unsigned)time(NULL) ); //seed random number generator
+                  //seed of the random number generators, each thread
+                  //uses its own generator (seeded with seed+threadID)
+  this->computeRandomSeed = this->randomSeedSet ? this->randomSeed : (unsigned)time(NULL);
 
                   //STEP2: create the threads that generate hypotheses and test
 
-  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();   
-  threader->SetNumberOfThreads( this->numberOfThreads );
-  threader->SetSingleMethod( RANSAC<T,S>::RANSACThreadCallback, this );
+  if( this->numberOfThreads == 1 ) {
+            //no need for creating a thread, run in the calling thread
+    itk::MultiThreader::ThreadInfoStruct threadInfo;
+    threadInfo.ThreadID = 0;
+    threadInfo.NumberOfThreads = 1;
+    threadInfo.UserData = this;
+    RANSAC<T,S>::RANSACThreadCallback( &threadInfo );
+  }
+  else {
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();   
+    threader->SetNumberOfThreads( this->numberOfThreads );
+    threader->SetSingleMethod( RANSAC<T,S>::RANSACThreadCallback, this );
             //runs all threads and blocks till they finish
-  threader->SingleMethodExecute();
+    threader->SingleMethodExecute();
+  }
 
          //STEP3: least squares estimate using largest consensus set and cleanup
 
@@ -156,6 +186,10 @@ ITK_THREAD_RETURN_TYPE RANSAC<T,S>::RANSACThreadCallback( void *arg )
     //true if data[i] is NOT chosen for computing the exact fit, otherwise false
     bool *notChosen = new bool[numDataObjects]; 
 
+    //random number generator of this thread
+    std::minstd_rand randomGenerator( caller->computeRandomSeed + infoStruct->ThreadID );
+    const double randomRange = static_cast<double>( randomGenerator.max() - randomGenerator.min() );
+
     for( unsigned int i = 0; i < caller->numTries; i++ )
     {
       //randomly select data for exact model fit ('numForEstimate' objects).
@@ -167,7 +201,7 @@ ITK_THREAD_RETURN_TYPE RANSAC<T,S>::RANSACThreadCallback( void *arg )
       for( unsigned int l = 0; l < numForEstimate; l++ )
       {
         //selectedIndex is in [0,maxIndex]
-        int selectedIndex = (int)( ((float)rand() / (float)RAND_MAX) * maxIndex + 0.5);
+        int selectedIndex = (int)( ((randomGenerator() - randomGenerator.min()) / randomRange) * maxIndex + 0.5);
         unsigned int k(0);
         int j(-1);
         for( ; k < numDataObjects && j < selectedIndex; k++ )